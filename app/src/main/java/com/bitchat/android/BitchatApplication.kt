@@ -2,6 +2,7 @@ package com.bitchat.android
 
 import android.app.Application
 import com.bitchat.android.nostr.RelayDirectory
+import com.bitchat.android.services.StartupCoordinator
 import com.bitchat.android.ui.theme.ThemePreferenceManager
 import com.bitchat.android.net.TorManager
 
@@ -12,25 +13,30 @@ class BitchatApplication : Application() {
     
     override fun onCreate() {
         super.onCreate()
+
+        // Start loading identity key material in the background before anything else;
+        // the mesh service awaits it when MainActivity creates it
+        StartupCoordinator.begin(this)
         
         // Initialize Tor first so any early network goes over Tor
-        try { TorManager.init(this) } catch (_: Exception) { }
+        StartupCoordinator.stage("tor.init") {
+            try { TorManager.init(this) } catch (_: Exception) { }
+        }
 
         // Initialize relay directory (loads assets/nostr_relays.csv)
-        RelayDirectory.initialize(this)
+        StartupCoordinator.stage("relay.directory") { RelayDirectory.initialize(this) }
 
         // Initialize LocationNotesManager dependencies early so sheet subscriptions can start immediately
         try { com.bitchat.android.nostr.LocationNotesInitializer.initialize(this) } catch (_: Exception) { }
 
         // Initialize favorites persistence early so MessageRouter/NostrTransport can use it on startup
-        try {
-            com.bitchat.android.favorites.FavoritesPersistenceService.initialize(this)
-        } catch (_: Exception) { }
-
-        // Warm up Nostr identity to ensure npub is available for favorite notifications
-        try {
-            com.bitchat.android.nostr.NostrIdentityBridge.getCurrentNostrIdentity(this)
-        } catch (_: Exception) { }
+        StartupCoordinator.stage("favorites") {
+            try {
+                com.bitchat.android.favorites.FavoritesPersistenceService.initialize(this)
+            } catch (_: Exception) { }
+        }
+
+        // Nostr identity (npub for favorite notifications) is warmed up by StartupCoordinator.begin
 
         // Initialize theme preference
         ThemePreferenceManager.init(this)
@@ -35,11 +35,15 @@ import com.bitchat.android.onboarding.OnboardingCoordinator
 import com.bitchat.android.onboarding.OnboardingState
 import com.bitchat.android.onboarding.PermissionExplanationScreen
 import com.bitchat.android.onboarding.PermissionManager
+import com.bitchat.android.services.StartupCoordinator
 import com.bitchat.android.ui.ChatScreen
 import com.bitchat.android.ui.ChatViewModel
 import com.bitchat.android.ui.OrientationAwareActivity
 import com.bitchat.android.ui.theme.BitchatTheme
+import com.bitchat.android.util.WriteBehindWriter
 import com.bitchat.android.nostr.PoWPreferenceManager
+import kotlinx.coroutines.Deferred
+import kotlinx.coroutines.async
 import kotlinx.coroutines.delay
 import kotlinx.coroutines.launch
 
@@ -51,8 +55,10 @@ class MainActivity : OrientationAwareActivity() {
     private lateinit var locationStatusManager: LocationStatusManager
     private lateinit var batteryOptimizationManager: BatteryOptimizationManager
     
-    // Core mesh service - managed at app level
+    // Core mesh service - managed at app level; built once the identity keys are loaded
     private lateinit var meshService: BluetoothMeshService
+    private var meshServiceBuild: Deferred<BluetoothMeshService>? = null
+    private var meshServiceAvailable by mutableStateOf(false)
     private val mainViewModel: MainViewModel by viewModels()
     private val chatViewModel: ChatViewModel by viewModels { 
         object : ViewModelProvider.Factory {
@@ -71,8 +77,9 @@ class MainActivity : OrientationAwareActivity() {
 
         // Initialize permission management
         permissionManager = PermissionManager(this)
-        // Initialize core mesh service first
-        meshService = BluetoothMeshService(this)
+        // Initialize core mesh service first, as soon as the identity keys warmed up by
+        // BitchatApplication are ready (at once if they already are)
+        buildMeshServiceAsync()
         bluetoothStatusManager = BluetoothStatusManager(
             activity = this,
             context = this,
@@ -112,6 +119,9 @@ class MainActivity : OrientationAwareActivity() {
             }
         }
         
+        // Posted behind the first traversal, so this approximates time to first frame
+        window.decorView.post { StartupCoordinator.mark("first_frame") }
+        
         // Collect state changes in a lifecycle-aware manner
         lifecycleScope.launch {
             repeatOnLifecycle(Lifecycle.State.STARTED) {
@@ -227,7 +237,10 @@ class MainActivity : OrientationAwareActivity() {
                 )
             }
 
-            OnboardingState.CHECKING, OnboardingState.INITIALIZING, OnboardingState.COMPLETE -> {
+            OnboardingState.CHECKING, OnboardingState.INITIALIZING, OnboardingState.COMPLETE -> if (!meshServiceAvailable) {
+                // Identity keys are still loading; the chat screen needs the mesh service
+                InitializingScreen(modifier)
+            } else {
                 // Set up back navigation handling for the chat screen
                 val backCallback = object : OnBackPressedCallback(true) {
                     override fun handleOnBackPressed() {
@@ -582,6 +595,24 @@ class MainActivity : OrientationAwareActivity() {
         mainViewModel.updateOnboardingState(OnboardingState.BATTERY_OPTIMIZATION_CHECK)
     }
     
+    /**
+     * Build the mesh service once the identity keys are loaded. The keystore work runs on
+     * StartupCoordinator's background scope; this only suspends, so the main thread never
+     * blocks on it. A failed build is retried by the next call.
+     */
+    private fun buildMeshServiceAsync(): Deferred<BluetoothMeshService> {
+        meshServiceBuild?.let { build ->
+            if (!build.isCompleted || build.getCompletionExceptionOrNull() == null) return build
+        }
+        return lifecycleScope.async {
+            StartupCoordinator.identityKeys(this@MainActivity)
+            StartupCoordinator.stage("mesh.service") { BluetoothMeshService(this@MainActivity) }.also {
+                meshService = it
+                meshServiceAvailable = true
+            }
+        }.also { meshServiceBuild = it }
+    }
+    
     private fun initializeApp() {
         Log.d("MainActivity", "Starting app initialization")
         
@@ -609,6 +640,7 @@ class MainActivity : OrientationAwareActivity() {
                 }
 
                 // Set up mesh service delegate and start services
+                buildMeshServiceAsync().await()
                 meshService.delegate = chatViewModel
                 meshService.startServices()
                 
@@ -631,7 +663,7 @@ class MainActivity : OrientationAwareActivity() {
     override fun onNewIntent(intent: Intent) {
         super.onNewIntent(intent)
         // Handle notification intents when app is already running
-        if (mainViewModel.onboardingState.value == OnboardingState.COMPLETE) {
+        if (mainViewModel.onboardingState.value == OnboardingState.COMPLETE && meshServiceAvailable) {
             handleNotificationIntent(intent)
         }
     }
@@ -639,7 +671,7 @@ class MainActivity : OrientationAwareActivity() {
     override fun onResume() {
         super.onResume()
         // Check Bluetooth and Location status on resume and handle accordingly
-        if (mainViewModel.onboardingState.value == OnboardingState.COMPLETE) {
+        if (mainViewModel.onboardingState.value == OnboardingState.COMPLETE && meshServiceAvailable) {
             // Set app foreground state
             meshService.connectionManager.setAppBackgroundState(false)
             chatViewModel.setAppBackgroundState(false)
@@ -667,8 +699,11 @@ class MainActivity : OrientationAwareActivity() {
     
      override fun onPause() {
         super.onPause()
+        // Make write-behind stores (favorites, blocks, bookmarks) durable before we can be killed;
+        // committed on IO so EncryptedSharedPreferences never writes on the main thread
+        WriteBehindWriter.flushAllAsync()
         // Only set background state if app is fully initialized
-        if (mainViewModel.onboardingState.value == OnboardingState.COMPLETE) {
+        if (mainViewModel.onboardingState.value == OnboardingState.COMPLETE && meshServiceAvailable) {
             // Set app background state
             meshService.connectionManager.setAppBackgroundState(true)
             chatViewModel.setAppBackgroundState(true)
@@ -747,7 +782,7 @@ class MainActivity : OrientationAwareActivity() {
         }
         
         // Stop mesh services if app was fully initialized
-        if (mainViewModel.onboardingState.value == OnboardingState.COMPLETE) {
+        if (mainViewModel.onboardingState.value == OnboardingState.COMPLETE && meshServiceAvailable) {
             try {
                 meshService.stopServices()
                 Log.d("MainActivity", "Mesh services stopped successfully")
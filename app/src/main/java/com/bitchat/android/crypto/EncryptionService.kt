@@ -205,6 +205,20 @@ class EncryptionService(private val context: Context) {
         return noiseService.getSessionState(peerID)
     }
     
+    /**
+     * Get the Noise handshake hash for a peer's established session (for binding derived keys)
+     */
+    fun getHandshakeHash(peerID: String): ByteArray? {
+        return noiseService.getHandshakeHash(peerID)
+    }
+    
+    /**
+     * Use the bulk replay window for a peer's session (incoming file streams)
+     */
+    fun useBulkReplayWindow(peerID: String) {
+        noiseService.useBulkReplayWindow(peerID)
+    }
+    
     /**
      * Get encryption icon state for UI
      */
@@ -1,10 +1,14 @@
 package com.bitchat.android.favorites
 
 import android.content.Context
+import android.util.Base64
 import android.util.Log
 import com.bitchat.android.identity.SecureIdentityStateManager
+import com.bitchat.android.util.WriteBehindWriter
 import com.google.gson.Gson
 import com.google.gson.reflect.TypeToken
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 import java.util.*
 
 /**
@@ -61,8 +65,12 @@ class FavoritesPersistenceService private constructor(private val context: Conte
 
     companion object {
         private const val TAG = "FavoritesPersistenceService"
+        // Legacy whole-collection JSON blobs; migrated to per-record keys on load
         private const val FAVORITES_KEY = "favorite_relationships"            // noiseHex -> relationship
         private const val PEERID_INDEX_KEY = "favorite_peerid_index"         // peerID(16-hex) -> npub
+        // One secure value per record so a mutation rewrites only that record
+        private const val FAVORITE_RECORD_PREFIX = "favorite:"               // + noiseHex -> binary record (Base64)
+        private const val PEERID_RECORD_PREFIX = "favorite_peerid:"          // + peerID -> npub
 
         @Volatile
         private var INSTANCE: FavoritesPersistenceService? = null
@@ -83,6 +91,7 @@ class FavoritesPersistenceService private constructor(private val context: Conte
 
     private val stateManager = SecureIdentityStateManager(context)
     private val gson = Gson()
+    private val writer = WriteBehindWriter<String>("favorites") { batch -> stateManager.writeSecureValues(batch) }
     private val favorites = mutableMapOf<String, FavoriteRelationship>() // noiseHex -> relationship
     // NEW: Index by current mesh peerID (16-hex) for direct lookup when sending Nostr DMs from mesh context
     private val peerIdIndex = mutableMapOf<String, String>() // peerID (lowercase 16-hex) -> npub
@@ -133,7 +142,7 @@ class FavoritesPersistenceService private constructor(private val context: Conte
             favorites[keyHex] = relationship
         }
 
-        saveFavorites()
+        persistFavorite(keyHex)
         notifyChanged(keyHex)
         Log.d(TAG, "Updated Nostr pubkey association for ${keyHex.take(16)}...")
     }
@@ -144,7 +153,7 @@ class FavoritesPersistenceService private constructor(private val context: Conte
         val pid = peerID.lowercase()
         if (pid.length == 16 && pid.matches(Regex("^[0-9a-f]+$"))) {
             peerIdIndex[pid] = nostrPubkey
-            savePeerIdIndex()
+            writer.put(PEERID_RECORD_PREFIX + pid, nostrPubkey)
             Log.d(TAG, "Indexed npub for peerID ${pid.take(8)}…")
         } else {
             Log.w(TAG, "updateNostrPublicKeyForPeerID called with non-16hex peerID: $peerID")
@@ -202,7 +211,7 @@ class FavoritesPersistenceService private constructor(private val context: Conte
         }
 
         favorites[keyHex] = updated
-        saveFavorites()
+        persistFavorite(keyHex)
         notifyChanged(keyHex)
 
         Log.d(TAG, "Updated favorite status for $nickname: $isFavorite")
@@ -219,7 +228,7 @@ class FavoritesPersistenceService private constructor(private val context: Conte
                 lastUpdated = Date()
             )
             favorites[keyHex] = updated
-            saveFavorites()
+            persistFavorite(keyHex)
             notifyChanged(keyHex)
 
             Log.d(TAG, "Updated peer favorited us for ${keyHex.take(16)}...: $theyFavoritedUs")
@@ -230,10 +239,16 @@ class FavoritesPersistenceService private constructor(private val context: Conte
     fun getOurFavorites(): List<FavoriteRelationship> = favorites.values.filter { it.isFavorite }
 
     fun clearAllFavorites() {
+        val recordKeys = favorites.keys.map { FAVORITE_RECORD_PREFIX + it } +
+            peerIdIndex.keys.map { PEERID_RECORD_PREFIX + it }
         favorites.clear()
-        saveFavorites()
         peerIdIndex.clear()
-        savePeerIdIndex()
+        writer.discardPending()
+        val storedKeys = try {
+            stateManager.getSecureValuesWithPrefix(FAVORITE_RECORD_PREFIX).keys +
+                stateManager.getSecureValuesWithPrefix(PEERID_RECORD_PREFIX).keys
+        } catch (_: Exception) { emptySet() }
+        (recordKeys + storedKeys + listOf(FAVORITES_KEY, PEERID_INDEX_KEY)).toSet().forEach { writer.remove(it) }
         Log.i(TAG, "Cleared all favorites")
         notifyAllCleared()
     }
@@ -256,60 +271,69 @@ class FavoritesPersistenceService private constructor(private val context: Conte
 
     private fun loadFavorites() {
         try {
+            favorites.clear()
+            stateManager.getSecureValuesWithPrefix(FAVORITE_RECORD_PREFIX).forEach { (key, value) ->
+                FavoriteRecordCodec.decode(value)?.let { favorites[key.removePrefix(FAVORITE_RECORD_PREFIX)] = it }
+            }
+
+            // Migrate the legacy JSON blob into per-record keys
             val favoritesJson = stateManager.getSecureValue(FAVORITES_KEY)
             if (favoritesJson != null) {
                 val type = object : TypeToken<Map<String, FavoriteRelationshipData>>() {}.type
                 val data: Map<String, FavoriteRelationshipData> = gson.fromJson(favoritesJson, type)
-
-                favorites.clear()
                 data.forEach { (key, relationshipData) ->
-                    favorites[key] = relationshipData.toFavoriteRelationship()
+                    if (!favorites.containsKey(key)) {
+                        favorites[key] = relationshipData.toFavoriteRelationship()
+                        persistFavorite(key)
+                    }
                 }
-                Log.d(TAG, "Loaded ${favorites.size} favorite relationships")
+                writer.remove(FAVORITES_KEY)
+                Log.i(TAG, "Migrated ${data.size} favorite relationships to record storage")
             }
+            Log.d(TAG, "Loaded ${favorites.size} favorite relationships")
         } catch (e: Exception) {
             Log.e(TAG, "Failed to load favorites: ${e.message}")
         }
     }
 
-    private fun saveFavorites() {
-        try {
-            val data = favorites.mapValues { (_, relationship) ->
-                FavoriteRelationshipData.fromFavoriteRelationship(relationship)
-            }
-            val favoritesJson = gson.toJson(data)
-            stateManager.storeSecureValue(FAVORITES_KEY, favoritesJson)
-            Log.d(TAG, "Saved ${favorites.size} favorite relationships")
-        } catch (e: Exception) {
-            Log.e(TAG, "Failed to save favorites: ${e.message}")
+    /**
+     * Queue the current state of one relationship (or its removal) for write-behind
+     */
+    private fun persistFavorite(keyHex: String) {
+        val relationship = favorites[keyHex]
+        if (relationship != null) {
+            writer.put(FAVORITE_RECORD_PREFIX + keyHex, FavoriteRecordCodec.encode(relationship))
+        } else {
+            writer.remove(FAVORITE_RECORD_PREFIX + keyHex)
         }
     }
 
     private fun loadPeerIdIndex() {
         try {
+            peerIdIndex.clear()
+            stateManager.getSecureValuesWithPrefix(PEERID_RECORD_PREFIX).forEach { (key, npub) ->
+                peerIdIndex[key.removePrefix(PEERID_RECORD_PREFIX)] = npub
+            }
+
+            // Migrate the legacy JSON blob into per-record keys
             val json = stateManager.getSecureValue(PEERID_INDEX_KEY)
             if (json != null) {
                 val type = object : TypeToken<Map<String, String>>() {}.type
                 val data: Map<String, String> = gson.fromJson(json, type)
-                peerIdIndex.clear()
-                peerIdIndex.putAll(data)
-                Log.d(TAG, "Loaded ${peerIdIndex.size} peerID→npub mappings")
+                data.forEach { (pid, npub) ->
+                    if (!peerIdIndex.containsKey(pid)) {
+                        peerIdIndex[pid] = npub
+                        writer.put(PEERID_RECORD_PREFIX + pid, npub)
+                    }
+                }
+                writer.remove(PEERID_INDEX_KEY)
             }
+            Log.d(TAG, "Loaded ${peerIdIndex.size} peerID→npub mappings")
         } catch (e: Exception) {
             Log.e(TAG, "Failed to load peerID index: ${e.message}")
         }
     }
 
-    private fun savePeerIdIndex() {
-        try {
-            val json = gson.toJson(peerIdIndex)
-            stateManager.storeSecureValue(PEERID_INDEX_KEY, json)
-            Log.d(TAG, "Saved ${peerIdIndex.size} peerID→npub mappings")
-        } catch (e: Exception) {
-            Log.e(TAG, "Failed to save peerID index: ${e.message}")
-        }
-    }
-
     // MARK: - Listeners
     fun addListener(listener: FavoritesChangeListener) {
         synchronized(listeners) { if (!listeners.contains(listener)) listeners.add(listener) }
@@ -335,7 +359,68 @@ class FavoritesPersistenceService private constructor(private val context: Conte
     } catch (_: Exception) { null }
 }
 
-/** Serializable data for JSON storage */
+/**
+ * Compact binary record for one relationship, stored Base64 under its own secure key.
+ * Layout: [version][keyLen][noiseKey][flags][favoritedAt i64][lastUpdated i64]
+ *         [nickLen u16][nickname UTF-8] then, if FLAG_HAS_NOSTR, [npubLen u16][npub UTF-8]
+ */
+private object FavoriteRecordCodec {
+    private const val VERSION = 1
+    private const val FLAG_FAVORITE = 0x01
+    private const val FLAG_THEY_FAVORITED = 0x02
+    private const val FLAG_HAS_NOSTR = 0x04
+
+    fun encode(relationship: FavoriteRelationship): String {
+        val key = relationship.peerNoisePublicKey
+        val nick = relationship.peerNickname.toByteArray(Charsets.UTF_8).let { if (it.size > 0xFFFF) it.copyOf(0xFFFF) else it }
+        val nostr = relationship.peerNostrPublicKey?.toByteArray(Charsets.UTF_8)
+        var flags = 0
+        if (relationship.isFavorite) flags = flags or FLAG_FAVORITE
+        if (relationship.theyFavoritedUs) flags = flags or FLAG_THEY_FAVORITED
+        if (nostr != null) flags = flags or FLAG_HAS_NOSTR
+
+        val size = 1 + 1 + key.size + 1 + 8 + 8 + 2 + nick.size + (nostr?.let { 2 + it.size } ?: 0)
+        val buf = ByteBuffer.allocate(size).order(ByteOrder.BIG_ENDIAN)
+        buf.put(VERSION.toByte())
+        buf.put(key.size.toByte())
+        buf.put(key)
+        buf.put(flags.toByte())
+        buf.putLong(relationship.favoritedAt.time)
+        buf.putLong(relationship.lastUpdated.time)
+        buf.putShort(nick.size.toShort())
+        buf.put(nick)
+        if (nostr != null) {
+            buf.putShort(nostr.size.toShort())
+            buf.put(nostr)
+        }
+        return Base64.encodeToString(buf.array(), Base64.NO_WRAP)
+    }
+
+    fun decode(value: String): FavoriteRelationship? = try {
+        val buf = ByteBuffer.wrap(Base64.decode(value, Base64.NO_WRAP)).order(ByteOrder.BIG_ENDIAN)
+        if (buf.get().toInt() != VERSION) null else {
+            val key = ByteArray(buf.get().toInt() and 0xFF).also { buf.get(it) }
+            val flags = buf.get().toInt() and 0xFF
+            val favoritedAt = buf.long
+            val lastUpdated = buf.long
+            val nick = ByteArray(buf.short.toInt() and 0xFFFF).also { buf.get(it) }
+            val nostr = if ((flags and FLAG_HAS_NOSTR) != 0) {
+                String(ByteArray(buf.short.toInt() and 0xFFFF).also { buf.get(it) }, Charsets.UTF_8)
+            } else null
+            FavoriteRelationship(
+                peerNoisePublicKey = key,
+                peerNostrPublicKey = nostr,
+                peerNickname = String(nick, Charsets.UTF_8),
+                isFavorite = (flags and FLAG_FAVORITE) != 0,
+                theyFavoritedUs = (flags and FLAG_THEY_FAVORITED) != 0,
+                favoritedAt = Date(favoritedAt),
+                lastUpdated = Date(lastUpdated)
+            )
+        }
+    } catch (_: Exception) { null }
+}
+
+/** Serializable data for legacy JSON storage (read once for migration) */
 private data class FavoriteRelationshipData(
     val peerNoisePublicKeyHex: String,
     val peerNostrPublicKey: String?,
@@ -345,20 +430,6 @@ private data class FavoriteRelationshipData(
     val favoritedAt: Long,
     val lastUpdated: Long
 ) {
-    companion object {
-        fun fromFavoriteRelationship(relationship: FavoriteRelationship): FavoriteRelationshipData {
-            return FavoriteRelationshipData(
-                peerNoisePublicKeyHex = relationship.peerNoisePublicKey.joinToString("") { "%02x".format(it) },
-                peerNostrPublicKey = relationship.peerNostrPublicKey,
-                peerNickname = relationship.peerNickname,
-                isFavorite = relationship.isFavorite,
-                theyFavoritedUs = relationship.theyFavoritedUs,
-                favoritedAt = relationship.favoritedAt.time,
-                lastUpdated = relationship.lastUpdated.time
-            )
-        }
-    }
-
     fun toFavoriteRelationship(): FavoriteRelationship {
         val noiseKeyBytes = peerNoisePublicKeyHex.chunked(2).map { it.toInt(16).toByte() }.toByteArray()
         return FavoriteRelationship(
@@ -197,37 +197,8 @@ object FileUtils {
     ): String {
         val lowerMime = file.mimeType.lowercase()
         val isImage = lowerMime.startsWith("image/")
-        val baseDir = context.filesDir
-        val subdir = if (isImage) "images/incoming" else "files/incoming"
-        val dir = java.io.File(baseDir, subdir).apply { mkdirs() }
-
-        fun extFromMime(m: String): String = when (m.lowercase()) {
-            "image/jpeg", "image/jpg" -> ".jpg"
-            "image/png" -> ".png"
-            "image/webp" -> ".webp"
-            "application/pdf" -> ".pdf"
-            "text/plain" -> ".txt"
-            else -> if (isImage) ".jpg" else ".bin"
-        }
-
-        // Prefer transmitted original name; ensure uniqueness to avoid overwrites
-        val baseName = (file.fileName.takeIf { it.isNotBlank() }
-            ?: (if (isImage) "img" else "file"))
-            .replace(Regex("[^A-Za-z0-9._-]"), "_")
-        val ext = extFromMime(lowerMime)
-        var safeName = if (baseName.contains('.')) baseName else baseName + ext
-        var idx = 1
-        while (java.io.File(dir, safeName).exists() && idx < 1000) {
-            val dot = safeName.lastIndexOf('.')
-            safeName = if (dot > 0) {
-                val b = safeName.substring(0, dot)
-                val e = safeName.substring(dot)
-                "$b ($idx)$e"
-            } else {
-                "$safeName ($idx)"
-            }
-            idx++
-        }
+        val safeName = incomingFileName(context, file.fileName, file.mimeType)
+        val dir = incomingDir(context, file.mimeType)
 
         return try {
             val out = java.io.File(dir, safeName)
@@ -260,6 +231,73 @@ object FileUtils {
         }
     }
 
+    /**
+     * Move a fully received, already-assembled file (e.g. a streamed transfer written
+     * record by record to a temp file) into incoming storage without re-reading it.
+     * Returns the absolute path, or null if the file could not be placed.
+     */
+    fun moveIncomingFile(
+        context: Context,
+        assembled: java.io.File,
+        fileName: String,
+        mimeType: String
+    ): String? {
+        val target = java.io.File(incomingDir(context, mimeType), incomingFileName(context, fileName, mimeType))
+        return try {
+            if (assembled.renameTo(target)) {
+                target.absolutePath
+            } else {
+                // Different filesystem; fall back to a streaming copy
+                assembled.inputStream().use { input -> target.outputStream().use { input.copyTo(it) } }
+                assembled.delete()
+                target.absolutePath
+            }
+        } catch (_: Exception) {
+            null
+        }
+    }
+
+    private fun incomingDir(context: Context, mimeType: String): java.io.File {
+        val isImage = mimeType.lowercase().startsWith("image/")
+        val subdir = if (isImage) "images/incoming" else "files/incoming"
+        return java.io.File(context.filesDir, subdir).apply { mkdirs() }
+    }
+
+    private fun incomingFileName(context: Context, fileName: String, mimeType: String): String {
+        val lowerMime = mimeType.lowercase()
+        val isImage = lowerMime.startsWith("image/")
+        val dir = incomingDir(context, mimeType)
+
+        fun extFromMime(m: String): String = when (m.lowercase()) {
+            "image/jpeg", "image/jpg" -> ".jpg"
+            "image/png" -> ".png"
+            "image/webp" -> ".webp"
+            "application/pdf" -> ".pdf"
+            "text/plain" -> ".txt"
+            else -> if (isImage) ".jpg" else ".bin"
+        }
+
+        // Prefer transmitted original name; ensure uniqueness to avoid overwrites
+        val baseName = (fileName.takeIf { it.isNotBlank() }
+            ?: (if (isImage) "img" else "file"))
+            .replace(Regex("[^A-Za-z0-9._-]"), "_")
+        val ext = extFromMime(lowerMime)
+        var safeName = if (baseName.contains('.')) baseName else baseName + ext
+        var idx = 1
+        while (java.io.File(dir, safeName).exists() && idx < 1000) {
+            val dot = safeName.lastIndexOf('.')
+            safeName = if (dot > 0) {
+                val b = safeName.substring(0, dot)
+                val e = safeName.substring(dot)
+                "$b ($idx)$e"
+            } else {
+                "$safeName ($idx)"
+            }
+            idx++
+        }
+        return safeName
+    }
+
     /**
      * Classify BitchatMessageType from MIME string used in file messages.
      */
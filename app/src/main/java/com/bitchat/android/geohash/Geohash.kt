@@ -3,13 +3,32 @@ package com.bitchat.android.geohash
 /**
  * Lightweight Geohash encoder used for Location Channels.
  * Encodes latitude/longitude to base32 geohash with a fixed precision.
- * 
- * Port of iOS implementation for 100% compatibility
+ *
+ * Port of iOS implementation for 100% compatibility.
+ *
+ * A geohash of precision p is the 5p-bit Morton code of the quantized longitude
+ * (ceil(5p/2) bits) and latitude (floor(5p/2) bits), longitude bit first. Cells are
+ * handled as integers: coordinates are quantized once, bits are (de)interleaved with
+ * shift-and-mask, and neighbours are offsets in cell coordinates. Only the resulting
+ * strings are allocated. Precision is limited to [MAX_PRECISION] characters (60 bits).
  */
 object Geohash {
-    
+
+    const val MAX_PRECISION = 12
+
     private val base32Chars = "0123456789bcdefghjkmnpqrstuvwxyz".toCharArray()
-    private val charToValue: Map<Char, Int> = base32Chars.withIndex().associate { it.value to it.index }
+
+    // ASCII -> 5-bit value, -1 for characters outside the alphabet (either case accepted)
+    private val charToValue = IntArray(128) { -1 }.also { table ->
+        base32Chars.forEachIndexed { i, c ->
+            table[c.code] = i
+            table[c.uppercaseChar().code] = i
+        }
+    }
+
+    // Neighbour offsets (dLon, dLat) in cell units: N, NE, E, SE, S, SW, W, NW
+    private val NEIGHBOR_DX = intArrayOf(0, 1, 1, 1, 0, -1, -1, -1)
+    private val NEIGHBOR_DY = intArrayOf(1, 1, 0, -1, -1, -1, 0, 1)
 
     data class Bounds(val latMin: Double, val latMax: Double, val lonMin: Double, val lonMax: Double)
 
@@ -17,53 +36,19 @@ object Geohash {
      * Encodes the provided coordinates into a geohash string.
      * @param latitude Latitude in degrees (-90...90)
      * @param longitude Longitude in degrees (-180...180)
-     * @param precision Number of geohash characters (2-12 typical). Values <= 0 return an empty string.
+     * @param precision Number of geohash characters (1-12). Values <= 0 return an empty string;
+     *                  larger values are clamped to [MAX_PRECISION].
      * @return Base32 geohash string of length `precision`.
      */
     fun encode(latitude: Double, longitude: Double, precision: Int): String {
         if (precision <= 0) return ""
-
-        var latInterval = -90.0 to 90.0
-        var lonInterval = -180.0 to 180.0
-
-        var isEven = true
-        var bit = 0
-        var ch = 0
-        val geohash = StringBuilder()
-
-        val lat = latitude.coerceIn(-90.0, 90.0)
-        val lon = longitude.coerceIn(-180.0, 180.0)
-
-        while (geohash.length < precision) {
-            if (isEven) {
-                val mid = (lonInterval.first + lonInterval.second) / 2
-                if (lon >= mid) {
-                    ch = ch or (1 shl (4 - bit))
-                    lonInterval = mid to lonInterval.second
-                } else {
-                    lonInterval = lonInterval.first to mid
-                }
-            } else {
-                val mid = (latInterval.first + latInterval.second) / 2
-                if (lat >= mid) {
-                    ch = ch or (1 shl (4 - bit))
-                    latInterval = mid to latInterval.second
-                } else {
-                    latInterval = latInterval.first to mid
-                }
-            }
-
-            isEven = !isEven
-            if (bit < 4) {
-                bit += 1
-            } else {
-                geohash.append(base32Chars[ch])
-                bit = 0
-                ch = 0
-            }
-        }
-
-        return geohash.toString()
+        val p = minOf(precision, MAX_PRECISION)
+        val bits = 5 * p
+        val lonBits = (bits + 1) / 2
+        val latBits = bits / 2
+        val lonQ = quantize(longitude.coerceIn(-180.0, 180.0) + 180.0, 360.0, lonBits)
+        val latQ = quantize(latitude.coerceIn(-90.0, 90.0) + 90.0, 180.0, latBits)
+        return toBase32(interleave(lonQ, latQ, bits), p)
     }
 
     /**
@@ -82,69 +67,124 @@ object Geohash {
      */
     fun decodeToBounds(geohash: String): Bounds {
         if (geohash.isEmpty()) return Bounds(0.0, 0.0, 0.0, 0.0)
-
-        var latInterval = -90.0 to 90.0
-        var lonInterval = -180.0 to 180.0
-        var isEven = true
-
-        geohash.lowercase().forEach { ch ->
-            val cd = charToValue[ch] ?: return Bounds(0.0, 0.0, 0.0, 0.0)
-            for (mask in intArrayOf(16, 8, 4, 2, 1)) {
-                if (isEven) {
-                    val mid = (lonInterval.first + lonInterval.second) / 2
-                    if ((cd and mask) != 0) {
-                        lonInterval = mid to lonInterval.second
-                    } else {
-                        lonInterval = lonInterval.first to mid
-                    }
-                } else {
-                    val mid = (latInterval.first + latInterval.second) / 2
-                    if ((cd and mask) != 0) {
-                        latInterval = mid to latInterval.second
-                    } else {
-                        latInterval = latInterval.first to mid
-                    }
-                }
-                isEven = !isEven
-            }
-        }
+        val code = fromBase32(geohash)
+        if (code < 0) return Bounds(0.0, 0.0, 0.0, 0.0)
+        val bits = 5 * geohash.length
+        val lonBits = (bits + 1) / 2
+        val latBits = bits / 2
+        val lonStep = 360.0 / (1L shl lonBits)
+        val latStep = 180.0 / (1L shl latBits)
+        val lonMin = -180.0 + deinterleaveLon(code, bits) * lonStep
+        val latMin = -90.0 + deinterleaveLat(code, bits) * latStep
         return Bounds(
-            latMin = minOf(latInterval.first, latInterval.second),
-            latMax = maxOf(latInterval.first, latInterval.second),
-            lonMin = minOf(lonInterval.first, lonInterval.second),
-            lonMax = maxOf(lonInterval.first, lonInterval.second)
+            latMin = latMin,
+            latMax = latMin + latStep,
+            lonMin = lonMin,
+            lonMax = lonMin + lonStep
         )
     }
 
     /**
      * Returns the 8 neighboring geohash cells at the same precision as the input.
      * Neighbors include N, NE, E, SE, S, SW, W, NW, even when crossing parent cell boundaries.
+     * Longitude wraps at the antimeridian; rows beyond a pole clamp to the polar row.
      */
     fun neighborsSamePrecision(geohash: String): Set<String> {
         if (geohash.isEmpty()) return emptySet()
+        val code = fromBase32(geohash)
+        if (code < 0) return emptySet()
         val p = geohash.length
-        val b = decodeToBounds(geohash)
-        val dLat = b.latMax - b.latMin
-        val dLon = b.lonMax - b.lonMin
-
-        fun wrapLon(lon: Double): Double {
-            var x = lon
-            while (x > 180.0) x -= 360.0
-            while (x < -180.0) x += 360.0
-            return x
+        val bits = 5 * p
+        val lonMask = (1L shl ((bits + 1) / 2)) - 1
+        val latMax = (1L shl (bits / 2)) - 1
+        val lonQ = deinterleaveLon(code, bits)
+        val latQ = deinterleaveLat(code, bits)
+
+        val neighbors = LinkedHashSet<String>(16)
+        for (i in NEIGHBOR_DX.indices) {
+            val nLon = (lonQ + NEIGHBOR_DX[i]) and lonMask
+            val nLat = (latQ + NEIGHBOR_DY[i]).coerceIn(0L, latMax)
+            val nCode = interleave(nLon, nLat, bits)
+            if (nCode != code) neighbors.add(toBase32(nCode, p))
+        }
+        return neighbors
+    }
+
+    // --- Integer codec ---
+
+    /**
+     * Index of the 2^bits-way bisection cell containing `offset` in [0, span]; `span` maps to the last cell
+     */
+    private fun quantize(offset: Double, span: Double, bits: Int): Long {
+        val cells = 1L shl bits
+        val q = (offset / span * cells).toLong()
+        return if (q >= cells) cells - 1 else q
+    }
+
+    /**
+     * Morton code of `bits` total bits with the longitude bit most significant
+     */
+    private fun interleave(lonQ: Long, latQ: Long, bits: Int): Long {
+        return if (bits % 2 == 0) {
+            (spread(lonQ) shl 1) or spread(latQ)
+        } else {
+            spread(lonQ) or (spread(latQ) shl 1)
+        }
+    }
+
+    private fun deinterleaveLon(code: Long, bits: Int): Long =
+        if (bits % 2 == 0) compact(code ushr 1) else compact(code)
+
+    private fun deinterleaveLat(code: Long, bits: Int): Long =
+        if (bits % 2 == 0) compact(code) else compact(code ushr 1)
+
+    /**
+     * Insert a zero bit above each of the low 32 bits of x
+     */
+    private fun spread(value: Long): Long {
+        var x = value and 0xFFFFFFFFL
+        x = (x or (x shl 16)) and 0x0000FFFF0000FFFFL
+        x = (x or (x shl 8)) and 0x00FF00FF00FF00FFL
+        x = (x or (x shl 4)) and 0x0F0F0F0F0F0F0F0FL
+        x = (x or (x shl 2)) and 0x3333333333333333L
+        x = (x or (x shl 1)) and 0x5555555555555555L
+        return x
+    }
+
+    /**
+     * Inverse of [spread]: gather the even bits of x
+     */
+    private fun compact(value: Long): Long {
+        var x = value and 0x5555555555555555L
+        x = (x or (x ushr 1)) and 0x3333333333333333L
+        x = (x or (x ushr 2)) and 0x0F0F0F0F0F0F0F0FL
+        x = (x or (x ushr 4)) and 0x00FF00FF00FF00FFL
+        x = (x or (x ushr 8)) and 0x0000FFFF0000FFFFL
+        x = (x or (x ushr 16)) and 0x00000000FFFFFFFFL
+        return x
+    }
+
+    private fun toBase32(code: Long, precision: Int): String {
+        val chars = CharArray(precision)
+        var c = code
+        for (i in precision - 1 downTo 0) {
+            chars[i] = base32Chars[(c and 31L).toInt()]
+            c = c ushr 5
         }
+        return String(chars)
+    }
 
-        val neighbors = mutableSetOf<String>()
-        for (dy in -1..1) {
-            for (dx in -1..1) {
-                if (dx == 0 && dy == 0) continue // skip center
-                val centerLat = (b.latMin + b.latMax) / 2 + dy * dLat
-                val rawLonCenter = (b.lonMin + b.lonMax) / 2 + dx * dLon
-                val centerLon = wrapLon(rawLonCenter)
-                val enc = encode(centerLat.coerceIn(-90.0, 90.0), centerLon, p)
-                if (enc.isNotEmpty() && enc != geohash) neighbors.add(enc)
-            }
+    /**
+     * Morton code for a geohash string, or -1 if it is too long or has invalid characters
+     */
+    private fun fromBase32(geohash: String): Long {
+        if (geohash.length > MAX_PRECISION) return -1
+        var code = 0L
+        for (ch in geohash) {
+            val v = if (ch.code < 128) charToValue[ch.code] else -1
+            if (v < 0) return -1
+            code = (code shl 5) or v.toLong()
         }
-        return neighbors
+        return code
     }
 }
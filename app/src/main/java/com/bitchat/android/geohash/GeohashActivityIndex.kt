@@ -0,0 +1,150 @@
+package com.bitchat.android.geohash
+
+import com.bitchat.android.util.AppConstants
+import java.util.concurrent.atomic.AtomicInteger
+import java.util.concurrent.atomic.AtomicLong
+
+/**
+ * Shared index of locally seen geohash-tagged activity: channel messages, location notes
+ * and bookmarks, keyed by the geohash they were tagged with.
+ *
+ * Each feature still owns its own data; this only keeps per-cell counters in a
+ * [GeohashIndex] so questions like "how much happened inside this city" or "is there
+ * anything around this block" are prefix range queries instead of aggregations over
+ * every feature's map. People are indexed the same way by GeohashRepository.
+ *
+ * Bounded: cells without activity for ACTIVITY_MAX_AGE_MS are dropped unless bookmarked,
+ * and past MAX_CELLS the least recently active cells go first. Clock-injected for tests.
+ */
+class GeohashActivityIndex(
+    private val clock: () -> Long = System::currentTimeMillis,
+    private val maxCells: Int = AppConstants.Location.ACTIVITY_MAX_CELLS,
+    private val maxAgeMs: Long = AppConstants.Location.ACTIVITY_MAX_AGE_MS
+) {
+
+    class CellActivity {
+        val messages = AtomicInteger()
+        val notes = AtomicInteger()
+        val lastActivityMs = AtomicLong()
+        @Volatile var bookmarked = false
+
+        internal fun touch(atMs: Long) {
+            lastActivityMs.accumulateAndGet(atMs) { a, b -> maxOf(a, b) }
+        }
+
+        internal val hasActivity: Boolean get() = messages.get() > 0 || notes.get() > 0
+    }
+
+    data class Summary(
+        val messages: Int = 0,
+        val notes: Int = 0,
+        val bookmarks: Int = 0,
+        val activeCells: Int = 0,
+        val lastActivityMs: Long = 0L
+    )
+
+    companion object {
+        val shared: GeohashActivityIndex by lazy { GeohashActivityIndex() }
+    }
+
+    private val index = GeohashIndex<CellActivity>()
+    private val pruneLock = Any()
+
+    val size: Int get() = index.size
+
+    fun recordMessage(geohash: String, atMs: Long) {
+        if (geohash.isEmpty()) return
+        cell(geohash).apply {
+            messages.incrementAndGet()
+            touch(atMs)
+        }
+        pruneIfFull()
+    }
+
+    fun recordNote(geohash: String, atMs: Long) {
+        if (geohash.isEmpty()) return
+        cell(geohash).apply {
+            notes.incrementAndGet()
+            touch(atMs)
+        }
+        pruneIfFull()
+    }
+
+    fun setBookmarked(geohash: String, bookmarked: Boolean) {
+        if (geohash.isEmpty()) return
+        if (bookmarked) {
+            cell(geohash).bookmarked = true
+        } else {
+            val cell = index[geohash] ?: return
+            cell.bookmarked = false
+            if (!cell.hasActivity) index.remove(geohash)
+        }
+    }
+
+    /**
+     * Activity inside `prefix` (the cell and all finer cells), optionally only since `sinceMs`
+     */
+    fun summaryWithin(prefix: String, sinceMs: Long = 0L): Summary =
+        summarize(index.within(prefix).values, sinceMs)
+
+    /**
+     * Activity inside the cell and its 8 same-precision neighbours
+     */
+    fun neighborhoodSummary(geohash: String, sinceMs: Long = 0L): Summary =
+        summarize(index.withinNeighborhood(geohash).values, sinceMs)
+
+    /**
+     * Drop cells idle for longer than the max age (bookmarks stay), then the least recently
+     * active ones while over capacity
+     */
+    fun prune() {
+        synchronized(pruneLock) {
+            val cutoff = clock() - maxAgeMs
+            index.keys().toList().forEach { geohash ->
+                val cell = index[geohash] ?: return@forEach
+                if (cell.bookmarked) {
+                    // Keep the bookmark, forget its stale counters
+                    if (cell.hasActivity && cell.lastActivityMs.get() < cutoff) {
+                        cell.messages.set(0)
+                        cell.notes.set(0)
+                    }
+                } else if (cell.lastActivityMs.get() < cutoff) {
+                    index.remove(geohash)
+                }
+            }
+            val excess = index.size - maxCells
+            if (excess <= 0) return
+            index.within("").entries
+                .filter { !it.value.bookmarked }
+                .sortedBy { it.value.lastActivityMs.get() }
+                .take(excess)
+                .forEach { index.remove(it.key) }
+        }
+    }
+
+    fun clear() = index.clear()
+
+    private fun cell(geohash: String): CellActivity = index.getOrPut(geohash) { CellActivity() }
+
+    private fun pruneIfFull() {
+        if (index.size > maxCells) prune()
+    }
+
+    private fun summarize(cells: Collection<CellActivity>, sinceMs: Long): Summary {
+        var messages = 0
+        var notes = 0
+        var bookmarks = 0
+        var active = 0
+        var last = 0L
+        for (cell in cells) {
+            if (cell.bookmarked) bookmarks++
+            val at = cell.lastActivityMs.get()
+            if (at < sinceMs || !cell.hasActivity) continue
+            messages += cell.messages.get()
+            notes += cell.notes.get()
+            active++
+            if (at > last) last = at
+        }
+        return Summary(messages, notes, bookmarks, active, last)
+    }
+}
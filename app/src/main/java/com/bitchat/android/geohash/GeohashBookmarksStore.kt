@@ -7,6 +7,7 @@ import android.location.LocationManager
 import android.util.Log
 import androidx.lifecycle.LiveData
 import androidx.lifecycle.MutableLiveData
+import com.bitchat.android.util.WriteBehindWriter
 import com.google.gson.Gson
 import com.google.gson.reflect.TypeToken
 import kotlinx.coroutines.CoroutineScope
@@ -16,7 +17,7 @@ import java.util.Locale
 
 /**
  * Stores a user-maintained list of bookmarked geohash channels.
- * - Persistence: SharedPreferences (JSON string array)
+ * - Persistence: SharedPreferences (JSON string array), written behind on IO
  * - Semantics: geohashes are normalized to lowercase base32 and de-duplicated
  */
 class GeohashBookmarksStore private constructor(private val context: Context) {
@@ -43,6 +44,14 @@ class GeohashBookmarksStore private constructor(private val context: Context) {
 
     private val gson = Gson()
     private val prefs = context.getSharedPreferences("geohash_prefs", Context.MODE_PRIVATE)
+    // Snapshots are queued as-is and JSON-encoded when the batch commits on IO
+    private val writer = WriteBehindWriter<Any>("geohash_bookmarks") { batch ->
+        val editor = prefs.edit()
+        batch.forEach { (key, value) ->
+            if (value != null) editor.putString(key, gson.toJson(value)) else editor.remove(key)
+        }
+        if (!editor.commit()) throw IllegalStateException("geohash_prefs commit failed")
+    }
 
     private val membership = mutableSetOf<String>()
 
@@ -68,6 +77,7 @@ class GeohashBookmarksStore private constructor(private val context: Context) {
         val gh = normalize(geohash)
         if (gh.isEmpty() || membership.contains(gh)) return
         membership.add(gh)
+        GeohashActivityIndex.shared.setBookmarked(gh, true)
         val updated = listOf(gh) + (_bookmarks.value ?: emptyList())
         _bookmarks.postValue(updated)
         persist(updated)
@@ -79,6 +89,7 @@ class GeohashBookmarksStore private constructor(private val context: Context) {
         val gh = normalize(geohash)
         if (!membership.contains(gh)) return
         membership.remove(gh)
+        GeohashActivityIndex.shared.setBookmarked(gh, false)
         val updated = (_bookmarks.value ?: emptyList()).filterNot { it == gh }
         _bookmarks.postValue(updated)
         // Remove stored name to avoid stale cache growth
@@ -108,6 +119,7 @@ class GeohashBookmarksStore private constructor(private val context: Context) {
                     }
                 }
                 membership.clear(); membership.addAll(seen)
+                seen.forEach { GeohashActivityIndex.shared.setBookmarked(it, true) }
                 _bookmarks.postValue(ordered)
             }
         } catch (e: Exception) {
@@ -125,27 +137,15 @@ class GeohashBookmarksStore private constructor(private val context: Context) {
         }
     }
 
-    private fun persist() {
-        try {
-            val json = gson.toJson(_bookmarks.value ?: emptyList<String>())
-            prefs.edit().putString(STORE_KEY, json).apply()
-        } catch (_: Exception) {}
-    }
-
-    private fun persistNames() {
-        try {
-            val json = gson.toJson(_bookmarkNames.value ?: emptyMap<String, String>())
-            prefs.edit().putString(NAMES_STORE_KEY, json).apply()
-        } catch (_: Exception) {}
-    }
-
     // MARK: - Destructive Reset
 
     fun clearAll() {
         try {
+            membership.forEach { GeohashActivityIndex.shared.setBookmarked(it, false) }
             membership.clear()
             _bookmarks.postValue(emptyList())
             _bookmarkNames.postValue(emptyMap())
+            writer.discardPending()
             prefs.edit()
                 .remove(STORE_KEY)
                 .remove(NAMES_STORE_KEY)
@@ -234,16 +234,10 @@ class GeohashBookmarksStore private constructor(private val context: Context) {
     }
 
     private fun persist(list: List<String>) {
-        try {
-            val json = gson.toJson(list)
-            prefs.edit().putString(STORE_KEY, json).apply()
-        } catch (_: Exception) {}
+        writer.put(STORE_KEY, list.toList())
     }
 
     private fun persistNames(map: Map<String, String>) {
-        try {
-            val json = gson.toJson(map)
-            prefs.edit().putString(NAMES_STORE_KEY, json).apply()
-        } catch (_: Exception) {}
+        writer.put(NAMES_STORE_KEY, map.toMap())
     }
 }
@@ -0,0 +1,85 @@
+package com.bitchat.android.geohash
+
+/**
+ * Tracks the geohash cell the user is in, with hysteresis against border flapping.
+ *
+ * Every coarser channel level is a prefix of the cell at [precision], so one tracked cell
+ * decides whether any level changed. A fix in a different cell is accepted when it lies
+ * at least [marginFraction] of a cell beyond the committed cell's edge, or once
+ * [confirmFixes] consecutive fixes land in that same new cell. Jitter along a border
+ * therefore keeps the committed cell instead of alternating between two.
+ *
+ * Not thread-safe; callers serialize access.
+ */
+class GeohashCellTracker(
+    val precision: Int,
+    private val marginFraction: Double,
+    private val confirmFixes: Int
+) {
+    var committed: String? = null
+        private set
+
+    private var pending: String? = null
+    private var pendingCount = 0
+
+    /**
+     * True while fixes point at a different cell that has not been confirmed yet
+     */
+    val hasPendingChange: Boolean get() = pending != null
+
+    /**
+     * Feed a fix; returns the newly committed cell, or null if the committed cell is unchanged
+     */
+    fun update(latitude: Double, longitude: Double): String? {
+        val cell = Geohash.encode(latitude, longitude, precision)
+        val current = committed
+        if (current == null || cell != current && isBeyondMargin(current, latitude, longitude)) {
+            commit(cell)
+            return cell
+        }
+        if (cell == current) {
+            pending = null
+            pendingCount = 0
+            return null
+        }
+        if (cell == pending) {
+            pendingCount++
+        } else {
+            pending = cell
+            pendingCount = 1
+        }
+        if (pendingCount >= confirmFixes) {
+            commit(cell)
+            return cell
+        }
+        return null
+    }
+
+    fun reset() {
+        committed = null
+        pending = null
+        pendingCount = 0
+    }
+
+    private fun commit(cell: String) {
+        committed = cell
+        pending = null
+        pendingCount = 0
+    }
+
+    private fun isBeyondMargin(cell: String, latitude: Double, longitude: Double): Boolean {
+        val b = Geohash.decodeToBounds(cell)
+        val latOutside = maxOf(b.latMin - latitude, latitude - b.latMax, 0.0)
+        // Shortest way around for cells touching the antimeridian
+        val lonOutside = minOf(
+            lonDistance(b, longitude),
+            lonDistance(b, longitude + 360.0),
+            lonDistance(b, longitude - 360.0)
+        )
+        return latOutside >= (b.latMax - b.latMin) * marginFraction ||
+            lonOutside >= (b.lonMax - b.lonMin) * marginFraction
+    }
+
+    private fun lonDistance(b: Geohash.Bounds, longitude: Double): Double =
+        maxOf(b.lonMin - longitude, longitude - b.lonMax, 0.0)
+}
@@ -0,0 +1,69 @@
+package com.bitchat.android.geohash
+
+import java.util.NavigableMap
+import java.util.concurrent.ConcurrentSkipListMap
+
+/**
+ * Geohash-keyed map ordered along the Morton curve.
+ *
+ * The base32 geohash alphabet is in ASCII order, so sorting keys as strings sorts cells by
+ * Morton code and every cell's descendants form one contiguous key range. "Everything
+ * inside this city/neighbourhood/block" is a range scan bounded by the prefix rather than
+ * a walk over all entries, and zooming between [GeohashChannelLevel]s is just a shorter or
+ * longer prefix.
+ *
+ * Keys are normalized to lowercase. Thread-safe; range views are weakly consistent.
+ */
+class GeohashIndex<V : Any> {
+
+    private val entries = ConcurrentSkipListMap<String, V>()
+
+    val size: Int get() = entries.size
+
+    operator fun get(geohash: String): V? = entries[geohash.lowercase()]
+
+    fun put(geohash: String, value: V): V? = entries.put(geohash.lowercase(), value)
+
+    fun getOrPut(geohash: String, create: () -> V): V {
+        val key = geohash.lowercase()
+        entries[key]?.let { return it }
+        val created = create()
+        return entries.putIfAbsent(key, created) ?: created
+    }
+
+    fun remove(geohash: String): V? = entries.remove(geohash.lowercase())
+
+    fun keys(): Set<String> = entries.keys
+
+    fun clear() = entries.clear()
+
+    /**
+     * Entries for `prefix` itself and every finer cell inside it (empty prefix = everything)
+     */
+    fun within(prefix: String): NavigableMap<String, V> {
+        val from = prefix.lowercase()
+        if (from.isEmpty()) return entries
+        // '~' sorts after every base32 character
+        return entries.subMap(from, true, "$from~", false)
+    }
+
+    /**
+     * Entries inside the cell or any of its 8 same-precision neighbours
+     */
+    fun withinNeighborhood(geohash: String): Map<String, V> {
+        val cell = geohash.lowercase()
+        val result = LinkedHashMap<String, V>()
+        result.putAll(within(cell))
+        Geohash.neighborsSamePrecision(cell).forEach { result.putAll(within(it)) }
+        return result
+    }
+
+    /**
+     * Fold the entries inside `prefix` without materializing them
+     */
+    inline fun <R> foldWithin(prefix: String, initial: R, operation: (acc: R, geohash: String, value: V) -> R): R {
+        var acc = initial
+        for ((key, value) in within(prefix)) acc = operation(acc, key, value)
+        return acc
+    }
+}
@@ -16,6 +16,7 @@ import kotlinx.coroutines.*
 import java.util.*
 import com.google.gson.Gson
 import com.google.gson.JsonSyntaxException
+import com.bitchat.android.util.AppConstants
 
 /**
  * Manages location permissions, one-shot location retrieval, and computing geohash channels.
@@ -52,6 +53,23 @@ class LocationChannelManager private constructor(private val context: Context) {
     private val gson = Gson()
     private var dataManager: com.bitchat.android.ui.DataManager? = null
 
+    // Committed building-level cell; every channel level is a prefix of it
+    private val cellTracker = GeohashCellTracker(
+        precision = GeohashChannelLevel.BUILDING.precision,
+        marginFraction = AppConstants.Location.CELL_HYSTERESIS_MARGIN,
+        confirmFixes = AppConstants.Location.CELL_CONFIRM_FIXES
+    )
+    // Consecutive fixes that left every channel level unchanged
+    @Volatile private var stationaryFixes = 0
+
+    // Reverse-geocoded names per block-level cell (LRU), so moving back and forth
+    // between cells does not hit the Geocoder again
+    private val geocodeCache = object : LinkedHashMap<String, Map<GeohashChannelLevel, String>>(16, 0.75f, true) {
+        override fun removeEldestEntry(eldest: MutableMap.MutableEntry<String, Map<GeohashChannelLevel, String>>?): Boolean =
+            size > AppConstants.Location.GEOCODE_CACHE_SIZE
+    }
+    @Volatile private var publishedNamesCell: String? = null
+
     // Published state for UI bindings (matching iOS @Published properties)
     private val _permissionState = MutableLiveData(PermissionState.NOT_DETERMINED)
     val permissionState: LiveData<PermissionState> = _permissionState
@@ -126,9 +144,10 @@ class LocationChannelManager private constructor(private val context: Context) {
     }
 
     /**
-     * Begin periodic one-shot location refreshes while a selector UI is visible
+     * Begin periodic one-shot location refreshes while a selector UI is visible.
+     * The interval doubles (up to REFRESH_MAX_INTERVAL_MS) while the user stays in the same cell.
      */
-    fun beginLiveRefresh(interval: Long = 5000L) {
+    fun beginLiveRefresh(interval: Long = AppConstants.Location.REFRESH_INTERVAL_MS) {
         Log.d(TAG, "Beginning live refresh with interval ${interval}ms")
         
         if (_permissionState.value != PermissionState.AUTHORIZED) {
@@ -146,16 +165,22 @@ class LocationChannelManager private constructor(private val context: Context) {
         
         // Start new timer with coroutines
         refreshTimer = CoroutineScope(Dispatchers.IO).launch {
+            // Kick off immediately
+            requestOneShotLocation()
             while (isActive) {
+                delay(refreshInterval(interval))
                 if (isLocationServicesEnabled()) {
                     requestOneShotLocation()
                 }
-                delay(interval)
             }
         }
-        
-        // Kick off immediately
-        requestOneShotLocation()
+    }
+
+    private fun isStationary(): Boolean = stationaryFixes >= AppConstants.Location.STATIONARY_FIXES
+
+    private fun refreshInterval(base: Long): Long {
+        val steps = (stationaryFixes - AppConstants.Location.STATIONARY_FIXES + 1).coerceIn(0, 6)
+        return (base shl steps).coerceAtMost(maxOf(base, AppConstants.Location.REFRESH_MAX_INTERVAL_MS))
     }
 
     /**
@@ -176,18 +201,14 @@ class LocationChannelManager private constructor(private val context: Context) {
         _selectedChannel.value = channel
         saveChannelSelection(channel)
 
-        // Immediately recompute teleported status against the latest known location
-        lastLocation?.let { location ->
+        // Immediately recompute teleported status against the latest committed cell
+        currentCell()?.let { cell ->
             when (channel) {
                 is ChannelID.Mesh -> {
                     _teleported.postValue(false)
                 }
                 is ChannelID.Location -> {
-                    val currentGeohash = Geohash.encode(
-                        latitude = location.latitude,
-                        longitude = location.longitude,
-                        precision = channel.channel.level.precision
-                    )
+                    val currentGeohash = cell.take(channel.channel.level.precision)
                     val isTeleportedNow = currentGeohash != channel.channel.geohash
                     _teleported.postValue(isTeleportedNow)
                     Log.d(TAG, "Teleported (immediate recompute): $isTeleportedNow (current: $currentGeohash, selected: ${channel.channel.geohash})")
@@ -230,6 +251,7 @@ class LocationChannelManager private constructor(private val context: Context) {
         endLiveRefresh()
         
         // Clear available channels when location is disabled
+        resetCellTracking()
         _availableChannels.postValue(emptyList())
         _locationNames.postValue(emptyMap())
         
@@ -279,10 +301,8 @@ class LocationChannelManager private constructor(private val context: Context) {
             // Use last known location if we have one
             if (lastKnownLocation != null) {
                 Log.d(TAG, "Using last known location: ${lastKnownLocation.latitude}, ${lastKnownLocation.longitude}")
-                lastLocation = lastKnownLocation
                 _isLoadingLocation.postValue(false) // Make sure loading state is off
-                computeChannels(lastKnownLocation)
-                reverseGeocodeIfNeeded(lastKnownLocation)
+                onLocationFix(lastKnownLocation)
             } else {
                 Log.d(TAG, "No last known location available")
                 // Set loading state to true so UI can show a spinner
@@ -303,9 +323,7 @@ class LocationChannelManager private constructor(private val context: Context) {
     private val oneShotLocationListener = object : LocationListener {
         override fun onLocationChanged(location: Location) {
             Log.d(TAG, "Fresh location received: ${location.latitude}, ${location.longitude}")
-            lastLocation = location
-            computeChannels(location)
-            reverseGeocodeIfNeeded(location)
+            onLocationFix(location)
             
             // Update loading state to indicate we have a location now
             _isLoadingLocation.postValue(false)
@@ -330,12 +348,20 @@ class LocationChannelManager private constructor(private val context: Context) {
             // Set loading state to true to indicate we're actively trying to get a location
             _isLoadingLocation.postValue(true)
             
-            // Try common providers in order of preference
-            val providers = listOf(
-                LocationManager.GPS_PROVIDER,
-                LocationManager.NETWORK_PROVIDER,
-                LocationManager.PASSIVE_PROVIDER
-            )
+            // Try common providers in order of preference; a stationary user does not need GPS
+            val providers = if (isStationary()) {
+                listOf(
+                    LocationManager.NETWORK_PROVIDER,
+                    LocationManager.PASSIVE_PROVIDER,
+                    LocationManager.GPS_PROVIDER
+                )
+            } else {
+                listOf(
+                    LocationManager.GPS_PROVIDER,
+                    LocationManager.NETWORK_PROVIDER,
+                    LocationManager.PASSIVE_PROVIDER
+                )
+            }
             
             var providerFound = false
             for (provider in providers) {
@@ -351,9 +377,7 @@ class LocationChannelManager private constructor(private val context: Context) {
                             { location ->
                                 if (location != null) {
                                     Log.d(TAG, "Fresh location received: ${location.latitude}, ${location.longitude}")
-                                    lastLocation = location
-                                    computeChannels(location)
-                                    reverseGeocodeIfNeeded(location)
+                                    onLocationFix(location)
                                 } else {
                                     Log.w(TAG, "Received null location from getCurrentLocation")
                                 }
@@ -416,18 +440,46 @@ class LocationChannelManager private constructor(private val context: Context) {
                ActivityCompat.checkSelfPermission(context, Manifest.permission.ACCESS_COARSE_LOCATION) == PackageManager.PERMISSION_GRANTED
     }
 
-    private fun computeChannels(location: Location) {
-        Log.d(TAG, "Computing channels for location: ${location.latitude}, ${location.longitude}")
+    /**
+     * Single entry point for every location fix. Channels, teleport state and names are only
+     * recomputed when the hysteresis-filtered building cell changes, so downstream
+     * re-subscriptions and geocoding happen on real cell changes rather than on every poll.
+     */
+    private fun onLocationFix(location: Location) {
+        val changedCell = synchronized(cellTracker) {
+            lastLocation = location
+            val cell = cellTracker.update(location.latitude, location.longitude)
+            stationaryFixes = when {
+                cell != null || cellTracker.hasPendingChange -> 0
+                else -> stationaryFixes + 1
+            }
+            cell
+        }
+        if (changedCell != null) {
+            Log.d(TAG, "Cell changed to $changedCell")
+            computeChannels(changedCell)
+        }
+        reverseGeocodeIfNeeded(location)
+    }
+
+    private fun currentCell(): String? = synchronized(cellTracker) { cellTracker.committed }
+
+    private fun resetCellTracking() {
+        synchronized(cellTracker) {
+            cellTracker.reset()
+            stationaryFixes = 0
+        }
+        synchronized(geocodeCache) { publishedNamesCell = null }
+    }
+
+    private fun computeChannels(cell: String) {
+        Log.d(TAG, "Computing channels for cell: $cell")
         
         val levels = GeohashChannelLevel.allCases()
         val result = mutableListOf<GeohashChannel>()
         
         for (level in levels) {
-            val geohash = Geohash.encode(
-                latitude = location.latitude,
-                longitude = location.longitude,
-                precision = level.precision
-            )
+            val geohash = cell.take(level.precision)
             result.add(GeohashChannel(level = level, geohash = geohash))
             
             Log.v(TAG, "Generated ${level.displayName}: $geohash")
@@ -435,18 +487,14 @@ class LocationChannelManager private constructor(private val context: Context) {
         
         _availableChannels.postValue(result)
         
-        // Recompute teleported status based on current location vs selected channel
+        // Recompute teleported status based on current cell vs selected channel
         val selectedChannelValue = _selectedChannel.value
         when (selectedChannelValue) {
             is ChannelID.Mesh -> {
                 _teleported.postValue(false)
             }
             is ChannelID.Location -> {
-                val currentGeohash = Geohash.encode(
-                    latitude = location.latitude,
-                    longitude = location.longitude,
-                    precision = selectedChannelValue.channel.level.precision
-                )
+                val currentGeohash = cell.take(selectedChannelValue.channel.level.precision)
                 val isTeleported = currentGeohash != selectedChannelValue.channel.geohash
                 _teleported.postValue(isTeleported)
                 Log.d(TAG, "Teleported status: $isTeleported (current: $currentGeohash, selected: ${selectedChannelValue.channel.geohash})")
@@ -458,6 +506,19 @@ class LocationChannelManager private constructor(private val context: Context) {
     }
 
     private fun reverseGeocodeIfNeeded(location: Location) {
+        // Names never go below block level, so one lookup serves the whole block
+        val cell = currentCell()?.take(GeohashChannelLevel.BLOCK.precision) ?: return
+        val cached = synchronized(geocodeCache) {
+            if (cell == publishedNamesCell) return
+            geocodeCache[cell]
+        }
+        if (cached != null) {
+            Log.d(TAG, "Using cached location names for $cell")
+            publishedNamesCell = cell
+            _locationNames.postValue(cached)
+            return
+        }
+
         if (!Geocoder.isPresent()) {
             Log.w(TAG, "Geocoder not present on this device")
             return
@@ -482,10 +543,14 @@ class LocationChannelManager private constructor(private val context: Context) {
                     val names = namesByLevel(address)
                     
                     Log.d(TAG, "Reverse geocoding result: $names")
+                    synchronized(geocodeCache) { geocodeCache[cell] = names }
                     _locationNames.postValue(names)
                 } else {
                     Log.w(TAG, "No reverse geocoding results")
+                    synchronized(geocodeCache) { geocodeCache[cell] = emptyMap() }
+                    _locationNames.postValue(emptyMap())
                 }
+                publishedNamesCell = cell
             } catch (e: Exception) {
                 Log.e(TAG, "Reverse geocoding failed: ${e.message}")
             } finally {
@@ -667,6 +732,7 @@ class LocationChannelManager private constructor(private val context: Context) {
     fun cleanup() {
         Log.d(TAG, "Cleaning up LocationChannelManager")
         endLiveRefresh()
+        resetCellTracking()
         
         // For older Android versions, remove any remaining location listener to prevent memory leaks
         if (android.os.Build.VERSION.SDK_INT < android.os.Build.VERSION_CODES.R) {
@@ -24,26 +24,45 @@ class SecureIdentityStateManager(private val context: Context) {
         private const val KEY_STATIC_PUBLIC_KEY = "static_public_key"
         private const val KEY_SIGNING_PRIVATE_KEY = "signing_private_key"
         private const val KEY_SIGNING_PUBLIC_KEY = "signing_public_key"
-    }
-    
-    private val prefs: SharedPreferences
-    
-    init {
-        // Create master key for encryption
-        val masterKey = MasterKey.Builder(context, MasterKey.DEFAULT_MASTER_KEY_ALIAS)
-            .setKeyScheme(MasterKey.KeyScheme.AES256_GCM)
-            .build()
         
-        // Create encrypted shared preferences
-        prefs = EncryptedSharedPreferences.create(
-            context,
-            PREFS_NAME,
-            masterKey,
-            EncryptedSharedPreferences.PrefKeyEncryptionScheme.AES256_SIV,
-            EncryptedSharedPreferences.PrefValueEncryptionScheme.AES256_GCM
-        )
+        // One EncryptedSharedPreferences per process: creating it costs keystore round-trips,
+        // and many components construct their own SecureIdentityStateManager
+        @Volatile
+        private var sharedPrefs: SharedPreferences? = null
+        
+        private fun encryptedPrefs(context: Context): SharedPreferences {
+            sharedPrefs?.let { return it }
+            return synchronized(this) {
+                sharedPrefs ?: createEncryptedPrefs(context.applicationContext).also { sharedPrefs = it }
+            }
+        }
+        
+        private fun createEncryptedPrefs(context: Context): SharedPreferences {
+            // Create master key for encryption
+            val masterKey = MasterKey.Builder(context, MasterKey.DEFAULT_MASTER_KEY_ALIAS)
+                .setKeyScheme(MasterKey.KeyScheme.AES256_GCM)
+                .build()
+            
+            // Create encrypted shared preferences
+            return EncryptedSharedPreferences.create(
+                context,
+                PREFS_NAME,
+                masterKey,
+                EncryptedSharedPreferences.PrefKeyEncryptionScheme.AES256_SIV,
+                EncryptedSharedPreferences.PrefValueEncryptionScheme.AES256_GCM
+            )
+        }
+        
+        /**
+         * Open secure storage ahead of first use (called off the main thread at startup)
+         */
+        fun warmUp(context: Context) {
+            encryptedPrefs(context)
+        }
     }
     
+    private val prefs: SharedPreferences by lazy { encryptedPrefs(context) }
+    
     // MARK: - Static Key Management
     
     /**
@@ -292,6 +311,27 @@ class SecureIdentityStateManager(private val context: Context) {
         prefs.edit().remove(key).apply()
     }
     
+    /**
+     * Write a batch of values in one synchronous commit; a null value removes the key.
+     * For write-behind callers already off the main thread.
+     */
+    fun writeSecureValues(values: Map<String, String?>) {
+        val editor = prefs.edit()
+        values.forEach { (key, value) ->
+            if (value != null) editor.putString(key, value) else editor.remove(key)
+        }
+        if (!editor.commit()) throw IllegalStateException("Secure preferences commit failed")
+    }
+    
+    /**
+     * All string values whose key starts with the given prefix
+     */
+    fun getSecureValuesWithPrefix(prefix: String): Map<String, String> {
+        return prefs.all.entries
+            .filter { it.key.startsWith(prefix) && it.value is String }
+            .associate { it.key to it.value as String }
+    }
+    
     /**
      * Check if a key exists in secure preferences
      */
@@ -39,6 +39,7 @@ class BluetoothMeshService(private val context: Context) {
     companion object {
         private const val TAG = "BluetoothMeshService"
         private val MAX_TTL: UByte = com.bitchat.android.util.AppConstants.MESSAGE_TTL_HOPS
+        private val LOCAL_CAPABILITIES: Long = com.bitchat.android.model.PeerCapability.toBitmask(com.bitchat.android.model.PeerCapability.LOCAL)
     }
     
     // Core components - each handling specific responsibilities
@@ -51,6 +52,9 @@ class BluetoothMeshService(private val context: Context) {
     private val securityManager = SecurityManager(encryptionService, myPeerID)
     private val storeForwardManager = StoreForwardManager()
     private val messageHandler = MessageHandler(myPeerID, context.applicationContext)
+    // Last identity binding per peerID, so repeated announces skip the persistence writes
+    private val peerBindings = java.util.concurrent.ConcurrentHashMap<String, String>()
+    private val fileStreamManager = FileStreamManager(context.applicationContext, myPeerID)
     internal val connectionManager = BluetoothConnectionManager(context, myPeerID, fragmentManager) // Made internal for access
     private val packetProcessor = PacketProcessor(myPeerID)
     private lateinit var gossipSyncManager: GossipSyncManager
@@ -67,6 +71,7 @@ class BluetoothMeshService(private val context: Context) {
     init {
         setupDelegates()
         messageHandler.packetProcessor = packetProcessor
+        messageHandler.fileStreamManager = fileStreamManager
         //startPeriodicDebugLogging()
 
         // Initialize sync manager (needs serviceScope)
@@ -212,6 +217,25 @@ class BluetoothMeshService(private val context: Context) {
             }
         }
         
+        // FileStreamManager delegates
+        fileStreamManager.delegate = object : FileStreamManagerDelegate {
+            override fun getHandshakeHash(peerID: String): ByteArray? {
+                return encryptionService.getHandshakeHash(peerID)
+            }
+            
+            override fun useBulkReplayWindow(peerID: String) {
+                encryptionService.useBulkReplayWindow(peerID)
+            }
+            
+            override fun encryptForPeer(data: ByteArray, recipientPeerID: String): ByteArray? {
+                return securityManager.encryptForPeer(data, recipientPeerID)
+            }
+            
+            override fun sendPacket(packet: BitchatPacket) {
+                connectionManager.broadcastPacket(RoutedPacket(signPacketBeforeBroadcast(packet)))
+            }
+        }
+        
         // MessageHandler delegates
         messageHandler.delegate = object : MessageHandlerDelegate {
             // Peer management
@@ -247,6 +271,10 @@ class BluetoothMeshService(private val context: Context) {
                 return peerManager.updatePeerInfo(peerID, nickname, noisePublicKey, signingPublicKey, isVerified)
             }
             
+            override fun updatePeerCapabilities(peerID: String, capabilities: Long) {
+                peerManager.updatePeerCapabilities(peerID, capabilities)
+            }
+            
             // Packet operations
             override fun sendPacket(packet: BitchatPacket) {
                 // Sign the packet before broadcasting
@@ -329,6 +357,14 @@ class BluetoothMeshService(private val context: Context) {
                 // Update peer mapping in the PeerManager for peer ID rotation support
                 peerManager.addOrUpdatePeer(newPeerID, nickname)
                 
+                val binding = "${publicKey.toHexString()}|$nickname"
+                val unchanged = peerBindings.put(newPeerID, binding) == binding
+                previousPeerID?.let { peerBindings.remove(it) }
+                if (unchanged && previousPeerID == null && peerManager.hasFingerprintForPeer(newPeerID)) {
+                    // Same key and nickname as last time: fingerprint and Nostr index are already current
+                    return
+                }
+
                 // Store fingerprint for the peer via centralized fingerprint manager
                 val fingerprint = peerManager.storeFingerprintForPeer(newPeerID, publicKey)
 
@@ -368,6 +404,10 @@ class BluetoothMeshService(private val context: Context) {
             override fun onReadReceiptReceived(messageID: String, peerID: String) {
                 delegate?.didReceiveReadReceipt(messageID, peerID)
             }
+            
+            override fun onReadUpToReceived(messageID: String, peerID: String) {
+                delegate?.didReceiveReadUpTo(messageID, peerID)
+            }
         }
         
         // PacketProcessor delegates
@@ -401,6 +441,10 @@ class BluetoothMeshService(private val context: Context) {
                 serviceScope.launch { messageHandler.handleNoiseEncrypted(routed) }
             }
             
+            override fun handleFileStreamRecord(routed: RoutedPacket) {
+                serviceScope.launch { messageHandler.handleFileStreamRecord(routed) }
+            }
+            
             override fun handleAnnounce(routed: RoutedPacket) {
                 serviceScope.launch {
                     // Process the announce
@@ -579,6 +623,7 @@ class BluetoothMeshService(private val context: Context) {
             securityManager.shutdown()
             storeForwardManager.shutdown()
             messageHandler.shutdown()
+            fileStreamManager.shutdown()
             packetProcessor.shutdown()
             
             serviceScope.cancel()
@@ -588,7 +633,7 @@ class BluetoothMeshService(private val context: Context) {
     /**
      * Send public message
      */
-    fun sendMessage(content: String, mentions: List<String> = emptyList(), channel: String? = null) {
+    fun sendMessage(content: String, mentions: List<String> = emptyList(), channel: String? = null, ttl: UByte = MAX_TTL) {
         if (content.isEmpty()) return
         
         serviceScope.launch {
@@ -600,7 +645,7 @@ class BluetoothMeshService(private val context: Context) {
                 timestamp = System.currentTimeMillis().toULong(),
                 payload = content.toByteArray(Charsets.UTF_8),
                 signature = null,
-                ttl = MAX_TTL
+                ttl = ttl
             )
 
             // Sign the packet before broadcasting
@@ -647,7 +692,9 @@ class BluetoothMeshService(private val context: Context) {
     }
 
     /**
-     * Send a file as an encrypted private message using Noise protocol
+     * Send a file as an encrypted private message using Noise protocol.
+     * Large files to peers advertising FILE_STREAM go as chunked AEAD records
+     * (see FileStreamManager); everything else uses a single Noise message.
      */
     fun sendFilePrivate(recipientPeerID: String, file: com.bitchat.android.model.BitchatFilePacket) {
         try {
@@ -665,6 +712,15 @@ class BluetoothMeshService(private val context: Context) {
                         }
                         Log.d(TAG, "📦 Encoded file TLV: ${filePayload.size} bytes")
                         
+                        // Progress ID must match the one MediaSendingManager derives from the file TLV
+                        val transferId = sha256Hex(filePayload)
+                        if (FileStreamManager.shouldStream(file) &&
+                            peerManager.peerSupports(recipientPeerID, com.bitchat.android.model.PeerCapability.FILE_STREAM) &&
+                            fileStreamManager.sendFile(recipientPeerID, file, transferId)) {
+                            Log.d(TAG, "✅ Streaming encrypted file to $recipientPeerID")
+                            return@launch
+                        }
+                        
                         // Create NoisePayload wrapper (type byte + file TLV data) - same as iOS
                         val noisePayload = com.bitchat.android.model.NoisePayload(
                             type = com.bitchat.android.model.NoisePayloadType.FILE_TRANSFER,
@@ -693,8 +749,6 @@ class BluetoothMeshService(private val context: Context) {
                         
                         // Sign and send the encrypted packet
                         val signed = signPacketBeforeBroadcast(packet)
-                        // Use a stable transferId based on the unencrypted file TLV payload for progress tracking
-                        val transferId = sha256Hex(filePayload)
                         connectionManager.broadcastPacket(RoutedPacket(signed, transferId = transferId))
                         Log.d(TAG, "✅ Sent encrypted file to $recipientPeerID")
                         
@@ -714,7 +768,7 @@ class BluetoothMeshService(private val context: Context) {
     }
 
     fun cancelFileTransfer(transferId: String): Boolean {
-        return connectionManager.cancelTransfer(transferId)
+        return fileStreamManager.cancelOutgoing(transferId) || connectionManager.cancelTransfer(transferId)
     }
 
     // Local helper to hash payloads to a stable hex ID for progress mapping
@@ -844,10 +898,11 @@ class BluetoothMeshService(private val context: Context) {
     /**
      * Send read receipt for a received private message - NEW NoisePayloadType implementation
      * Uses same encryption approach as iOS SimplifiedBluetoothService
+     * With `upTo` the receipt is a READ_UP_TO covering earlier messages too (READ_UP_TO peers only)
      */
-    fun sendReadReceipt(messageID: String, recipientPeerID: String, readerNickname: String) {
+    fun sendReadReceipt(messageID: String, recipientPeerID: String, readerNickname: String, upTo: Boolean = false) {
         serviceScope.launch {
-            Log.d(TAG, "📖 Sending read receipt for message $messageID to $recipientPeerID")
+            Log.d(TAG, "📖 Sending read receipt for message $messageID to $recipientPeerID${if (upTo) " (up to)" else ""}")
             
             // Route geohash read receipts via MessageRouter instead of here
             val geo = runCatching { com.bitchat.android.services.MessageRouter.tryGetInstance() }.getOrNull()
@@ -863,7 +918,7 @@ class BluetoothMeshService(private val context: Context) {
             try {
                 // Create read receipt payload using NoisePayloadType exactly like iOS
                 val readReceiptPayload = com.bitchat.android.model.NoisePayload(
-                    type = com.bitchat.android.model.NoisePayloadType.READ_RECEIPT,
+                    type = if (upTo) com.bitchat.android.model.NoisePayloadType.READ_UP_TO else com.bitchat.android.model.NoisePayloadType.READ_RECEIPT,
                     data = messageID.toByteArray(Charsets.UTF_8)
                 )
                 
@@ -893,6 +948,19 @@ class BluetoothMeshService(private val context: Context) {
         }
     }
     
+    /**
+     * Send our favorite/nickname/npub state to a peer that supports PEER_STATE.
+     * Returns false when the peer needs the legacy "[FAVORITED]" private message instead.
+     */
+    fun syncPeerState(peerID: String): Boolean = messageHandler.syncPeerState(peerID)
+
+    /**
+     * Schedule a state sync with every active peer, e.g. after a nickname change
+     */
+    fun syncPeerStateWithAll() {
+        peerManager.getActivePeerIDs().forEach { messageHandler.syncPeerState(it) }
+    }
+    
     /**
      * Send broadcast announce with TLV-encoded identity announcement - exactly like iOS
      */
@@ -916,7 +984,7 @@ class BluetoothMeshService(private val context: Context) {
             }
             
             // Create iOS-compatible IdentityAnnouncement with TLV encoding
-            val announcement = IdentityAnnouncement(nickname, staticKey, signingKey)
+            val announcement = IdentityAnnouncement(nickname, staticKey, signingKey, LOCAL_CAPABILITIES)
             val tlvPayload = announcement.encode()
             if (tlvPayload == null) {
                 Log.e(TAG, "Failed to encode announcement as TLV")
@@ -936,6 +1004,7 @@ class BluetoothMeshService(private val context: Context) {
             } ?: announcePacket
             
             connectionManager.broadcastPacket(RoutedPacket(signedPacket))
+            com.bitchat.android.services.StartupCoordinator.mark("first_announce")
             Log.d(TAG, "Sent iOS-compatible signed TLV announce (${tlvPayload.size} bytes)")
             // Track announce for sync
             try { gossipSyncManager.onPublicPacketSeen(signedPacket) } catch (_: Exception) { }
@@ -965,7 +1034,7 @@ class BluetoothMeshService(private val context: Context) {
         }
         
         // Create iOS-compatible IdentityAnnouncement with TLV encoding
-        val announcement = IdentityAnnouncement(nickname, staticKey, signingKey)
+        val announcement = IdentityAnnouncement(nickname, staticKey, signingKey, LOCAL_CAPABILITIES)
         val tlvPayload = announcement.encode()
         if (tlvPayload == null) {
             Log.e(TAG, "Failed to encode peer announcement as TLV")
@@ -1133,7 +1202,11 @@ class BluetoothMeshService(private val context: Context) {
             appendLine()
             appendLine(messageHandler.getDebugInfo())
             appendLine()
+            appendLine(fileStreamManager.getDebugInfo())
+            appendLine()
             appendLine(packetProcessor.getDebugInfo())
+            appendLine()
+            appendLine(com.bitchat.android.services.StartupCoordinator.getDebugInfo())
         }
     }
     
@@ -1199,6 +1272,8 @@ class BluetoothMeshService(private val context: Context) {
             securityManager.clearAllData()
             peerManager.clearAllPeers()
             peerManager.clearAllFingerprints()
+            peerBindings.clear()
+            messageHandler.clearPeerState()
             Log.d(TAG, "✅ Cleared all mesh service internal data")
         } catch (e: Exception) {
             Log.e(TAG, "❌ Error clearing mesh service internal data: ${e.message}")
@@ -1229,6 +1304,8 @@ interface BluetoothMeshDelegate {
     fun didReceiveChannelLeave(channel: String, fromPeer: String)
     fun didReceiveDeliveryAck(messageID: String, recipientPeerID: String)
     fun didReceiveReadReceipt(messageID: String, recipientPeerID: String)
+    fun didReceiveReadUpTo(messageID: String, recipientPeerID: String)
+    fun didFailToDeliver(messageID: String, recipientPeerID: String, reason: String)
     fun decryptChannelMessage(encryptedContent: ByteArray, channel: String): String?
     fun getNickname(): String?
     fun isFavorite(peerID: String): Boolean
@@ -156,7 +156,7 @@ class BluetoothPacketBroadcaster(
                         if (transferId != null && transferJobs[transferId]?.isCancelled == true) return@launch
                         broadcastSinglePacket(RoutedPacket(fragment, transferId = transferId), gattServer, characteristic)
                         // 20ms delay between fragments
-                        delay(20)
+                        delay(com.bitchat.android.util.AppConstants.Fragmentation.INTER_FRAGMENT_DELAY_MS)
                         if (transferId != null) {
                             sent += 1
                             TransferProgressManager.progress(transferId, sent, fragments.size)
@@ -0,0 +1,55 @@
+package com.bitchat.android.mesh
+
+import com.bitchat.android.util.AppConstants
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+
+/**
+ * Collects delivery ACKs per sender for a short window and hands them on as one batch.
+ *
+ * The first ACK for a peer opens its window; the batch goes out when the window closes
+ * or when it reaches `maxIds`, whichever comes first. A store-and-forward flush of N
+ * messages then costs about N / maxIds encrypted, signed, routed packets instead of N.
+ */
+class DeliveryAckBatcher(
+    private val scope: CoroutineScope,
+    private val windowMs: Long = AppConstants.Mesh.ACK_BATCH_WINDOW_MS,
+    private val maxIds: Int = AppConstants.Mesh.ACK_BATCH_MAX_IDS,
+    private val send: suspend (peerID: String, messageIDs: List<String>) -> Unit
+) {
+    private class Window {
+        val ids = LinkedHashSet<String>()
+    }
+
+    private val open = HashMap<String, Window>()
+
+    fun add(peerID: String, messageID: String) {
+        val full = synchronized(open) {
+            val window = open[peerID] ?: Window().also { window ->
+                open[peerID] = window
+                scope.launch {
+                    delay(windowMs)
+                    close(peerID, window)?.let { send(peerID, it) }
+                }
+            }
+            window.ids.add(messageID)
+            if (window.ids.size >= maxIds) close(peerID, window) else null
+        }
+        if (full != null) scope.launch { send(peerID, full) }
+    }
+
+    /**
+     * Drop pending ACKs, e.g. on panic or shutdown
+     */
+    fun clear() {
+        synchronized(open) { open.clear() }
+    }
+
+    // Null when the window was already closed (it filled up before its timer ran)
+    private fun close(peerID: String, window: Window): List<String>? = synchronized(open) {
+        if (open[peerID] !== window) return null
+        open.remove(peerID)
+        window.ids.toList()
+    }
+}
@@ -0,0 +1,433 @@
+package com.bitchat.android.mesh
+
+import android.content.Context
+import android.util.Log
+import com.bitchat.android.model.BitchatFilePacket
+import com.bitchat.android.model.FileStreamRecord
+import com.bitchat.android.model.FileStreamStart
+import com.bitchat.android.model.NoisePayload
+import com.bitchat.android.model.NoisePayloadType
+import com.bitchat.android.noise.FileStreamCipher
+import com.bitchat.android.protocol.BitchatPacket
+import com.bitchat.android.protocol.MessageType
+import com.bitchat.android.util.AppConstants
+import com.bitchat.android.util.toHexString
+import kotlinx.coroutines.*
+import java.io.File
+import java.io.RandomAccessFile
+import java.util.BitSet
+import java.util.concurrent.ConcurrentHashMap
+
+/**
+ * Streams private files as independently authenticated AEAD records instead of one
+ * whole-file Noise message.
+ *
+ * Sender: one FILE_STREAM_START (inside Noise) carries the transfer secret, then each
+ * record is sealed, packetized and handed to the broadcaster in turn, so encryption of
+ * the next record overlaps with fragment transmission of the previous one.
+ *
+ * Receiver: records are verified and written to a sparse temp file as they arrive (in
+ * any order); the file is moved into incoming storage once every record is present.
+ */
+class FileStreamManager(private val appContext: Context, private val myPeerID: String) {
+
+    companion object {
+        private const val TAG = "FileStreamManager"
+        private const val RECORD_SIZE = AppConstants.FileStream.RECORD_SIZE_BYTES
+        private const val INCOMING_TIMEOUT = AppConstants.FileStream.INCOMING_TIMEOUT_MS
+        private const val CLEANUP_INTERVAL = AppConstants.FileStream.CLEANUP_INTERVAL_MS
+        private const val MAX_CONCURRENT_INCOMING = AppConstants.FileStream.MAX_CONCURRENT_INCOMING
+        private const val MAX_EARLY_RECORDS = AppConstants.FileStream.MAX_EARLY_RECORDS
+        private const val MAX_EARLY_BYTES_PER_PEER = AppConstants.FileStream.MAX_EARLY_BYTES_PER_PEER
+        private const val MAX_EARLY_BYTES_TOTAL = AppConstants.FileStream.MAX_EARLY_BYTES_TOTAL
+        private const val STREAM_DIR = "file-streams"
+
+        /**
+         * Whether a file is large enough to benefit from streaming over a single Noise message
+         */
+        fun shouldStream(file: BitchatFilePacket): Boolean {
+            return file.content.size >= AppConstants.FileStream.MIN_STREAM_FILE_SIZE_BYTES
+        }
+    }
+
+    /**
+     * A completed incoming transfer, ready to surface as a message
+     */
+    data class CompletedStream(
+        val peerID: String,
+        val savedPath: String,
+        val fileName: String,
+        val mimeType: String,
+        val timestamp: Long
+    )
+
+    private class IncomingStream(
+        val peerID: String,
+        val start: FileStreamStart,
+        val cipher: FileStreamCipher,
+        val tempFile: File,
+        val output: RandomAccessFile,
+        val timestamp: Long
+    ) {
+        val received = BitSet(start.recordCount)
+        var lastActivity = System.currentTimeMillis()
+        var finished = false
+    }
+
+    private class EarlyRecords(val peerID: String, val firstSeen: Long) {
+        val records = mutableListOf<FileStreamRecord>()
+        var bytes = 0
+    }
+
+    var delegate: FileStreamManagerDelegate? = null
+
+    private val incoming = ConcurrentHashMap<String, IncomingStream>()           // peerID:transferId -> state
+    // Records that arrived before their START; the transfer ID is sender-chosen, so the
+    // buffer is bounded per peer and overall (all guarded by earlyRecords)
+    private val earlyRecords = HashMap<String, EarlyRecords>()
+    private val earlyBytesByPeer = HashMap<String, Int>()
+    private var earlyBytesTotal = 0
+    private val outgoingJobs = ConcurrentHashMap<String, Job>()                  // progress transferId -> job
+
+    private val managerScope = CoroutineScope(Dispatchers.IO + SupervisorJob())
+
+    init {
+        // Leftover parts from a previous process can never complete; drop them
+        try { File(appContext.cacheDir, STREAM_DIR).listFiles()?.forEach { it.delete() } } catch (_: Exception) { }
+        startPeriodicCleanup()
+    }
+
+    // MARK: - Sending
+
+    /**
+     * Start a streamed transfer to a peer with an established Noise session.
+     * Returns false if the transfer could not be started (caller falls back to the
+     * single-message path).
+     */
+    fun sendFile(recipientPeerID: String, file: BitchatFilePacket, progressId: String): Boolean {
+        val d = delegate ?: return false
+        val handshakeHash = d.getHandshakeHash(recipientPeerID) ?: return false
+
+        val content = file.content
+        val recordCount = maxOf(1, (content.size + RECORD_SIZE - 1) / RECORD_SIZE)
+        val transferId = FileStreamCipher.newTransferId()
+        val secret = FileStreamCipher.newSecret()
+        val start = FileStreamStart(
+            transferId = transferId,
+            secret = secret,
+            fileSize = content.size.toLong(),
+            recordSize = RECORD_SIZE,
+            recordCount = recordCount,
+            fileName = file.fileName,
+            mimeType = file.mimeType
+        )
+        val startPayload = start.encode() ?: return false
+        val encryptedStart = d.encryptForPeer(
+            NoisePayload(NoisePayloadType.FILE_STREAM_START, startPayload).encode(),
+            recipientPeerID
+        ) ?: return false
+        val cipher = FileStreamCipher.create(secret, handshakeHash, transferId)
+        secret.fill(0)
+
+        d.sendPacket(
+            BitchatPacket(
+                version = 1u,
+                type = MessageType.NOISE_ENCRYPTED.value,
+                senderID = hexStringToByteArray(myPeerID),
+                recipientID = hexStringToByteArray(recipientPeerID),
+                timestamp = System.currentTimeMillis().toULong(),
+                payload = encryptedStart,
+                signature = null,
+                ttl = AppConstants.MESSAGE_TTL_HOPS
+            )
+        )
+        Log.d(TAG, "📤 Started file stream ${transferId.toHexString().take(8)} to $recipientPeerID: $start")
+
+        val job = managerScope.launch {
+            try {
+                TransferProgressManager.start(progressId, recordCount)
+                for (index in 0 until recordCount) {
+                    if (!isActive) return@launch
+                    val from = index * RECORD_SIZE
+                    val to = minOf(content.size, from + RECORD_SIZE)
+                    val isFinal = index == recordCount - 1
+                    val sealed = cipher.seal(index, isFinal, content.copyOfRange(from, to))
+                    val record = FileStreamRecord(transferId, index, isFinal, sealed).encode()
+                    val packet = BitchatPacket(
+                        version = 1u,
+                        type = MessageType.FILE_STREAM_RECORD.value,
+                        senderID = hexStringToByteArray(myPeerID),
+                        recipientID = hexStringToByteArray(recipientPeerID),
+                        timestamp = System.currentTimeMillis().toULong(),
+                        payload = record,
+                        signature = null,
+                        ttl = AppConstants.MESSAGE_TTL_HOPS
+                    )
+                    d.sendPacket(packet)
+                    TransferProgressManager.progress(progressId, index + 1, recordCount)
+                    // Pace on the broadcaster's fragment cadence so records do not pile up in memory
+                    delay(fragmentCountFor(record.size) * AppConstants.Fragmentation.INTER_FRAGMENT_DELAY_MS)
+                }
+                TransferProgressManager.complete(progressId, recordCount)
+                Log.d(TAG, "✅ Sent $recordCount records for stream ${transferId.toHexString().take(8)}")
+            } finally {
+                cipher.destroy()
+            }
+        }
+        outgoingJobs[progressId] = job
+        job.invokeOnCompletion { outgoingJobs.remove(progressId) }
+        return true
+    }
+
+    fun cancelOutgoing(progressId: String): Boolean {
+        val job = outgoingJobs.remove(progressId) ?: return false
+        job.cancel()
+        return true
+    }
+
+    // MARK: - Receiving
+
+    /**
+     * Handle a decrypted FILE_STREAM_START from a peer
+     */
+    fun handleStart(peerID: String, payload: ByteArray, timestamp: Long) {
+        val start = FileStreamStart.decode(payload)
+        if (start == null) {
+            Log.w(TAG, "⚠️ Invalid FILE_STREAM_START from $peerID")
+            return
+        }
+        if (start.fileSize > AppConstants.Media.MAX_FILE_SIZE_BYTES) {
+            Log.w(TAG, "⚠️ Rejecting oversized stream from $peerID: ${start.fileSize} bytes")
+            return
+        }
+        val key = streamKey(peerID, start.transferId)
+        if (incoming.containsKey(key)) return
+        if (incoming.size >= MAX_CONCURRENT_INCOMING) {
+            Log.w(TAG, "⚠️ Too many concurrent incoming streams; dropping ${start.transferId.toHexString().take(8)} from $peerID")
+            return
+        }
+        val handshakeHash = delegate?.getHandshakeHash(peerID)
+        if (handshakeHash == null) {
+            Log.w(TAG, "⚠️ No Noise session binding for stream from $peerID")
+            return
+        }
+
+        val stream = try {
+            val dir = File(appContext.cacheDir, STREAM_DIR).apply { mkdirs() }
+            // Transfer IDs are sender-chosen; scope the file to the sender like the stream key
+            val temp = File(dir, "${tempFileName(peerID, start.transferId)}.part")
+            val raf = RandomAccessFile(temp, "rw")
+            raf.setLength(start.fileSize)
+            IncomingStream(
+                peerID = peerID,
+                start = start,
+                cipher = FileStreamCipher.create(start.secret, handshakeHash, start.transferId),
+                tempFile = temp,
+                output = raf,
+                timestamp = timestamp
+            )
+        } catch (e: Exception) {
+            Log.e(TAG, "❌ Failed to open stream file: ${e.message}")
+            return
+        } finally {
+            start.secret.fill(0)
+        }
+        incoming[key] = stream
+        // Records arrive in bursts that reorder beyond the default window
+        delegate?.useBulkReplayWindow(peerID)
+        Log.d(TAG, "📥 Accepted file stream from $peerID: $start")
+
+        // Records that overtook the START on another path
+        takeEarlyRecords(key).forEach { writeRecord(stream, key, it) }
+    }
+
+    /**
+     * Handle a FILE_STREAM_RECORD packet addressed to us.
+     * Returns the completed transfer when this record was the last missing one.
+     */
+    fun handleRecord(peerID: String, payload: ByteArray): CompletedStream? {
+        val record = FileStreamRecord.decode(payload) ?: run {
+            Log.w(TAG, "⚠️ Malformed FILE_STREAM_RECORD from $peerID")
+            return null
+        }
+        val key = streamKey(peerID, record.transferId)
+        val stream = incoming[key]
+        if (stream == null) {
+            bufferEarlyRecord(peerID, key, record)
+            return null
+        }
+        return writeRecord(stream, key, record)
+    }
+
+    private fun bufferEarlyRecord(peerID: String, key: String, record: FileStreamRecord) {
+        val size = record.sealed.size
+        synchronized(earlyRecords) {
+            val peerBytes = earlyBytesByPeer[peerID] ?: 0
+            if (peerBytes + size > MAX_EARLY_BYTES_PER_PEER || earlyBytesTotal + size > MAX_EARLY_BYTES_TOTAL) {
+                Log.w(TAG, "⚠️ Early record buffer full; dropping record ${record.index} from $peerID")
+                return
+            }
+            val pending = earlyRecords.getOrPut(key) { EarlyRecords(peerID, System.currentTimeMillis()) }
+            if (pending.records.size >= MAX_EARLY_RECORDS) return
+            pending.records.add(record)
+            pending.bytes += size
+            earlyBytesByPeer[peerID] = peerBytes + size
+            earlyBytesTotal += size
+        }
+    }
+
+    private fun takeEarlyRecords(key: String): List<FileStreamRecord> = synchronized(earlyRecords) {
+        val early = earlyRecords.remove(key) ?: return emptyList()
+        val peerBytes = (earlyBytesByPeer[early.peerID] ?: 0) - early.bytes
+        if (peerBytes > 0) earlyBytesByPeer[early.peerID] = peerBytes else earlyBytesByPeer.remove(early.peerID)
+        earlyBytesTotal -= early.bytes
+        early.records
+    }
+
+    private fun writeRecord(stream: IncomingStream, key: String, record: FileStreamRecord): CompletedStream? {
+        val start = stream.start
+        synchronized(stream) {
+            if (stream.finished || record.index >= start.recordCount) return null
+            if (record.isFinal != (record.index == start.recordCount - 1)) {
+                Log.w(TAG, "⚠️ Record ${record.index} final flag mismatch from ${stream.peerID}")
+                return null
+            }
+            if (stream.received.get(record.index)) return null
+
+            val plaintext = try {
+                stream.cipher.open(record.index, record.isFinal, record.sealed)
+            } catch (e: Exception) {
+                Log.w(TAG, "⚠️ Record ${record.index} failed authentication from ${stream.peerID}")
+                return null
+            }
+            val offset = record.index.toLong() * start.recordSize
+            val expected = minOf(start.recordSize.toLong(), start.fileSize - offset).toInt()
+            if (plaintext.size != expected) {
+                Log.w(TAG, "⚠️ Record ${record.index} has ${plaintext.size} bytes, expected $expected")
+                return null
+            }
+
+            try {
+                stream.output.seek(offset)
+                stream.output.write(plaintext)
+            } catch (e: Exception) {
+                Log.e(TAG, "❌ Failed writing record ${record.index}: ${e.message}")
+                abort(key, stream)
+                return null
+            }
+            stream.received.set(record.index)
+            stream.lastActivity = System.currentTimeMillis()
+
+            if (stream.received.cardinality() < start.recordCount) return null
+
+            stream.finished = true
+            incoming.remove(key)
+            stream.cipher.destroy()
+            try { stream.output.close() } catch (_: Exception) { }
+            val savedPath = com.bitchat.android.features.file.FileUtils.moveIncomingFile(
+                appContext, stream.tempFile, start.fileName, start.mimeType
+            )
+            if (savedPath == null) {
+                stream.tempFile.delete()
+                Log.e(TAG, "❌ Could not store completed stream ${record.transferId.toHexString().take(8)}")
+                return null
+            }
+            Log.d(TAG, "✅ File stream complete from ${stream.peerID}: ${start.fileName} -> $savedPath")
+            return CompletedStream(stream.peerID, savedPath, start.fileName, start.mimeType, stream.timestamp)
+        }
+    }
+
+    private fun abort(key: String, stream: IncomingStream) {
+        incoming.remove(key)
+        stream.finished = true
+        stream.cipher.destroy()
+        try { stream.output.close() } catch (_: Exception) { }
+        stream.tempFile.delete()
+    }
+
+    // MARK: - Maintenance
+
+    private fun startPeriodicCleanup() {
+        managerScope.launch {
+            while (isActive) {
+                delay(CLEANUP_INTERVAL)
+                cleanupStaleStreams()
+            }
+        }
+    }
+
+    private fun cleanupStaleStreams() {
+        val now = System.currentTimeMillis()
+        incoming.entries.filter { now - it.value.lastActivity > INCOMING_TIMEOUT }.forEach { (key, stream) ->
+            synchronized(stream) {
+                if (!stream.finished) {
+                    Log.w(TAG, "⏰ File stream from ${stream.peerID} timed out with ${stream.received.cardinality()}/${stream.start.recordCount} records")
+                    abort(key, stream)
+                }
+            }
+        }
+        // Early records whose START never arrived
+        synchronized(earlyRecords) {
+            earlyRecords.entries.filter { now - it.value.firstSeen > INCOMING_TIMEOUT }.map { it.key }
+        }.forEach { takeEarlyRecords(it) }
+    }
+
+    fun getDebugInfo(): String = buildString {
+        appendLine("=== File Stream Manager Debug Info ===")
+        appendLine("Outgoing streams: ${outgoingJobs.size}")
+        appendLine("Incoming streams: ${incoming.size}")
+        incoming.values.forEach { s ->
+            appendLine("  - ${s.peerID}: ${s.start.fileName} ${s.received.cardinality()}/${s.start.recordCount} records")
+        }
+        synchronized(earlyRecords) {
+            appendLine("Early records buffered: ${earlyRecords.values.sumOf { it.records.size }} ($earlyBytesTotal bytes)")
+        }
+    }
+
+    fun shutdown() {
+        incoming.entries.toList().forEach { (key, stream) -> synchronized(stream) { abort(key, stream) } }
+        synchronized(earlyRecords) {
+            earlyRecords.clear()
+            earlyBytesByPeer.clear()
+            earlyBytesTotal = 0
+        }
+        outgoingJobs.values.forEach { it.cancel() }
+        outgoingJobs.clear()
+        managerScope.cancel()
+    }
+
+    // MARK: - Helpers
+
+    private fun streamKey(peerID: String, transferId: ByteArray) = "$peerID:${transferId.toHexString()}"
+
+    private fun tempFileName(peerID: String, transferId: ByteArray) =
+        "${peerID.filter { it.isLetterOrDigit() }}-${transferId.toHexString()}"
+
+    private fun fragmentCountFor(payloadSize: Int): Int {
+        return if (payloadSize <= AppConstants.Fragmentation.FRAGMENT_SIZE_THRESHOLD) 1
+        else (payloadSize + AppConstants.Fragmentation.MAX_FRAGMENT_SIZE - 1) / AppConstants.Fragmentation.MAX_FRAGMENT_SIZE
+    }
+
+    private fun hexStringToByteArray(hexString: String): ByteArray {
+        val result = ByteArray(8) { 0 }
+        var tempID = hexString
+        var index = 0
+        while (tempID.length >= 2 && index < 8) {
+            val byte = tempID.substring(0, 2).toIntOrNull(16)?.toByte()
+            if (byte != null) result[index] = byte
+            tempID = tempID.substring(2)
+            index++
+        }
+        return result
+    }
+}
+
+/**
+ * Delegate interface for file stream callbacks
+ */
+interface FileStreamManagerDelegate {
+    fun getHandshakeHash(peerID: String): ByteArray?
+    fun useBulkReplayWindow(peerID: String)
+    fun encryptForPeer(data: ByteArray, recipientPeerID: String): ByteArray?
+    fun sendPacket(packet: BitchatPacket)
+}
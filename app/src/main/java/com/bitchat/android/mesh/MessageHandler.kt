@@ -6,6 +6,7 @@ import com.bitchat.android.model.IdentityAnnouncement
 import com.bitchat.android.model.RoutedPacket
 import com.bitchat.android.protocol.BitchatPacket
 import com.bitchat.android.protocol.MessageType
+import com.bitchat.android.services.PathQualityEstimator
 import com.bitchat.android.ui.debug.DebugMessage
 import com.bitchat.android.util.toHexString
 import kotlinx.coroutines.*
@@ -27,9 +28,22 @@ class MessageHandler(private val myPeerID: String, private val appContext: andro
     // Reference to PacketProcessor for recursive packet handling
     var packetProcessor: PacketProcessor? = null
     
+    // Reference to FileStreamManager for streamed private file transfers
+    var fileStreamManager: FileStreamManager? = null
+    
     // Coroutines
     private val handlerScope = CoroutineScope(Dispatchers.IO + SupervisorJob())
     
+    // Delivery ACKs to BATCH_ACK peers, one DELIVERED_BATCH packet per sender and window
+    private val ackBatcher = DeliveryAckBatcher(handlerScope) { peerID, messageIDs -> sendDeliveryAckBatch(peerID, messageIDs) }
+    
+    // Favorite flag, nickname and npub for PEER_STATE peers, replacing "[FAVORITED]" PMs
+    private val peerStateSync = PeerStateSync(
+        scope = handlerScope,
+        localState = { peerKey -> localPeerState(peerKey) },
+        send = { peerID, record -> sendPeerState(peerID, record) }
+    )
+    
     /**
      * Handle Noise encrypted transport message - SIMPLIFIED iOS-compatible version
      * Uses NoisePayloadType system exactly like iOS SimplifiedBluetoothService
@@ -115,30 +129,18 @@ class MessageHandler(private val myPeerID: String, private val appContext: andro
                     val file = com.bitchat.android.model.BitchatFilePacket.decode(noisePayload.data)
                     if (file != null) {
                         Log.d(TAG, "🔓 Decrypted encrypted file from $peerID: name='${file.fileName}', size=${file.fileSize}, mime='${file.mimeType}'")
-                        val uniqueMsgId = java.util.UUID.randomUUID().toString().uppercase()
                         val savedPath = com.bitchat.android.features.file.FileUtils.saveIncomingFile(appContext, file)
-                        val message = BitchatMessage(
-                            id = uniqueMsgId,
-                            sender = delegate?.getPeerNickname(peerID) ?: "Unknown",
-                            content = savedPath,
-                            type = com.bitchat.android.features.file.FileUtils.messageTypeForMime(file.mimeType),
-                            timestamp = java.util.Date(packet.timestamp.toLong()),
-                            isRelay = false,
-                            isPrivate = true,
-                            recipientNickname = delegate?.getMyNickname(),
-                            senderPeerID = peerID
-                        )
-
-                        Log.d(TAG, "📄 Saved encrypted incoming file to $savedPath (msgId=$uniqueMsgId)")
-                        delegate?.onMessageReceived(message)
-
-                        // Send delivery ACK with generated message ID
-                        sendDeliveryAck(uniqueMsgId, peerID)
+                        deliverPrivateFile(peerID, savedPath, file.mimeType, packet.timestamp.toLong())
                     } else {
                         Log.w(TAG, "⚠️ Failed to decode encrypted file transfer from $peerID")
                     }
                 }
                 
+                com.bitchat.android.model.NoisePayloadType.FILE_STREAM_START -> {
+                    // Streamed file: records follow as FILE_STREAM_RECORD packets
+                    fileStreamManager?.handleStart(peerID, noisePayload.data, packet.timestamp.toLong())
+                }
+                
                 com.bitchat.android.model.NoisePayloadType.DELIVERED -> {
                     // Handle delivery ACK exactly like iOS
                     val messageID = String(noisePayload.data, Charsets.UTF_8)
@@ -148,6 +150,20 @@ class MessageHandler(private val myPeerID: String, private val appContext: andro
                     delegate?.onDeliveryAckReceived(messageID, peerID)
                 }
                 
+                com.bitchat.android.model.NoisePayloadType.DELIVERED_BATCH -> {
+                    val messageIDs = com.bitchat.android.model.DeliveredBatch.decode(noisePayload.data)
+                    if (messageIDs == null) {
+                        Log.w(TAG, "Malformed delivery ACK batch from $peerID")
+                        return
+                    }
+                    Log.d(TAG, "📬 ${messageIDs.size} delivery ACKs received from $peerID")
+                    messageIDs.forEach { delegate?.onDeliveryAckReceived(it, peerID) }
+                }
+                
+                com.bitchat.android.model.NoisePayloadType.PEER_STATE -> {
+                    handlePeerState(noisePayload.data, peerID)
+                }
+                
                 com.bitchat.android.model.NoisePayloadType.READ_RECEIPT -> {
                     // Handle read receipt exactly like iOS
                     val messageID = String(noisePayload.data, Charsets.UTF_8)
@@ -156,12 +172,19 @@ class MessageHandler(private val myPeerID: String, private val appContext: andro
                     // Simplified: Call delegate with messageID and peerID directly
                     delegate?.onReadReceiptReceived(messageID, peerID)
                 }
+                
+                com.bitchat.android.model.NoisePayloadType.READ_UP_TO -> {
+                    val messageID = String(noisePayload.data, Charsets.UTF_8)
+                    Log.d(TAG, "👁️ Read receipt received from $peerID up to message $messageID")
+                    delegate?.onReadUpToReceived(messageID, peerID)
+                }
                 com.bitchat.android.model.NoisePayloadType.PING -> {
                     val privateMessage = com.bitchat.android.model.PrivateMessagePacket.decode(noisePayload.data)
                     if (privateMessage != null){
                         val messageID = privateMessage.messageID
                         debugManager?.addDebugMessage(DebugMessage.SystemMessage("📤 Sent ping ACK to $peerID for message $messageID"))
-                        sendDeliveryAck(messageID, peerID)
+                        // Not batched: the ACK is the RTT sample
+                        sendDeliveryAck(messageID, peerID, immediate = true)
                     }
                 }
             }
@@ -170,6 +193,44 @@ class MessageHandler(private val myPeerID: String, private val appContext: andro
             Log.e(TAG, "Error processing Noise encrypted message from $peerID: ${e.message}")
         }
     }
+    /**
+     * Handle a sealed record of a streamed private file transfer
+     */
+    suspend fun handleFileStreamRecord(routed: RoutedPacket) {
+        val packet = routed.packet
+        val peerID = routed.peerID ?: "unknown"
+        if (peerID == myPeerID) return
+        if (packet.recipientID?.toHexString() != myPeerID) return
+        
+        val completed = fileStreamManager?.handleRecord(peerID, packet.payload) ?: return
+        deliverPrivateFile(completed.peerID, completed.savedPath, completed.mimeType, completed.timestamp)
+    }
+    
+    /**
+     * Surface a received private file as a message and acknowledge it
+     */
+    private suspend fun deliverPrivateFile(peerID: String, savedPath: String, mimeType: String, timestamp: Long) {
+        // Generate unique message ID
+        val uniqueMsgId = java.util.UUID.randomUUID().toString().uppercase()
+        val message = BitchatMessage(
+            id = uniqueMsgId,
+            sender = delegate?.getPeerNickname(peerID) ?: "Unknown",
+            content = savedPath,
+            type = com.bitchat.android.features.file.FileUtils.messageTypeForMime(mimeType),
+            timestamp = java.util.Date(timestamp),
+            isRelay = false,
+            isPrivate = true,
+            recipientNickname = delegate?.getMyNickname(),
+            senderPeerID = peerID
+        )
+
+        Log.d(TAG, "📄 Saved encrypted incoming file to $savedPath (msgId=$uniqueMsgId)")
+        delegate?.onMessageReceived(message)
+
+        // Send delivery ACK with generated message ID
+        sendDeliveryAck(uniqueMsgId, peerID)
+    }
+    
     suspend fun handlePingPacket(routed: RoutedPacket){
 
 
@@ -177,38 +238,65 @@ class MessageHandler(private val myPeerID: String, private val appContext: andro
     /**
      * Send delivery ACK for a received private message - exactly like iOS
      */
-    private suspend fun sendDeliveryAck(messageID: String, senderPeerID: String) {
+    private suspend fun sendDeliveryAck(messageID: String, senderPeerID: String, immediate: Boolean = false) {
+        // Peers that understand DELIVERED_BATCH get their ACKs collected for a short window
+        val capabilities = delegate?.getPeerInfo(senderPeerID)?.capabilities ?: 0L
+        if (!immediate && com.bitchat.android.model.PeerCapability.has(capabilities, com.bitchat.android.model.PeerCapability.BATCH_ACK)) {
+            ackBatcher.add(senderPeerID, messageID)
+            return
+        }
+
+        // Create ACK payload: [type byte] + [message ID] - exactly like iOS
+        val ackPayload = com.bitchat.android.model.NoisePayload(
+            type = com.bitchat.android.model.NoisePayloadType.DELIVERED,
+            data = messageID.toByteArray(Charsets.UTF_8)
+        )
+        if (sendNoisePayload(ackPayload, senderPeerID)) {
+            Log.d(TAG, "📤 Sent delivery ACK to $senderPeerID for message $messageID")
+        }
+    }
+
+    private fun sendDeliveryAckBatch(senderPeerID: String, messageIDs: List<String>) {
+        val data = com.bitchat.android.model.DeliveredBatch.encode(messageIDs)
+        if (data == null) {
+            Log.w(TAG, "Failed to encode ${messageIDs.size} delivery ACKs for $senderPeerID")
+            return
+        }
+        val ackPayload = com.bitchat.android.model.NoisePayload(
+            type = com.bitchat.android.model.NoisePayloadType.DELIVERED_BATCH,
+            data = data
+        )
+        if (sendNoisePayload(ackPayload, senderPeerID)) {
+            Log.d(TAG, "📤 Sent ${messageIDs.size} delivery ACKs to $senderPeerID in one packet")
+        }
+    }
+
+    private fun sendNoisePayload(payload: com.bitchat.android.model.NoisePayload, recipientPeerID: String): Boolean {
         try {
-            // Create ACK payload: [type byte] + [message ID] - exactly like iOS
-            val ackPayload = com.bitchat.android.model.NoisePayload(
-                type = com.bitchat.android.model.NoisePayloadType.DELIVERED,
-                data = messageID.toByteArray(Charsets.UTF_8)
-            )
-            
             // Encrypt the payload
-            val encryptedPayload = delegate?.encryptForPeer(ackPayload.encode(), senderPeerID)
+            val encryptedPayload = delegate?.encryptForPeer(payload.encode(), recipientPeerID)
             if (encryptedPayload == null) {
-                Log.w(TAG, "Failed to encrypt delivery ACK for $senderPeerID")
-                return
+                Log.w(TAG, "Failed to encrypt ${payload.type} for $recipientPeerID")
+                return false
             }
             
             // Create NOISE_ENCRYPTED packet exactly like iOS
-                val packet = BitchatPacket(
-                    version = 1u,
-                    type = MessageType.NOISE_ENCRYPTED.value,
-                    senderID = hexStringToByteArray(myPeerID),
-                    recipientID = hexStringToByteArray(senderPeerID),
-                    timestamp = System.currentTimeMillis().toULong(),
-                    payload = encryptedPayload,
-                    signature = null,
-                    ttl = com.bitchat.android.util.AppConstants.MESSAGE_TTL_HOPS // Same TTL as iOS messageTTL
-                )
+            val packet = BitchatPacket(
+                version = 1u,
+                type = MessageType.NOISE_ENCRYPTED.value,
+                senderID = hexStringToByteArray(myPeerID),
+                recipientID = hexStringToByteArray(recipientPeerID),
+                timestamp = System.currentTimeMillis().toULong(),
+                payload = encryptedPayload,
+                signature = null,
+                ttl = com.bitchat.android.util.AppConstants.MESSAGE_TTL_HOPS // Same TTL as iOS messageTTL
+            )
             
             delegate?.sendPacket(packet)
-            Log.d(TAG, "📤 Sent delivery ACK to $senderPeerID for message $messageID")
-            
+            return true
         } catch (e: Exception) {
-            Log.e(TAG, "Failed to send delivery ACK to $senderPeerID: ${e.message}")
+            Log.e(TAG, "Failed to send ${payload.type} to $recipientPeerID: ${e.message}")
+            return false
         }
     }
     
@@ -266,6 +354,12 @@ class MessageHandler(private val myPeerID: String, private val appContext: andro
                 "noisePublicKey=${announcement.noisePublicKey.joinToString("") { "%02x".format(it) }.take(16)}..., " +
                 "signingPublicKey=${announcement.signingPublicKey.joinToString("") { "%02x".format(it) }.take(16)}...")
         
+        // Announces leave with MESSAGE_TTL_HOPS and lose one per relay
+        val ttlHops = com.bitchat.android.util.AppConstants.MESSAGE_TTL_HOPS.toInt()
+        if (packet.ttl.toInt() <= ttlHops) {
+            PathQualityEstimator.shared.onHopCount(peerID, ttlHops - packet.ttl.toInt() + 1)
+        }
+
         // Extract nickname and public keys from TLV data
         val nickname = announcement.nickname
         val noisePublicKey = announcement.noisePublicKey
@@ -280,6 +374,9 @@ class MessageHandler(private val myPeerID: String, private val appContext: andro
             isVerified = true
         ) ?: false
 
+        // Record optional protocol features so capability-gated senders can pick their path
+        delegate?.updatePeerCapabilities(peerID, announcement.capabilities)
+
         // Update peer ID binding with noise public key for identity management
         delegate?.updatePeerIDBinding(
             newPeerID = peerID,
@@ -339,6 +436,8 @@ class MessageHandler(private val myPeerID: String, private val appContext: andro
             val hasSession = delegate?.hasNoiseSession(peerID) ?: false
             if (hasSession) {
                 Log.d(TAG, "✅ Noise session established with $peerID")
+                // Catch the peer up on state that changed while apart (no-op if it has this version)
+                syncPeerState(peerID)
             }
             
         } catch (e: Exception) {
@@ -532,6 +631,77 @@ class MessageHandler(private val myPeerID: String, private val appContext: andro
         handlerScope.cancel()
     }
 
+    /**
+     * Schedule a state record for a peer that supports PEER_STATE. Returns false when the
+     * peer does not (or is unknown), in which case callers use the "[FAVORITED]" PM.
+     */
+    fun syncPeerState(peerID: String): Boolean {
+        val peerInfo = delegate?.getPeerInfo(peerID) ?: return false
+        val noiseKey = peerInfo.noisePublicKey ?: return false
+        if (!com.bitchat.android.model.PeerCapability.has(peerInfo.capabilities, com.bitchat.android.model.PeerCapability.PEER_STATE)) return false
+        peerStateSync.schedule(noiseKey.toHexString(), peerID)
+        return true
+    }
+
+    fun clearPeerState() {
+        peerStateSync.clear()
+    }
+
+    private fun localPeerState(peerKey: String): com.bitchat.android.model.PeerStateRecord? {
+        val noiseKey = peerKey.chunked(2).map { it.toInt(16).toByte() }.toByteArray()
+        // Nothing to share with peers we have no favorite relationship with
+        val relationship = com.bitchat.android.favorites.FavoritesPersistenceService.shared.getFavoriteStatus(noiseKey) ?: return null
+        val npub = try {
+            com.bitchat.android.nostr.NostrIdentityBridge.getCurrentNostrIdentity(appContext)?.npub
+        } catch (_: Exception) { null }
+        return com.bitchat.android.model.PeerStateRecord(
+            version = 0L,
+            isFavorite = relationship.isFavorite,
+            nickname = delegate?.getMyNickname() ?: myPeerID,
+            npub = npub
+        )
+    }
+
+    private fun sendPeerState(peerID: String, record: com.bitchat.android.model.PeerStateRecord): Boolean {
+        val data = record.encode() ?: return false
+        val payload = com.bitchat.android.model.NoisePayload(com.bitchat.android.model.NoisePayloadType.PEER_STATE, data)
+        return sendNoisePayload(payload, peerID).also { sent ->
+            if (sent) Log.d(TAG, "📤 Sent peer state v${record.version} to $peerID (favorite=${record.isFavorite})")
+        }
+    }
+
+    /**
+     * Apply a PEER_STATE record. Only fields that changed are written, and the system
+     * message appears only when the favorite flag actually flipped.
+     */
+    private fun handlePeerState(data: ByteArray, fromPeerID: String) {
+        val record = com.bitchat.android.model.PeerStateRecord.decode(data)
+        if (record == null) {
+            Log.w(TAG, "Malformed peer state from $fromPeerID")
+            return
+        }
+        val peerInfo = delegate?.getPeerInfo(fromPeerID) ?: return
+        val noiseKey = peerInfo.noisePublicKey ?: return
+        if (!peerStateSync.accept(noiseKey.toHexString(), record)) {
+            Log.d(TAG, "Ignoring peer state v${record.version} from $fromPeerID (already applied)")
+            return
+        }
+
+        val favorites = com.bitchat.android.favorites.FavoritesPersistenceService.shared
+        val previous = favorites.getFavoriteStatus(noiseKey)
+        if (record.npub != null && record.npub.startsWith("npub1") && record.npub != previous?.peerNostrPublicKey) {
+            favorites.updateNostrPublicKey(noiseKey, record.npub)
+            favorites.updateNostrPublicKeyForPeerID(fromPeerID, record.npub)
+        }
+        if (record.nickname.isNotEmpty() && record.nickname != peerInfo.nickname) {
+            delegate?.updatePeerNickname(fromPeerID, record.nickname)
+        }
+        if (record.isFavorite != (previous?.theyFavoritedUs ?: false)) {
+            favorites.updatePeerFavoritedUs(noiseKey, record.isFavorite)
+            announceFavoriteChange(record.nickname.ifEmpty { peerInfo.nickname }, record.isFavorite, noiseKey)
+        }
+    }
+
     /**
      * Handle favorite/unfavorite notification received over mesh as a private message.
      * Content format: "[FAVORITED]:npub..." or "[UNFAVORITED]:npub..."
@@ -553,32 +723,36 @@ class MessageHandler(private val myPeerID: String, private val appContext: andro
                     com.bitchat.android.favorites.FavoritesPersistenceService.shared.updateNostrPublicKeyForPeerID(fromPeerID, npub)
                 }
 
-                // Determine iOS-style guidance text
-                val rel = com.bitchat.android.favorites.FavoritesPersistenceService.shared.getFavoriteStatus(noiseKey)
-                val guidance = if (isFavorite) {
-                    if (rel?.isFavorite == true) {
-                        " — mutual! You can continue DMs via Nostr when out of mesh."
-                    } else {
-                        " — favorite back to continue DMs later."
-                    }
-                } else {
-                    ". DMs over Nostr will pause unless you both favorite again."
-                }
-
-                // Emit system message via delegate callback
-                val action = if (isFavorite) "favorited" else "unfavorited"
-                val sys = com.bitchat.android.model.BitchatMessage(
-                    sender = "system",
-                    content = "${peerInfo.nickname} $action you$guidance",
-                    timestamp = java.util.Date(),
-                    isRelay = false
-                )
-                delegate?.onMessageReceived(sys)
+                announceFavoriteChange(peerInfo.nickname, isFavorite, noiseKey)
             }
         } catch (_: Exception) {
             // Best-effort; ignore errors
         }
     }
+
+    private fun announceFavoriteChange(nickname: String, isFavorite: Boolean, noiseKey: ByteArray) {
+        // Determine iOS-style guidance text
+        val rel = com.bitchat.android.favorites.FavoritesPersistenceService.shared.getFavoriteStatus(noiseKey)
+        val guidance = if (isFavorite) {
+            if (rel?.isFavorite == true) {
+                " — mutual! You can continue DMs via Nostr when out of mesh."
+            } else {
+                " — favorite back to continue DMs later."
+            }
+        } else {
+            ". DMs over Nostr will pause unless you both favorite again."
+        }
+
+        // Emit system message via delegate callback
+        val action = if (isFavorite) "favorited" else "unfavorited"
+        val sys = com.bitchat.android.model.BitchatMessage(
+            sender = "system",
+            content = "$nickname $action you$guidance",
+            timestamp = java.util.Date(),
+            isRelay = false
+        )
+        delegate?.onMessageReceived(sys)
+    }
 }
 
 /**
@@ -594,6 +768,7 @@ interface MessageHandlerDelegate {
     fun getMyNickname(): String?
     fun getPeerInfo(peerID: String): PeerInfo?
     fun updatePeerInfo(peerID: String, nickname: String, noisePublicKey: ByteArray, signingPublicKey: ByteArray, isVerified: Boolean): Boolean
+    fun updatePeerCapabilities(peerID: String, capabilities: Long)
     
     // Packet operations
     fun sendPacket(packet: BitchatPacket)
@@ -621,4 +796,5 @@ interface MessageHandlerDelegate {
     fun onChannelLeave(channel: String, fromPeer: String)
     fun onDeliveryAckReceived(messageID: String, peerID: String)
     fun onReadReceiptReceived(messageID: String, peerID: String)
+    fun onReadUpToReceived(messageID: String, peerID: String)
 }
@@ -155,6 +155,7 @@ class PacketProcessor(private val myPeerID: String) {
                     when (messageType) {
                         MessageType.NOISE_HANDSHAKE -> handleNoiseHandshake(routed)
                         MessageType.NOISE_ENCRYPTED -> handleNoiseEncrypted(routed)
+                        MessageType.FILE_STREAM_RECORD -> handleFileStreamRecord(routed)
                         MessageType.FILE_TRANSFER -> handleMessage(routed)
                         else -> {
                             validPacket = false
@@ -194,6 +195,15 @@ class PacketProcessor(private val myPeerID: String) {
         delegate?.handleNoiseEncrypted(routed)
     }
     
+    /**
+     * Handle streamed private file record
+     */
+    private suspend fun handleFileStreamRecord(routed: RoutedPacket) {
+        val peerID = routed.peerID ?: "unknown"
+        Log.d(TAG, "Processing file stream record from ${formatPeerForLog(peerID)}")
+        delegate?.handleFileStreamRecord(routed)
+    }
+    
     /**
      * Handle announce message
      */
@@ -318,6 +328,7 @@ interface PacketProcessorDelegate {
     // Message type handlers
     fun handleNoiseHandshake(routed: RoutedPacket): Boolean
     fun handleNoiseEncrypted(routed: RoutedPacket)
+    fun handleFileStreamRecord(routed: RoutedPacket)
     fun handleAnnounce(routed: RoutedPacket)
     fun handleMessage(routed: RoutedPacket)
     fun handleLeave(routed: RoutedPacket)
@@ -4,6 +4,8 @@ import com.bitchat.android.protocol.MessageType
 import android.util.Log
 import com.bitchat.android.model.RoutedPacket
 import com.bitchat.android.protocol.BitchatPacket
+import com.bitchat.android.services.PathQualityEstimator
+import com.bitchat.android.util.AppConstants
 import com.bitchat.android.util.toHexString
 import kotlinx.coroutines.*
 import kotlin.random.Random
@@ -101,6 +103,15 @@ class PacketRelayManager(private val myPeerID: String) {
      * Determine if we should relay this packet based on type and network conditions
      */
     private fun shouldRelayPacket(packet: BitchatPacket, fromPeerID: String): Boolean {
+        // Directed packets: use the recipient's announced hop distance when it is recent;
+        // stale or unknown distances fall through to the probabilistic relay below
+        recipientHops(packet)?.let { hops ->
+            // Our neighbours receive this copy, so it covers ttl + 1 hops from here
+            val reachable = hops <= packet.ttl.toInt() + 1 + AppConstants.PathQuality.RELAY_HOP_SLACK
+            Log.d(TAG, "Recipient ${hops} hop(s) away, TTL ${packet.ttl}: ${if (reachable) "relaying" else "out of reach"}")
+            return reachable
+        }
+
         // Always relay if TTL is high enough (indicates important message)
         if (packet.ttl >= 4u) {
             Log.d(TAG, "High TTL (${packet.ttl}), relaying")
@@ -131,6 +142,13 @@ class PacketRelayManager(private val myPeerID: String) {
         return shouldRelay
     }
     
+    private fun recipientHops(packet: BitchatPacket): Int? {
+        val recipientID = packet.recipientID ?: return null
+        val broadcastRecipient = delegate?.getBroadcastRecipient()
+        if (broadcastRecipient != null && recipientID.contentEquals(broadcastRecipient)) return null
+        return PathQualityEstimator.shared.hops(recipientID.toHexString())
+    }
+
     /**
      * Actually broadcast the packet for relay
      */
@@ -17,7 +17,8 @@ data class PeerInfo(
     var noisePublicKey: ByteArray?,
     var signingPublicKey: ByteArray?,      // NEW: Ed25519 public key for verification
     var isVerifiedNickname: Boolean,       // NEW: Verification status flag
-    var lastSeen: Long  // Using Long instead of Date for simplicity
+    var lastSeen: Long,  // Using Long instead of Date for simplicity
+    var capabilities: Long = 0L            // PeerCapability bitmask from the latest verified announce
 ) {
     override fun equals(other: Any?): Boolean {
         if (this === other) return true
@@ -39,6 +40,7 @@ data class PeerInfo(
         } else if (other.signingPublicKey != null) return false
         if (isVerifiedNickname != other.isVerifiedNickname) return false
         if (lastSeen != other.lastSeen) return false
+        if (capabilities != other.capabilities) return false
         
         return true
     }
@@ -52,6 +54,7 @@ data class PeerInfo(
         result = 31 * result + (signingPublicKey?.contentHashCode() ?: 0)
         result = 31 * result + isVerifiedNickname.hashCode()
         result = 31 * result + lastSeen.hashCode()
+        result = 31 * result + capabilities.hashCode()
         return result
     }
 }
@@ -121,7 +124,8 @@ class PeerManager {
             noisePublicKey = noisePublicKey,
             signingPublicKey = signingPublicKey,
             isVerifiedNickname = isVerified,
-            lastSeen = now
+            lastSeen = now,
+            capabilities = existingPeer?.capabilities ?: 0L
         )
         
         peers[peerID] = peerInfo
@@ -151,6 +155,26 @@ class PeerManager {
         return peers[peerID]
     }
 
+    /**
+     * Record the capability bitmask advertised in a peer's verified announce
+     */
+    fun updatePeerCapabilities(peerID: String, capabilities: Long) {
+        peers[peerID]?.let { existing ->
+            if (existing.capabilities != capabilities) {
+                peers[peerID] = existing.copy(capabilities = capabilities)
+                Log.d(TAG, "Peer $peerID capabilities: ${com.bitchat.android.model.PeerCapability.fromBitmask(capabilities)}")
+            }
+        }
+    }
+
+    /**
+     * Check whether a peer advertised support for an optional protocol feature
+     */
+    fun peerSupports(peerID: String, capability: com.bitchat.android.model.PeerCapability): Boolean {
+        val mask = peers[peerID]?.capabilities ?: return false
+        return com.bitchat.android.model.PeerCapability.has(mask, capability)
+    }
+
     /**
      * Check if peer is verified
      */
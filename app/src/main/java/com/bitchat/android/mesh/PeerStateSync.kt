@@ -0,0 +1,91 @@
+package com.bitchat.android.mesh
+
+import com.bitchat.android.model.PeerStateRecord
+import com.bitchat.android.util.AppConstants
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+
+/**
+ * Versioned exchange of [PeerStateRecord]s, keyed by the peer's Noise key so peer ID
+ * rotations do not count as a new peer.
+ *
+ * Sending: [schedule] is debounced per peer, so rapid favorite toggles or reconnect churn
+ * collapse into one send of the latest state. The local record's version only moves when
+ * one of its fields changed, and a peer is sent a version at most once.
+ * Receiving: [accept] admits a record only if it is newer than the last one from that
+ * peer, which makes duplicates and replays no-ops.
+ */
+class PeerStateSync(
+    private val scope: CoroutineScope,
+    private val debounceMs: Long = AppConstants.Mesh.PEER_STATE_DEBOUNCE_MS,
+    private val clock: () -> Long = System::currentTimeMillis,
+    // Our current state towards a peer (version ignored), or null when there is nothing to share
+    private val localState: (peerKey: String) -> PeerStateRecord?,
+    private val send: suspend (peerID: String, record: PeerStateRecord) -> Boolean
+) {
+    private class Pending(val peerID: String)
+
+    private val built = HashMap<String, PeerStateRecord>()
+    private val sent = HashMap<String, Long>()
+    private val received = HashMap<String, Long>()
+    private val pending = HashMap<String, Pending>()
+
+    /**
+     * Send our state to `peerID` (Noise key `peerKey`) once the debounce window passes,
+     * unless that version already went out
+     */
+    fun schedule(peerKey: String, peerID: String) {
+        val token = Pending(peerID)
+        synchronized(this) { pending[peerKey] = token }
+        scope.launch {
+            delay(debounceMs)
+            flush(peerKey, token)
+        }
+    }
+
+    /**
+     * True when `record` is newer than anything seen from this peer and should be applied
+     */
+    @Synchronized
+    fun accept(peerKey: String, record: PeerStateRecord): Boolean {
+        if (record.version <= (received[peerKey] ?: Long.MIN_VALUE)) return false
+        received[peerKey] = record.version
+        return true
+    }
+
+    @Synchronized
+    fun clear() {
+        built.clear()
+        sent.clear()
+        received.clear()
+        pending.clear()
+    }
+
+    private suspend fun flush(peerKey: String, token: Pending) {
+        synchronized(this) {
+            // A later schedule() superseded this one
+            if (pending[peerKey] !== token) return
+            pending.remove(peerKey)
+        }
+        val state = localState(peerKey) ?: return
+        val record = synchronized(this) {
+            val record = versioned(peerKey, state)
+            if (sent[peerKey] == record.version) return
+            record
+        }
+        if (send(token.peerID, record)) {
+            synchronized(this) { sent[peerKey] = record.version }
+        }
+    }
+
+    // Keeps the version while the state is unchanged; otherwise moves past both the old
+    // version and the clock so a restart (which forgets `built`) still counts as newer
+    private fun versioned(peerKey: String, state: PeerStateRecord): PeerStateRecord {
+        val previous = built[peerKey]
+        if (previous != null && previous.sameStateAs(state)) return previous
+        val record = state.copy(version = maxOf((previous?.version ?: 0L) + 1, clock()))
+        built[peerKey] = record
+        return record
+    }
+}
@@ -0,0 +1,68 @@
+package com.bitchat.android.model
+
+import java.nio.ByteBuffer
+import java.util.UUID
+
+/**
+ * Payload of a DELIVERED_BATCH Noise message: the IDs of several received messages,
+ * acknowledged together.
+ *
+ * Format: [count: u8] then per ID either [0x01][16-byte UUID] for IDs in the canonical
+ * uppercase UUID form both platforms generate, or [0x00][length: u8][UTF-8 bytes].
+ */
+object DeliveredBatch {
+    private const val KIND_STRING: Int = 0x00
+    private const val KIND_UUID: Int = 0x01
+
+    fun encode(messageIDs: List<String>): ByteArray? {
+        if (messageIDs.isEmpty() || messageIDs.size > 255) return null
+        val out = java.io.ByteArrayOutputStream()
+        out.write(messageIDs.size)
+        for (id in messageIDs) {
+            val uuid = canonicalUuid(id)
+            if (uuid != null) {
+                out.write(KIND_UUID)
+                out.write(ByteBuffer.allocate(16).putLong(uuid.mostSignificantBits).putLong(uuid.leastSignificantBits).array())
+            } else {
+                val bytes = id.toByteArray(Charsets.UTF_8)
+                if (bytes.size > 255) return null
+                out.write(KIND_STRING)
+                out.write(bytes.size)
+                out.write(bytes)
+            }
+        }
+        return out.toByteArray()
+    }
+
+    fun decode(data: ByteArray): List<String>? {
+        if (data.isEmpty()) return null
+        val buffer = ByteBuffer.wrap(data)
+        val count = buffer.get().toInt() and 0xFF
+        val ids = ArrayList<String>(count)
+        repeat(count) {
+            if (!buffer.hasRemaining()) return null
+            when (buffer.get().toInt() and 0xFF) {
+                KIND_UUID -> {
+                    if (buffer.remaining() < 16) return null
+                    ids.add(UUID(buffer.long, buffer.long).toString().uppercase())
+                }
+                KIND_STRING -> {
+                    if (!buffer.hasRemaining()) return null
+                    val length = buffer.get().toInt() and 0xFF
+                    if (buffer.remaining() < length) return null
+                    val bytes = ByteArray(length).also { buffer.get(it) }
+                    ids.add(String(bytes, Charsets.UTF_8))
+                }
+                else -> return null
+            }
+        }
+        return ids
+    }
+
+    // Only IDs that survive the round trip unchanged are packed
+    private fun canonicalUuid(id: String): UUID? {
+        if (id.length != 36) return null
+        val uuid = try { UUID.fromString(id) } catch (_: IllegalArgumentException) { return null }
+        return uuid.takeIf { it.toString().uppercase() == id }
+    }
+}
@@ -0,0 +1,181 @@
+package com.bitchat.android.model
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * FileStreamStart: opens a streamed private file transfer.
+ * Sent once inside a Noise transport message (NoisePayloadType.FILE_STREAM_START), so the
+ * transfer secret is only ever visible to the Noise session peer.
+ *
+ * TLVs (1-byte type, 2-byte big-endian length):
+ *  - 0x01: transfer ID (16 bytes)
+ *  - 0x02: transfer secret (32 bytes)
+ *  - 0x03: file size (8 bytes, UInt64)
+ *  - 0x04: record size (4 bytes, UInt32) — plaintext bytes per record, last may be shorter
+ *  - 0x05: record count (4 bytes, UInt32)
+ *  - 0x06: filename (UTF-8)
+ *  - 0x07: mime type (UTF-8)
+ */
+data class FileStreamStart(
+    val transferId: ByteArray,
+    val secret: ByteArray,
+    val fileSize: Long,
+    val recordSize: Int,
+    val recordCount: Int,
+    val fileName: String,
+    val mimeType: String
+) {
+    private enum class TLVType(val v: UByte) {
+        TRANSFER_ID(0x01u), SECRET(0x02u), FILE_SIZE(0x03u), RECORD_SIZE(0x04u),
+        RECORD_COUNT(0x05u), FILE_NAME(0x06u), MIME_TYPE(0x07u);
+        companion object { fun from(value: UByte) = values().find { it.v == value } }
+    }
+
+    fun encode(): ByteArray? {
+        val nameBytes = fileName.toByteArray(Charsets.UTF_8)
+        val mimeBytes = mimeType.toByteArray(Charsets.UTF_8)
+        if (nameBytes.size > 0xFFFF || mimeBytes.size > 0xFFFF) return null
+
+        val capacity = (3 + transferId.size) + (3 + secret.size) + (3 + 8) + (3 + 4) + (3 + 4) +
+            (3 + nameBytes.size) + (3 + mimeBytes.size)
+        val buf = ByteBuffer.allocate(capacity).order(ByteOrder.BIG_ENDIAN)
+        fun putTLV(type: TLVType, value: ByteArray) {
+            buf.put(type.v.toByte())
+            buf.putShort(value.size.toShort())
+            buf.put(value)
+        }
+        putTLV(TLVType.TRANSFER_ID, transferId)
+        putTLV(TLVType.SECRET, secret)
+        putTLV(TLVType.FILE_SIZE, ByteBuffer.allocate(8).putLong(fileSize).array())
+        putTLV(TLVType.RECORD_SIZE, ByteBuffer.allocate(4).putInt(recordSize).array())
+        putTLV(TLVType.RECORD_COUNT, ByteBuffer.allocate(4).putInt(recordCount).array())
+        putTLV(TLVType.FILE_NAME, nameBytes)
+        putTLV(TLVType.MIME_TYPE, mimeBytes)
+        return buf.array()
+    }
+
+    companion object {
+        fun decode(data: ByteArray): FileStreamStart? {
+            try {
+                var off = 0
+                var transferId: ByteArray? = null
+                var secret: ByteArray? = null
+                var fileSize: Long? = null
+                var recordSize: Int? = null
+                var recordCount: Int? = null
+                var name: String? = null
+                var mime: String? = null
+                while (off + 3 <= data.size) {
+                    val t = TLVType.from(data[off].toUByte())
+                    val len = ((data[off + 1].toInt() and 0xFF) shl 8) or (data[off + 2].toInt() and 0xFF)
+                    off += 3
+                    if (off + len > data.size) return null
+                    val value = data.copyOfRange(off, off + len)
+                    off += len
+                    when (t) {
+                        TLVType.TRANSFER_ID -> transferId = value
+                        TLVType.SECRET -> secret = value
+                        TLVType.FILE_SIZE -> if (len == 8) fileSize = ByteBuffer.wrap(value).long else return null
+                        TLVType.RECORD_SIZE -> if (len == 4) recordSize = ByteBuffer.wrap(value).int else return null
+                        TLVType.RECORD_COUNT -> if (len == 4) recordCount = ByteBuffer.wrap(value).int else return null
+                        TLVType.FILE_NAME -> name = String(value, Charsets.UTF_8)
+                        TLVType.MIME_TYPE -> mime = String(value, Charsets.UTF_8)
+                        null -> continue // Unknown TLV; skip for forward compatibility
+                    }
+                }
+                val id = transferId ?: return null
+                val key = secret ?: return null
+                val size = fileSize ?: return null
+                val rSize = recordSize ?: return null
+                val rCount = recordCount ?: return null
+                if (size < 0 || rSize <= 0 || rCount <= 0) return null
+                // Record layout must cover the file exactly: full records plus one (possibly short) tail
+                if (size > rSize.toLong() * rCount || (rCount > 1 && size <= rSize.toLong() * (rCount - 1))) return null
+                return FileStreamStart(id, key, size, rSize, rCount, name ?: "file", mime ?: "application/octet-stream")
+            } catch (e: Exception) {
+                android.util.Log.e("FileStreamStart", "❌ Decoding failed: ${e.message}", e)
+                return null
+            }
+        }
+    }
+
+    // Override equals and hashCode since we use ByteArray
+    override fun equals(other: Any?): Boolean {
+        if (this === other) return true
+        if (javaClass != other?.javaClass) return false
+        other as FileStreamStart
+        return transferId.contentEquals(other.transferId) &&
+            secret.contentEquals(other.secret) &&
+            fileSize == other.fileSize &&
+            recordSize == other.recordSize &&
+            recordCount == other.recordCount &&
+            fileName == other.fileName &&
+            mimeType == other.mimeType
+    }
+
+    override fun hashCode(): Int {
+        var result = transferId.contentHashCode()
+        result = 31 * result + fileSize.hashCode()
+        result = 31 * result + recordCount
+        return result
+    }
+
+    // Never log the transfer secret
+    override fun toString(): String {
+        return "FileStreamStart(name='$fileName', size=$fileSize, records=$recordCount x $recordSize, mime='$mimeType')"
+    }
+}
+
+/**
+ * FileStreamRecord: one sealed chunk of a streamed transfer, carried as the payload of a
+ * FILE_STREAM_RECORD packet addressed to the recipient.
+ *
+ * Layout: [transferId 16][index UInt32][flags 1][ciphertext + 16-byte tag]
+ */
+data class FileStreamRecord(
+    val transferId: ByteArray,
+    val index: Int,
+    val isFinal: Boolean,
+    val sealed: ByteArray
+) {
+    companion object {
+        private const val FLAG_FINAL = 0x01
+        const val HEADER_SIZE = 16 + 4 + 1
+
+        fun decode(data: ByteArray): FileStreamRecord? {
+            if (data.size < HEADER_SIZE + 16) return null
+            val buf = ByteBuffer.wrap(data).order(ByteOrder.BIG_ENDIAN)
+            val transferId = ByteArray(16).also { buf.get(it) }
+            val index = buf.int
+            val flags = buf.get().toInt() and 0xFF
+            if (index < 0) return null
+            val sealed = ByteArray(buf.remaining()).also { buf.get(it) }
+            return FileStreamRecord(transferId, index, (flags and FLAG_FINAL) != 0, sealed)
+        }
+    }
+
+    fun encode(): ByteArray {
+        return ByteBuffer.allocate(HEADER_SIZE + sealed.size).order(ByteOrder.BIG_ENDIAN)
+            .put(transferId)
+            .putInt(index)
+            .put((if (isFinal) FLAG_FINAL else 0).toByte())
+            .put(sealed)
+            .array()
+    }
+
+    override fun equals(other: Any?): Boolean {
+        if (this === other) return true
+        if (javaClass != other?.javaClass) return false
+        other as FileStreamRecord
+        return transferId.contentEquals(other.transferId) && index == other.index &&
+            isFinal == other.isFinal && sealed.contentEquals(other.sealed)
+    }
+
+    override fun hashCode(): Int {
+        var result = transferId.contentHashCode()
+        result = 31 * result + index
+        result = 31 * result + sealed.contentHashCode()
+        return result
+    }
+}
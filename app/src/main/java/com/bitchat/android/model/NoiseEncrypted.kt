@@ -22,7 +22,11 @@ enum class NoisePayloadType(val value: UByte) {
     READ_RECEIPT(0x02u),        // Message was read
     DELIVERED(0x03u),           // Message was delivered
     PING(0x4u),
-    FILE_TRANSFER(0x20u);
+    FILE_TRANSFER(0x20u),
+    FILE_STREAM_START(0x21u),   // Opens a chunked AEAD file transfer (records follow as FILE_STREAM_RECORD packets)
+    DELIVERED_BATCH(0x22u),     // Several delivery ACKs at once (DeliveredBatch); only sent to BATCH_ACK peers
+    PEER_STATE(0x23u),          // Versioned favorite/nickname/npub record (PeerStateRecord); only sent to PEER_STATE peers
+    READ_UP_TO(0x24u);          // Read receipt that also covers earlier messages; only sent to READ_UP_TO peers
 
 
     companion object {
@@ -0,0 +1,49 @@
+package com.bitchat.android.model
+
+/**
+ * Optional protocol features a peer advertises in its announce (CAPABILITIES TLV).
+ *
+ * Peers that omit the TLV (older Android builds, iOS) advertise nothing, so every
+ * capability-gated send path must keep its legacy behaviour as the fallback.
+ */
+enum class PeerCapability(val bit: Int) {
+    FILE_STREAM(0),     // Chunked AEAD private file transfer (FILE_STREAM_START + FILE_STREAM_RECORD)
+    BATCH_ACK(1),       // Several delivery ACKs in one DELIVERED_BATCH payload
+    PEER_STATE(2),      // Favorite flag, nickname and npub as a versioned PEER_STATE record
+    READ_UP_TO(3);      // One READ_UP_TO receipt covers every earlier message in the chat
+
+    companion object {
+        /**
+         * Capabilities implemented by this build; advertised in every announce
+         */
+        val LOCAL: Set<PeerCapability> = setOf(FILE_STREAM, BATCH_ACK, PEER_STATE, READ_UP_TO)
+
+        fun toBitmask(capabilities: Set<PeerCapability>): Long {
+            return capabilities.fold(0L) { mask, cap -> mask or (1L shl cap.bit) }
+        }
+
+        fun fromBitmask(mask: Long): Set<PeerCapability> {
+            return values().filter { (mask and (1L shl it.bit)) != 0L }.toSet()
+        }
+
+        fun has(mask: Long, capability: PeerCapability): Boolean {
+            return (mask and (1L shl capability.bit)) != 0L
+        }
+
+        /**
+         * Minimal big-endian encoding (1..8 bytes) so the TLV stays small while bits are few
+         */
+        fun encodeBitmask(mask: Long): ByteArray {
+            var length = 1
+            while (length < 8 && (mask ushr (length * 8)) != 0L) length++
+            return ByteArray(length) { i -> (mask ushr ((length - 1 - i) * 8)).toByte() }
+        }
+
+        fun decodeBitmask(bytes: ByteArray): Long {
+            var mask = 0L
+            // Ignore bytes beyond 8 from a future peer rather than rejecting the announce
+            bytes.takeLast(8).forEach { b -> mask = (mask shl 8) or (b.toLong() and 0xFF) }
+            return mask
+        }
+    }
+}
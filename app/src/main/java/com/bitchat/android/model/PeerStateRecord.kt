@@ -0,0 +1,105 @@
+package com.bitchat.android.model
+
+/**
+ * What a peer tells one other peer about itself, as one PEER_STATE Noise payload:
+ * whether it favorites the receiver, its nickname and its Nostr npub.
+ *
+ * Replaces the "[FAVORITED]:npub" private messages for peers advertising
+ * PeerCapability.PEER_STATE. `version` grows whenever any field changes; receivers keep
+ * the highest version seen per sender and ignore the rest, so resends are harmless.
+ */
+data class PeerStateRecord(
+    val version: Long,
+    val isFavorite: Boolean,
+    val nickname: String,
+    val npub: String?
+) {
+
+    /**
+     * TLV types (Android extension; unknown types are skipped on decode)
+     */
+    private enum class TLVType(val value: UByte) {
+        VERSION(0x01u),
+        FLAGS(0x02u),
+        NICKNAME(0x03u),
+        NPUB(0x04u);
+
+        companion object {
+            fun fromValue(value: UByte): TLVType? {
+                return values().find { it.value == value }
+            }
+        }
+    }
+
+    /**
+     * Same fields, ignoring the version
+     */
+    fun sameStateAs(other: PeerStateRecord): Boolean =
+        isFavorite == other.isFavorite && nickname == other.nickname && npub == other.npub
+
+    fun encode(): ByteArray? {
+        val nicknameData = nickname.toByteArray(Charsets.UTF_8)
+        val npubData = npub?.toByteArray(Charsets.UTF_8)
+        if (nicknameData.size > 255 || (npubData?.size ?: 0) > 255) return null
+
+        val result = mutableListOf<Byte>()
+
+        result.add(TLVType.VERSION.value.toByte())
+        result.add(8)
+        for (i in 7 downTo 0) result.add((version ushr (i * 8)).toByte())
+
+        result.add(TLVType.FLAGS.value.toByte())
+        result.add(1)
+        result.add(if (isFavorite) FLAG_FAVORITE else 0)
+
+        result.add(TLVType.NICKNAME.value.toByte())
+        result.add(nicknameData.size.toByte())
+        result.addAll(nicknameData.toList())
+
+        if (npubData != null) {
+            result.add(TLVType.NPUB.value.toByte())
+            result.add(npubData.size.toByte())
+            result.addAll(npubData.toList())
+        }
+
+        return result.toByteArray()
+    }
+
+    companion object {
+        private const val FLAG_FAVORITE: Byte = 0x01
+
+        fun decode(data: ByteArray): PeerStateRecord? {
+            var offset = 0
+            var version: Long? = null
+            var flags = 0
+            var nickname: String? = null
+            var npub: String? = null
+
+            while (offset + 2 <= data.size) {
+                val type = TLVType.fromValue(data[offset].toUByte())
+                val length = data[offset + 1].toUByte().toInt()
+                offset += 2
+                if (offset + length > data.size) return null
+                val value = data.copyOfRange(offset, offset + length)
+                offset += length
+
+                when (type) {
+                    TLVType.VERSION -> {
+                        if (length != 8) return null
+                        version = value.fold(0L) { acc, b -> (acc shl 8) or (b.toLong() and 0xFF) }
+                    }
+                    TLVType.FLAGS -> flags = value.firstOrNull()?.toInt() ?: 0
+                    TLVType.NICKNAME -> nickname = String(value, Charsets.UTF_8)
+                    TLVType.NPUB -> npub = String(value, Charsets.UTF_8)
+                    null -> continue
+                }
+            }
+
+            return if (version != null && nickname != null) {
+                PeerStateRecord(version, (flags and FLAG_FAVORITE.toInt()) != 0, nickname, npub)
+            } else {
+                null
+            }
+        }
+    }
+}
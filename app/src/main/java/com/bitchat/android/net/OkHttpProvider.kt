@@ -1,54 +1,139 @@
 package com.bitchat.android.net
 
+import android.util.Log
+import com.bitchat.android.util.AppConstants
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+import okhttp3.ConnectionPool
+import okhttp3.Dispatcher
 import okhttp3.OkHttpClient
 import java.net.InetSocketAddress
 import java.net.Proxy
 import java.util.concurrent.TimeUnit
-import java.util.concurrent.atomic.AtomicReference
+import javax.net.SocketFactory
 
 /**
  * Centralized OkHttp provider to ensure all network traffic honors Tor settings.
+ *
+ * One base client per proxy setting owns the connection pool and dispatcher; the HTTP and
+ * WebSocket clients are derived from it with newBuilder(), so relay sockets and directory
+ * downloads share threads and connections. [reset] starts a new base for the new proxy
+ * and drains the old one once its websockets have had time to close.
+ *
+ * Under Tor, each [TorIsolation] group gets its own client. The client dials through
+ * [Socks5SocketFactory] with that group's SOCKS credentials, so Arti keeps the groups on
+ * separate circuits, and the pool never shares a connection across groups.
  */
 object OkHttpProvider {
-    private val httpClientRef = AtomicReference<OkHttpClient?>(null)
-    private val wsClientRef = AtomicReference<OkHttpClient?>(null)
+    private const val TAG = "OkHttpProvider"
+
+    private class Clients(
+        val base: OkHttpClient,
+        val http: OkHttpClient,
+        val webSocket: Map<TorIsolation, OkHttpClient>
+    )
+
+    @Volatile private var clients: Clients? = null
+    private val lock = Any()
+    private val drainScope = CoroutineScope(Dispatchers.IO + SupervisorJob())
 
     fun reset() {
-        httpClientRef.set(null)
-        wsClientRef.set(null)
+        val old = synchronized(lock) {
+            clients.also { clients = null }
+        } ?: return
+        drainScope.launch {
+            // Callers close their websockets right after reset; give the close handshakes a chance
+            delay(AppConstants.Network.DRAIN_GRACE_MS)
+            drain(old.base)
+        }
     }
 
-    fun httpClient(): OkHttpClient {
-        httpClientRef.get()?.let { return it }
-        val client = baseBuilderForCurrentProxy()
-            .callTimeout(15, TimeUnit.SECONDS)
-            .connectTimeout(10, TimeUnit.SECONDS)
-            .readTimeout(15, TimeUnit.SECONDS)
-            .build()
-        httpClientRef.set(client)
-        return client
+    fun httpClient(): OkHttpClient = current().http
+
+    fun webSocketClient(isolation: TorIsolation = TorIsolation.GEOHASH): OkHttpClient =
+        current().webSocket.getValue(isolation)
+
+    /**
+     * Socket factory for `isolation` on the current proxy, or null when Tor is off
+     */
+    fun torSocketFactory(isolation: TorIsolation): SocketFactory? {
+        val socks = TorManager.currentSocksAddress() ?: return null
+        return Socks5SocketFactory(socks, isolation, sessionSecret, TorManager.circuitStats)
+    }
+
+    private fun current(): Clients {
+        clients?.let { return it }
+        synchronized(lock) {
+            clients?.let { return it }
+            return build().also { clients = it }
+        }
     }
 
-    fun webSocketClient(): OkHttpClient {
-        wsClientRef.get()?.let { return it }
-        val client = baseBuilderForCurrentProxy()
+    private fun build(): Clients {
+        val socks: InetSocketAddress? = TorManager.currentSocksAddress()
+        val dispatcher = Dispatcher().apply {
+            // Every open relay websocket holds a running call
+            maxRequests = AppConstants.Network.DISPATCHER_MAX_REQUESTS
+        }
+        val builder = OkHttpClient.Builder()
+            .dispatcher(dispatcher)
+            .connectionPool(
+                ConnectionPool(
+                    AppConstants.Network.POOL_MAX_IDLE_CONNECTIONS,
+                    AppConstants.Network.POOL_KEEP_ALIVE_MS,
+                    TimeUnit.MILLISECONDS
+                )
+            )
             .connectTimeout(10, TimeUnit.SECONDS)
+        // If a SOCKS address is defined, always use it. TorManager sets this as soon as Tor mode is ON,
+        // even before bootstrap, to prevent any direct connections from occurring. Streams go out
+        // by hostname through our SOCKS5 sockets; nothing is resolved locally.
+        if (socks != null) {
+            builder.proxy(Proxy.NO_PROXY).dns(TorDns)
+        }
+        val base = builder.build()
+        fun OkHttpClient.Builder.isolated(isolation: TorIsolation): OkHttpClient.Builder = apply {
+            if (socks != null) socketFactory(Socks5SocketFactory(socks, isolation, sessionSecret, TorManager.circuitStats))
+        }
+
+        val http = base.newBuilder()
+            .isolated(TorIsolation.DIRECTORY)
+            .callTimeout(15, TimeUnit.SECONDS)
+            .readTimeout(15, TimeUnit.SECONDS)
+            .build()
+        // Pings detect dead relay sockets (onFailure -> reconnect with backoff); Tor circuits are slower
+        val pingMs = if (socks != null) AppConstants.Network.WEBSOCKET_PING_INTERVAL_TOR_MS else AppConstants.Network.WEBSOCKET_PING_INTERVAL_MS
+        val webSocketBase = base.newBuilder()
             .readTimeout(0, TimeUnit.SECONDS)
             .writeTimeout(10, TimeUnit.SECONDS)
+            .pingInterval(pingMs, TimeUnit.MILLISECONDS)
             .build()
-        wsClientRef.set(client)
-        return client
+        val webSocket = if (socks == null) {
+            TorIsolation.values().associateWith { webSocketBase }
+        } else {
+            TorIsolation.values().associateWith { webSocketBase.newBuilder().isolated(it).build() }
+        }
+        return Clients(base, http, webSocket)
     }
 
-    private fun baseBuilderForCurrentProxy(): OkHttpClient.Builder {
-        val builder = OkHttpClient.Builder()
-        val socks: InetSocketAddress? = TorManager.currentSocksAddress()
-        // If a SOCKS address is defined, always use it. TorManager sets this as soon as Tor mode is ON,
-        // even before bootstrap, to prevent any direct connections from occurring.
-        if (socks != null) {
-            val proxy = Proxy(Proxy.Type.SOCKS, socks)
-            builder.proxy(proxy)
+    // SOCKS password shared by this process's streams; a restart starts from fresh circuits
+    private val sessionSecret: String by lazy {
+        val bytes = ByteArray(16).also { java.security.SecureRandom().nextBytes(it) }
+        bytes.joinToString("") { "%02x".format(it) }
+    }
+
+    private fun drain(base: OkHttpClient) {
+        try {
+            val running = base.dispatcher.runningCallsCount()
+            base.dispatcher.cancelAll()
+            base.connectionPool.evictAll()
+            base.dispatcher.executorService.shutdown()
+            if (running > 0) Log.d(TAG, "Drained previous client ($running call(s) cancelled)")
+        } catch (e: Exception) {
+            Log.w(TAG, "Failed to drain previous client: ${e.message}")
         }
-        return builder
     }
 }
@@ -0,0 +1,123 @@
+package com.bitchat.android.net
+
+import com.bitchat.android.util.AppConstants
+import okhttp3.Dns
+import java.io.DataInputStream
+import java.io.IOException
+import java.io.InputStream
+import java.io.OutputStream
+import java.net.InetAddress
+import java.net.InetSocketAddress
+import java.net.Socket
+import java.net.SocketAddress
+import javax.net.SocketFactory
+
+/**
+ * Sockets that reach their endpoint through a SOCKS5 proxy (Arti) with username/password
+ * auth, so each [TorIsolation] key gets its own circuits. The JDK's built-in SOCKS support
+ * cannot vary credentials per connection.
+ *
+ * Used together with [TorDns]: OkHttp hands the socket an unresolved placeholder address
+ * that still carries the hostname, and the CONNECT goes out by name. DNS never leaves the
+ * device, the same as with Proxy.Type.SOCKS. Every handshake is reported to `stats` as
+ * that circuit's connect latency.
+ */
+class Socks5SocketFactory(
+    private val proxy: InetSocketAddress,
+    private val isolation: TorIsolation,
+    private val sessionSecret: String,
+    private val stats: TorCircuitStats? = null
+) : SocketFactory() {
+
+    override fun createSocket(): Socket = Socks5Socket()
+
+    override fun createSocket(host: String, port: Int): Socket =
+        createSocket().apply { connect(InetSocketAddress.createUnresolved(host, port)) }
+
+    override fun createSocket(host: String, port: Int, localHost: InetAddress?, localPort: Int): Socket =
+        createSocket(host, port)
+
+    override fun createSocket(host: InetAddress, port: Int): Socket =
+        createSocket().apply { connect(InetSocketAddress(host, port)) }
+
+    override fun createSocket(address: InetAddress, port: Int, localAddress: InetAddress?, localPort: Int): Socket =
+        createSocket(address, port)
+
+    private inner class Socks5Socket : Socket() {
+        override fun connect(endpoint: SocketAddress, timeout: Int) {
+            val target = endpoint as? InetSocketAddress ?: throw IOException("Unsupported address: $endpoint")
+            val host = target.address?.hostName ?: target.hostString
+            val key = isolation.keyFor(host)
+            val startedAt = System.nanoTime()
+            try {
+                super.connect(proxy, timeout)
+                soTimeout = AppConstants.Tor.SOCKS_CONNECT_TIMEOUT_MS.toInt()
+                Socks5.connect(getInputStream(), getOutputStream(), host, target.port, key, sessionSecret)
+                soTimeout = 0
+                stats?.record(key, (System.nanoTime() - startedAt) / 1_000_000, success = true)
+            } catch (e: IOException) {
+                stats?.record(key, (System.nanoTime() - startedAt) / 1_000_000, success = false)
+                runCatching { close() }
+                throw e
+            }
+        }
+    }
+}
+
+/**
+ * Hands OkHttp a placeholder address per host without resolving it; the SOCKS CONNECT
+ * carries the hostname and the exit resolves it.
+ */
+object TorDns : Dns {
+    private val UNSPECIFIED = byteArrayOf(0, 0, 0, 0)
+
+    override fun lookup(hostname: String): List<InetAddress> =
+        listOf(InetAddress.getByAddress(hostname, UNSPECIFIED))
+}
+
+/**
+ * Client side of the SOCKS5 handshake (RFC 1928) with username/password auth (RFC 1929)
+ */
+object Socks5 {
+    private const val VERSION: Int = 5
+    private const val AUTH_USER_PASS: Int = 2
+    private const val CMD_CONNECT: Int = 1
+    private const val ATYP_IPV4: Int = 1
+    private const val ATYP_DOMAIN: Int = 3
+    private const val ATYP_IPV6: Int = 4
+
+    fun connect(input: InputStream, output: OutputStream, host: String, port: Int, username: String, password: String) {
+        val inp = DataInputStream(input)
+        output.write(byteArrayOf(VERSION.toByte(), 1, AUTH_USER_PASS.toByte()))
+        output.flush()
+        if (inp.readUnsignedByte() != VERSION || inp.readUnsignedByte() != AUTH_USER_PASS) {
+            throw IOException("SOCKS proxy refused username/password auth")
+        }
+
+        val user = username.toByteArray(Charsets.UTF_8).take(255).toByteArray()
+        val pass = password.toByteArray(Charsets.UTF_8).take(255).toByteArray()
+        output.write(byteArrayOf(1, user.size.toByte()) + user + byteArrayOf(pass.size.toByte()) + pass)
+        output.flush()
+        inp.readUnsignedByte()
+        if (inp.readUnsignedByte() != 0) throw IOException("SOCKS auth rejected")
+
+        val name = host.toByteArray(Charsets.US_ASCII)
+        if (name.isEmpty() || name.size > 255) throw IOException("Bad SOCKS host: $host")
+        output.write(
+            byteArrayOf(VERSION.toByte(), CMD_CONNECT.toByte(), 0, ATYP_DOMAIN.toByte(), name.size.toByte()) + name +
+                byteArrayOf((port shr 8).toByte(), port.toByte())
+        )
+        output.flush()
+        if (inp.readUnsignedByte() != VERSION) throw IOException("Bad SOCKS reply")
+        val reply = inp.readUnsignedByte()
+        inp.readUnsignedByte()
+        val addressLength = when (inp.readUnsignedByte()) {
+            ATYP_IPV4 -> 4
+            ATYP_IPV6 -> 16
+            ATYP_DOMAIN -> inp.readUnsignedByte()
+            else -> throw IOException("Bad SOCKS address type")
+        }
+        inp.readFully(ByteArray(addressLength + 2))
+        if (reply != 0) throw IOException("SOCKS connect to $host:$port failed (reply $reply)")
+    }
+}
@@ -0,0 +1,71 @@
+package com.bitchat.android.net
+
+import com.bitchat.android.util.AppConstants
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+import kotlinx.coroutines.awaitAll
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.withContext
+import kotlinx.coroutines.withTimeoutOrNull
+import java.io.IOException
+import java.net.URI
+import javax.net.SocketFactory
+
+/**
+ * Builds Tor circuits before the relay websockets need them.
+ *
+ * Arti's SOCKS port accepts streams as soon as it is "sufficiently bootstrapped", which is
+ * before TorManager reports RUNNING and the relays reconnect. For each distinct isolation
+ * key, one throwaway stream is opened to a relay of that group, retrying until it goes
+ * through. The circuit then exists and is reused by the real connection that follows with
+ * the same credentials. Connect latencies land in the factory's [TorCircuitStats].
+ */
+class TorCircuitPrewarmer(private val factoryFor: (TorIsolation) -> SocketFactory) {
+
+    data class Target(val isolation: TorIsolation, val relayUrl: String)
+
+    /**
+     * Returns isolation key -> whether a stream got through before `timeoutMs`
+     */
+    suspend fun prewarm(
+        targets: List<Target>,
+        timeoutMs: Long = AppConstants.Tor.PREWARM_TIMEOUT_MS,
+        retryMs: Long = AppConstants.Tor.PREWARM_RETRY_MS
+    ): Map<String, Boolean> = coroutineScope {
+        // One stream per circuit: shared groups are only warmed once
+        val byKey = LinkedHashMap<String, Triple<TorIsolation, String, Int>>()
+        targets.forEach { target ->
+            val (host, port) = hostAndPort(target.relayUrl) ?: return@forEach
+            byKey.putIfAbsent(target.isolation.keyFor(host), Triple(target.isolation, host, port))
+        }
+        byKey.map { (key, target) ->
+            async {
+                val (isolation, host, port) = target
+                val warmed = withTimeoutOrNull(timeoutMs) {
+                    while (!tryOpen(isolation, host, port)) delay(retryMs)
+                    true
+                } ?: false
+                key to warmed
+            }
+        }.awaitAll().toMap()
+    }
+
+    private suspend fun tryOpen(isolation: TorIsolation, host: String, port: Int): Boolean = withContext(Dispatchers.IO) {
+        try {
+            factoryFor(isolation).createSocket(host, port).close()
+            true
+        } catch (_: IOException) {
+            false
+        }
+    }
+
+    private fun hostAndPort(url: String): Pair<String, Int>? = try {
+        val uri = URI(url)
+        val host = uri.host ?: return null
+        val port = if (uri.port > 0) uri.port else if (uri.scheme.equals("ws", ignoreCase = true)) 80 else 443
+        host to port
+    } catch (_: Exception) {
+        null
+    }
+}
@@ -0,0 +1,49 @@
+package com.bitchat.android.net
+
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+
+/**
+ * Connect latency per Tor circuit (isolation key): the time from opening the SOCKS
+ * connection to the proxy until the proxy reports the stream to the relay as open. That
+ * covers circuit building (or reuse) plus the exit's TCP connect.
+ */
+class TorCircuitStats(private val clock: () -> Long = System::currentTimeMillis) {
+
+    data class Circuit(
+        val key: String,
+        val lastConnectMs: Long,
+        val smoothedConnectMs: Long,
+        val connects: Int,
+        val failures: Int,
+        val updatedAt: Long
+    )
+
+    private val _circuits = MutableStateFlow<Map<String, Circuit>>(emptyMap())
+    val circuits: StateFlow<Map<String, Circuit>> = _circuits.asStateFlow()
+
+    @Synchronized
+    fun record(key: String, connectMs: Long, success: Boolean) {
+        val previous = _circuits.value[key]
+        val updated = if (success) {
+            Circuit(
+                key = key,
+                lastConnectMs = connectMs,
+                // Same 1/8 gain as TCP's srtt
+                smoothedConnectMs = previous?.takeIf { it.connects > 0 }?.let { it.smoothedConnectMs + (connectMs - it.smoothedConnectMs) / 8 } ?: connectMs,
+                connects = (previous?.connects ?: 0) + 1,
+                failures = previous?.failures ?: 0,
+                updatedAt = clock()
+            )
+        } else {
+            (previous ?: Circuit(key, 0L, 0L, 0, 0, 0L)).copy(failures = (previous?.failures ?: 0) + 1, updatedAt = clock())
+        }
+        _circuits.value = _circuits.value + (key to updated)
+    }
+
+    @Synchronized
+    fun clear() {
+        _circuits.value = emptyMap()
+    }
+}
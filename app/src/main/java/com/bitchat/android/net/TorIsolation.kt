@@ -0,0 +1,21 @@
+package com.bitchat.android.net
+
+/**
+ * Which relay connections may share a Tor circuit.
+ *
+ * Arti gives streams with different SOCKS credentials different circuits, so each isolation
+ * key becomes the SOCKS username. DM relays get a circuit each, so one exit never sees
+ * the whole private-message relay set. Geohash relays carry public channel traffic and share
+ * one circuit. Directory downloads get their own.
+ */
+enum class TorIsolation {
+    DIRECT_MESSAGES,
+    GEOHASH,
+    DIRECTORY;
+
+    fun keyFor(host: String): String = when (this) {
+        DIRECT_MESSAGES -> "dm:${host.lowercase()}"
+        GEOHASH -> "geohash"
+        DIRECTORY -> "directory"
+    }
+}
@@ -19,6 +19,7 @@ import kotlinx.coroutines.Job
 import kotlinx.coroutines.withTimeoutOrNull
 import kotlinx.coroutines.CompletableDeferred
 
+import java.io.IOException
 import java.net.InetSocketAddress
 import java.util.concurrent.atomic.AtomicReference
 import java.util.concurrent.atomic.AtomicLong
@@ -69,6 +70,10 @@ object TorManager {
 
     private val stateChangeDeferred = AtomicReference<CompletableDeferred<TorState>?>(null)
 
+    // Per-circuit (isolation key) connect latency, fed by every SOCKS stream we open
+    val circuitStats = TorCircuitStats()
+    private var prewarmJob: Job? = null
+
     fun isProxyEnabled(): Boolean {
         val s = _status.value
         return s.mode != TorMode.OFF && s.running && s.bootstrapPercent >= 100 && socksAddr != null && s.state == TorState.RUNNING
@@ -126,6 +131,7 @@ object TorManager {
                         // Best-effort wait for STOPPED before we declare OFF
                         waitForStateTransition(target = TorState.OFF, timeoutMs = STOP_TIMEOUT_MS)
                         socksAddr = null
+                        circuitStats.clear()
                         _status.value = _status.value.copy(mode = TorMode.OFF, running = false, bootstrapPercent = 0, state = TorState.OFF)
                         currentSocksPort = DEFAULT_SOCKS_PORT
                         bindRetryAttempts = 0
@@ -243,7 +249,29 @@ object TorManager {
                message.contains("could not bind")
     }
 
+    /**
+     * SOCKS works from here on while bootstrap continues: build the relay circuits now so
+     * the reconnect after RUNNING does not wait for them
+     */
+    private fun startCircuitPrewarm() {
+        prewarmJob?.cancel()
+        prewarmJob = appScope.launch {
+            val targets = try {
+                com.bitchat.android.nostr.NostrRelayManager.shared.torPrewarmTargets()
+            } catch (_: Throwable) { emptyList() }
+            if (targets.isEmpty()) return@launch
+            val prewarmer = TorCircuitPrewarmer { isolation ->
+                OkHttpProvider.torSocketFactory(isolation) ?: throw IOException("Tor proxy not set")
+            }
+            val started = System.currentTimeMillis()
+            val results = prewarmer.prewarm(targets)
+            Log.i(TAG, "Prewarmed ${results.count { it.value }}/${results.size} circuits in ${System.currentTimeMillis() - started}ms")
+        }
+    }
+
     private fun stopArtiInternal() {
+        prewarmJob?.cancel()
+        prewarmJob = null
         try {
             val proxy = artiProxyRef.getAndSet(null)
             if (proxy != null) {
@@ -363,6 +391,7 @@ object TorManager {
                 retryAttempts = 0
                 bindRetryAttempts = 0
                 startInactivityMonitoring()
+                startCircuitPrewarm()
             }
             //s.contains("AMEx: state changed to Running", ignoreCase = true) -> {
             s.contains("We have found that guard [scrubbed] is usable.", ignoreCase = true) -> {
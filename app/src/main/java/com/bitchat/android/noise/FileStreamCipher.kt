@@ -0,0 +1,130 @@
+package com.bitchat.android.noise
+
+import com.bitchat.android.noise.southernstorm.protocol.ChaChaPolyCipherState
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.security.SecureRandom
+import javax.crypto.Mac
+import javax.crypto.spec.SecretKeySpec
+
+/**
+ * Record-level AEAD for streamed private file transfers.
+ *
+ * The sender picks a random transfer secret and delivers it inside a Noise transport
+ * message (FILE_STREAM_START). Both sides derive the record key with HKDF-SHA256 using
+ * the Noise handshake hash as salt, so the key is bound to the session that carried it.
+ *
+ * Each record is sealed independently with ChaCha20-Poly1305 (nonce = record index).
+ * The associated data is transferId || index || final flag, so a record cannot be
+ * replayed into another transfer or index, and the stream cannot be truncated unnoticed.
+ */
+class FileStreamCipher private constructor(key: ByteArray, transferId: ByteArray) {
+
+    companion object {
+        const val SECRET_SIZE = 32
+        const val TRANSFER_ID_SIZE = 16
+        const val TAG_SIZE = 16
+
+        private const val KEY_SIZE = 32
+        private const val KDF_LABEL = "bitchat-file-stream-v1"
+        private val secureRandom = SecureRandom()
+
+        /**
+         * Derive the record cipher for a transfer from the shared secret and session binding
+         */
+        fun create(secret: ByteArray, handshakeHash: ByteArray, transferId: ByteArray): FileStreamCipher {
+            require(secret.size == SECRET_SIZE) { "Transfer secret must be $SECRET_SIZE bytes, got ${secret.size}" }
+            require(transferId.size == TRANSFER_ID_SIZE) { "Transfer ID must be $TRANSFER_ID_SIZE bytes, got ${transferId.size}" }
+            val info = KDF_LABEL.toByteArray(Charsets.UTF_8) + transferId
+            val key = hkdfSha256(secret, handshakeHash, info, KEY_SIZE)
+            return FileStreamCipher(key, transferId)
+        }
+
+        fun newSecret(): ByteArray = ByteArray(SECRET_SIZE).also { secureRandom.nextBytes(it) }
+
+        fun newTransferId(): ByteArray = ByteArray(TRANSFER_ID_SIZE).also { secureRandom.nextBytes(it) }
+
+        /**
+         * RFC 5869 HKDF (extract + expand) over HMAC-SHA256
+         */
+        internal fun hkdfSha256(ikm: ByteArray, salt: ByteArray, info: ByteArray, length: Int): ByteArray {
+            val extract = Mac.getInstance("HmacSHA256")
+            extract.init(SecretKeySpec(if (salt.isEmpty()) ByteArray(32) else salt, "HmacSHA256"))
+            val prk = extract.doFinal(ikm)
+
+            val expand = Mac.getInstance("HmacSHA256")
+            expand.init(SecretKeySpec(prk, "HmacSHA256"))
+            val output = ByteArray(length)
+            var previous = ByteArray(0)
+            var offset = 0
+            var counter = 1
+            while (offset < length) {
+                expand.update(previous)
+                expand.update(info)
+                expand.update(counter.toByte())
+                previous = expand.doFinal()
+                val take = minOf(previous.size, length - offset)
+                System.arraycopy(previous, 0, output, offset, take)
+                offset += take
+                counter++
+            }
+            prk.fill(0)
+            return output
+        }
+    }
+
+    private val transferId = transferId.copyOf()
+
+    // ChaChaPolyCipherState is not thread-safe; records may be opened from concurrent handlers
+    private val cipher = ChaChaPolyCipherState()
+    private val cipherLock = Any()
+
+    init {
+        cipher.initializeKey(key, 0)
+        key.fill(0)
+    }
+
+    /**
+     * Seal one record; returns ciphertext || 16-byte tag
+     */
+    fun seal(index: Int, isFinal: Boolean, plaintext: ByteArray): ByteArray {
+        require(index >= 0) { "Record index must be non-negative" }
+        val ad = associatedData(index, isFinal)
+        val out = ByteArray(plaintext.size + TAG_SIZE)
+        synchronized(cipherLock) {
+            cipher.setNonce(index.toLong())
+            cipher.encryptWithAd(ad, plaintext, 0, out, 0, plaintext.size)
+        }
+        return out
+    }
+
+    /**
+     * Open one record; throws if the tag does not verify for this transfer/index/final flag
+     */
+    fun open(index: Int, isFinal: Boolean, sealed: ByteArray): ByteArray {
+        if (index < 0 || sealed.size < TAG_SIZE) throw SessionError.DecryptionFailed
+        val ad = associatedData(index, isFinal)
+        val out = ByteArray(sealed.size - TAG_SIZE)
+        synchronized(cipherLock) {
+            cipher.setNonce(index.toLong())
+            try {
+                cipher.decryptWithAd(ad, sealed, 0, out, 0, sealed.size)
+            } catch (e: Exception) {
+                throw SessionError.DecryptionFailed
+            }
+        }
+        return out
+    }
+
+    fun destroy() {
+        synchronized(cipherLock) { cipher.destroy() }
+    }
+
+    private fun associatedData(index: Int, isFinal: Boolean): ByteArray {
+        return ByteBuffer.allocate(TRANSFER_ID_SIZE + 5).order(ByteOrder.BIG_ENDIAN)
+            .put(transferId)
+            .putInt(index)
+            .put(if (isFinal) 1 else 0)
+            .array()
+    }
+}
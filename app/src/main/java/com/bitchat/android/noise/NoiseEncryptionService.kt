@@ -5,6 +5,7 @@ import android.util.Log
 import com.bitchat.android.identity.SecureIdentityStateManager
 import com.bitchat.android.mesh.PeerFingerprintManager
 import com.bitchat.android.noise.southernstorm.protocol.Noise
+import com.bitchat.android.services.StartupCoordinator
 import java.security.MessageDigest
 import java.security.SecureRandom
 import java.util.concurrent.ConcurrentHashMap
@@ -26,8 +27,85 @@ class NoiseEncryptionService(private val context: Context) {
         // Session limits for performance and security
         private const val REKEY_TIME_LIMIT = com.bitchat.android.util.AppConstants.Noise.REKEY_TIME_LIMIT_MS // 1 hour (same as iOS)
         private const val REKEY_MESSAGE_LIMIT = com.bitchat.android.util.AppConstants.Noise.REKEY_MESSAGE_LIMIT_ENCRYPTION // 1k messages (matches iOS) (same as iOS)
+        
+        /**
+         * Load or create the persistent static (Curve25519) and signing (Ed25519) key pairs.
+         * Hits keystore-backed storage, so call it off the main thread (see StartupCoordinator).
+         */
+        fun loadOrCreateIdentityKeys(identityStateManager: SecureIdentityStateManager): IdentityKeys {
+            val staticKeyPair = identityStateManager.loadStaticKey()?.also {
+                Log.d(TAG, "Loaded existing static identity key")
+            } ?: generateKeyPair().also {
+                identityStateManager.saveStaticKey(it.first, it.second)
+                Log.d(TAG, "Generated and saved new static identity key")
+            }
+            
+            val signingKeyPair = identityStateManager.loadSigningKey()?.also {
+                Log.d(TAG, "Loaded existing Ed25519 signing key")
+            } ?: generateEd25519KeyPair().also {
+                identityStateManager.saveSigningKey(it.first, it.second)
+                Log.d(TAG, "Generated and saved new Ed25519 signing key")
+            }
+            
+            return IdentityKeys(staticKeyPair.first, staticKeyPair.second, signingKeyPair.first, signingKeyPair.second)
+        }
+        
+        /**
+         * Generate a new Curve25519 key pair using the real Noise library
+         * Returns (privateKey, publicKey) as 32-byte arrays
+         */
+        private fun generateKeyPair(): Pair<ByteArray, ByteArray> {
+            try {
+                val dhState = com.bitchat.android.noise.southernstorm.protocol.Noise.createDH("25519")
+                dhState.generateKeyPair()
+                
+                val privateKey = ByteArray(32)
+                val publicKey = ByteArray(32)
+                
+                dhState.getPrivateKey(privateKey, 0)
+                dhState.getPublicKey(publicKey, 0)
+                
+                dhState.destroy()
+                
+                return Pair(privateKey, publicKey)
+            } catch (e: Exception) {
+                Log.e(TAG, "Failed to generate key pair: ${e.message}")
+                throw e
+            }
+        }
+        
+        /**
+         * Generate a new Ed25519 key pair for signing using BouncyCastle
+         * Returns (privateKey, publicKey) as 32-byte arrays
+         */
+        private fun generateEd25519KeyPair(): Pair<ByteArray, ByteArray> {
+            try {
+                // Use BouncyCastle for proper Ed25519 key generation
+                val keyGen = org.bouncycastle.crypto.generators.Ed25519KeyPairGenerator()
+                keyGen.init(org.bouncycastle.crypto.params.Ed25519KeyGenerationParameters(SecureRandom()))
+                val keyPair = keyGen.generateKeyPair()
+                
+                val privateKey = (keyPair.private as org.bouncycastle.crypto.params.Ed25519PrivateKeyParameters).encoded
+                val publicKey = (keyPair.public as org.bouncycastle.crypto.params.Ed25519PublicKeyParameters).encoded
+                
+                return Pair(privateKey, publicKey)
+            } catch (e: Exception) {
+                Log.e(TAG, "Failed to generate Ed25519 key pair: ${e.message}")
+                throw e
+            }
+        }
     }
     
+    /**
+     * Persistent identity key material loaded at startup
+     */
+    class IdentityKeys(
+        val staticPrivateKey: ByteArray,
+        val staticPublicKey: ByteArray,
+        val signingPrivateKey: ByteArray,
+        val signingPublicKey: ByteArray
+    )
+    
     // Static identity key (persistent across app restarts) - loaded from secure storage
     private val staticIdentityPrivateKey: ByteArray
     private val staticIdentityPublicKey: ByteArray
@@ -56,39 +134,12 @@ class NoiseEncryptionService(private val context: Context) {
         // Initialize identity state manager for persistent storage
         identityStateManager = SecureIdentityStateManager(context)
         
-        // Load or create static identity key (persistent across sessions)
-        val loadedKeyPair = identityStateManager.loadStaticKey()
-        if (loadedKeyPair != null) {
-            staticIdentityPrivateKey = loadedKeyPair.first
-            staticIdentityPublicKey = loadedKeyPair.second
-            Log.d(TAG, "Loaded existing static identity key: ${calculateFingerprint(staticIdentityPublicKey)}")
-        } else {
-            // Generate new identity key pair
-            val keyPair = generateKeyPair()
-            staticIdentityPrivateKey = keyPair.first
-            staticIdentityPublicKey = keyPair.second
-            
-            // Save to secure storage
-            identityStateManager.saveStaticKey(staticIdentityPrivateKey, staticIdentityPublicKey)
-            Log.d(TAG, "Generated and saved new static identity key")
-        }
-        
-        // Load or create Ed25519 signing key (persistent across sessions)
-        val loadedSigningKeyPair = identityStateManager.loadSigningKey()
-        if (loadedSigningKeyPair != null) {
-            signingPrivateKey = loadedSigningKeyPair.first
-            signingPublicKey = loadedSigningKeyPair.second
-            Log.d(TAG, "Loaded existing Ed25519 signing key")
-        } else {
-            // Generate new Ed25519 signing key pair
-            val signingKeyPair = generateEd25519KeyPair()
-            signingPrivateKey = signingKeyPair.first
-            signingPublicKey = signingKeyPair.second
-            
-            // Save to secure storage
-            identityStateManager.saveSigningKey(signingPrivateKey, signingPublicKey)
-            Log.d(TAG, "Generated and saved new Ed25519 signing key")
-        }
+        // Static and signing keys are warmed up off the main thread at app start; wait for them here
+        val keys = StartupCoordinator.awaitIdentityKeys(context)
+        staticIdentityPrivateKey = keys.staticPrivateKey
+        staticIdentityPublicKey = keys.staticPublicKey
+        signingPrivateKey = keys.signingPrivateKey
+        signingPublicKey = keys.signingPublicKey
         
         // Initialize session manager
         sessionManager = NoiseSessionManager(staticIdentityPrivateKey, staticIdentityPublicKey)
@@ -136,6 +187,7 @@ class NoiseEncryptionService(private val context: Context) {
      */
     fun clearPersistentIdentity() {
         identityStateManager.clearIdentityData()
+        StartupCoordinator.invalidateIdentity()
     }
     
     // MARK: - Handshake Management
@@ -180,6 +232,21 @@ class NoiseEncryptionService(private val context: Context) {
         return sessionManager.getSessionState(peerID)
     }
     
+    /**
+     * Get the handshake hash of the established session with a peer (channel binding)
+     */
+    fun getHandshakeHash(peerID: String): ByteArray? {
+        if (!hasEstablishedSession(peerID)) return null
+        return sessionManager.getHandshakeHash(peerID)
+    }
+    
+    /**
+     * Use the bulk replay window for a peer about to stream a file to us
+     */
+    fun useBulkReplayWindow(peerID: String) {
+        sessionManager.useBulkReplayWindow(peerID)
+    }
+    
     // MARK: - Encryption/Decryption
     
     /**
@@ -316,30 +383,6 @@ class NoiseEncryptionService(private val context: Context) {
     
     // MARK: - Private Helpers
     
-    /**
-     * Generate a new Curve25519 key pair using the real Noise library
-     * Returns (privateKey, publicKey) as 32-byte arrays
-     */
-    private fun generateKeyPair(): Pair<ByteArray, ByteArray> {
-        try {
-            val dhState = com.bitchat.android.noise.southernstorm.protocol.Noise.createDH("25519")
-            dhState.generateKeyPair()
-            
-            val privateKey = ByteArray(32)
-            val publicKey = ByteArray(32)
-            
-            dhState.getPrivateKey(privateKey, 0)
-            dhState.getPublicKey(publicKey, 0)
-            
-            dhState.destroy()
-            
-            return Pair(privateKey, publicKey)
-        } catch (e: Exception) {
-            Log.e(TAG, "Failed to generate key pair: ${e.message}")
-            throw e
-        }
-    }
-    
     /**
      * Handle session establishment (called when Noise handshake completes)
      */
@@ -421,27 +464,6 @@ class NoiseEncryptionService(private val context: Context) {
         }
     }
 
-    /**
-     * Generate a new Ed25519 key pair for signing using BouncyCastle
-     * Returns (privateKey, publicKey) as 32-byte arrays
-     */
-    private fun generateEd25519KeyPair(): Pair<ByteArray, ByteArray> {
-        try {
-            // Use BouncyCastle for proper Ed25519 key generation
-            val keyGen = org.bouncycastle.crypto.generators.Ed25519KeyPairGenerator()
-            keyGen.init(org.bouncycastle.crypto.params.Ed25519KeyGenerationParameters(SecureRandom()))
-            val keyPair = keyGen.generateKeyPair()
-            
-            val privateKey = (keyPair.private as org.bouncycastle.crypto.params.Ed25519PrivateKeyParameters).encoded
-            val publicKey = (keyPair.public as org.bouncycastle.crypto.params.Ed25519PublicKeyParameters).encoded
-            
-            return Pair(privateKey, publicKey)
-        } catch (e: Exception) {
-            Log.e(TAG, "Failed to generate Ed25519 key pair: ${e.message}")
-            throw e
-        }
-    }
-
     /**
      * Sign data with Ed25519 private key using BouncyCastle
      */
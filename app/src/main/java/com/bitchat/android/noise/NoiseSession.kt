@@ -38,73 +38,10 @@ class NoiseSession(
         
         // Constants for replay protection (matching iOS implementation)
         private const val NONCE_SIZE_BYTES = 4
-        private const val REPLAY_WINDOW_SIZE = 1024
-        private const val REPLAY_WINDOW_BYTES = REPLAY_WINDOW_SIZE / 8 // 128 bytes
+        private const val REPLAY_WINDOW_SIZE = com.bitchat.android.util.AppConstants.Noise.REPLAY_WINDOW_SIZE
+        private const val REPLAY_WINDOW_SIZE_BULK = com.bitchat.android.util.AppConstants.Noise.REPLAY_WINDOW_SIZE_BULK
         private const val HIGH_NONCE_WARNING_THRESHOLD = com.bitchat.android.util.AppConstants.Noise.HIGH_NONCE_WARNING_THRESHOLD
         
-        // MARK: - Sliding Window Replay Protection
-        
-        /**
-         * Check if nonce is valid for replay protection (matching iOS implementation)
-         */
-        private fun isValidNonce(receivedNonce: Long, highestReceivedNonce: Long, replayWindow: ByteArray): Boolean {
-            if (receivedNonce + REPLAY_WINDOW_SIZE <= highestReceivedNonce) {
-                return false  // Too old, outside window
-            }
-            
-            if (receivedNonce > highestReceivedNonce) {
-                return true  // Always accept newer nonces
-            }
-            
-            val offset = (highestReceivedNonce - receivedNonce).toInt()
-            val byteIndex = offset / 8
-            val bitIndex = offset % 8
-            
-            return (replayWindow[byteIndex].toInt() and (1 shl bitIndex)) == 0  // Not yet seen
-        }
-        
-        /**
-         * Mark nonce as seen in replay window (matching iOS implementation)
-         */
-        private fun markNonceAsSeen(receivedNonce: Long, highestReceivedNonce: Long, replayWindow: ByteArray): Pair<Long, ByteArray> {
-            var newHighestReceivedNonce = highestReceivedNonce
-            val newReplayWindow = replayWindow.copyOf()
-            
-            if (receivedNonce > highestReceivedNonce) {
-                val shift = (receivedNonce - highestReceivedNonce).toInt()
-                
-                if (shift >= REPLAY_WINDOW_SIZE) {
-                    // Clear entire window - shift is too large
-                    newReplayWindow.fill(0)
-                } else {
-                    // Shift window right by `shift` bits
-                    for (i in (REPLAY_WINDOW_BYTES - 1) downTo 0) {
-                        val sourceByteIndex = i - shift / 8
-                        var newByte = 0
-                        
-                        if (sourceByteIndex >= 0) {
-                            newByte = (newReplayWindow[sourceByteIndex].toInt() and 0xFF) ushr (shift % 8)
-                            if (sourceByteIndex > 0 && shift % 8 != 0) {
-                                newByte = newByte or ((newReplayWindow[sourceByteIndex - 1].toInt() and 0xFF) shl (8 - shift % 8))
-                            }
-                        }
-                        
-                        newReplayWindow[i] = (newByte and 0xFF).toByte()
-                    }
-                }
-                
-                newHighestReceivedNonce = receivedNonce
-                newReplayWindow[0] = (newReplayWindow[0].toInt() or 1).toByte()  // Mark most recent bit as seen
-            } else {
-                val offset = (highestReceivedNonce - receivedNonce).toInt()
-                val byteIndex = offset / 8
-                val bitIndex = offset % 8
-                newReplayWindow[byteIndex] = (newReplayWindow[byteIndex].toInt() or (1 shl bitIndex)).toByte()
-            }
-            
-            return Pair(newHighestReceivedNonce, newReplayWindow)
-        }
-        
         /**
          * Extract nonce from combined payload <nonce><ciphertext> (matching iOS implementation)
          * Returns Pair of (nonce, ciphertext) or null if invalid
@@ -160,8 +97,7 @@ class NoiseSession(
     private var messagesReceived = 0L
     
     // Sliding window replay protection (used during transport encryption/decryption)
-    private var highestReceivedNonce = 0L
-    private var replayWindow = ByteArray(REPLAY_WINDOW_BYTES)
+    private val replayWindow = ReplayWindow(REPLAY_WINDOW_SIZE)
     
     // CRITICAL FIX: Enhanced thread safety for cipher operations
     // The noise-java CipherState objects are NOT thread-safe. Multiple concurrent
@@ -455,8 +391,7 @@ class NoiseSession(
             currentPattern = 0
             
             // Reset sliding window replay protection for new transport phase
-            highestReceivedNonce = 0L
-            replayWindow = ByteArray(REPLAY_WINDOW_BYTES)
+            synchronized(cipherLock) { replayWindow.reset() }
             
             state = NoiseSessionState.Established
             Log.d(TAG, "Handshake completed with $peerID as isInitiator: $isInitiator - transport keys derived")
@@ -574,9 +509,21 @@ class NoiseSession(
                 val (extractedNonce, ciphertext) = nonceAndCiphertext
                 
                 // Validate nonce with sliding window replay protection
-                if (!isValidNonce(extractedNonce, highestReceivedNonce, replayWindow)) {
-                    Log.w(TAG, "Replay attack detected: nonce $extractedNonce rejected for $peerID")
-                    throw SessionError.DecryptionFailed
+                when (replayWindow.check(extractedNonce)) {
+                    ReplayWindow.Verdict.ACCEPT -> Unit
+                    ReplayWindow.Verdict.DUPLICATE -> {
+                        Log.w(TAG, "Replay attack detected: nonce $extractedNonce rejected for $peerID")
+                        throw SessionError.DecryptionFailed
+                    }
+                    ReplayWindow.Verdict.TOO_OLD -> {
+                        Log.w(TAG, "Nonce $extractedNonce fell behind replay window (highest: ${replayWindow.highestNonce}, window: ${replayWindow.windowSize}) for $peerID")
+                        // Reordering on this path is deeper than the window; widen it for the rest of the session
+                        if (replayWindow.windowSize < REPLAY_WINDOW_SIZE_BULK) {
+                            replayWindow.resize(REPLAY_WINDOW_SIZE_BULK)
+                            Log.i(TAG, "Widened replay window to $REPLAY_WINDOW_SIZE_BULK for $peerID")
+                        }
+                        throw SessionError.DecryptionFailed
+                    }
                 }
                 
                 // Use the extracted nonce for decryption
@@ -586,9 +533,7 @@ class NoiseSession(
                 val plaintextLength = receiveCipher!!.decryptWithAd(null, ciphertext, 0, plaintext, 0, ciphertext.size)
                 
                 // Mark nonce as seen after successful decryption
-                val (newHighestReceivedNonce, newReplayWindow) = markNonceAsSeen(extractedNonce, highestReceivedNonce, replayWindow)
-                highestReceivedNonce = newHighestReceivedNonce
-                replayWindow = newReplayWindow
+                replayWindow.markSeen(extractedNonce)
 
                 // Log high nonce values that might indicate issues
                 if (extractedNonce > HIGH_NONCE_WARNING_THRESHOLD) {
@@ -596,7 +541,7 @@ class NoiseSession(
                 }
 
                 val result = plaintext.copyOf(plaintextLength)
-                Log.d(TAG, "✅ ANDROID DECRYPT: ${combinedPayload.size} → ${result.size} bytes from $peerID (nonce: $extractedNonce, highest: $highestReceivedNonce, role: ${if (isInitiator) "INITIATOR" else "RESPONDER"})")
+                Log.d(TAG, "✅ ANDROID DECRYPT: ${combinedPayload.size} → ${result.size} bytes from $peerID (nonce: $extractedNonce, highest: ${replayWindow.highestNonce}, role: ${if (isInitiator) "INITIATOR" else "RESPONDER"})")
                 return result
                 
             } catch (e: Exception) {
@@ -606,7 +551,7 @@ class NoiseSession(
                 if (receiveCipher != null) {
                     Log.e(TAG, "Receive cipher state: ${receiveCipher!!.javaClass.simpleName}")
                 }
-                Log.e(TAG, "Session state: $state, highest received nonce: $highestReceivedNonce")
+                Log.e(TAG, "Session state: $state, highest received nonce: ${replayWindow.highestNonce}")
                 Log.e(TAG, "Input data size: ${combinedPayload.size} bytes")
                 
                 throw SessionError.DecryptionFailed
@@ -630,6 +575,20 @@ class NoiseSession(
         return handshakeHash?.clone()
     }
     
+    /**
+     * Set the replay window size (multiple of 64); history that still fits is kept
+     */
+    fun setReplayWindowSize(size: Int) {
+        synchronized(cipherLock) { replayWindow.resize(size) }
+    }
+    
+    /**
+     * Replay rejections so far as (too old, duplicate)
+     */
+    fun getReplayRejections(): Pair<Long, Long> {
+        return synchronized(cipherLock) { Pair(replayWindow.tooOldCount, replayWindow.duplicateCount) }
+    }
+    
     /**
      * Check if session needs rekeying
      */
@@ -651,6 +610,10 @@ class NoiseSession(
         appendLine("  Role: ${if (isInitiator) "initiator" else "responder"}")
         appendLine("  Messages sent: $messagesSent")
         appendLine("  Messages received: $messagesReceived")
+        synchronized(cipherLock) {
+            appendLine("  Replay window: ${replayWindow.windowSize} (highest nonce: ${replayWindow.highestNonce}, max reorder depth: ${replayWindow.maxReorderDepth})")
+            appendLine("  Rejected nonces: ${replayWindow.tooOldCount} too old, ${replayWindow.duplicateCount} duplicate")
+        }
         appendLine("  Session age: ${(System.currentTimeMillis() - creationTime) / 1000}s")
         appendLine("  Needs rekey: ${needsRekey()}")
         appendLine("  Has remote key: ${remoteStaticPublicKey != null}")
@@ -673,8 +636,7 @@ class NoiseSession(
             messagesReceived = 0
             
             // Reset sliding window replay protection
-            highestReceivedNonce = 0L
-            replayWindow = ByteArray(REPLAY_WINDOW_BYTES)
+            synchronized(cipherLock) { replayWindow.reset() }
             
             remoteStaticPublicKey = null
             handshakeHash = null
@@ -177,6 +177,13 @@ class NoiseSessionManager(
         return getSession(peerID)?.getHandshakeHash()
     }
     
+    /**
+     * Widen a peer's replay window for a bulk transfer, whose bursts reorder far more nonces
+     */
+    fun useBulkReplayWindow(peerID: String) {
+        getSession(peerID)?.setReplayWindowSize(com.bitchat.android.util.AppConstants.Noise.REPLAY_WINDOW_SIZE_BULK)
+    }
+    
     /**
      * Get sessions that need rekeying based on time or message count
      */
@@ -199,7 +206,8 @@ class NoiseSessionManager(
         if (sessions.isNotEmpty()) {
             appendLine("Sessions:")
             sessions.forEach { (peerID, session) ->
-                appendLine("  $peerID: ${session.getState()}")
+                val (tooOld, duplicate) = session.getReplayRejections()
+                appendLine("  $peerID: ${session.getState()} (replay rejects: $tooOld too old, $duplicate duplicate)")
             }
         }
     }
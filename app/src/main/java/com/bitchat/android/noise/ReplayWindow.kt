@@ -0,0 +1,121 @@
+package com.bitchat.android.noise
+
+/**
+ * Sliding-window replay protection for Noise transport nonces.
+ *
+ * Bit k of the window records whether nonce (highest - k) has been seen. The bitmap is a
+ * LongArray so advancing the window shifts whole words instead of individual bytes, and
+ * is updated in place rather than copied per message.
+ *
+ * Rejections are split into "too old" (fell behind the window, usually reordering deeper
+ * than the window on multi-path relays) and "duplicate" (a genuine replay or a relayed
+ * copy), so loss from reordering is visible separately from replays.
+ *
+ * Not thread-safe; NoiseSession only touches it under its cipher lock.
+ */
+class ReplayWindow(windowSize: Int) {
+
+    enum class Verdict { ACCEPT, TOO_OLD, DUPLICATE }
+
+    var windowSize: Int = checkedSize(windowSize)
+        private set
+
+    private var bits = LongArray(windowSize / Long.SIZE_BITS)
+
+    var highestNonce = 0L
+        private set
+
+    // Statistics
+    var tooOldCount = 0L
+        private set
+    var duplicateCount = 0L
+        private set
+    var maxReorderDepth = 0L
+        private set
+
+    /**
+     * Check a received nonce without recording it; counts rejections
+     */
+    fun check(nonce: Long): Verdict {
+        if (nonce > highestNonce) return Verdict.ACCEPT
+        val offset = highestNonce - nonce
+        if (offset >= windowSize) {
+            tooOldCount++
+            return Verdict.TOO_OLD
+        }
+        if (isSet(offset.toInt())) {
+            duplicateCount++
+            return Verdict.DUPLICATE
+        }
+        return Verdict.ACCEPT
+    }
+
+    /**
+     * Record a nonce as seen; call only after the message authenticated
+     */
+    fun markSeen(nonce: Long) {
+        if (nonce > highestNonce) {
+            shiftBy(nonce - highestNonce)
+            highestNonce = nonce
+            bits[0] = bits[0] or 1L
+        } else {
+            val offset = highestNonce - nonce
+            if (offset >= windowSize) return
+            if (offset > maxReorderDepth) maxReorderDepth = offset
+            val bit = offset.toInt()
+            bits[bit / Long.SIZE_BITS] = bits[bit / Long.SIZE_BITS] or (1L shl (bit % Long.SIZE_BITS))
+        }
+    }
+
+    /**
+     * Change the window size, keeping history for offsets that still fit.
+     * When growing, offsets the old window had already dropped are marked seen: their
+     * history is unknown, so accepting them would reopen a replay hole.
+     */
+    fun resize(newWindowSize: Int) {
+        val size = checkedSize(newWindowSize)
+        if (size == windowSize) return
+        val oldWords = bits.size
+        bits = bits.copyOf(size / Long.SIZE_BITS)
+        if (bits.size > oldWords) bits.fill(-1L, oldWords, bits.size)
+        windowSize = size
+    }
+
+    fun reset() {
+        bits.fill(0L)
+        highestNonce = 0L
+        tooOldCount = 0L
+        duplicateCount = 0L
+        maxReorderDepth = 0L
+    }
+
+    private fun isSet(offset: Int): Boolean {
+        return (bits[offset / Long.SIZE_BITS] and (1L shl (offset % Long.SIZE_BITS))) != 0L
+    }
+
+    /**
+     * Move every recorded offset up by `shift` (the window's top advanced by that much)
+     */
+    private fun shiftBy(shift: Long) {
+        if (shift >= windowSize) {
+            bits.fill(0L)
+            return
+        }
+        val wordShift = (shift / Long.SIZE_BITS).toInt()
+        val bitShift = (shift % Long.SIZE_BITS).toInt()
+        // Walk from the top word down so each source word is read before it is overwritten
+        for (i in bits.indices.reversed()) {
+            val src = i - wordShift
+            var word = if (src >= 0) bits[src] shl bitShift else 0L
+            if (bitShift != 0 && src - 1 >= 0) {
+                word = word or (bits[src - 1] ushr (Long.SIZE_BITS - bitShift))
+            }
+            bits[i] = word
+        }
+    }
+
+    private fun checkedSize(size: Int): Int {
+        require(size > 0 && size % Long.SIZE_BITS == 0) { "Replay window must be a positive multiple of 64, got $size" }
+        return size
+    }
+}
@@ -0,0 +1,38 @@
+package com.bitchat.android.nostr
+
+import android.content.Context
+import android.content.SharedPreferences
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+
+/**
+ * Opt-in flag for bridge node mode (mesh timeline <-> local geohash channel)
+ */
+object BridgePreferenceManager {
+
+    private const val PREFS_NAME = "bridge_preferences"
+    private const val KEY_BRIDGE_ENABLED = "bridge_enabled"
+
+    private val _bridgeEnabled = MutableStateFlow(false)
+    val bridgeEnabled: StateFlow<Boolean> = _bridgeEnabled.asStateFlow()
+
+    private lateinit var sharedPrefs: SharedPreferences
+    private var isInitialized = false
+
+    fun init(context: Context) {
+        if (isInitialized) return
+        sharedPrefs = context.getSharedPreferences(PREFS_NAME, Context.MODE_PRIVATE)
+        _bridgeEnabled.value = sharedPrefs.getBoolean(KEY_BRIDGE_ENABLED, false)
+        isInitialized = true
+    }
+
+    fun isBridgeEnabled(): Boolean = _bridgeEnabled.value
+
+    fun setBridgeEnabled(enabled: Boolean) {
+        _bridgeEnabled.value = enabled
+        if (::sharedPrefs.isInitialized) {
+            sharedPrefs.edit().putBoolean(KEY_BRIDGE_ENABLED, enabled).apply()
+        }
+    }
+}
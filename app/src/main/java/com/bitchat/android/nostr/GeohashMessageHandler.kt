@@ -5,8 +5,13 @@ import android.util.Log
 import com.bitchat.android.model.BitchatMessage
 import com.bitchat.android.ui.ChatState
 import com.bitchat.android.ui.MessageManager
+import com.bitchat.android.util.AppConstants
+import com.bitchat.android.util.BatchingQueue
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+import kotlinx.coroutines.awaitAll
+import kotlinx.coroutines.coroutineScope
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
 import java.util.Date
@@ -15,7 +20,11 @@ import java.util.Date
  * GeohashMessageHandler
  * - Processes kind=20000 Nostr events for geohash channels
  * - Updates repository for participants + nicknames
+ * - Persists verified events to [NostrEventStore] and replays them on channel switch
+ * - Catches up with relays by negentropy reconciliation against the store when supported
  * - Emits messages to MessageManager
+ * - Events are queued and handled in batches on a background dispatcher, with one
+ *   main-thread hop per batch
  */
 class GeohashMessageHandler(
     private val application: Application,
@@ -32,6 +41,15 @@ class GeohashMessageHandler(
     private val seen = HashSet<String>()
     private val max = 2000
 
+    private val eventStore = NostrEventStore.getInstance(application)
+
+    private data class Incoming(val event: NostrEvent, val geohash: String, val fromStore: Boolean)
+
+    // Relay and replayed events are parsed, verified, stored and turned into messages in
+    // batches off the main thread
+    private val incoming = BatchingQueue<Incoming>(scope, AppConstants.Nostr.EVENT_BATCH_MAX) { processBatch(it) }
+
+    @Synchronized
     private fun dedupe(id: String): Boolean {
         if (seen.contains(id)) return true
         seen.add(id)
@@ -43,61 +61,171 @@ class GeohashMessageHandler(
         return false
     }
 
-    fun onEvent(event: NostrEvent, subscribedGeohash: String) {
-        scope.launch(Dispatchers.Default) {
-            try {
-                if (event.kind != 20000) return@launch
-                val tagGeo = event.tags.firstOrNull { it.size >= 2 && it[0] == "g" }?.getOrNull(1)
-                if (tagGeo == null || !tagGeo.equals(subscribedGeohash, true)) return@launch
-                if (dedupe(event.id)) return@launch
-
-                // PoW validation (if enabled)
-                val pow = PoWPreferenceManager.getCurrentSettings()
-                if (pow.enabled && pow.difficulty > 0) {
-                    if (!NostrProofOfWork.validateDifficulty(event, pow.difficulty)) return@launch
+    /**
+     * Replay stored events for a geohash, then return the `since` (ms) a relay subscription
+     * needs to fill the gap: the stored high-water mark, clamped to the window start.
+     */
+    suspend fun replayStored(geohash: String, windowStartMs: Long, limit: Int): Long {
+        val (stored, highWater) = withContext(Dispatchers.IO) {
+            eventStore.recent(geohash, NostrKind.EPHEMERAL_EVENT, windowStartMs / 1000, limit) to
+                eventStore.highWaterMark(geohash, NostrKind.EPHEMERAL_EVENT)
+        }
+        if (stored.isNotEmpty()) Log.d(TAG, "Replaying ${stored.size} stored events for $geohash")
+        stored.forEach { onEvent(it, geohash, fromStore = true) }
+        val resumeMs = highWater?.let { (it - AppConstants.Nostr.EVENT_STORE_SINCE_OVERLAP_SEC) * 1000 } ?: windowStartMs
+        return maxOf(windowStartMs, resumeMs)
+    }
+
+    /**
+     * Backfill a geohash alongside its live subscription, which already covers everything
+     * from `liveSinceMs`. Stored events are replayed, then the window is reconciled against
+     * each geohash relay with NIP-77 negentropy and only the events we lack are fetched by
+     * id. A relay that cannot reconcile, or reports a gap larger than one page, gets a
+     * one-shot since-based fetch of the gap instead: from the [replayStored] resume point up
+     * to `liveSinceMs`.
+     */
+    suspend fun catchUp(
+        geohash: String,
+        windowStartMs: Long,
+        liveSinceMs: Long,
+        limit: Int,
+        priority: RelayConnectionScheduler.Priority = RelayConnectionScheduler.Priority.NORMAL
+    ) {
+        val resumeMs = replayStored(geohash, windowStartMs, limit)
+        if (resumeMs >= liveSinceMs) return
+        val relayManager = NostrRelayManager.getInstance(application)
+        relayManager.ensureGeohashRelaysConnected(geohash, nRelays = 5, includeDefaults = false, priority = priority)
+        val relays = relayManager.getRelaysForGeohash(geohash)
+        if (relays.isEmpty()) return
+
+        val local = withContext(Dispatchers.IO) {
+            eventStore.negentropyItems(geohash, NostrKind.EPHEMERAL_EVENT, windowStartMs / 1000)
+        }
+        // Same window as the live REQ, without the limit: the relay must describe its whole set
+        val filter = NostrFilter.geohashEphemeral(geohash, windowStartMs).copy(limit = null)
+        val gapFilter = NostrFilter.geohashEphemeral(geohash, resumeMs, limit).copy(until = (liveSinceMs / 1000).toInt())
+        val handler: (NostrEvent) -> Unit = { event -> onEvent(event, geohash) }
+        val needByRelay = coroutineScope {
+            relays.map { relay -> async { relay to relayManager.reconcileWithRelay(relay, filter, local) } }.awaitAll()
+        }
+
+        // Fetch each missing event once, from the first relay that reported it
+        val claimed = HashSet<String>()
+        var fallbacks = 0
+        coroutineScope {
+            for ((relay, need) in needByRelay) {
+                val ids = need?.filter { claimed.add(it) }
+                if (ids == null || ids.size > limit) {
+                    // No negentropy, or the newest `limit` by since is cheaper than all of it
+                    fallbacks++
+                    launch { relayManager.fetch(relay, gapFilter, handler) }
+                } else if (ids.isNotEmpty()) {
+                    launch {
+                        if (!relayManager.fetchEvents(relay, ids, handler)) relayManager.fetch(relay, gapFilter, handler)
+                    }
                 }
+            }
+        }
+        Log.d(TAG, "Caught up $geohash with ${relays.size} relays: ${local.size} local, ${claimed.size} fetched by id, $fallbacks since-based")
+    }
 
+    /**
+     * Enqueue an event for batched processing. Cheap and thread-safe, so relay handlers
+     * call it directly from the socket thread without a main-thread hop.
+     */
+    fun onEvent(event: NostrEvent, subscribedGeohash: String, fromStore: Boolean = false) {
+        incoming.offer(Incoming(event, subscribedGeohash, fromStore))
+    }
+
+    private suspend fun processBatch(batch: List<Incoming>) {
+        // Filter and dedupe, grouping by geohash so storage and repository updates are per batch
+        val byGeohash = LinkedHashMap<String, Pair<MutableList<NostrEvent>, MutableList<NostrEvent>>>()
+        for ((event, subscribedGeohash, fromStore) in batch) {
+            if (event.kind != 20000) continue
+            val tagGeo = event.tags.firstOrNull { it.size >= 2 && it[0] == "g" }?.getOrNull(1)
+            if (tagGeo == null || !tagGeo.equals(subscribedGeohash, true)) continue
+            if (dedupe(event.id)) continue
+            // Several bridges may republish the same mesh packet, each under its own key
+            MeshNostrBridge.bridgeKey(event)?.let { key -> if (dedupe("bridge:$key")) continue }
+            val (live, stored) = byGeohash.getOrPut(subscribedGeohash) { mutableListOf<NostrEvent>() to mutableListOf() }
+            if (fromStore) stored.add(event) else live.add(event)
+        }
+        if (byGeohash.isEmpty()) return
+
+        val pow = PoWPreferenceManager.getCurrentSettings()
+        val wanted = { event: NostrEvent ->
+            // PoW validation (if enabled)
+            (!pow.enabled || pow.difficulty <= 0 || NostrProofOfWork.validateDifficulty(event, pow.difficulty)) &&
                 // Blocked users check (use injected DataManager which has loaded state)
-                if (dataManager.isGeohashUserBlocked(event.pubkey)) return@launch
-
-                // Update repository (participants, nickname, teleport)
-                // Update repository on a background-safe path; repository will post updates to LiveData
-                repo.updateParticipant(subscribedGeohash, event.pubkey, Date(event.createdAt * 1000L))
-                event.tags.find { it.size >= 2 && it[0] == "n" }?.let { repo.cacheNickname(event.pubkey, it[1]) }
-                event.tags.find { it.size >= 2 && it[0] == "t" && it[1] == "teleport" }?.let { repo.markTeleported(event.pubkey) }
-                // Register a geohash DM alias for this participant so MessageRouter can route DMs via Nostr
-                try {
-                    com.bitchat.android.nostr.GeohashAliasRegistry.put("nostr_${event.pubkey.take(16)}", event.pubkey)
-                } catch (_: Exception) { }
-
-                // Skip our own events for message emission
-                val my = NostrIdentityBridge.deriveIdentity(subscribedGeohash, application)
-                if (my.publicKeyHex.equals(event.pubkey, true)) return@launch
-
-                val isTeleportPresence = event.tags.any { it.size >= 2 && it[0] == "t" && it[1] == "teleport" } &&
-                                         event.content.trim().isEmpty()
-                if (isTeleportPresence) return@launch
-
-                val senderName = repo.displayNameForNostrPubkeyUI(event.pubkey)
-                val hasNonce = try { NostrProofOfWork.hasNonce(event) } catch (_: Exception) { false }
-                val msg = BitchatMessage(
-                    id = event.id,
-                    sender = senderName,
-                    content = event.content,
-                    timestamp = Date(event.createdAt * 1000L),
-                    isRelay = false,
-                    originalSender = repo.displayNameForNostrPubkey(event.pubkey),
-                    senderPeerID = "nostr:${event.pubkey.take(8)}",
-                    mentions = null,
-                    channel = "#$subscribedGeohash",
-                    powDifficulty = try {
-                        if (hasNonce) NostrProofOfWork.calculateDifficulty(event.id).takeIf { it > 0 } else null
-                    } catch (_: Exception) { null }
-                )
-                withContext(Dispatchers.Main) { messageManager.addChannelMessage("geo:$subscribedGeohash", msg) }
+                !dataManager.isGeohashUserBlocked(event.pubkey)
+        }
+        for ((geohash, lists) in byGeohash) {
+            val live = lists.first.filter(wanted)
+            val stored = lists.second.filter(wanted)
+            // Filtered first, so spam and blocked users are never stored or move the
+            // high-water mark; stored events were verified when they were written
+            val accepted = if (live.isEmpty()) stored else {
+                stored + withContext(Dispatchers.IO) { eventStore.putAll(live, geohash) }
+            }
+            if (accepted.isEmpty()) continue
+            try {
+                emitBatch(geohash, accepted)
             } catch (e: Exception) {
                 Log.e(TAG, "onEvent error: ${e.message}")
             }
         }
     }
+
+    private fun emitBatch(geohash: String, events: List<NostrEvent>) {
+        // Update repository (participants, nickname, teleport) once per batch;
+        // repository will post updates to LiveData
+        val lastSeen = HashMap<String, Date>()
+        val nicknames = HashMap<String, String>()
+        val teleported = HashSet<String>()
+        for (event in events) {
+            val seen = Date(event.createdAt * 1000L)
+            lastSeen.merge(event.pubkey, seen) { a, b -> if (a.after(b)) a else b }
+            event.tags.find { it.size >= 2 && it[0] == "n" }?.let { nicknames[event.pubkey] = it[1] }
+            if (event.tags.any { it.size >= 2 && it[0] == "t" && it[1] == "teleport" }) teleported.add(event.pubkey)
+            // Register a geohash DM alias for this participant so MessageRouter can route DMs via Nostr
+            try {
+                com.bitchat.android.nostr.GeohashAliasRegistry.put("nostr_${event.pubkey.take(16)}", event.pubkey)
+            } catch (_: Exception) { }
+        }
+        repo.updateParticipants(geohash, lastSeen)
+        repo.cacheNicknames(nicknames)
+        repo.markTeleported(teleported)
+
+        // Skip our own events for message emission
+        val my = NostrIdentityBridge.deriveIdentity(geohash, application)
+        val messages = ArrayList<BitchatMessage>(events.size)
+        for (event in events) {
+            if (my.publicKeyHex.equals(event.pubkey, true)) continue
+            val isTeleportPresence = event.tags.any { it.size >= 2 && it[0] == "t" && it[1] == "teleport" } &&
+                                     event.content.trim().isEmpty()
+            if (isTeleportPresence) continue
+
+            com.bitchat.android.geohash.GeohashActivityIndex.shared.recordMessage(geohash, event.createdAt * 1000L)
+
+            val senderName = repo.displayNameForNostrPubkeyUI(event.pubkey)
+            val hasNonce = try { NostrProofOfWork.hasNonce(event) } catch (_: Exception) { false }
+            messages.add(BitchatMessage(
+                id = event.id,
+                sender = senderName,
+                content = event.content,
+                timestamp = Date(event.createdAt * 1000L),
+                isRelay = false,
+                originalSender = repo.displayNameForNostrPubkey(event.pubkey),
+                senderPeerID = "nostr:${event.pubkey.take(8)}",
+                mentions = null,
+                channel = "#$geohash",
+                powDifficulty = try {
+                    if (hasNonce) NostrProofOfWork.calculateDifficulty(event.id).takeIf { it > 0 } else null
+                } catch (_: Exception) { null }
+            ))
+        }
+        if (messages.isEmpty()) return
+        // One main-thread hop per batch; the timeline publishes at most once per frame
+        scope.launch(Dispatchers.Main) { messageManager.addChannelMessages("geo:$geohash", messages) }
+    }
 }
@@ -3,14 +3,23 @@ package com.bitchat.android.nostr
 import android.app.Application
 import android.util.Log
 import androidx.lifecycle.LiveData
+import com.bitchat.android.geohash.GeohashIndex
 import com.bitchat.android.ui.ChatState
 import com.bitchat.android.ui.GeoPerson
+import com.bitchat.android.util.AppConstants
 import java.util.Date
 
 /**
  * GeohashRepository
  * - Owns geohash participant tracking and nickname caching
  * - Maintains lightweight state for geohash-related UI
+ *
+ * Participant counts: the channel in view is counted exactly from its participant map;
+ * sampled channels are counted with a [SlidingHyperLogLog] per geohash. Both update in
+ * O(1) per event and counts are only published when one changes. Participant maps of
+ * channels not in view are capped, so memory stays bounded for large crowds. A published
+ * count is never below the exact people seen inside the cell at finer levels (a prefix
+ * range over the Morton-ordered participant index), so zooming out does not lose anyone.
  */
 class GeohashRepository(
     private val application: Application,
@@ -19,8 +28,14 @@ class GeohashRepository(
 ) {
     companion object { private const val TAG = "GeohashRepository" }
 
-    // geohash -> (participant pubkeyHex -> lastSeen)
-    private val geohashParticipants: MutableMap<String, MutableMap<String, Date>> = mutableMapOf()
+    // geohash -> (participant pubkeyHex -> lastSeen), least recently updated first
+    // Morton-ordered so people inside a coarser cell are a prefix range query
+    // Participant maps are guarded by participantsLock together with the sketches and published counts
+    private val geohashParticipants = GeohashIndex<LinkedHashMap<String, Date>>()
+    private val participantSketches: MutableMap<String, SlidingHyperLogLog> = mutableMapOf()
+    private val publishedCounts: MutableMap<String, Int> = mutableMapOf()
+    private val participantsLock = Any()
+    private val activeWindowMs = AppConstants.Nostr.PARTICIPANT_ACTIVE_WINDOW_MS
 
 
     // pubkeyHex(lowercase) -> nickname (without #hash)
@@ -50,11 +65,26 @@ class GeohashRepository(
     // Current geohash in view
     private var currentGeohash: String? = null
 
-    fun setCurrentGeohash(geo: String?) { currentGeohash = geo }
+    fun setCurrentGeohash(geo: String?) {
+        val previous = currentGeohash
+        currentGeohash = geo
+        if (previous == geo) return
+        // Counting source changes for both channels (exact <-> sketch)
+        synchronized(participantsLock) {
+            var changed = false
+            previous?.let { changed = recountLocked(it, System.currentTimeMillis()) }
+            geo?.let { changed = recountLocked(it, System.currentTimeMillis()) || changed }
+            if (changed) publishCountsLocked()
+        }
+    }
     fun getCurrentGeohash(): String? = currentGeohash
 
     fun clearAll() {
-        geohashParticipants.clear()
+        synchronized(participantsLock) {
+            geohashParticipants.clear()
+            participantSketches.clear()
+            publishedCounts.clear()
+        }
         geoNicknames.clear()
         nostrKeyMapping.clear()
         state.setGeohashPeople(emptyList())
@@ -72,13 +102,33 @@ class GeohashRepository(
         }
     }
 
+    /**
+     * Batch form of [cacheNickname]: refreshes the people list at most once
+     */
+    fun cacheNicknames(nicknames: Map<String, String>) {
+        var changed = false
+        for ((pubkeyHex, nickname) in nicknames) {
+            val lower = pubkeyHex.lowercase()
+            if (geoNicknames.put(lower, nickname) != nickname) changed = true
+        }
+        if (changed && currentGeohash != null) {
+            refreshGeohashPeople()
+        }
+    }
+
     fun getCachedNickname(pubkeyHex: String): String? = geoNicknames[pubkeyHex.lowercase()]
 
-    fun markTeleported(pubkeyHex: String) {
+    fun markTeleported(pubkeyHex: String) = markTeleported(listOf(pubkeyHex))
+
+    /**
+     * Mark several pubkeys as teleported with a single state post
+     */
+    fun markTeleported(pubkeysHex: Collection<String>) {
+        if (pubkeysHex.isEmpty()) return
         val set = state.getTeleportedGeoValue().toMutableSet()
-        val key = pubkeyHex.lowercase()
-        if (!set.contains(key)) {
-            set.add(key)
+        var changed = false
+        pubkeysHex.forEach { if (set.add(it.lowercase())) changed = true }
+        if (changed) {
             // Background safe update
             state.postTeleportedGeo(set)
         }
@@ -88,24 +138,48 @@ class GeohashRepository(
         return state.getTeleportedGeoValue().contains(pubkeyHex.lowercase())
     }
 
-    fun updateParticipant(geohash: String, participantId: String, lastSeen: Date) {
-        val participants = geohashParticipants.getOrPut(geohash) { mutableMapOf() }
-        participants[participantId] = lastSeen
-        if (currentGeohash == geohash) refreshGeohashPeople()
-        updateReactiveParticipantCounts()
+    fun updateParticipant(geohash: String, participantId: String, lastSeen: Date) =
+        updateParticipants(geohash, mapOf(participantId to lastSeen))
+
+    /**
+     * Record a batch of participants seen in one geohash: one lock, at most one count
+     * publish and one people refresh per batch
+     */
+    fun updateParticipants(geohash: String, lastSeenById: Map<String, Date>) {
+        if (lastSeenById.isEmpty()) return
+        val now = System.currentTimeMillis()
+        val isCurrent = currentGeohash == geohash
+        synchronized(participantsLock) {
+            val participants = geohashParticipants.getOrPut(geohash) { LinkedHashMap() }
+            val sketch = participantSketches.getOrPut(geohash) { SlidingHyperLogLog(activeWindowMs) }
+            var sketchChanged = false
+            var newlyActive = false
+            for ((participantId, lastSeen) in lastSeenById) {
+                // Re-insert so iteration order tracks recency for eviction
+                val previous = participants.remove(participantId)
+                participants[participantId] = if (previous != null && previous.after(lastSeen)) previous else lastSeen
+                if (!isCurrent && participants.size > AppConstants.Nostr.PARTICIPANT_EXACT_CAP) {
+                    participants.remove(participants.keys.first())
+                }
+                if (sketch.add(participantId, lastSeen.time, now)) sketchChanged = true
+                if (previous == null || previous.time < now - activeWindowMs) newlyActive = true
+            }
+
+            val changed = if (isCurrent) {
+                newlyActive && recountLocked(geohash, now, exactPrune = false)
+            } else {
+                sketchChanged && recountLocked(geohash, now)
+            }
+            if (changed) publishCountsLocked()
+        }
+        if (isCurrent) refreshGeohashPeople()
     }
 
     fun geohashParticipantCount(geohash: String): Int {
-        val cutoff = Date(System.currentTimeMillis() - 5 * 60 * 1000)
-        val participants = geohashParticipants[geohash] ?: return 0
-        // prune expired
-        val it = participants.iterator()
-        while (it.hasNext()) {
-            val e = it.next()
-            if (e.value.before(cutoff)) it.remove()
+        val cutoff = System.currentTimeMillis() - activeWindowMs
+        return synchronized(participantsLock) {
+            maxOf(publishedCounts[geohash] ?: 0, participantCountWithinLocked(geohash, cutoff))
         }
-        // exclude blocked users
-        return participants.keys.count { !dataManager.isGeohashUserBlocked(it) }
     }
 
     fun refreshGeohashPeople() {
@@ -115,27 +189,23 @@ class GeohashRepository(
             state.postGeohashPeople(emptyList())
             return
         }
-        val cutoff = Date(System.currentTimeMillis() - 5 * 60 * 1000)
-        val participants = geohashParticipants[geohash] ?: mutableMapOf()
-        // prune expired
-        val it = participants.iterator()
-        while (it.hasNext()) {
-            val e = it.next()
-            if (e.value.before(cutoff)) it.remove()
+        val participants = synchronized(participantsLock) {
+            pruneLocked(geohash, System.currentTimeMillis())
+            geohashParticipants[geohash]?.let { LinkedHashMap(it) } ?: LinkedHashMap()
         }
-        geohashParticipants[geohash] = participants
+        // Self identity once per refresh, not once per participant
+        val myHex = try {
+            currentGeohash?.let { NostrIdentityBridge.deriveIdentity(it, application).publicKeyHex }
+        } catch (_: Exception) { null }
         // exclude blocked users from people list
         val people = participants.filterKeys { !dataManager.isGeohashUserBlocked(it) }
             .map { (pubkeyHex, lastSeen) ->
             // Use our actual nickname for self; otherwise use cached nickname or anon
-            val base = try {
-                val myHex = currentGeohash?.let { NostrIdentityBridge.deriveIdentity(it, application).publicKeyHex }
-                if (myHex != null && myHex.equals(pubkeyHex, true)) {
-                    state.getNicknameValue() ?: "anon"
-                } else {
-                    getCachedNickname(pubkeyHex) ?: "anon"
-                }
-            } catch (_: Exception) { getCachedNickname(pubkeyHex) ?: "anon" }
+            val base = if (myHex != null && myHex.equals(pubkeyHex, true)) {
+                state.getNicknameValue() ?: "anon"
+            } else {
+                getCachedNickname(pubkeyHex) ?: "anon"
+            }
             GeoPerson(
                 id = pubkeyHex.lowercase(),
                 displayName = base, // UI can add #hash if necessary
@@ -146,18 +216,96 @@ class GeohashRepository(
         state.postGeohashPeople(people)
     }
 
-    fun updateReactiveParticipantCounts() {
-        val cutoff = Date(System.currentTimeMillis() - 5 * 60 * 1000)
-        val counts = mutableMapOf<String, Int>()
-        for ((gh, participants) in geohashParticipants) {
-            val active = participants.filterKeys { !dataManager.isGeohashUserBlocked(it) }
-                .values.count { !it.before(cutoff) }
-            counts[gh] = active
+    /**
+     * Expire participants that fell out of the activity window and republish counts that
+     * changed. Counts only go down with time, so this runs on a timer rather than per event.
+     * Returns false once nothing is tracked any more.
+     */
+    fun updateReactiveParticipantCounts(): Boolean {
+        val now = System.currentTimeMillis()
+        synchronized(participantsLock) {
+            var changed = false
+            for (gh in (geohashParticipants.keys() + participantSketches.keys).toList()) {
+                changed = recountLocked(gh, now) || changed
+                if (gh != currentGeohash &&
+                    geohashParticipants[gh].isNullOrEmpty() &&
+                    participantSketches[gh]?.isExpired(now) != false
+                ) {
+                    geohashParticipants.remove(gh)
+                    participantSketches.remove(gh)
+                    publishedCounts.remove(gh)
+                    changed = true
+                }
+            }
+            if (changed) publishCountsLocked()
+            return geohashParticipants.size > 0 || participantSketches.isNotEmpty()
+        }
+    }
+
+    private fun pruneLocked(geohash: String, now: Long) {
+        val participants = geohashParticipants[geohash] ?: return
+        val cutoff = now - activeWindowMs
+        val it = participants.values.iterator()
+        while (it.hasNext()) {
+            if (it.next().time < cutoff) it.remove()
+        }
+    }
+
+    /**
+     * Recompute one geohash's count; true if it differs from the published value
+     */
+    private fun recountLocked(geohash: String, now: Long, exactPrune: Boolean = true): Boolean {
+        val count = if (geohash == currentGeohash) {
+            if (exactPrune) pruneLocked(geohash, now)
+            val participants = geohashParticipants[geohash]
+            if (exactPrune) {
+                participants?.keys?.count { !dataManager.isGeohashUserBlocked(it) } ?: 0
+            } else {
+                // Per-event path: blocked users never reach here, expiry is left to the timer
+                participants?.size ?: 0
+            }
+        } else {
+            if (exactPrune) pruneLocked(geohash, now)
+            participantSketches[geohash]?.estimate(now) ?: 0
         }
-        // Use postValue for thread safety - this can be called from background threads  
+        if (publishedCounts[geohash] == count) return false
+        publishedCounts[geohash] = count
+        return true
+    }
+
+    private fun publishCountsLocked() {
+        // A coarser channel also counts the people seen in finer channels inside it
+        val cutoff = System.currentTimeMillis() - activeWindowMs
+        val counts = HashMap<String, Int>(publishedCounts.size)
+        for ((geohash, count) in publishedCounts) {
+            counts[geohash] = maxOf(count, participantCountWithinLocked(geohash, cutoff))
+        }
+        // Use postValue for thread safety - this can be called from background threads
         state.postGeohashParticipantCounts(counts)
     }
 
+    /**
+     * Distinct active participants seen in `prefix` or any finer channel inside it.
+     * Exact participants only; channels not in view keep at most PARTICIPANT_EXACT_CAP each.
+     */
+    fun participantCountWithin(prefix: String): Int {
+        val cutoff = System.currentTimeMillis() - activeWindowMs
+        return synchronized(participantsLock) { participantCountWithinLocked(prefix, cutoff) }
+    }
+
+    private fun participantCountWithinLocked(prefix: String, cutoff: Long): Int {
+        return geohashParticipants.foldWithin(prefix, HashSet<String>()) { acc, _, participants ->
+            participants.forEach { (pubkey, lastSeen) ->
+                if (lastSeen.time >= cutoff && !dataManager.isGeohashUserBlocked(pubkey)) acc.add(pubkey)
+            }
+            acc
+        }.size
+    }
+
+    private fun participantsSnapshot(geohash: String): Map<String, Date> {
+        return synchronized(participantsLock) { geohashParticipants[geohash]?.let { HashMap(it) } ?: emptyMap() }
+    }
+
     fun putNostrKeyMapping(tempKeyOrPeer: String, pubkeyHex: String) {
         nostrKeyMapping[tempKeyOrPeer] = pubkeyHex
     }
@@ -185,18 +333,15 @@ class GeohashRepository(
         val lower = pubkeyHex.lowercase()
         val suffix = pubkeyHex.takeLast(4)
         val current = currentGeohash
-        val base: String = try {
-            if (current != null) {
-                val my = NostrIdentityBridge.deriveIdentity(current, application)
-                if (my.publicKeyHex.equals(lower, true)) {
-                    state.getNicknameValue() ?: "anon"
-                } else geoNicknames[lower] ?: "anon"
-            } else geoNicknames[lower] ?: "anon"
-        } catch (_: Exception) { geoNicknames[lower] ?: "anon" }
+        // Called while rendering; use the identity warmed on channel switch rather than deriving here
+        val my = current?.let { NostrIdentityBridge.cachedIdentity(it) }
+        val base: String = if (my != null && my.publicKeyHex.equals(lower, true)) {
+            state.getNicknameValue() ?: "anon"
+        } else geoNicknames[lower] ?: "anon"
         if (current == null) return base
         return try {
-            val cutoff = Date(System.currentTimeMillis() - 5 * 60 * 1000)
-            val participants = geohashParticipants[current] ?: emptyMap()
+            val cutoff = Date(System.currentTimeMillis() - activeWindowMs)
+            val participants = participantsSnapshot(current)
             var count = 0
             for ((k, t) in participants) {
                 if (dataManager.isGeohashUserBlocked(k)) continue
@@ -217,8 +362,8 @@ class GeohashRepository(
         val suffix = pubkeyHex.takeLast(4)
         val base = geoNicknames[lower] ?: "anon"
         return try {
-            val cutoff = Date(System.currentTimeMillis() - 5 * 60 * 1000)
-            val participants = geohashParticipants[sourceGeohash] ?: emptyMap()
+            val cutoff = Date(System.currentTimeMillis() - activeWindowMs)
+            val participants = participantsSnapshot(sourceGeohash)
             var count = 0
             for ((k, t) in participants) {
                 if (dataManager.isGeohashUserBlocked(k)) continue
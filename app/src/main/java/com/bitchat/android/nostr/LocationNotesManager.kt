@@ -4,6 +4,7 @@ import android.util.Log
 import androidx.annotation.MainThread
 import androidx.lifecycle.LiveData
 import androidx.lifecycle.MutableLiveData
+import com.bitchat.android.util.SortedTimeline
 import kotlinx.coroutines.*
 
 /**
@@ -81,7 +82,6 @@ class LocationNotesManager private constructor() {
     
     // Private state
     private var subscriptionIDs: MutableMap<String, String> = mutableMapOf()
-    private val noteIDs = mutableSetOf<String>() // For deduplication
     private var subscribedGeohashes: Set<String> = emptySet()
     
     // Dependencies (injected via setters for flexibility)
@@ -93,6 +93,16 @@ class LocationNotesManager private constructor() {
     
     // Coroutine scope for background operations
     private val scope = CoroutineScope(Dispatchers.Main + SupervisorJob())
+
+    // Newest-first, de-duplicated by event id; relay bursts publish once per frame
+    private val timeline = SortedTimeline<Note>(
+        capacity = MAX_NOTES_IN_MEMORY,
+        newestFirst = true,
+        scope = scope,
+        idOf = { it.id },
+        timeOf = { it.createdAt * 1000L },
+        publish = { _notes.postValue(it) }
+    )
     
     /**
      * Initialize dependencies
@@ -140,8 +150,8 @@ class LocationNotesManager private constructor() {
         _errorMessage.value = null
         
         // Clear notes
+        timeline.clear()
         _notes.value = emptyList()
-        noteIDs.clear()
         _geohash.value = normalized
         
         // Compute target geohashes: center + neighbors (±1)
@@ -177,8 +187,8 @@ class LocationNotesManager private constructor() {
         
         // Cancel and restart subscriptions for current ±1 set
         cancel()
+        timeline.clear()
         _notes.value = emptyList()
-        noteIDs.clear()
         _initialLoadComplete.value = false
         // Rebuild subscribedGeohashes and resubscribe
         val neighbors = try {
@@ -254,16 +264,7 @@ class LocationNotesManager private constructor() {
                     nickname = nickname
                 )
                 
-                if (!noteIDs.contains(event.id)) {
-                    noteIDs.add(event.id)
-                    val currentNotes = _notes.value ?: emptyList()
-                    _notes.value = (currentNotes + localNote).sortedByDescending { it.createdAt }
-                    
-                    // Trim if exceeds max
-                    if (noteIDs.size > MAX_NOTES_IN_MEMORY) {
-                        trimOldestNotes()
-                    }
-                }
+                timeline.add(localNote)
                 
                 // CRITICAL FIX: Send to geo-specific relays (matching iOS pattern)
                 // iOS: dependencies.sendEvent(event, relays)
@@ -346,7 +347,7 @@ class LocationNotesManager private constructor() {
             if (!_initialLoadComplete.value!!) {
                 _initialLoadComplete.value = true
                 _state.value = State.READY
-                Log.d(TAG, "Initial load complete for geohash: $currentGeohash (${noteIDs.size} notes)")
+                Log.d(TAG, "Initial load complete for geohash: $currentGeohash (${timeline.size} notes)")
             }
         }
     }
@@ -376,7 +377,7 @@ class LocationNotesManager private constructor() {
         }
         
         // Deduplicate
-        if (noteIDs.contains(event.id)) {
+        if (timeline.contains(event.id)) {
             return
         }
         
@@ -393,17 +394,11 @@ class LocationNotesManager private constructor() {
             nickname = nickname
         )
         
-        // Add to collection
-        noteIDs.add(event.id)
-        val currentNotes = _notes.value ?: emptyList()
-        _notes.value = (currentNotes + note).sortedByDescending { it.createdAt }
+        // Sorted insert; eviction beyond MAX_NOTES_IN_MEMORY happens when the frame's batch is published
+        if (!timeline.add(note)) return
+        com.bitchat.android.geohash.GeohashActivityIndex.shared.recordNote(eventGeohash, event.createdAt * 1000L)
         
-        Log.d(TAG, "📥 Added note: ${note.displayName} - ${note.content.take(50)}")
-        
-        // Trim if exceeds max
-        if (noteIDs.size > MAX_NOTES_IN_MEMORY) {
-            trimOldestNotes()
-        }
+        Log.v(TAG, "📥 Added note: ${note.displayName} - ${note.content.take(50)}")
         
         // Update state
         if (!_initialLoadComplete.value!!) {
@@ -412,23 +407,6 @@ class LocationNotesManager private constructor() {
         _state.value = State.READY
     }
     
-    /**
-     * Trim oldest notes to stay within memory limit
-     */
-    private fun trimOldestNotes() {
-        val currentNotes = _notes.value ?: return
-        if (currentNotes.size <= MAX_NOTES_IN_MEMORY) return
-        
-        val trimmed = currentNotes.sortedByDescending { it.createdAt }.take(MAX_NOTES_IN_MEMORY)
-        _notes.value = trimmed
-        
-        // Update note IDs set
-        noteIDs.clear()
-        noteIDs.addAll(trimmed.map { it.id })
-        
-        Log.d(TAG, "Trimmed notes to $MAX_NOTES_IN_MEMORY (removed ${currentNotes.size - trimmed.size})")
-    }
-    
     /**
      * Clear error message - matches iOS clearError()
      */
@@ -458,9 +436,9 @@ class LocationNotesManager private constructor() {
      */
     fun cleanup() {
         cancel()
+        timeline.clear()
         scope.cancel()
         _notes.value = emptyList()
-        noteIDs.clear()
         _geohash.value = null
         _initialLoadComplete.value = false
         _errorMessage.value = null
@@ -0,0 +1,157 @@
+package com.bitchat.android.nostr
+
+import android.app.Application
+import android.util.Log
+import androidx.lifecycle.Observer
+import com.bitchat.android.geohash.GeohashChannel
+import com.bitchat.android.geohash.LocationChannelManager
+import com.bitchat.android.mesh.BluetoothMeshService
+import com.bitchat.android.model.BitchatMessage
+import com.bitchat.android.model.BitchatMessageType
+import com.bitchat.android.util.AppConstants
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.isActive
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.withContext
+
+/**
+ * Runs a [MeshNostrBridge] for the block-level geohash around this device while bridge
+ * mode is enabled, re-targeting it as the device changes cell.
+ */
+class MeshBridgeManager(
+    private val application: Application,
+    private val scope: CoroutineScope,
+    private val getMeshService: () -> BluetoothMeshService
+) {
+    companion object {
+        private const val TAG = "MeshBridgeManager"
+    }
+
+    private val relayManager get() = NostrRelayManager.getInstance(application)
+    private var locationChannelManager: LocationChannelManager? = null
+
+    @Volatile private var bridge: MeshNostrBridge? = null
+    private var subscriptionId: String? = null
+    private var lastChannels: List<GeohashChannel> = emptyList()
+    private var refreshJob: Job? = null
+
+    private val channelsObserver = Observer<List<GeohashChannel>> { channels ->
+        lastChannels = channels
+        retarget()
+    }
+
+    fun initialize() {
+        BridgePreferenceManager.init(application)
+        try {
+            locationChannelManager = LocationChannelManager.getInstance(application)
+            locationChannelManager?.availableChannels?.observeForever(channelsObserver)
+        } catch (e: Exception) {
+            Log.e(TAG, "Failed to observe location channels: ${e.message}")
+        }
+        scope.launch {
+            BridgePreferenceManager.bridgeEnabled.collect { enabled ->
+                refreshJob?.cancel()
+                refreshJob = if (enabled) startLocationRefresh() else null
+                retarget()
+            }
+        }
+    }
+
+    fun shutdown() {
+        locationChannelManager?.availableChannels?.removeObserver(channelsObserver)
+        refreshJob?.cancel()
+        stopBridge()
+    }
+
+    /**
+     * Public mesh message accepted by the UI (already deduplicated and not blocked)
+     */
+    fun onMeshMessage(message: BitchatMessage) {
+        val bridge = bridge ?: return
+        if (message.isPrivate || message.channel != null || message.type != BitchatMessageType.Message) return
+        val senderPeerID = message.senderPeerID ?: return
+        val result = bridge.onMeshMessage(senderPeerID, message.sender, message.content, message.timestamp.time)
+        if (result != MeshNostrBridge.Result.BRIDGED) Log.v(TAG, "Mesh message not bridged: $result")
+    }
+
+    // Location channels are otherwise only computed while the selector is open
+    private fun startLocationRefresh(): Job = scope.launch {
+        while (isActive) {
+            locationChannelManager?.refreshChannels()
+            delay(AppConstants.Location.REFRESH_MAX_INTERVAL_MS)
+        }
+    }
+
+    private fun retarget() {
+        val geohash = if (BridgePreferenceManager.isBridgeEnabled()) {
+            lastChannels.firstOrNull { it.geohash.length == AppConstants.Bridge.GEOHASH_PRECISION }?.geohash
+        } else null
+        if (geohash == bridge?.geohash) return
+        stopBridge()
+        if (geohash != null) startBridge(geohash)
+    }
+
+    private fun startBridge(geohash: String) {
+        val bridge = MeshNostrBridge(
+            geohash = geohash,
+            mesh = { content, ttl -> getMeshService().sendMessage(content, ttl = ttl) },
+            relay = { outbound -> scope.launch { publish(outbound) } }
+        )
+        this.bridge = bridge
+        subscriptionId = relayManager.subscribeForGeohash(
+            geohash = geohash,
+            filter = NostrFilter.geohashEphemeral(geohash, since = System.currentTimeMillis() - AppConstants.Bridge.MAX_EVENT_AGE_MS),
+            id = "bridge-$geohash",
+            handler = { event ->
+                val result = bridge.onRelayEvent(event)
+                if (result == MeshNostrBridge.Result.BRIDGED) Log.d(TAG, "Injected ${event.id.take(8)} into mesh")
+            },
+            deliverOnMain = false
+        )
+        Log.i(TAG, "Bridge started for geohash=$geohash")
+    }
+
+    private fun stopBridge() {
+        subscriptionId?.let { relayManager.unsubscribe(it) }
+        subscriptionId = null
+        bridge?.let { Log.i(TAG, "Bridge stopped for geohash=${it.geohash}") }
+        bridge = null
+    }
+
+    /**
+     * Publish under this bridge's secret pseudonym for the mesh peer. Other bridges hearing
+     * the same packet publish their own event; receivers collapse the copies on the
+     * `["bridge", meshKey]` tag. Mined to the current PoW setting so channels that require
+     * PoW show bridged messages too.
+     */
+    private suspend fun publish(outbound: MeshNostrBridge.Outbound) {
+        try {
+            val event = withContext(Dispatchers.Default) {
+                val identity = NostrIdentityBridge.deriveBridgeIdentity(outbound.geohash, outbound.senderPeerID, application)
+                val tags = mutableListOf(listOf("g", outbound.geohash))
+                if (outbound.nickname.isNotEmpty()) tags.add(listOf("n", outbound.nickname))
+                tags.add(listOf(MeshNostrBridge.BRIDGE_TAG, outbound.meshKey))
+                var event = NostrEvent(
+                    pubkey = identity.publicKeyHex,
+                    createdAt = outbound.createdAtSec.toInt(),
+                    kind = NostrKind.EPHEMERAL_EVENT,
+                    tags = tags,
+                    content = outbound.content
+                )
+                val pow = PoWPreferenceManager.getCurrentSettings()
+                if (pow.enabled && pow.difficulty > 0) {
+                    event = NostrProofOfWork.mineEvent(event, pow.difficulty) ?: event.also {
+                        Log.w(TAG, "PoW mining failed for bridged message, publishing without PoW")
+                    }
+                }
+                identity.signEvent(event)
+            }
+            relayManager.sendEventToGeohash(event, outbound.geohash, includeDefaults = false, nRelays = 5)
+        } catch (e: Exception) {
+            Log.e(TAG, "Failed to bridge mesh message: ${e.message}")
+        }
+    }
+}
@@ -0,0 +1,196 @@
+package com.bitchat.android.nostr
+
+import com.bitchat.android.util.AppConstants
+import java.security.MessageDigest
+
+/**
+ * Loop-safe relay between the public mesh timeline and one geohash channel.
+ *
+ * Mesh broadcasts are republished to the channel tagged `["bridge", meshKey]`, where the
+ * key is a hash of (sender peer ID, packet timestamp, content). Every bridge that hears
+ * the same packet derives the same key, but signs with its own secret pseudonym, so the
+ * event ids differ: the key is the shared packet id. Channel events carrying a key this
+ * bridge has already seen are never injected back, and receivers show one copy per key
+ * ([bridgeKey]).
+ * Channel events travel the other way wrapped in a short text envelope
+ * (`⇄#geohash/id8 <nick> text`) with a small TTL. Envelopes are never republished, and
+ * their id prefix tells other bridges on the same mesh that the event is already there.
+ *
+ * Both directions are rate limited, with an additional per-sender limit, and ids are
+ * kept in bounded LRU ledgers. Sending is done through [MeshPort] and [RelayPort] so the
+ * logic runs without Android or a live relay. Thread-safe.
+ */
+class MeshNostrBridge(
+    val geohash: String,
+    private val mesh: MeshPort,
+    private val relay: RelayPort,
+    private val clock: () -> Long = System::currentTimeMillis
+) {
+
+    fun interface MeshPort {
+        fun broadcast(content: String, ttl: UByte)
+    }
+
+    fun interface RelayPort {
+        fun publish(message: Outbound)
+    }
+
+    /**
+     * A mesh broadcast to publish into [geohash]
+     */
+    data class Outbound(
+        val geohash: String,
+        val meshKey: String,
+        val senderPeerID: String,
+        val nickname: String,
+        val content: String,
+        val createdAtSec: Long
+    )
+
+    data class Envelope(val geohash: String, val eventIdPrefix: String, val nickname: String, val content: String)
+
+    enum class Result { BRIDGED, LOOP, DUPLICATE, RATE_LIMITED, STALE, IGNORED }
+
+    companion object {
+        const val BRIDGE_TAG = "bridge"
+
+        private const val ENVELOPE_MARK = "⇄#"
+        private const val ID_PREFIX_LENGTH = 8
+        private val ENVELOPE = Regex("^⇄#([0-9b-hjkmnp-z]{1,12})/([0-9a-f]{8}) <([^>\\n]*)> ([\\s\\S]*)$")
+
+        fun encodeEnvelope(geohash: String, eventId: String, nickname: String, content: String): String {
+            val nick = nickname.replace(Regex("[<>\\n]"), "").take(AppConstants.UI.MAX_NICKNAME_LENGTH)
+            return "$ENVELOPE_MARK$geohash/${eventId.take(ID_PREFIX_LENGTH)} <$nick> $content"
+        }
+
+        fun parseEnvelope(content: String): Envelope? {
+            if (!content.startsWith(ENVELOPE_MARK)) return null
+            val m = ENVELOPE.matchEntire(content) ?: return null
+            return Envelope(m.groupValues[1], m.groupValues[2], m.groupValues[3], m.groupValues[4])
+        }
+
+        /**
+         * The mesh key of a bridged event, or null if the event was not bridged
+         */
+        fun bridgeKey(event: NostrEvent): String? =
+            event.tags.firstOrNull { it.size >= 2 && it[0] == BRIDGE_TAG }?.get(1)
+
+        /**
+         * Key shared by every bridge that hears the same mesh packet
+         */
+        fun meshKey(senderPeerID: String, timestampMs: Long, content: String): String {
+            val digest = MessageDigest.getInstance("SHA-256")
+                .digest("$senderPeerID|$timestampMs|$content".toByteArray(Charsets.UTF_8))
+            return Negentropy.toHex(digest.copyOf(16))
+        }
+    }
+
+    private val seenMeshKeys = IdLedger(AppConstants.Bridge.LEDGER_SIZE)
+    private val seenEventIds = IdLedger(AppConstants.Bridge.LEDGER_SIZE)
+    private val onMeshIdPrefixes = IdLedger(AppConstants.Bridge.LEDGER_SIZE)
+
+    private val toRelayLimit = TokenBucket(AppConstants.Bridge.TO_RELAY_PER_MINUTE)
+    private val toMeshLimit = TokenBucket(AppConstants.Bridge.TO_MESH_PER_MINUTE)
+    private val senderLimits = object : LinkedHashMap<String, TokenBucket>(16, 0.75f, true) {
+        override fun removeEldestEntry(eldest: MutableMap.MutableEntry<String, TokenBucket>?): Boolean {
+            return size > AppConstants.Bridge.SENDER_LIMITS_SIZE
+        }
+    }
+
+    /**
+     * A public text message heard on the mesh
+     */
+    @Synchronized
+    fun onMeshMessage(senderPeerID: String, nickname: String, content: String, timestampMs: Long): Result {
+        if (content.isBlank()) return Result.IGNORED
+        parseEnvelope(content)?.let { envelope ->
+            // Another bridge already injected this event here; remember it so we don't repeat it
+            if (envelope.geohash == geohash) onMeshIdPrefixes.add(envelope.eventIdPrefix)
+            return Result.LOOP
+        }
+        val key = meshKey(senderPeerID, timestampMs, content)
+        if (!seenMeshKeys.add(key)) return Result.DUPLICATE
+
+        val now = clock()
+        if (!senderBucket("mesh:$senderPeerID").take(now) || !toRelayLimit.take(now)) return Result.RATE_LIMITED
+
+        // Keep the packet time so other bridges produce an identical event; fall back to ours on skew
+        val createdAtMs = if (Math.abs(now - timestampMs) <= AppConstants.Bridge.MAX_CLOCK_SKEW_MS) timestampMs else now
+        relay.publish(
+            Outbound(
+                geohash = geohash,
+                meshKey = key,
+                senderPeerID = senderPeerID,
+                nickname = nickname,
+                content = content.take(AppConstants.Bridge.MAX_CONTENT_CHARS),
+                createdAtSec = createdAtMs / 1000
+            )
+        )
+        return Result.BRIDGED
+    }
+
+    /**
+     * An event from the geohash subscription
+     */
+    @Synchronized
+    fun onRelayEvent(event: NostrEvent): Result {
+        if (event.kind != NostrKind.EPHEMERAL_EVENT || event.content.isBlank()) return Result.IGNORED
+        if (event.tags.none { it.size >= 2 && it[0] == "g" && it[1] == geohash }) return Result.IGNORED
+        if (!seenEventIds.add(event.id)) return Result.DUPLICATE
+
+        bridgeKey(event)?.let { key ->
+            if (!seenMeshKeys.add(key)) return Result.LOOP
+        }
+        if (parseEnvelope(event.content) != null) return Result.LOOP
+        if (onMeshIdPrefixes.contains(event.id.take(ID_PREFIX_LENGTH))) return Result.LOOP
+
+        val now = clock()
+        if (now - event.createdAt * 1000L > AppConstants.Bridge.MAX_EVENT_AGE_MS) return Result.STALE
+        if (!senderBucket("nostr:${event.pubkey}").take(now) || !toMeshLimit.take(now)) return Result.RATE_LIMITED
+
+        val nickname = event.tags.firstOrNull { it.size >= 2 && it[0] == "n" }?.get(1)
+            ?: "anon#${event.pubkey.takeLast(4)}"
+        onMeshIdPrefixes.add(event.id.take(ID_PREFIX_LENGTH))
+        mesh.broadcast(
+            encodeEnvelope(geohash, event.id, nickname, event.content.take(AppConstants.Bridge.MAX_CONTENT_CHARS)),
+            AppConstants.Bridge.MESH_TTL_HOPS
+        )
+        return Result.BRIDGED
+    }
+
+    private fun senderBucket(key: String): TokenBucket =
+        senderLimits.getOrPut(key) { TokenBucket(AppConstants.Bridge.PER_SENDER_PER_MINUTE) }
+
+    private class IdLedger(private val capacity: Int) {
+        private val ids = LinkedHashSet<String>()
+
+        /**
+         * False if already present
+         */
+        fun add(id: String): Boolean {
+            if (!ids.add(id)) return false
+            if (ids.size > capacity) ids.remove(ids.first())
+            return true
+        }
+
+        fun contains(id: String): Boolean = id in ids
+    }
+
+    /**
+     * `perMinute` tokens, refilled continuously, burst of the same size
+     */
+    private class TokenBucket(private val perMinute: Int) {
+        private var tokens = perMinute.toDouble()
+        private var lastMs = -1L
+
+        fun take(nowMs: Long): Boolean {
+            if (lastMs >= 0) {
+                tokens = minOf(perMinute.toDouble(), tokens + (nowMs - lastMs).coerceAtLeast(0) * perMinute / 60_000.0)
+            }
+            lastMs = nowMs
+            if (tokens < 1.0) return false
+            tokens -= 1.0
+            return true
+        }
+    }
+}
@@ -0,0 +1,41 @@
+package com.bitchat.android.nostr
+
+/**
+ * LRU cache of NIP-44 conversation keys per (recipient, sender) pair.
+ *
+ * Deriving a conversation key is an EC multiplication (two when the first Y parity guess
+ * is wrong) plus HKDF. Gift wraps come from throwaway keys, but the seals inside them are
+ * from the real sender. A backlog of DMs from one contact therefore repeats the same
+ * derivation once per message. Entries hold the key for the parity that actually
+ * decrypted. The recipient is identified by a hash of its private key. A collision only
+ * costs a failed AEAD check and a fresh derivation.
+ */
+class NIP44KeyCache(private val capacity: Int) {
+
+    private val keys = object : LinkedHashMap<String, ByteArray>(capacity, 0.75f, true) {
+        override fun removeEldestEntry(eldest: MutableMap.MutableEntry<String, ByteArray>?): Boolean = size > capacity
+    }
+
+    @Synchronized
+    fun get(recipientPrivateKeyHex: String, senderPublicKeyHex: String): ByteArray? =
+        keys[slot(recipientPrivateKeyHex, senderPublicKeyHex)]
+
+    @Synchronized
+    fun put(recipientPrivateKeyHex: String, senderPublicKeyHex: String, key: ByteArray) {
+        keys[slot(recipientPrivateKeyHex, senderPublicKeyHex)] = key
+    }
+
+    @Synchronized
+    fun remove(recipientPrivateKeyHex: String, senderPublicKeyHex: String) {
+        keys.remove(slot(recipientPrivateKeyHex, senderPublicKeyHex))
+    }
+
+    @Synchronized
+    fun clear() = keys.clear()
+
+    @get:Synchronized
+    val size: Int get() = keys.size
+
+    private fun slot(recipientPrivateKeyHex: String, senderPublicKeyHex: String): String =
+        "${recipientPrivateKeyHex.hashCode().toUInt().toString(16)}:${senderPublicKeyHex.lowercase()}"
+}
@@ -0,0 +1,337 @@
+package com.bitchat.android.nostr
+
+import java.io.ByteArrayOutputStream
+import java.security.MessageDigest
+
+/**
+ * NIP-77 negentropy (protocol version 1) range-based set reconciliation.
+ *
+ * Items are (created_at, event id) pairs sorted by timestamp then id. Each side describes
+ * ranges of its set by bound, either as a fingerprint (truncated SHA-256 of the
+ * 256-bit sum of the ids plus their count) or, for small ranges, as the full id list.
+ * Ranges whose fingerprints match are skipped and mismatching ones are split into 16
+ * buckets, so a round trip costs roughly O(log n) plus the size of the actual difference.
+ *
+ * The client is the initiator: [initiate] produces the NEG-OPEN payload and [reconcile]
+ * consumes each NEG-MSG, collecting ids only we have (`haveIds`) and ids only the relay
+ * has (`needIds`), until it returns null. The responder side is only used to test the
+ * exchange end to end. Not thread-safe; one instance per exchange.
+ */
+class Negentropy(items: Collection<Item>) {
+
+    class Item(val timestamp: Long, val id: ByteArray) {
+        init { require(id.size == ID_SIZE) { "event id must be $ID_SIZE bytes" } }
+    }
+
+    private class Bound(val timestamp: Long, val idPrefix: ByteArray = EMPTY)
+
+    companion object {
+        const val PROTOCOL_VERSION = 0x61
+
+        private const val ID_SIZE = 32
+        private const val FINGERPRINT_SIZE = 16
+        private const val BUCKETS = 16
+
+        private const val MODE_SKIP = 0
+        private const val MODE_FINGERPRINT = 1
+        private const val MODE_ID_LIST = 2
+
+        private const val INFINITY = Long.MAX_VALUE
+        private val EMPTY = ByteArray(0)
+        private val HEX = "0123456789abcdef".toCharArray()
+
+        /**
+         * Item for a stored event, or null if `idHex` is not a 32-byte hex id
+         */
+        fun item(createdAt: Long, idHex: String): Item? {
+            if (idHex.length != ID_SIZE * 2) return null
+            val id = ByteArray(ID_SIZE)
+            for (i in 0 until ID_SIZE) {
+                val hi = Character.digit(idHex[2 * i], 16)
+                val lo = Character.digit(idHex[2 * i + 1], 16)
+                if (hi < 0 || lo < 0) return null
+                id[i] = ((hi shl 4) or lo).toByte()
+            }
+            return Item(createdAt, id)
+        }
+
+        fun toHex(bytes: ByteArray): String {
+            val chars = CharArray(bytes.size * 2)
+            bytes.forEachIndexed { i, b ->
+                chars[2 * i] = HEX[(b.toInt() shr 4) and 0xF]
+                chars[2 * i + 1] = HEX[b.toInt() and 0xF]
+            }
+            return String(chars)
+        }
+
+        fun fromHex(hex: String): ByteArray {
+            require(hex.length % 2 == 0) { "odd-length hex" }
+            return ByteArray(hex.length / 2) { i ->
+                val hi = Character.digit(hex[2 * i], 16)
+                val lo = Character.digit(hex[2 * i + 1], 16)
+                require(hi >= 0 && lo >= 0) { "invalid hex" }
+                ((hi shl 4) or lo).toByte()
+            }
+        }
+
+        private fun compareIds(a: ByteArray, b: ByteArray): Int {
+            val n = minOf(a.size, b.size)
+            for (i in 0 until n) {
+                val c = (a[i].toInt() and 0xFF) - (b[i].toInt() and 0xFF)
+                if (c != 0) return c
+            }
+            return a.size - b.size
+        }
+    }
+
+    private val items: List<Item> = items.sortedWith { a, b ->
+        if (a.timestamp != b.timestamp) a.timestamp.compareTo(b.timestamp) else compareIds(a.id, b.id)
+    }
+
+    private var isInitiator = false
+    private var lastTimestampIn = 0L
+    private var lastTimestampOut = 0L
+
+    /**
+     * First message of the exchange (hex-encode for NEG-OPEN)
+     */
+    fun initiate(): ByteArray {
+        check(!isInitiator) { "already initiated" }
+        isInitiator = true
+        val out = Output()
+        out.byte(PROTOCOL_VERSION)
+        splitRange(0, items.size, Bound(INFINITY), out)
+        return out.toByteArray()
+    }
+
+    /**
+     * Process a message from the other side. Returns the reply, or null once an initiator has
+     * nothing left to reconcile. Throws IllegalArgumentException on malformed input.
+     */
+    fun reconcile(message: ByteArray, haveIds: MutableList<String>, needIds: MutableList<String>): ByteArray? {
+        val input = Input(message)
+        lastTimestampIn = 0L
+        lastTimestampOut = 0L
+        val out = Output()
+        out.byte(PROTOCOL_VERSION)
+
+        val version = input.byte()
+        require(version in 0x60..0x6F) { "invalid negentropy protocol version byte" }
+        if (version != PROTOCOL_VERSION) {
+            require(!isInitiator) { "unsupported negentropy protocol version ${version - 0x60}" }
+            return out.toByteArray()
+        }
+
+        var prevBound = Bound(0)
+        var prevIndex = 0
+        var skip = false
+
+        while (input.hasRemaining()) {
+            val o = Output()
+            fun flushSkip() {
+                if (skip) {
+                    skip = false
+                    encodeBound(prevBound, o)
+                    o.varint(MODE_SKIP.toLong())
+                }
+            }
+
+            val currBound = decodeBound(input)
+            val mode = input.varint().toInt()
+            val lower = prevIndex
+            val upper = lowerBound(prevIndex, items.size, currBound)
+
+            when (mode) {
+                MODE_SKIP -> skip = true
+                MODE_FINGERPRINT -> {
+                    val theirs = input.bytes(FINGERPRINT_SIZE)
+                    if (!theirs.contentEquals(fingerprint(lower, upper))) {
+                        flushSkip()
+                        splitRange(lower, upper, currBound, o)
+                    } else {
+                        skip = true
+                    }
+                }
+                MODE_ID_LIST -> {
+                    val count = input.varint().toInt()
+                    val theirs = LinkedHashSet<String>()
+                    repeat(count) { theirs.add(toHex(input.bytes(ID_SIZE))) }
+                    if (isInitiator) {
+                        skip = true
+                        for (i in lower until upper) {
+                            val id = toHex(items[i].id)
+                            if (!theirs.remove(id)) haveIds.add(id)
+                        }
+                        needIds.addAll(theirs)
+                    } else {
+                        flushSkip()
+                        encodeBound(currBound, o)
+                        o.varint(MODE_ID_LIST.toLong())
+                        o.varint((upper - lower).toLong())
+                        for (i in lower until upper) o.bytes(items[i].id)
+                    }
+                }
+                else -> throw IllegalArgumentException("unexpected negentropy mode $mode")
+            }
+
+            out.append(o)
+            prevIndex = upper
+            prevBound = currBound
+        }
+
+        return if (isInitiator && out.size == 1) null else out.toByteArray()
+    }
+
+    private fun splitRange(lower: Int, upper: Int, upperBound: Bound, o: Output) {
+        val count = upper - lower
+        if (count < BUCKETS * 2) {
+            encodeBound(upperBound, o)
+            o.varint(MODE_ID_LIST.toLong())
+            o.varint(count.toLong())
+            for (i in lower until upper) o.bytes(items[i].id)
+            return
+        }
+        val perBucket = count / BUCKETS
+        val withExtra = count % BUCKETS
+        var curr = lower
+        for (i in 0 until BUCKETS) {
+            val size = perBucket + if (i < withExtra) 1 else 0
+            val fp = fingerprint(curr, curr + size)
+            curr += size
+            val next = if (curr == upper) upperBound else minimalBound(items[curr - 1], items[curr])
+            encodeBound(next, o)
+            o.varint(MODE_FINGERPRINT.toLong())
+            o.bytes(fp)
+        }
+    }
+
+    /**
+     * Shortest bound separating `prev` from `curr`
+     */
+    private fun minimalBound(prev: Item, curr: Item): Bound {
+        if (curr.timestamp != prev.timestamp) return Bound(curr.timestamp)
+        var shared = 0
+        while (shared < ID_SIZE && curr.id[shared] == prev.id[shared]) shared++
+        return Bound(curr.timestamp, curr.id.copyOf(minOf(shared + 1, ID_SIZE)))
+    }
+
+    /**
+     * First index in [first, last) whose item is not below `bound`
+     */
+    private fun lowerBound(first: Int, last: Int, bound: Bound): Int {
+        var lo = first
+        var hi = last
+        while (lo < hi) {
+            val mid = (lo + hi) ushr 1
+            val item = items[mid]
+            val below = item.timestamp < bound.timestamp ||
+                (item.timestamp == bound.timestamp && compareIds(item.id, bound.idPrefix) < 0)
+            if (below) lo = mid + 1 else hi = mid
+        }
+        return lo
+    }
+
+    /**
+     * SHA-256 over (sum of ids as little-endian 256-bit integers mod 2^256 || varint(count)), first 16 bytes
+     */
+    private fun fingerprint(lower: Int, upper: Int): ByteArray {
+        val sum = ByteArray(ID_SIZE)
+        for (i in lower until upper) {
+            val id = items[i].id
+            var carry = 0
+            for (j in 0 until ID_SIZE) {
+                val v = (sum[j].toInt() and 0xFF) + (id[j].toInt() and 0xFF) + carry
+                sum[j] = v.toByte()
+                carry = v ushr 8
+            }
+        }
+        val digest = MessageDigest.getInstance("SHA-256")
+        digest.update(sum)
+        digest.update(Output().apply { varint((upper - lower).toLong()) }.toByteArray())
+        return digest.digest().copyOf(FINGERPRINT_SIZE)
+    }
+
+    private fun encodeBound(bound: Bound, o: Output) {
+        if (bound.timestamp == INFINITY) {
+            lastTimestampOut = INFINITY
+            o.varint(0)
+        } else {
+            val delta = bound.timestamp - lastTimestampOut
+            lastTimestampOut = bound.timestamp
+            o.varint(delta + 1)
+        }
+        o.varint(bound.idPrefix.size.toLong())
+        o.bytes(bound.idPrefix)
+    }
+
+    private fun decodeBound(input: Input): Bound {
+        val encoded = input.varint()
+        var timestamp = if (encoded == 0L) INFINITY else encoded - 1
+        if (lastTimestampIn == INFINITY || timestamp == INFINITY) {
+            lastTimestampIn = INFINITY
+            timestamp = INFINITY
+        } else {
+            timestamp += lastTimestampIn
+            lastTimestampIn = timestamp
+        }
+        val length = input.varint().toInt()
+        require(length <= ID_SIZE) { "bound key too long" }
+        return Bound(timestamp, input.bytes(length))
+    }
+
+    // --- Wire helpers ---
+
+    private class Output {
+        private val buffer = ByteArrayOutputStream()
+        val size: Int get() = buffer.size()
+
+        fun byte(value: Int) = buffer.write(value)
+        fun bytes(value: ByteArray) = buffer.write(value, 0, value.size)
+        fun append(other: Output) = other.buffer.writeTo(buffer)
+        fun toByteArray(): ByteArray = buffer.toByteArray()
+
+        /**
+         * Big-endian base-128, high bit set on every byte but the last
+         */
+        fun varint(value: Long) {
+            if (value == 0L) {
+                buffer.write(0)
+                return
+            }
+            val groups = ArrayList<Int>(10)
+            var v = value
+            while (v != 0L) {
+                groups.add((v and 0x7F).toInt())
+                v = v ushr 7
+            }
+            for (i in groups.indices.reversed()) {
+                buffer.write(if (i == 0) groups[i] else groups[i] or 0x80)
+            }
+        }
+    }
+
+    private class Input(private val data: ByteArray) {
+        private var pos = 0
+
+        fun hasRemaining(): Boolean = pos < data.size
+
+        fun byte(): Int {
+            require(pos < data.size) { "negentropy message ends prematurely" }
+            return data[pos++].toInt() and 0xFF
+        }
+
+        fun bytes(count: Int): ByteArray {
+            require(pos + count <= data.size) { "negentropy message ends prematurely" }
+            return data.copyOfRange(pos, pos + count).also { pos += count }
+        }
+
+        fun varint(): Long {
+            var result = 0L
+            while (true) {
+                val b = byte()
+                result = (result shl 7) or (b and 0x7F).toLong()
+                if (b and 0x80 == 0) return result
+            }
+        }
+    }
+}
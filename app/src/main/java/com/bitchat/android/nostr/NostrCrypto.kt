@@ -263,14 +263,30 @@ object NostrCrypto {
      * NIP-44 v2 decryption using XChaCha20-Poly1305
      * Only accepts the exact "v2:" base64url format.
      * Tries both even/odd Y parities for x-only pubkeys.
+     * With `keyCache`, a cached conversation key for this pair is tried first and the key
+     * that works is remembered.
      */
-    fun decryptNIP44(ciphertext: String, senderPublicKeyHex: String, recipientPrivateKeyHex: String): String {
+    fun decryptNIP44(
+        ciphertext: String,
+        senderPublicKeyHex: String,
+        recipientPrivateKeyHex: String,
+        keyCache: NIP44KeyCache? = null
+    ): String {
         try {
             require(ciphertext.startsWith("v2:")) { "Invalid NIP-44 version prefix" }
             val encoded = ciphertext.substring(3)
             val encryptedData = base64UrlDecode(encoded)
                 ?: throw IllegalArgumentException("Invalid base64url payload")
 
+            keyCache?.get(recipientPrivateKeyHex, senderPublicKeyHex)?.let { cached ->
+                try {
+                    return String(XChaCha20Poly1305(cached).decrypt(encryptedData, null), Charsets.UTF_8)
+                } catch (e: Exception) {
+                    // Tampered payload or a hash collision; derive below
+                    keyCache.remove(recipientPrivateKeyHex, senderPublicKeyHex)
+                }
+            }
+
             var lastError: Exception? = null
             // Try even-Y first, then odd-Y
             for (preferOdd in listOf(false, true)) {
@@ -281,6 +297,7 @@ object NostrCrypto {
                     val key = deriveNIP44Key(secretMaterial)
                     val aead = XChaCha20Poly1305(key)
                     val pt = aead.decrypt(encryptedData, null) // expects nonce||ct||tag
+                    keyCache?.put(recipientPrivateKeyHex, senderPublicKeyHex, key)
                     return String(pt, Charsets.UTF_8)
                 } catch (e: Exception) {
                     lastError = e
@@ -9,12 +9,24 @@ import com.bitchat.android.services.SeenMessageStore
 import com.bitchat.android.ui.ChatState
 import com.bitchat.android.ui.MeshDelegateHandler
 import com.bitchat.android.ui.PrivateChatManager
+import com.bitchat.android.util.AppConstants
+import com.bitchat.android.util.BatchingQueue
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
-import kotlinx.coroutines.launch
+import kotlinx.coroutines.async
+import kotlinx.coroutines.awaitAll
+import kotlinx.coroutines.coroutineScope
 import kotlinx.coroutines.withContext
 import java.util.Date
 
+/**
+ * NostrDirectMessageHandler
+ * - Receives NIP-17 gift wraps (kind 1059) for the account and geohash identities
+ * - Drops duplicates, expired wraps and wraps for other identities before any crypto
+ * - Unwraps queued wraps in batches, in parallel on a bounded pool, with seal keys
+ *   cached per sender
+ * - Hands the results on in rumor timestamp order, with one main-thread hop per batch
+ */
 class NostrDirectMessageHandler(
     private val application: Application,
     private val state: ChatState,
@@ -33,6 +45,25 @@ class NostrDirectMessageHandler(
     private val seen = HashSet<String>()
     private val max = 2000
 
+    private data class Incoming(val giftWrap: NostrEvent, val geohash: String, val identity: NostrIdentity)
+
+    private data class Unwrapped(val incoming: Incoming, val content: String, val senderPubkey: String, val rumorTimestamp: Int)
+
+    // Collected while a batch is handled, applied once at its end
+    private class BatchEffects {
+        val ui = ArrayList<() -> Unit>()
+        val messageIds = HashSet<String>()
+    }
+
+    // Seal conversation keys per (identity, sender)
+    private val sealKeys = NIP44KeyCache(AppConstants.Nostr.GIFT_WRAP_KEY_CACHE_SIZE)
+
+    // NIP-44 decryption is CPU-bound; cap it so a reconnect backlog cannot take every core
+    private val unwrapDispatcher = Dispatchers.Default.limitedParallelism(AppConstants.Nostr.GIFT_WRAP_UNWRAP_PARALLELISM)
+
+    private val incoming = BatchingQueue<Incoming>(scope, AppConstants.Nostr.GIFT_WRAP_BATCH_MAX) { processBatch(it) }
+
+    @Synchronized
     private fun dedupe(id: String): Boolean {
         if (seen.contains(id)) return true
         seen.add(id)
@@ -44,78 +75,108 @@ class NostrDirectMessageHandler(
         return false
     }
 
+    /**
+     * Filter and enqueue a gift wrap. Cheap and thread-safe, so relay handlers call it
+     * directly from the socket thread.
+     */
     fun onGiftWrap(giftWrap: NostrEvent, geohash: String, identity: NostrIdentity) {
-        scope.launch(Dispatchers.Default) {
-            try {
-                if (dedupe(giftWrap.id)) return@launch
-
-                val messageAge = System.currentTimeMillis() / 1000 - giftWrap.createdAt
-                if (messageAge > 173700) return@launch // 48 hours + 15 mins
-
-                val decryptResult = NostrProtocol.decryptPrivateMessage(giftWrap, identity)
-                if (decryptResult == null) {
-                    Log.w(TAG, "Failed to decrypt Nostr message")
-                    return@launch
-                }
+        if (giftWrap.kind != NostrKind.GIFT_WRAP) return
+        val messageAge = System.currentTimeMillis() / 1000 - giftWrap.createdAt
+        if (messageAge > AppConstants.Nostr.GIFT_WRAP_MAX_AGE_SEC) return
+        // Addressed to another (e.g. a previous geohash) identity: it cannot decrypt anyway
+        val recipients = giftWrap.tags.filter { it.size >= 2 && it[0] == "p" }.map { it[1] }
+        if (recipients.isNotEmpty() && identity.publicKeyHex !in recipients) return
+        if (dedupe(giftWrap.id)) return
+        incoming.offer(Incoming(giftWrap, geohash, identity))
+    }
 
-                val (content, senderPubkey, rumorTimestamp) = decryptResult
+    private suspend fun processBatch(batch: List<Incoming>) {
+        val unwrapped = coroutineScope {
+            batch.map { item -> async(unwrapDispatcher) { unwrap(item) } }.awaitAll()
+        }.filterNotNull().sortedBy { it.rumorTimestamp }
+        if (batch.size > 1) Log.d(TAG, "Unwrapped ${unwrapped.size}/${batch.size} gift wraps")
 
-                // If sender is blocked for geohash contexts, drop any events from this pubkey
-                // Applies to both geohash DMs (geohash != "") and account DMs (geohash == "")
-                if (dataManager.isGeohashUserBlocked(senderPubkey)) return@launch
-                if (!content.startsWith("bitchat1:")) return@launch
+        val effects = BatchEffects()
+        for (item in unwrapped) {
+            try {
+                handleUnwrapped(item, effects)
+            } catch (e: Exception) {
+                Log.e(TAG, "onGiftWrap error: ${e.message}")
+            }
+        }
+        if (effects.ui.isNotEmpty()) {
+            withContext(Dispatchers.Main) { effects.ui.forEach { it() } }
+        }
+    }
 
-                val base64Content = content.removePrefix("bitchat1:")
-                val packetData = base64URLDecode(base64Content) ?: return@launch
-                val packet = BitchatPacket.fromBinaryData(packetData) ?: return@launch
+    private fun unwrap(item: Incoming): Unwrapped? {
+        val decryptResult = NostrProtocol.decryptPrivateMessage(item.giftWrap, item.identity, sealKeys)
+        if (decryptResult == null) {
+            Log.w(TAG, "Failed to decrypt Nostr message")
+            return null
+        }
+        val (content, senderPubkey, rumorTimestamp) = decryptResult
+        return Unwrapped(item, content, senderPubkey, rumorTimestamp)
+    }
 
-                if (packet.type != com.bitchat.android.protocol.MessageType.NOISE_ENCRYPTED.value) return@launch
+    private fun handleUnwrapped(item: Unwrapped, effects: BatchEffects) {
+        val (giftWrap, geohash, identity) = item.incoming
+        val content = item.content
+        val senderPubkey = item.senderPubkey
 
-                val noisePayload = com.bitchat.android.model.NoisePayload.decode(packet.payload) ?: return@launch
-                val messageTimestamp = Date(giftWrap.createdAt * 1000L)
-                val convKey = "nostr_${senderPubkey.take(16)}"
-                repo.putNostrKeyMapping(convKey, senderPubkey)
-                com.bitchat.android.nostr.GeohashAliasRegistry.put(convKey, senderPubkey)
-                if (geohash.isNotEmpty()) {
-                    // Remember which geohash this conversation belongs to so we can subscribe on-demand
-                    repo.setConversationGeohash(convKey, geohash)
-                    GeohashConversationRegistry.set(convKey, geohash)
-                }
+        // If sender is blocked for geohash contexts, drop any events from this pubkey
+        // Applies to both geohash DMs (geohash != "") and account DMs (geohash == "")
+        if (dataManager.isGeohashUserBlocked(senderPubkey)) return
+        if (!content.startsWith("bitchat1:")) return
 
-                // Ensure sender appears in geohash people list even if they haven't posted publicly yet
-                if (geohash.isNotEmpty()) {
-                    // Cache a best-effort nickname and mark as participant
-                    val cached = repo.getCachedNickname(senderPubkey)
-                    if (cached == null) {
-                        val base = repo.displayNameForNostrPubkeyUI(senderPubkey).substringBefore("#")
-                        repo.cacheNickname(senderPubkey, base)
-                    }
-                    repo.updateParticipant(geohash, senderPubkey, messageTimestamp)
-                }
+        val base64Content = content.removePrefix("bitchat1:")
+        val packetData = base64URLDecode(base64Content) ?: return
+        val packet = BitchatPacket.fromBinaryData(packetData) ?: return
 
-                val senderNickname = repo.displayNameForNostrPubkeyUI(senderPubkey)
+        if (packet.type != com.bitchat.android.protocol.MessageType.NOISE_ENCRYPTED.value) return
 
-                processNoisePayload(noisePayload, convKey, senderNickname, messageTimestamp, senderPubkey, identity)
+        val noisePayload = com.bitchat.android.model.NoisePayload.decode(packet.payload) ?: return
+        val messageTimestamp = Date(giftWrap.createdAt * 1000L)
+        val convKey = "nostr_${senderPubkey.take(16)}"
+        repo.putNostrKeyMapping(convKey, senderPubkey)
+        com.bitchat.android.nostr.GeohashAliasRegistry.put(convKey, senderPubkey)
+        if (geohash.isNotEmpty()) {
+            // Remember which geohash this conversation belongs to so we can subscribe on-demand
+            repo.setConversationGeohash(convKey, geohash)
+            GeohashConversationRegistry.set(convKey, geohash)
+        }
 
-            } catch (e: Exception) {
-                Log.e(TAG, "onGiftWrap error: ${e.message}")
+        // Ensure sender appears in geohash people list even if they haven't posted publicly yet
+        if (geohash.isNotEmpty()) {
+            // Cache a best-effort nickname and mark as participant
+            val cached = repo.getCachedNickname(senderPubkey)
+            if (cached == null) {
+                val base = repo.displayNameForNostrPubkeyUI(senderPubkey).substringBefore("#")
+                repo.cacheNickname(senderPubkey, base)
             }
+            repo.updateParticipant(geohash, senderPubkey, messageTimestamp)
         }
+
+        val senderNickname = repo.displayNameForNostrPubkeyUI(senderPubkey)
+
+        processNoisePayload(noisePayload, convKey, senderNickname, messageTimestamp, senderPubkey, identity, effects)
     }
 
-    private suspend fun processNoisePayload(
+    private fun processNoisePayload(
         payload: com.bitchat.android.model.NoisePayload,
         convKey: String,
         senderNickname: String,
         timestamp: Date,
         senderPubkey: String,
-        recipientIdentity: NostrIdentity
+        recipientIdentity: NostrIdentity,
+        effects: BatchEffects
     ) {
         when (payload.type) {
             com.bitchat.android.model.NoisePayloadType.PRIVATE_MESSAGE -> {
                 val pm = com.bitchat.android.model.PrivateMessagePacket.decode(payload.data) ?: return
-                val existingMessages = state.getPrivateChatsValue()[convKey] ?: emptyList()
-                if (existingMessages.any { it.id == pm.messageID }) return
+                // Also covers copies that arrived over mesh first (hedged sends), and
+                // re-sends earlier in this batch that are not in the chat yet
+                if (!effects.messageIds.add(pm.messageID) || privateChatManager.hasPrivateMessage(pm.messageID)) return
 
                 val message = BitchatMessage(
                     id = pm.messageID,
@@ -132,9 +193,7 @@ class NostrDirectMessageHandler(
                 val isViewing = state.getSelectedPrivateChatPeerValue() == convKey
                 val suppressUnread = seenStore.hasRead(pm.messageID)
 
-                withContext(Dispatchers.Main) {
-                    privateChatManager.handleIncomingPrivateMessage(message, suppressUnread)
-                }
+                effects.ui += { privateChatManager.handleIncomingPrivateMessage(message, suppressUnread) }
 
                 if (!seenStore.hasDelivered(pm.messageID)) {
                     val nostrTransport = NostrTransport.getInstance(application)
@@ -143,6 +202,7 @@ class NostrDirectMessageHandler(
                 }
 
                 if (isViewing && !suppressUnread) {
+                    // Geohash peers advertise no capabilities: one READ_RECEIPT per message
                     val nostrTransport = NostrTransport.getInstance(application)
                     nostrTransport.sendReadReceiptGeohash(pm.messageID, senderPubkey, recipientIdentity)
                     seenStore.markRead(pm.messageID)
@@ -150,15 +210,31 @@ class NostrDirectMessageHandler(
             }
             com.bitchat.android.model.NoisePayloadType.DELIVERED -> {
                 val messageId = String(payload.data, Charsets.UTF_8)
-                withContext(Dispatchers.Main) {
-                    meshDelegateHandler.didReceiveDeliveryAck(messageId, convKey)
+                com.bitchat.android.services.MessageRouter.tryGetInstance()
+                    ?.onAcknowledged(messageId, read = false, via = com.bitchat.android.services.PathQualityEstimator.Transport.NOSTR)
+                effects.ui += { meshDelegateHandler.didReceiveDeliveryAck(messageId, convKey) }
+            }
+            com.bitchat.android.model.NoisePayloadType.DELIVERED_BATCH -> {
+                // Sent over mesh only, but cheap to honor if a peer bridges one
+                val messageIds = com.bitchat.android.model.DeliveredBatch.decode(payload.data) ?: return
+                messageIds.forEach { messageId ->
+                    com.bitchat.android.services.MessageRouter.tryGetInstance()
+                        ?.onAcknowledged(messageId, read = false, via = com.bitchat.android.services.PathQualityEstimator.Transport.NOSTR)
                 }
+                effects.ui += { messageIds.forEach { meshDelegateHandler.didReceiveDeliveryAck(it, convKey) } }
             }
             com.bitchat.android.model.NoisePayloadType.READ_RECEIPT -> {
                 val messageId = String(payload.data, Charsets.UTF_8)
-                withContext(Dispatchers.Main) {
-                    meshDelegateHandler.didReceiveReadReceipt(messageId, convKey)
-                }
+                com.bitchat.android.services.MessageRouter.tryGetInstance()
+                    ?.onAcknowledged(messageId, read = true, via = com.bitchat.android.services.PathQualityEstimator.Transport.NOSTR)
+                effects.ui += { meshDelegateHandler.didReceiveReadReceipt(messageId, convKey) }
+            }
+            com.bitchat.android.model.NoisePayloadType.READ_UP_TO -> {
+                // Sent over mesh only, but cheap to honor if a peer bridges one
+                val messageId = String(payload.data, Charsets.UTF_8)
+                com.bitchat.android.services.MessageRouter.tryGetInstance()
+                    ?.onAcknowledged(messageId, read = true, via = com.bitchat.android.services.PathQualityEstimator.Transport.NOSTR)
+                effects.ui += { meshDelegateHandler.didReceiveReadUpTo(messageId, convKey) }
             }
             com.bitchat.android.model.NoisePayloadType.FILE_TRANSFER -> {
                 // Properly handle encrypted file transfer
@@ -178,13 +254,19 @@ class NostrDirectMessageHandler(
                         senderPeerID = convKey
                     )
                     Log.d(TAG, "📄 Saved Nostr encrypted incoming file to $savedPath (msgId=$uniqueMsgId)")
-                    withContext(Dispatchers.Main) {
-                        privateChatManager.handleIncomingPrivateMessage(message, suppressUnread = false)
-                    }
+                    effects.ui += { privateChatManager.handleIncomingPrivateMessage(message, suppressUnread = false) }
                 } else {
                     Log.w(TAG, "⚠️ Failed to decode Nostr file transfer from $convKey")
                 }
             }
+            com.bitchat.android.model.NoisePayloadType.FILE_STREAM_START -> {
+                // Streamed transfers need the mesh FILE_STREAM_RECORD packets; not carried over Nostr
+                Log.w(TAG, "⚠️ Ignoring file stream start from $convKey over Nostr")
+            }
+            com.bitchat.android.model.NoisePayloadType.PEER_STATE -> {
+                // Mesh only; favorites over Nostr still use the "[FAVORITED]" private message
+                Log.w(TAG, "⚠️ Ignoring peer state from $convKey over Nostr")
+            }
             com.bitchat.android.model.NoisePayloadType.PING -> {
                 TODO("Ping not respond from Nostr")
             }
@@ -0,0 +1,256 @@
+package com.bitchat.android.nostr
+
+import android.content.ContentValues
+import android.content.Context
+import android.database.sqlite.SQLiteDatabase
+import android.database.sqlite.SQLiteOpenHelper
+import android.util.Log
+import com.bitchat.android.util.AppConstants
+
+/**
+ * Offline-first cache of geohash channel events.
+ *
+ * Signature-verified kind=20000 events are persisted in a small SQLite database indexed by
+ * (geohash, kind, created_at) and by event id. On a channel switch the stored events are
+ * replayed immediately, and the relay subscription only asks for what came after the
+ * per-geohash high-water mark instead of re-downloading the whole window. Events dated in
+ * the future are refused and the mark never passes the current time, so one bad
+ * created_at cannot make the live subscription skip everything.
+ *
+ * All methods block on disk; call them off the main thread.
+ */
+class NostrEventStore private constructor(context: Context) :
+    SQLiteOpenHelper(context, DB_NAME, null, DB_VERSION) {
+
+    companion object {
+        private const val TAG = "NostrEventStore"
+        private const val DB_NAME = "nostr_events.db"
+        private const val DB_VERSION = 1
+
+        private const val TABLE = "events"
+        private const val COL_ID = "id"
+        private const val COL_GEOHASH = "geohash"
+        private const val COL_KIND = "kind"
+        private const val COL_CREATED_AT = "created_at"
+        private const val COL_PUBKEY = "pubkey"
+        private const val COL_JSON = "json"
+
+        @Volatile private var INSTANCE: NostrEventStore? = null
+        fun getInstance(context: Context): NostrEventStore {
+            return INSTANCE ?: synchronized(this) {
+                INSTANCE ?: NostrEventStore(context.applicationContext).also { INSTANCE = it }
+            }
+        }
+    }
+
+    @Volatile private var insertsSincePrune = 0
+
+    override fun onCreate(db: SQLiteDatabase) {
+        db.execSQL(
+            "CREATE TABLE $TABLE (" +
+                "$COL_ID TEXT PRIMARY KEY NOT NULL, " +
+                "$COL_GEOHASH TEXT NOT NULL, " +
+                "$COL_KIND INTEGER NOT NULL, " +
+                "$COL_CREATED_AT INTEGER NOT NULL, " +
+                "$COL_PUBKEY TEXT NOT NULL, " +
+                "$COL_JSON TEXT NOT NULL)"
+        )
+        db.execSQL("CREATE INDEX idx_events_geo_kind_time ON $TABLE ($COL_GEOHASH, $COL_KIND, $COL_CREATED_AT)")
+    }
+
+    override fun onUpgrade(db: SQLiteDatabase, oldVersion: Int, newVersion: Int) {
+        // Cache only; drop and rebuild
+        db.execSQL("DROP TABLE IF EXISTS $TABLE")
+        onCreate(db)
+    }
+
+    override fun onConfigure(db: SQLiteDatabase) {
+        super.onConfigure(db)
+        db.enableWriteAheadLogging()
+    }
+
+    override fun onOpen(db: SQLiteDatabase) {
+        super.onOpen(db)
+        if (!db.isReadOnly) prune(db)
+    }
+
+    /**
+     * Verify and persist an event received for `geohash`.
+     * Returns false if the signature is invalid or the event is dated in the future; the
+     * caller should drop the event.
+     */
+    fun put(event: NostrEvent, geohash: String): Boolean {
+        if (!isAcceptable(event, nowSec())) return false
+        try {
+            val values = ContentValues().apply {
+                put(COL_ID, event.id)
+                put(COL_GEOHASH, geohash.lowercase())
+                put(COL_KIND, event.kind)
+                put(COL_CREATED_AT, event.createdAt.toLong())
+                put(COL_PUBKEY, event.pubkey)
+                put(COL_JSON, event.toJsonString())
+            }
+            writableDatabase.insertWithOnConflict(TABLE, null, values, SQLiteDatabase.CONFLICT_IGNORE)
+            if (++insertsSincePrune >= AppConstants.Nostr.EVENT_STORE_PRUNE_EVERY) {
+                insertsSincePrune = 0
+                prune()
+            }
+        } catch (e: Exception) {
+            // Storage failure must not drop a verified live event
+            Log.w(TAG, "Failed to persist event ${event.id.take(16)}…: ${e.message}")
+        }
+        return true
+    }
+
+    /**
+     * Batch form of [put]: verifies every event and persists the valid ones in one
+     * transaction. Returns the events that were accepted, in input order.
+     */
+    fun putAll(events: List<NostrEvent>, geohash: String): List<NostrEvent> {
+        val now = nowSec()
+        val valid = events.filter { isAcceptable(it, now) }
+        if (valid.isEmpty()) return valid
+        try {
+            val db = writableDatabase
+            db.beginTransaction()
+            try {
+                val values = ContentValues()
+                for (event in valid) {
+                    values.clear()
+                    values.put(COL_ID, event.id)
+                    values.put(COL_GEOHASH, geohash.lowercase())
+                    values.put(COL_KIND, event.kind)
+                    values.put(COL_CREATED_AT, event.createdAt.toLong())
+                    values.put(COL_PUBKEY, event.pubkey)
+                    values.put(COL_JSON, event.toJsonString())
+                    db.insertWithOnConflict(TABLE, null, values, SQLiteDatabase.CONFLICT_IGNORE)
+                }
+                db.setTransactionSuccessful()
+            } finally {
+                db.endTransaction()
+            }
+            insertsSincePrune += valid.size
+            if (insertsSincePrune >= AppConstants.Nostr.EVENT_STORE_PRUNE_EVERY) {
+                insertsSincePrune = 0
+                prune()
+            }
+        } catch (e: Exception) {
+            // Storage failure must not drop verified live events
+            Log.w(TAG, "Failed to persist ${valid.size} events: ${e.message}")
+        }
+        return valid
+    }
+
+    /**
+     * Stored events for a geohash created at or after `sinceSec`, oldest first, newest `limit` kept
+     */
+    fun recent(geohash: String, kind: Int, sinceSec: Long, limit: Int): List<NostrEvent> {
+        val events = ArrayList<NostrEvent>()
+        try {
+            readableDatabase.query(
+                TABLE,
+                arrayOf(COL_JSON),
+                "$COL_GEOHASH = ? AND $COL_KIND = ? AND $COL_CREATED_AT >= ?",
+                arrayOf(geohash.lowercase(), kind.toString(), sinceSec.toString()),
+                null, null,
+                "$COL_CREATED_AT DESC",
+                limit.toString()
+            ).use { cursor ->
+                while (cursor.moveToNext()) {
+                    NostrEvent.fromJsonString(cursor.getString(0))?.let { events.add(it) }
+                }
+            }
+        } catch (e: Exception) {
+            Log.w(TAG, "Failed to load events for $geohash: ${e.message}")
+        }
+        events.reverse()
+        return events
+    }
+
+    /**
+     * (created_at, id) of every stored event for a geohash at or after `sinceSec`, the local
+     * side of a negentropy reconciliation
+     */
+    fun negentropyItems(geohash: String, kind: Int, sinceSec: Long): List<Negentropy.Item> {
+        val items = ArrayList<Negentropy.Item>()
+        try {
+            readableDatabase.query(
+                TABLE,
+                arrayOf(COL_CREATED_AT, COL_ID),
+                "$COL_GEOHASH = ? AND $COL_KIND = ? AND $COL_CREATED_AT >= ?",
+                arrayOf(geohash.lowercase(), kind.toString(), sinceSec.toString()),
+                null, null, null
+            ).use { cursor ->
+                while (cursor.moveToNext()) {
+                    Negentropy.item(cursor.getLong(0), cursor.getString(1))?.let { items.add(it) }
+                }
+            }
+        } catch (e: Exception) {
+            Log.w(TAG, "Failed to load event ids for $geohash: ${e.message}")
+        }
+        return items
+    }
+
+    /**
+     * created_at (seconds) of the newest stored event for a geohash, capped at now, or null
+     * if none
+     */
+    fun highWaterMark(geohash: String, kind: Int): Long? {
+        val now = nowSec()
+        return try {
+            readableDatabase.rawQuery(
+                "SELECT MAX($COL_CREATED_AT) FROM $TABLE WHERE $COL_GEOHASH = ? AND $COL_KIND = ?",
+                arrayOf(geohash.lowercase(), kind.toString())
+            ).use { cursor ->
+                if (cursor.moveToFirst() && !cursor.isNull(0)) minOf(cursor.getLong(0), now) else null
+            }
+        } catch (e: Exception) {
+            Log.w(TAG, "Failed to read high-water mark for $geohash: ${e.message}")
+            null
+        }
+    }
+
+    /**
+     * Drop events older than the retention window, and any dated in the future
+     */
+    fun prune(db: SQLiteDatabase = writableDatabase) {
+        try {
+            val now = nowSec()
+            val cutoff = now - AppConstants.Nostr.EVENT_STORE_RETENTION_MS / 1000
+            val ceiling = now + AppConstants.Nostr.EVENT_STORE_MAX_FUTURE_SKEW_SEC
+            val removed = db.delete(
+                TABLE,
+                "$COL_CREATED_AT < ? OR $COL_CREATED_AT > ?",
+                arrayOf(cutoff.toString(), ceiling.toString())
+            )
+            if (removed > 0) Log.d(TAG, "Pruned $removed expired events")
+        } catch (e: Exception) {
+            Log.w(TAG, "Prune failed: ${e.message}")
+        }
+    }
+
+    private fun isAcceptable(event: NostrEvent, now: Long): Boolean {
+        if (event.createdAt > now + AppConstants.Nostr.EVENT_STORE_MAX_FUTURE_SKEW_SEC) {
+            Log.w(TAG, "Dropping geohash event ${event.id.take(16)}… dated ${event.createdAt - now}s in the future")
+            return false
+        }
+        if (!event.isValidSignature()) {
+            Log.w(TAG, "Dropping geohash event ${event.id.take(16)}… with invalid signature")
+            return false
+        }
+        return true
+    }
+
+    private fun nowSec(): Long = System.currentTimeMillis() / 1000
+
+    /**
+     * Remove every stored event (panic mode)
+     */
+    fun clearAll() {
+        try {
+            writableDatabase.delete(TABLE, null, null)
+        } catch (e: Exception) {
+            Log.w(TAG, "Failed to clear event store: ${e.message}")
+        }
+    }
+}
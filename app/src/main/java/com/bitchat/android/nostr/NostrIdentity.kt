@@ -98,32 +98,51 @@ object NostrIdentityBridge {
     private const val NOSTR_PRIVATE_KEY = "nostr_private_key"
     private const val DEVICE_SEED_KEY = "nostr_device_seed"
     
-    // Cache for derived geohash identities to avoid repeated crypto operations
-    private val geohashIdentityCache = mutableMapOf<String, NostrIdentity>()
+    private const val GEOHASH_IDENTITY_CACHE_SIZE = com.bitchat.android.util.AppConstants.Nostr.GEOHASH_IDENTITY_CACHE_SIZE
+    
+    // LRU cache for derived geohash identities to avoid repeated crypto operations.
+    // Bounded because browsing channels and location notes touches many geohashes; the
+    // active one is read constantly and stays hot. Guarded by its own monitor.
+    private val geohashIdentityCache = object : LinkedHashMap<String, NostrIdentity>(16, 0.75f, true) {
+        override fun removeEldestEntry(eldest: MutableMap.MutableEntry<String, NostrIdentity>?): Boolean {
+            return size > GEOHASH_IDENTITY_CACHE_SIZE
+        }
+    }
+    
+    // Current identity and device seed are read on every send path; keep them in memory
+    // instead of going back to encrypted storage each time
+    @Volatile private var currentIdentity: NostrIdentity? = null
+    @Volatile private var deviceSeed: ByteArray? = null
     
     /**
      * Get or create the current Nostr identity
      */
     fun getCurrentNostrIdentity(context: Context): NostrIdentity? {
-        val stateManager = SecureIdentityStateManager(context)
+        currentIdentity?.let { return it }
         
-        // Try to load existing Nostr private key
-        val existingKey = loadNostrPrivateKey(stateManager)
-        if (existingKey != null) {
-            return try {
-                NostrIdentity.fromPrivateKey(existingKey)
-            } catch (e: Exception) {
-                Log.e(TAG, "Failed to create identity from stored key: ${e.message}")
-                null
+        synchronized(this) {
+            currentIdentity?.let { return it }
+            val stateManager = SecureIdentityStateManager(context)
+            
+            // Try to load existing Nostr private key
+            val existingKey = loadNostrPrivateKey(stateManager)
+            if (existingKey != null) {
+                return try {
+                    NostrIdentity.fromPrivateKey(existingKey).also { currentIdentity = it }
+                } catch (e: Exception) {
+                    Log.e(TAG, "Failed to create identity from stored key: ${e.message}")
+                    null
+                }
             }
+            
+            // Generate new identity
+            val newIdentity = NostrIdentity.generate()
+            saveNostrPrivateKey(stateManager, newIdentity.privateKeyHex)
+            currentIdentity = newIdentity
+            
+            Log.i(TAG, "Created new Nostr identity: ${newIdentity.getShortNpub()}")
+            return newIdentity
         }
-        
-        // Generate new identity
-        val newIdentity = NostrIdentity.generate()
-        saveNostrPrivateKey(stateManager, newIdentity.privateKeyHex)
-        
-        Log.i(TAG, "Created new Nostr identity: ${newIdentity.getShortNpub()}")
-        return newIdentity
     }
     
     /**
@@ -136,14 +155,36 @@ object NostrIdentityBridge {
      */
     fun deriveIdentity(forGeohash: String, context: Context): NostrIdentity {
         // Check cache first for immediate response
-        geohashIdentityCache[forGeohash]?.let { cachedIdentity ->
-            //Log.v(TAG, "Using cached geohash identity for $forGeohash")
-            return cachedIdentity
-        }
+        cachedIdentity(forGeohash)?.let { return it }
         
-        val stateManager = SecureIdentityStateManager(context)
-        val seed = getOrCreateDeviceSeed(stateManager)
+        val seed = deviceSeed ?: synchronized(this) {
+            deviceSeed ?: getOrCreateDeviceSeed(SecureIdentityStateManager(context)).also { deviceSeed = it }
+        }
         
+        // Derive outside the cache lock; a concurrent miss for the same geohash yields the same key
+        val identity = deriveFromSeed(seed, forGeohash)
+        synchronized(geohashIdentityCache) { geohashIdentityCache[forGeohash] = identity }
+        return identity
+    }
+    
+    /**
+     * Pseudonym under which this device's bridge republishes a mesh peer into a geohash
+     * channel. Keyed by the secret device seed like geohash identities, so only this device
+     * can sign as it; other bridges relaying the same peer use pseudonyms of their own.
+     */
+    fun deriveBridgeIdentity(geohash: String, senderPeerID: String, context: Context): NostrIdentity {
+        // '|' never occurs in a geohash, so these never collide with channel identities
+        return deriveIdentity("bridge|$geohash|$senderPeerID", context)
+    }
+    
+    /**
+     * Cached geohash identity without deriving; for UI paths that must not block on a miss
+     */
+    fun cachedIdentity(forGeohash: String): NostrIdentity? {
+        return synchronized(geohashIdentityCache) { geohashIdentityCache[forGeohash] }
+    }
+    
+    private fun deriveFromSeed(seed: ByteArray, forGeohash: String): NostrIdentity {
         val geohashBytes = forGeohash.toByteArray(Charsets.UTF_8)
         
         // Try a few iterations to ensure a valid key can be formed (exactly like iOS)
@@ -152,13 +193,8 @@ object NostrIdentityBridge {
             val candidateKeyHex = candidateKey.toHexStringLocal()
             
             if (NostrCrypto.isValidPrivateKey(candidateKeyHex)) {
-                val identity = NostrIdentity.fromPrivateKey(candidateKeyHex)
-                
-                // Cache the result for future UI responsiveness
-                geohashIdentityCache[forGeohash] = identity
-                
                 Log.d(TAG, "Derived geohash identity for $forGeohash (iteration $i)")
-                return identity
+                return NostrIdentity.fromPrivateKey(candidateKeyHex)
             }
         }
         
@@ -167,13 +203,8 @@ object NostrIdentityBridge {
         val digest = MessageDigest.getInstance("SHA-256")
         val fallbackKey = digest.digest(combined)
         
-        val fallbackIdentity = NostrIdentity.fromPrivateKey(fallbackKey.toHexStringLocal())
-        
-        // Cache the fallback result too
-        geohashIdentityCache[forGeohash] = fallbackIdentity
-        
         Log.d(TAG, "Used fallback identity derivation for $forGeohash")
-        return fallbackIdentity
+        return NostrIdentity.fromPrivateKey(fallbackKey.toHexStringLocal())
     }
     
     /**
@@ -213,7 +244,11 @@ object NostrIdentityBridge {
         val stateManager = SecureIdentityStateManager(context)
         
         // Clear cache first
-        geohashIdentityCache.clear()
+        synchronized(geohashIdentityCache) { geohashIdentityCache.clear() }
+        synchronized(this) {
+            currentIdentity = null
+            deviceSeed = null
+        }
         
         // Clear Nostr private key using public methods instead of reflection
         try {
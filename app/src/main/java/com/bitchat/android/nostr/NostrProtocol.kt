@@ -57,10 +57,13 @@ object NostrProtocol {
     /**
      * Decrypt a received NIP-17 message
      * Returns (content, senderPubkey, timestamp) or null if decryption fails
+     * `sealKeys` caches conversation keys per sender for the seal layer (the wrap layer
+     * uses a one-off key, so caching it would never hit)
      */
     fun decryptPrivateMessage(
         giftWrap: NostrEvent,
-        recipientIdentity: NostrIdentity
+        recipientIdentity: NostrIdentity,
+        sealKeys: NIP44KeyCache? = null
     ): Triple<String, String, Int>? {
         Log.v(TAG, "Starting decryption of gift wrap: ${giftWrap.id.take(16)}...")
         
@@ -75,7 +78,7 @@ object NostrProtocol {
             Log.v(TAG, "Successfully unwrapped gift wrap from: ${seal.pubkey.take(16)}...")
             
             // 2. Open the seal
-            val rumor = openSeal(seal, recipientIdentity.privateKeyHex)
+            val rumor = openSeal(seal, recipientIdentity.privateKeyHex, sealKeys)
                 ?: run {
                     Log.w(TAG, "❌ Failed to open seal")
                     return null
@@ -278,13 +281,15 @@ object NostrProtocol {
     
     private fun openSeal(
         seal: NostrEvent,
-        recipientPrivateKey: String
+        recipientPrivateKey: String,
+        keyCache: NIP44KeyCache? = null
     ): NostrEvent? {
         return try {
             val decrypted = NostrCrypto.decryptNIP44(
                 ciphertext = seal.content,
                 senderPublicKeyHex = seal.pubkey,
-                recipientPrivateKeyHex = recipientPrivateKey
+                recipientPrivateKeyHex = recipientPrivateKey,
+                keyCache = keyCache
             )
             
             val jsonElement = JsonParser.parseString(decrypted)
@@ -7,11 +7,12 @@ import com.google.gson.Gson
 import com.google.gson.JsonArray
 import com.google.gson.JsonParser
 import kotlinx.coroutines.*
+import com.bitchat.android.net.TorCircuitPrewarmer
+import com.bitchat.android.net.TorIsolation
+import kotlinx.coroutines.channels.Channel
 import okhttp3.*
 import java.util.concurrent.ConcurrentHashMap
 import java.util.concurrent.TimeUnit
-import kotlin.math.min
-import kotlin.math.pow
 
 /**
  * Manages WebSocket connections to Nostr relays
@@ -40,12 +41,6 @@ class NostrRelayManager private constructor() {
             "wss://nostr21.com"
         )
         
-        // Exponential backoff configuration (same as iOS)
-        private const val INITIAL_BACKOFF_INTERVAL = com.bitchat.android.util.AppConstants.Nostr.INITIAL_BACKOFF_INTERVAL_MS  // 1 second
-        private const val MAX_BACKOFF_INTERVAL = com.bitchat.android.util.AppConstants.Nostr.MAX_BACKOFF_INTERVAL_MS    // 5 minutes
-        private const val BACKOFF_MULTIPLIER = com.bitchat.android.util.AppConstants.Nostr.BACKOFF_MULTIPLIER
-        private const val MAX_RECONNECT_ATTEMPTS = com.bitchat.android.util.AppConstants.Nostr.MAX_RECONNECT_ATTEMPTS
-        
         // Track gift-wraps we initiated for logging
         private val pendingGiftWrapIDs = ConcurrentHashMap.newKeySet<String>()
         
@@ -84,6 +79,11 @@ class NostrRelayManager private constructor() {
     private val subscriptions = ConcurrentHashMap<String, Set<String>>() // relay URL -> subscription IDs
     private val messageHandlers = ConcurrentHashMap<String, (NostrEvent) -> Unit>()
     
+    // NIP-77 sessions and one-shot id fetches waiting on relay replies, by subscription id
+    private val negentropySessions = ConcurrentHashMap<String, Channel<NostrResponse>>()
+    private val negentropyUnsupported = ConcurrentHashMap.newKeySet<String>()
+    private val pendingFetches = ConcurrentHashMap<String, CompletableDeferred<Unit>>()
+
     // Persistent subscription tracking for robust reconnection
     private val activeSubscriptions = ConcurrentHashMap<String, SubscriptionInfo>() // subscription ID -> info
     
@@ -96,7 +96,8 @@ class NostrRelayManager private constructor() {
         val handler: (NostrEvent) -> Unit,
         val targetRelayUrls: Set<String>? = null, // null means all relays
         val createdAt: Long = System.currentTimeMillis(),
-        val originGeohash: String? = null // used for logging and grouping
+        val originGeohash: String? = null, // used for logging and grouping
+        val deliverOnMain: Boolean = true // false: handler runs on the socket thread and must only enqueue
     )
     
     // Event deduplication system
@@ -112,10 +113,33 @@ class NostrRelayManager private constructor() {
     // Subscription validation timer
     private var subscriptionValidationJob: Job? = null
     private val SUBSCRIPTION_VALIDATION_INTERVAL = com.bitchat.android.util.AppConstants.Nostr.SUBSCRIPTION_VALIDATION_INTERVAL_MS // 30 seconds
+
+    // Hard cap on live REQs per relay; subscriptions over the cap wait until a CLOSE frees a slot
+    private val MAX_SUBSCRIPTIONS_PER_RELAY = com.bitchat.android.util.AppConstants.Nostr.MAX_SUBSCRIPTIONS_PER_RELAY
     
-    // OkHttp client for WebSocket connections (via provider to honor Tor)
-    private val httpClient: OkHttpClient
-        get() = com.bitchat.android.net.OkHttpProvider.webSocketClient()
+    // Connection attempts go through the scheduler (global budget, priorities, jittered backoff)
+    private val connectionScheduler = RelayConnectionScheduler()
+    private val relayPriorities = ConcurrentHashMap<String, RelayConnectionScheduler.Priority>()
+    private val activeListeners = ConcurrentHashMap<String, RelayWebSocketListener>() // relay URL -> current attempt
+    private val schedulerWake = Channel<Unit>(Channel.CONFLATED)
+    private var schedulerJob: Job? = null
+
+    // OkHttp client for WebSocket connections (via provider to honor Tor and its circuit isolation)
+    private fun httpClient(relayUrl: String): OkHttpClient =
+        com.bitchat.android.net.OkHttpProvider.webSocketClient(isolationFor(relayUrl))
+
+    // Default relays carry DMs (gift wraps) and get isolated circuits; geohash relays share one
+    private fun isolationFor(relayUrl: String): TorIsolation =
+        if (relayUrl in DEFAULT_RELAYS) TorIsolation.DIRECT_MESSAGES else TorIsolation.GEOHASH
+
+    /**
+     * Relays whose Tor circuits are worth building while Tor bootstraps
+     */
+    fun torPrewarmTargets(): List<TorCircuitPrewarmer.Target> {
+        val geohashRelays = geohashToRelays.values.flatten().filter { it !in DEFAULT_RELAYS }.distinct()
+        return DEFAULT_RELAYS.map { TorCircuitPrewarmer.Target(TorIsolation.DIRECT_MESSAGES, it) } +
+            geohashRelays.map { TorCircuitPrewarmer.Target(TorIsolation.GEOHASH, it) }
+    }
     
     private val gson by lazy { NostrRequest.createGson() }
     
@@ -126,8 +150,14 @@ class NostrRelayManager private constructor() {
 
     /**
      * Compute and connect to relays for a given geohash (nearest + optional defaults), cache the mapping.
+     * `priority` orders the connections: HIGH for the channel in view, LAZY for sampled ones.
      */
-    fun ensureGeohashRelaysConnected(geohash: String, nRelays: Int = 5, includeDefaults: Boolean = false) {
+    fun ensureGeohashRelaysConnected(
+        geohash: String,
+        nRelays: Int = 5,
+        includeDefaults: Boolean = false,
+        priority: RelayConnectionScheduler.Priority = RelayConnectionScheduler.Priority.NORMAL
+    ) {
         try {
             val nearest = RelayDirectory.closestRelaysForGeohash(geohash, nRelays)
             val selected = if (includeDefaults) {
@@ -139,7 +169,7 @@ class NostrRelayManager private constructor() {
             }
             geohashToRelays[geohash] = selected
             Log.i(TAG, "🌐 Geohash $geohash using ${selected.size} relays: ${selected.joinToString()}")
-            ensureConnectionsFor(selected)
+            ensureConnectionsFor(selected, priority)
         } catch (e: Exception) {
             Log.e(TAG, "Failed to ensure relays for $geohash: ${e.message}")
         }
@@ -161,16 +191,19 @@ class NostrRelayManager private constructor() {
         id: String = generateSubscriptionId(),
         handler: (NostrEvent) -> Unit,
         includeDefaults: Boolean = false,
-        nRelays: Int = 5
+        nRelays: Int = 5,
+        deliverOnMain: Boolean = true,
+        priority: RelayConnectionScheduler.Priority = RelayConnectionScheduler.Priority.NORMAL
     ): String {
-        ensureGeohashRelaysConnected(geohash, nRelays, includeDefaults)
+        ensureGeohashRelaysConnected(geohash, nRelays, includeDefaults, priority)
         val relayUrls = getRelaysForGeohash(geohash)
         Log.d(TAG, "📡 Subscribing id=$id for geohash=$geohash on ${relayUrls.size} relays")
         return subscribe(
             filter = filter,
             id = id,
             handler = handler,
-            targetRelayUrls = relayUrls
+            targetRelayUrls = relayUrls,
+            deliverOnMain = deliverOnMain
         ).also {
             // update origin geohash for this subscription
             activeSubscriptions[it]?.let { sub ->
@@ -179,6 +212,108 @@ class NostrRelayManager private constructor() {
         }
     }
 
+    /**
+     * NIP-77 reconciliation of `localItems` against one relay's events matching `filter`.
+     * Returns the ids the relay has and we lack, or null when the relay is not connected,
+     * does not speak negentropy, or the exchange failed; callers then fall back to a
+     * since-based REQ. Relays that never answer a NEG-OPEN are not asked again. The session
+     * holds one of the relay's REQ slots while it runs.
+     */
+    suspend fun reconcileWithRelay(
+        relayUrl: String,
+        filter: NostrFilter,
+        localItems: Collection<Negentropy.Item>
+    ): List<String>? {
+        if (relayUrl in negentropyUnsupported) return null
+        val webSocket = awaitConnected(relayUrl) ?: return null
+        val id = "neg-${generateSubscriptionId()}"
+        if (!awaitRelaySlot(relayUrl, id)) return null
+        val replies = Channel<NostrResponse>(Channel.UNLIMITED)
+        negentropySessions[id] = replies
+        val negentropy = Negentropy(localItems)
+        val haveIds = ArrayList<String>()
+        val needIds = ArrayList<String>()
+        try {
+            var outgoing: NostrRequest = NostrRequest.NegOpen(id, filter, Negentropy.toHex(negentropy.initiate()))
+            for (round in 0 until com.bitchat.android.util.AppConstants.Nostr.NEGENTROPY_MAX_ROUNDS) {
+                if (!webSocket.send(gson.toJson(outgoing, NostrRequest::class.java))) return null
+                when (val reply = withTimeoutOrNull(com.bitchat.android.util.AppConstants.Nostr.NEGENTROPY_ROUND_TIMEOUT_MS) { replies.receive() }) {
+                    null -> {
+                        if (round == 0) {
+                            Log.d(TAG, "Relay $relayUrl did not answer NEG-OPEN; using since-based catch-up")
+                            negentropyUnsupported.add(relayUrl)
+                        }
+                        return null
+                    }
+                    is NostrResponse.NegMessage -> {
+                        val next = negentropy.reconcile(Negentropy.fromHex(reply.message), haveIds, needIds)
+                            ?: return needIds
+                        outgoing = NostrRequest.NegMessage(id, Negentropy.toHex(next))
+                    }
+                    else -> return null
+                }
+            }
+            Log.w(TAG, "Negentropy with $relayUrl did not converge")
+            return null
+        } catch (e: IllegalArgumentException) {
+            Log.w(TAG, "Malformed negentropy message from $relayUrl: ${e.message}")
+            return null
+        } finally {
+            negentropySessions.remove(id)
+            replies.close()
+            runCatching { webSocket.send(gson.toJson(NostrRequest.NegClose(id), NostrRequest::class.java)) }
+            releaseTransientSlot(relayUrl, id)
+        }
+    }
+
+    /**
+     * One-shot fetch of specific events from one relay, in chunks closed at EOSE.
+     * `handler` is called on the socket thread. Returns false if any chunk did not complete.
+     */
+    suspend fun fetchEvents(relayUrl: String, ids: List<String>, handler: (NostrEvent) -> Unit): Boolean {
+        for (chunk in ids.chunked(com.bitchat.android.util.AppConstants.Nostr.NEGENTROPY_FETCH_CHUNK)) {
+            if (!fetch(relayUrl, NostrFilter.forEvents(chunk), handler)) return false
+        }
+        return true
+    }
+
+    /**
+     * One-shot REQ for `filter` on one relay, closed at EOSE. Holds one of the relay's REQ
+     * slots while open. `handler` is called on the socket thread. Returns false if the relay
+     * was unreachable, had no free slot in time, or did not reach EOSE.
+     */
+    suspend fun fetch(relayUrl: String, filter: NostrFilter, handler: (NostrEvent) -> Unit): Boolean {
+        val webSocket = awaitConnected(relayUrl) ?: return false
+        val id = "fetch-${generateSubscriptionId()}"
+        if (!awaitRelaySlot(relayUrl, id)) return false
+        val done = CompletableDeferred<Unit>()
+        messageHandlers[id] = handler
+        pendingFetches[id] = done
+        try {
+            val request = NostrRequest.Subscribe(id, listOf(filter))
+            if (!webSocket.send(gson.toJson(request, NostrRequest::class.java))) return false
+            return withTimeoutOrNull(com.bitchat.android.util.AppConstants.Nostr.NEGENTROPY_FETCH_TIMEOUT_MS) { done.await() } != null
+        } finally {
+            pendingFetches.remove(id)
+            messageHandlers.remove(id)
+            runCatching { webSocket.send(gson.toJson(NostrRequest.Close(id), NostrRequest::class.java)) }
+            releaseTransientSlot(relayUrl, id)
+        }
+    }
+
+    private suspend fun awaitConnected(relayUrl: String): WebSocket? {
+        fun openSocket(): WebSocket? =
+            connections[relayUrl]?.takeIf { relaysList.find { it.url == relayUrl }?.isConnected == true }
+        return withTimeoutOrNull(com.bitchat.android.util.AppConstants.Nostr.NEGENTROPY_CONNECT_WAIT_MS) {
+            var webSocket = openSocket()
+            while (webSocket == null) {
+                delay(100)
+                webSocket = openSocket()
+            }
+            webSocket
+        }
+    }
+
     /**
      * Send an event specifically to a geohash's relays (+ optional defaults).
      */
@@ -196,7 +331,7 @@ class NostrRelayManager private constructor() {
 
     // --- Internal helpers ---
 
-    private fun ensureConnectionsFor(relayUrls: Set<String>) {
+    private fun ensureConnectionsFor(relayUrls: Set<String>, priority: RelayConnectionScheduler.Priority) {
         // Ensure relays are tracked for UI/status
         relayUrls.forEach { url ->
             if (relaysList.none { it.url == url }) {
@@ -205,15 +340,42 @@ class NostrRelayManager private constructor() {
         }
         updateRelaysList()
 
-        scope.launch {
-            relayUrls.forEach { relayUrl ->
-                launch {
-                    if (!connections.containsKey(relayUrl)) {
-                        connectToRelay(relayUrl)
+        relayUrls.forEach { relayUrl -> requestConnection(relayUrl, priority) }
+        kickScheduler()
+    }
+
+    /**
+     * Queue a relay with the scheduler; a relay keeps the highest priority it was asked for
+     */
+    private fun requestConnection(relayUrl: String, priority: RelayConnectionScheduler.Priority? = null) {
+        val effective = relayPriorities.merge(relayUrl, priority ?: defaultPriority(relayUrl)) { old, new ->
+            if (new < old) new else old
+        }!!
+        if (!connections.containsKey(relayUrl)) {
+            connectionScheduler.request(relayUrl, effective)
+        }
+    }
+
+    // Default relays carry DMs and untargeted subscriptions
+    private fun defaultPriority(relayUrl: String): RelayConnectionScheduler.Priority =
+        if (relayUrl in DEFAULT_RELAYS) RelayConnectionScheduler.Priority.HIGH else RelayConnectionScheduler.Priority.NORMAL
+
+    /**
+     * Start due connections whenever the scheduler has budget, and wake for backoff deadlines
+     */
+    private fun kickScheduler() {
+        synchronized(schedulerWake) {
+            if (schedulerJob?.isActive != true) {
+                schedulerJob = scope.launch {
+                    while (isActive) {
+                        connectionScheduler.due().forEach { relayUrl -> launch { connectToRelay(relayUrl) } }
+                        val wait = connectionScheduler.nextWakeAt()?.let { (it - System.currentTimeMillis()).coerceAtLeast(1) }
+                        if (wait == null) schedulerWake.receive() else withTimeoutOrNull(wait) { schedulerWake.receive() }
                     }
                 }
             }
         }
+        schedulerWake.trySend(Unit)
     }
 
     init {
@@ -243,13 +405,8 @@ class NostrRelayManager private constructor() {
     fun connect() {
         Log.d(TAG, "🌐 Connecting to ${relaysList.size} Nostr relays")
         
-        scope.launch {
-            relaysList.forEach { relay ->
-                launch {
-                    connectToRelay(relay.url)
-                }
-            }
-        }
+        relaysList.toList().forEach { relay -> requestConnection(relay.url, relayPriorities[relay.url]) }
+        kickScheduler()
         
         // Start periodic subscription validation
         startSubscriptionValidation()
@@ -264,6 +421,9 @@ class NostrRelayManager private constructor() {
         // Stop subscription validation
         stopSubscriptionValidation()
         
+        // Untrack first so the closes below are not scheduled for reconnection
+        connectionScheduler.clear()
+        activeListeners.clear()
         connections.values.forEach { webSocket ->
             webSocket.close(1000, "Manual disconnect")
         }
@@ -300,19 +460,23 @@ class NostrRelayManager private constructor() {
     /**
      * Subscribe to events matching a filter
      * The subscription will be automatically re-established on reconnection
+     * Handlers run on the main thread unless `deliverOnMain` is false, in which case they are
+     * called directly on the socket thread and must be cheap and thread-safe (e.g. enqueue).
      */
     fun subscribe(
         filter: NostrFilter,
         id: String = generateSubscriptionId(),
         handler: (NostrEvent) -> Unit,
-        targetRelayUrls: List<String>? = null
+        targetRelayUrls: List<String>? = null,
+        deliverOnMain: Boolean = true
     ): String {
         // Store subscription info for persistent tracking
         val subscriptionInfo = SubscriptionInfo(
             id = id,
             filter = filter,
             handler = handler,
-            targetRelayUrls = targetRelayUrls?.toSet()
+            targetRelayUrls = targetRelayUrls?.toSet(),
+            deliverOnMain = deliverOnMain
         )
         
         activeSubscriptions[id] = subscriptionInfo
@@ -342,18 +506,20 @@ class NostrRelayManager private constructor() {
             targetRelays.forEach { relayUrl ->
                 val webSocket = connections[relayUrl]
                 if (webSocket != null) {
+                    if (!reserveRelaySlot(relayUrl, subscriptionInfo.id)) {
+                        Log.d(TAG, "⏸️ Relay $relayUrl at $MAX_SUBSCRIPTIONS_PER_RELAY subscriptions, deferring '${subscriptionInfo.id}'")
+                        return@forEach
+                    }
                     try {
                         val success = webSocket.send(message)
                         if (success) {
-                            // Track subscription for this relay
-                            val currentSubs = subscriptions[relayUrl] ?: emptySet()
-                            subscriptions[relayUrl] = currentSubs + subscriptionInfo.id
-                            
                             Log.v(TAG, "✅ Subscription '${subscriptionInfo.id}' sent to relay: $relayUrl")
                         } else {
+                            releaseRelaySlot(relayUrl, subscriptionInfo.id)
                             Log.w(TAG, "❌ Failed to send subscription to $relayUrl: WebSocket send failed")
                         }
                     } catch (e: Exception) {
+                        releaseRelaySlot(relayUrl, subscriptionInfo.id)
                         Log.e(TAG, "❌ Failed to send subscription to $relayUrl: ${e.message}")
                     }
                 } else {
@@ -391,11 +557,13 @@ class NostrRelayManager private constructor() {
                 if (currentSubs?.contains(id) == true) {
                     try {
                         webSocket.send(message)
-                        subscriptions[relayUrl] = currentSubs - id
+                        releaseRelaySlot(relayUrl, id)
                         Log.v(TAG, "Unsubscribed '$id' from relay: $relayUrl")
                     } catch (e: Exception) {
                         Log.e(TAG, "Failed to unsubscribe from $relayUrl: ${e.message}")
                     }
+                    // Hand the freed slot to a deferred subscription
+                    restoreSubscriptionsForRelay(relayUrl, webSocket, fresh = false)
                 }
             }
         }
@@ -412,13 +580,13 @@ class NostrRelayManager private constructor() {
         relay.nextReconnectTime = null
         
         // Disconnect if connected
-        connections[relayUrl]?.close(1000, "Manual retry")
-        connections.remove(relayUrl)
+        connectionScheduler.forget(relayUrl)
+        activeListeners.remove(relayUrl)
+        connections.remove(relayUrl)?.close(1000, "Manual retry")
         
-        // Attempt immediate reconnection
-        scope.launch {
-            connectToRelay(relayUrl)
-        }
+        // Attempt immediate reconnection, ahead of anything else waiting
+        requestConnection(relayUrl, RelayConnectionScheduler.Priority.HIGH)
+        kickScheduler()
     }
     
     /**
@@ -531,9 +699,11 @@ class NostrRelayManager private constructor() {
             }.toSet()
             
             val missing = expectedForRelay - actualSubs
-            val extra = actualSubs - expectedForRelay
+            // Short-lived NEG/fetch sessions hold slots without being active subscriptions
+            val extra = (actualSubs - expectedForRelay).filterNot { it.startsWith("neg-") || it.startsWith("fetch-") }
             
-            if (missing.isNotEmpty()) {
+            // Subscriptions deferred by the per-relay cap are expected to be missing
+            if (missing.isNotEmpty() && actualSubs.size < MAX_SUBSCRIPTIONS_PER_RELAY) {
                 inconsistencies.add("Relay $relayUrl missing subscriptions: $missing")
             }
             if (extra.isNotEmpty()) {
@@ -580,9 +750,9 @@ class NostrRelayManager private constructor() {
                             }.toSet()
                             
                             val missingSubs = expectedSubs - currentSubs
-                            if (missingSubs.isNotEmpty()) {
+                            if (missingSubs.isNotEmpty() && currentSubs.size < MAX_SUBSCRIPTIONS_PER_RELAY) {
                                 Log.i(TAG, "🔧 Auto-repairing ${missingSubs.size} missing subscriptions for $relayUrl")
-                                restoreSubscriptionsForRelay(relayUrl, webSocket)
+                                restoreSubscriptionsForRelay(relayUrl, webSocket, fresh = false)
                             }
                         }
                     }
@@ -609,6 +779,8 @@ class NostrRelayManager private constructor() {
     private suspend fun connectToRelay(urlString: String) {
         // Skip if we already have a connection
         if (connections.containsKey(urlString)) {
+            connectionScheduler.onConnected(urlString)
+            kickScheduler()
             return
         }
         
@@ -619,7 +791,9 @@ class NostrRelayManager private constructor() {
                 .url(urlString)
                 .build()
             
-            val webSocket = httpClient.newWebSocket(request, RelayWebSocketListener(urlString))
+            val listener = RelayWebSocketListener(urlString)
+            activeListeners[urlString] = listener
+            val webSocket = httpClient(urlString).newWebSocket(request, listener)
             connections[urlString] = webSocket
             
         } catch (e: Exception) {
@@ -691,8 +865,17 @@ class NostrRelayManager private constructor() {
                         // Call handler for new events only
                         val handler = messageHandlers[response.subscriptionId]
                         if (handler != null) {
-                            scope.launch(Dispatchers.Main) {
-                                handler(event)
+                            if (activeSubscriptions[response.subscriptionId]?.deliverOnMain == false ||
+                                pendingFetches.containsKey(response.subscriptionId)
+                            ) {
+                                // Batched consumers queue off-main; no per-event main-thread hop
+                                try { handler(event) } catch (e: Exception) {
+                                    Log.e(TAG, "Handler failed for sub=${response.subscriptionId}: ${e.message}")
+                                }
+                            } else {
+                                scope.launch(Dispatchers.Main) {
+                                    handler(event)
+                                }
                             }
                         } else {
                             Log.w(TAG, "⚠️ No handler for subscription ${response.subscriptionId}")
@@ -706,6 +889,16 @@ class NostrRelayManager private constructor() {
                 
                 is NostrResponse.EndOfStoredEvents -> {
                     Log.v(TAG, "End of stored events for subscription: ${response.subscriptionId}")
+                    pendingFetches[response.subscriptionId]?.complete(Unit)
+                }
+
+                is NostrResponse.NegMessage -> {
+                    negentropySessions[response.subscriptionId]?.trySend(response)
+                }
+
+                is NostrResponse.NegError -> {
+                    Log.d(TAG, "Negentropy error from $relayUrl: ${response.reason}")
+                    negentropySessions[response.subscriptionId]?.trySend(response)
                 }
                 
                 is NostrResponse.Ok -> {
@@ -740,42 +933,27 @@ class NostrRelayManager private constructor() {
         
         // Check if this is a DNS error
         val errorMessage = error.message?.lowercase() ?: ""
-        if (errorMessage.contains("hostname could not be found") || 
+        val isDnsError = errorMessage.contains("hostname could not be found") ||
             errorMessage.contains("dns") ||
-            errorMessage.contains("unable to resolve host")) {
-            
-            val relay = relaysList.find { it.url == relayUrl }
-            if (relay?.lastError == null) {
-                Log.w(TAG, "Nostr relay DNS failure for $relayUrl - not retrying")
-            }
-            return
-        }
+            errorMessage.contains("unable to resolve host")
         
-        // Implement exponential backoff for non-DNS errors
+        // Jittered backoff for non-DNS errors; the scheduler frees the attempt's slot either way
+        val backoffInterval = connectionScheduler.onFailed(relayUrl, retry = !isDnsError)
+        kickScheduler()
         val relay = relaysList.find { it.url == relayUrl } ?: return
-        relay.reconnectAttempts++
-        
-        // Stop attempting after max attempts
-        if (relay.reconnectAttempts >= MAX_RECONNECT_ATTEMPTS) {
-            Log.w(TAG, "Max reconnection attempts ($MAX_RECONNECT_ATTEMPTS) reached for $relayUrl")
+        if (isDnsError) {
+            Log.w(TAG, "Nostr relay DNS failure for $relayUrl - not retrying")
             return
         }
-        
-        // Calculate backoff interval
-        val backoffInterval = min(
-            INITIAL_BACKOFF_INTERVAL * BACKOFF_MULTIPLIER.pow(relay.reconnectAttempts - 1.0),
-            MAX_BACKOFF_INTERVAL.toDouble()
-        ).toLong()
-        
+        if (backoffInterval == null) {
+            Log.w(TAG, "Not reconnecting to $relayUrl (max attempts reached or no longer wanted)")
+            relay.nextReconnectTime = null
+            return
+        }
+        relay.reconnectAttempts = connectionScheduler.attempts(relayUrl)
         relay.nextReconnectTime = System.currentTimeMillis() + backoffInterval
         
         Log.d(TAG, "Scheduling reconnection to $relayUrl in ${backoffInterval / 1000}s (attempt ${relay.reconnectAttempts})")
-        
-        // Schedule reconnection
-        scope.launch {
-            delay(backoffInterval)
-            connectToRelay(relayUrl)
-        }
     }
     
     private fun updateRelayStatus(url: String, isConnected: Boolean, error: Throwable? = null) {
@@ -810,13 +988,56 @@ class NostrRelayManager private constructor() {
     }
     
     /**
-     * Restore all active subscriptions for a specific relay that just reconnected
+     * Reserve one of a relay's REQ slots for a subscription (already-live ids keep theirs)
      */
-    private fun restoreSubscriptionsForRelay(relayUrl: String, webSocket: WebSocket) {
+    private fun reserveRelaySlot(relayUrl: String, subscriptionId: String): Boolean {
+        var reserved = false
+        subscriptions.compute(relayUrl) { _, current ->
+            val subs = current ?: emptySet()
+            when {
+                subs.contains(subscriptionId) -> { reserved = true; subs }
+                subs.size >= MAX_SUBSCRIPTIONS_PER_RELAY -> subs
+                else -> { reserved = true; subs + subscriptionId }
+            }
+        }
+        return reserved
+    }
+
+    private fun releaseRelaySlot(relayUrl: String, subscriptionId: String) {
+        subscriptions.computeIfPresent(relayUrl) { _, subs -> subs - subscriptionId }
+    }
+
+    /**
+     * Wait briefly for a REQ slot for a short-lived NEG or fetch session, so catch-up counts
+     * against the same per-relay cap as live subscriptions
+     */
+    private suspend fun awaitRelaySlot(relayUrl: String, sessionId: String): Boolean {
+        return withTimeoutOrNull(com.bitchat.android.util.AppConstants.Nostr.NEGENTROPY_CONNECT_WAIT_MS) {
+            while (!reserveRelaySlot(relayUrl, sessionId)) delay(100)
+            true
+        } ?: false.also { Log.d(TAG, "⏸️ No free subscription slot on $relayUrl for '$sessionId'") }
+    }
+
+    /**
+     * Free a short-lived session's slot and hand it to a deferred subscription, if any
+     */
+    private fun releaseTransientSlot(relayUrl: String, sessionId: String) {
+        releaseRelaySlot(relayUrl, sessionId)
+        connections[relayUrl]?.let { restoreSubscriptionsForRelay(relayUrl, it, fresh = false) }
+    }
+
+    /**
+     * Send the active subscriptions a relay should carry but doesn't, oldest first, up to the
+     * per-relay cap. `fresh` means the socket is new (reconnect) and nothing is live on it yet.
+     */
+    private fun restoreSubscriptionsForRelay(relayUrl: String, webSocket: WebSocket, fresh: Boolean = true) {
+        if (fresh) subscriptions[relayUrl] = emptySet()
+        val live = subscriptions[relayUrl] ?: emptySet()
         val subscriptionsToRestore = activeSubscriptions.values.filter { subscriptionInfo ->
             // Include subscription if it targets all relays or specifically targets this relay
-            subscriptionInfo.targetRelayUrls == null || subscriptionInfo.targetRelayUrls.contains(relayUrl)
-        }
+            (subscriptionInfo.targetRelayUrls == null || subscriptionInfo.targetRelayUrls.contains(relayUrl)) &&
+                subscriptionInfo.id !in live
+        }.sortedBy { it.createdAt }
         
         if (subscriptionsToRestore.isEmpty()) {
             Log.v(TAG, "🔄 No subscriptions to restore for relay: $relayUrl")
@@ -825,25 +1046,31 @@ class NostrRelayManager private constructor() {
         
         Log.d(TAG, "🔄 Restoring ${subscriptionsToRestore.size} subscriptions for relay: $relayUrl")
         
+        var deferred = 0
         subscriptionsToRestore.forEach { subscriptionInfo ->
+            if (!reserveRelaySlot(relayUrl, subscriptionInfo.id)) {
+                deferred++
+                return@forEach
+            }
             try {
                 val request = NostrRequest.Subscribe(subscriptionInfo.id, listOf(subscriptionInfo.filter))
                 val message = gson.toJson(request, NostrRequest::class.java)
                 
                 val success = webSocket.send(message)
                 if (success) {
-                    // Track subscription for this relay
-                    val currentSubs = subscriptions[relayUrl] ?: emptySet()
-                    subscriptions[relayUrl] = currentSubs + subscriptionInfo.id
-                    
                     Log.v(TAG, "✅ Restored subscription '${subscriptionInfo.id}' to relay: $relayUrl")
                 } else {
+                    releaseRelaySlot(relayUrl, subscriptionInfo.id)
                     Log.w(TAG, "❌ Failed to restore subscription '${subscriptionInfo.id}' to $relayUrl: WebSocket send failed")
                 }
             } catch (e: Exception) {
+                releaseRelaySlot(relayUrl, subscriptionInfo.id)
                 Log.e(TAG, "❌ Failed to restore subscription '${subscriptionInfo.id}' to $relayUrl: ${e.message}")
             }
         }
+        if (deferred > 0) {
+            Log.d(TAG, "⏸️ $deferred subscriptions deferred on $relayUrl (cap $MAX_SUBSCRIPTIONS_PER_RELAY)")
+        }
     }
     
     /**
@@ -853,6 +1080,12 @@ class NostrRelayManager private constructor() {
         
         override fun onOpen(webSocket: WebSocket, response: Response) {
             Log.d(TAG, "✅ Connected to Nostr relay: $relayUrl")
+            if (isSuperseded()) {
+                webSocket.close(1000, "Superseded")
+                return
+            }
+            connectionScheduler.onConnected(relayUrl)
+            kickScheduler()
             updateRelayStatus(relayUrl, true)
             
             // Restore all active subscriptions for this relay
@@ -870,6 +1103,9 @@ class NostrRelayManager private constructor() {
             }
         }
         
+        // This attempt was replaced by a newer one to the same relay, or dropped by a disconnect
+        private fun isSuperseded(): Boolean = activeListeners[relayUrl] !== this
+
         override fun onMessage(webSocket: WebSocket, text: String) {
             handleMessage(text, relayUrl)
         }
@@ -880,12 +1116,14 @@ class NostrRelayManager private constructor() {
         
         override fun onClosed(webSocket: WebSocket, code: Int, reason: String) {
             Log.d(TAG, "WebSocket closed for $relayUrl: $code $reason")
+            if (isSuperseded()) return
             val error = Exception("WebSocket closed: $code $reason")
             handleDisconnection(relayUrl, error)
         }
         
         override fun onFailure(webSocket: WebSocket, t: Throwable, response: Response?) {
             Log.e(TAG, "❌ WebSocket failure for $relayUrl: ${t.message}")
+            if (isSuperseded()) return
             handleDisconnection(relayUrl, t)
         }
     }
@@ -5,7 +5,7 @@ import java.lang.reflect.Type
 
 /**
  * Nostr protocol request messages
- * Supports EVENT, REQ, and CLOSE message types
+ * Supports EVENT, REQ, and CLOSE message types, plus NIP-77 NEG-OPEN/NEG-MSG/NEG-CLOSE
  */
 sealed class NostrRequest {
     
@@ -26,6 +26,25 @@ sealed class NostrRequest {
      * CLOSE message - close a subscription
      */
     data class Close(val subscriptionId: String) : NostrRequest()
+
+    /**
+     * NEG-OPEN message - start negentropy reconciliation for a filter (NIP-77)
+     */
+    data class NegOpen(
+        val subscriptionId: String,
+        val filter: NostrFilter,
+        val message: String // hex
+    ) : NostrRequest()
+
+    /**
+     * NEG-MSG message - next negentropy round (NIP-77)
+     */
+    data class NegMessage(val subscriptionId: String, val message: String) : NostrRequest()
+
+    /**
+     * NEG-CLOSE message - end a negentropy session (NIP-77)
+     */
+    data class NegClose(val subscriptionId: String) : NostrRequest()
     
     /**
      * Custom JSON serializer for NostrRequest
@@ -52,6 +71,24 @@ sealed class NostrRequest {
                     array.add("CLOSE")
                     array.add(src.subscriptionId)
                 }
+
+                is NegOpen -> {
+                    array.add("NEG-OPEN")
+                    array.add(src.subscriptionId)
+                    array.add(context.serialize(src.filter, NostrFilter::class.java))
+                    array.add(src.message)
+                }
+
+                is NegMessage -> {
+                    array.add("NEG-MSG")
+                    array.add(src.subscriptionId)
+                    array.add(src.message)
+                }
+
+                is NegClose -> {
+                    array.add("NEG-CLOSE")
+                    array.add(src.subscriptionId)
+                }
             }
             
             return array
@@ -81,7 +118,7 @@ sealed class NostrRequest {
 
 /**
  * Nostr protocol response messages
- * Handles EVENT, EOSE, OK, and NOTICE responses
+ * Handles EVENT, EOSE, OK, and NOTICE responses, plus NIP-77 NEG-MSG/NEG-ERR
  */
 sealed class NostrResponse {
     
@@ -115,6 +152,22 @@ sealed class NostrResponse {
     data class Notice(
         val message: String
     ) : NostrResponse()
+
+    /**
+     * NEG-MSG response - negentropy round from the relay (NIP-77)
+     */
+    data class NegMessage(
+        val subscriptionId: String,
+        val message: String // hex
+    ) : NostrResponse()
+
+    /**
+     * NEG-ERR response - relay refused or aborted a negentropy session (NIP-77)
+     */
+    data class NegError(
+        val subscriptionId: String,
+        val reason: String
+    ) : NostrResponse()
     
     /**
      * Unknown response type
@@ -172,6 +225,22 @@ sealed class NostrResponse {
                         }
                     }
                     
+                    "NEG-MSG" -> {
+                        if (jsonArray.size() >= 3) {
+                            NegMessage(jsonArray[1].asString, jsonArray[2].asString)
+                        } else {
+                            Unknown(jsonArray.toString())
+                        }
+                    }
+
+                    "NEG-ERR" -> {
+                        if (jsonArray.size() >= 2) {
+                            NegError(jsonArray[1].asString, if (jsonArray.size() >= 3) jsonArray[2].asString else "")
+                        } else {
+                            Unknown(jsonArray.toString())
+                        }
+                    }
+
                     else -> Unknown(jsonArray.toString())
                 }
             } catch (e: Exception) {
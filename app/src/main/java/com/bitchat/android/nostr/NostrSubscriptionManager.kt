@@ -2,12 +2,17 @@ package com.bitchat.android.nostr
 
 import android.app.Application
 import android.util.Log
+import com.bitchat.android.util.AppConstants
 import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.delay
 import kotlinx.coroutines.launch
 
 /**
  * NostrSubscriptionManager
  * - Encapsulates subscription lifecycle with NostrRelayManager
+ * - Geohash subscriptions are reference-counted leases per (feature, geohash): repeated
+ *   acquires share one REQ, and the last release CLOSEs it after an idle grace period
  */
 class NostrSubscriptionManager(
     private val application: Application,
@@ -17,6 +22,12 @@ class NostrSubscriptionManager(
 
     private val relayManager get() = NostrRelayManager.getInstance(application)
 
+    private class Lease(val id: String) {
+        var refs = 0
+        var teardown: Job? = null
+    }
+    private val leases = HashMap<String, Lease>() // subscription id -> lease, guarded by itself
+
     fun connect() = scope.launch { runCatching { relayManager.connect() }.onFailure { Log.e(TAG, "connect failed: ${it.message}") } }
     fun disconnect() = scope.launch { runCatching { relayManager.disconnect() }.onFailure { Log.e(TAG, "disconnect failed: ${it.message}") } }
 
@@ -35,4 +46,80 @@ class NostrSubscriptionManager(
     }
 
     fun unsubscribe(id: String) { scope.launch { runCatching { relayManager.unsubscribe(id) } } }
+
+    /**
+     * Take a lease on the `feature` subscription for a geohash, opening it if none is live.
+     * A new REQ goes out right away for events from now on (minus a small overlap), and
+     * `backfill` runs alongside it with that `since` to fill the history before it; it is
+     * only invoked when a new REQ is actually sent. `handler` is called on the relay socket
+     * thread and should only enqueue (see GeohashMessageHandler.onEvent). `priority` orders
+     * the geohash's relay connections against everything else connecting.
+     */
+    fun acquireGeohash(
+        geohash: String,
+        feature: String,
+        limit: Int,
+        handler: (NostrEvent) -> Unit,
+        priority: RelayConnectionScheduler.Priority = RelayConnectionScheduler.Priority.NORMAL,
+        backfill: suspend (liveSinceMs: Long) -> Unit
+    ): String {
+        val id = "$feature-$geohash"
+        val lease: Lease
+        val isNew: Boolean
+        synchronized(leases) {
+            val existing = leases[id]
+            lease = existing ?: Lease(id).also { leases[id] = it }
+            isNew = existing == null
+            lease.refs++
+            lease.teardown?.cancel()
+            lease.teardown = null
+        }
+        if (isNew) {
+            val liveSinceMs = System.currentTimeMillis() - AppConstants.Nostr.EVENT_STORE_SINCE_OVERLAP_SEC * 1000
+            scope.launch {
+                val filter = NostrFilter.geohashEphemeral(geohash, liveSinceMs, limit)
+                relayManager.subscribeForGeohash(
+                    geohash, filter, id, handler, includeDefaults = false, nRelays = 5, deliverOnMain = false,
+                    priority = priority
+                )
+            }
+            scope.launch {
+                runCatching { backfill(liveSinceMs) }.onFailure { Log.w(TAG, "Backfill of $id failed: ${it.message}") }
+            }
+        }
+        return id
+    }
+
+    /**
+     * Drop a lease; the subscription is CLOSEd once it has been unreferenced for the idle period
+     */
+    fun releaseGeohash(geohash: String, feature: String) {
+        val id = "$feature-$geohash"
+        synchronized(leases) {
+            val lease = leases[id] ?: return
+            if (lease.refs > 0) lease.refs--
+            if (lease.refs > 0 || lease.teardown != null) return
+            lease.teardown = scope.launch {
+                delay(AppConstants.Nostr.SUBSCRIPTION_IDLE_TEARDOWN_MS)
+                val expired = synchronized(leases) {
+                    (lease.refs == 0 && leases[id] === lease).also { if (it) leases.remove(id) }
+                }
+                if (expired) {
+                    Log.d(TAG, "Closing idle geohash subscription $id")
+                    runCatching { relayManager.unsubscribe(id) }
+                }
+            }
+        }
+    }
+
+    /**
+     * Close every geohash subscription at once, regardless of outstanding leases (panic reset)
+     */
+    fun closeAllGeohash() {
+        val ids = synchronized(leases) {
+            leases.values.forEach { it.teardown?.cancel() }
+            leases.keys.toList().also { leases.clear() }
+        }
+        ids.forEach { unsubscribe(it) }
+    }
 }
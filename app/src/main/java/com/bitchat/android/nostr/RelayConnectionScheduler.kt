@@ -0,0 +1,134 @@
+package com.bitchat.android.nostr
+
+import com.bitchat.android.util.AppConstants
+import kotlin.random.Random
+
+/**
+ * Decides which relay connections to open and when.
+ *
+ * - At most `maxConcurrent` connection attempts (TLS / Tor circuit setup) run at once, so
+ *   a reset or network change does not open every relay in the same instant.
+ * - Waiting relays go out by priority, then request order. HIGH covers DM relays and the
+ *   active geohash. LAZY relays only serve sampled geohashes: they are opened only once no
+ *   HIGH or NORMAL relay is waiting or connecting.
+ * - A failed relay is retried with decorrelated jitter,
+ *   delay = min(cap, random(base, previous * 3)), until MAX_RECONNECT_ATTEMPTS.
+ *
+ * Only relays that were requested are tracked; a close or failure of anything else (e.g.
+ * sockets torn down by a manual disconnect) is not retried. Pure and clock-injected; the
+ * caller opens sockets for [due] and reports back through [onConnected] / [onFailed].
+ */
+class RelayConnectionScheduler(
+    private val maxConcurrent: Int = AppConstants.Nostr.MAX_CONCURRENT_CONNECTS,
+    private val clock: () -> Long = System::currentTimeMillis,
+    private val random: Random = Random.Default
+) {
+
+    enum class Priority { HIGH, NORMAL, LAZY }
+
+    private enum class State { WAITING, CONNECTING, CONNECTED }
+
+    private class Entry(val url: String, var priority: Priority, val order: Long) {
+        var state = State.WAITING
+        var attempts = 0
+        var previousDelay = 0L
+        var notBefore = 0L
+    }
+
+    private val entries = LinkedHashMap<String, Entry>()
+    private var nextOrder = 0L
+
+    /**
+     * Ask for `url` to be connected. A relay already known keeps its state and is only
+     * raised to a higher priority. Returns true if the relay is newly waiting.
+     */
+    @Synchronized
+    fun request(url: String, priority: Priority): Boolean {
+        val entry = entries[url]
+        if (entry == null) {
+            entries[url] = Entry(url, priority, nextOrder++)
+            return true
+        }
+        if (priority < entry.priority) entry.priority = priority
+        return false
+    }
+
+    /**
+     * Relays to start connecting now; they count against the budget until reported back
+     */
+    @Synchronized
+    fun due(): List<String> {
+        val now = clock()
+        var free = maxConcurrent - entries.values.count { it.state == State.CONNECTING }
+        if (free <= 0) return emptyList()
+        // Eager relays backing off after a failure do not hold lazy ones back
+        val eagerBusy = entries.values.any {
+            it.priority != Priority.LAZY &&
+                (it.state == State.CONNECTING || (it.state == State.WAITING && it.notBefore <= now))
+        }
+        val started = ArrayList<String>()
+        entries.values
+            .filter { it.state == State.WAITING && it.notBefore <= now && !(it.priority == Priority.LAZY && eagerBusy) }
+            .sortedWith(compareBy<Entry>({ it.priority }, { it.order }))
+            .forEach { entry ->
+                if (free <= 0) return started
+                entry.state = State.CONNECTING
+                started.add(entry.url)
+                free--
+            }
+        return started
+    }
+
+    @Synchronized
+    fun onConnected(url: String) {
+        val entry = entries[url] ?: return
+        entry.state = State.CONNECTED
+        entry.attempts = 0
+        entry.previousDelay = 0L
+        entry.notBefore = 0L
+    }
+
+    /**
+     * A connection attempt failed or an open socket closed. Returns the delay until the
+     * retry, or null if the relay is untracked, `retry` is false, or attempts ran out.
+     */
+    @Synchronized
+    fun onFailed(url: String, retry: Boolean = true): Long? {
+        val entry = entries[url] ?: return null
+        entry.attempts++
+        if (!retry || entry.attempts >= AppConstants.Nostr.MAX_RECONNECT_ATTEMPTS) {
+            entries.remove(url)
+            return null
+        }
+        val base = AppConstants.Nostr.INITIAL_BACKOFF_INTERVAL_MS
+        val upper = maxOf(base, entry.previousDelay * 3)
+        val delay = (if (upper > base) random.nextLong(base, upper + 1) else base)
+            .coerceAtMost(AppConstants.Nostr.MAX_BACKOFF_INTERVAL_MS)
+        entry.previousDelay = delay
+        entry.notBefore = clock() + delay
+        entry.state = State.WAITING
+        return delay
+    }
+
+    @Synchronized
+    fun attempts(url: String): Int = entries[url]?.attempts ?: 0
+
+    /**
+     * Earliest time a waiting relay becomes due, if any is still backing off
+     */
+    @Synchronized
+    fun nextWakeAt(): Long? {
+        val now = clock()
+        return entries.values.filter { it.state == State.WAITING && it.notBefore > now }.minOfOrNull { it.notBefore }
+    }
+
+    @Synchronized
+    fun forget(url: String) {
+        entries.remove(url)
+    }
+
+    @Synchronized
+    fun clear() {
+        entries.clear()
+    }
+}
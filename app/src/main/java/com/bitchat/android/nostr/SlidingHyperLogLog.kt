@@ -0,0 +1,95 @@
+package com.bitchat.android.nostr
+
+import kotlin.math.ln
+import kotlin.math.roundToInt
+
+/**
+ * Approximate distinct count over a sliding time window.
+ *
+ * The window is split into `buckets` time slices, each a HyperLogLog register set of
+ * 2^precision bytes. An add touches one register of the current slice; an estimate merges
+ * the slices still inside the window. Memory is buckets * 2^precision bytes no matter how
+ * many distinct keys are added (1.25 KB at the defaults, ~6.5% standard error).
+ *
+ * The window advances in whole slices, so a key stays counted for between
+ * (buckets - 1) and buckets slice lengths after it was last seen.
+ *
+ * Not thread-safe.
+ */
+class SlidingHyperLogLog(
+    windowMs: Long,
+    private val buckets: Int = 5,
+    private val precision: Int = 8
+) {
+    private val m = 1 shl precision
+    private val sliceMs = windowMs / buckets
+    private val registers = Array(buckets) { ByteArray(m) }
+    private val sliceEpoch = LongArray(buckets) { Long.MIN_VALUE }
+
+    init {
+        require(buckets > 0 && sliceMs > 0) { "Invalid window" }
+        require(precision in 4..16) { "Precision must be 4..16" }
+    }
+
+    /**
+     * Record `key` as seen at `atMs`. Returns true if the sketch changed (the estimate may have).
+     */
+    fun add(key: String, atMs: Long, nowMs: Long = System.currentTimeMillis()): Boolean {
+        val epoch = minOf(atMs, nowMs) / sliceMs
+        if (epoch <= nowMs / sliceMs - buckets) return false // already outside the window
+        val slot = Math.floorMod(epoch, buckets.toLong()).toInt()
+        if (sliceEpoch[slot] != epoch) {
+            if (sliceEpoch[slot] > epoch) return false // slot already reused by a newer slice
+            registers[slot].fill(0)
+            sliceEpoch[slot] = epoch
+        }
+        val hash = hash64(key)
+        val index = (hash ushr (Long.SIZE_BITS - precision)).toInt()
+        val rank = (java.lang.Long.numberOfLeadingZeros(hash shl precision) + 1)
+            .coerceAtMost(Long.SIZE_BITS - precision + 1).toByte()
+        val slice = registers[slot]
+        if (rank <= slice[index]) return false
+        slice[index] = rank
+        return true
+    }
+
+    fun estimate(nowMs: Long = System.currentTimeMillis()): Int {
+        val oldest = nowMs / sliceMs - buckets + 1
+        var sum = 0.0
+        var zeros = 0
+        for (i in 0 until m) {
+            var r = 0
+            for (s in 0 until buckets) {
+                if (sliceEpoch[s] >= oldest) r = maxOf(r, registers[s][i].toInt())
+            }
+            sum += 1.0 / (1L shl r)
+            if (r == 0) zeros++
+        }
+        if (zeros == m) return 0
+        val alpha = 0.7213 / (1 + 1.079 / m)
+        val raw = alpha * m * m / sum
+        // Linear counting is far more accurate for small crowds, the common case here
+        val corrected = if (raw <= 2.5 * m && zeros > 0) m * ln(m.toDouble() / zeros) else raw
+        return corrected.roundToInt()
+    }
+
+    /**
+     * True once every slice has fallen out of the window
+     */
+    fun isExpired(nowMs: Long = System.currentTimeMillis()): Boolean {
+        val oldest = nowMs / sliceMs - buckets + 1
+        return sliceEpoch.none { it >= oldest }
+    }
+
+    private fun hash64(key: String): Long {
+        // FNV-1a followed by the SplitMix64 finalizer for good high-bit diffusion
+        var h = -0x340d631b7bdddcdbL
+        for (c in key) {
+            h = h xor c.code.toLong()
+            h *= 0x100000001b3L
+        }
+        h = (h xor (h ushr 30)) * -0x40a7b892e31b1a47L
+        h = (h xor (h ushr 27)) * -0x6b2fb644ecceee15L
+        return h xor (h ushr 31)
+    }
+}
@@ -0,0 +1,174 @@
+package com.bitchat.android.services
+
+import android.content.Context
+import android.util.Log
+import com.bitchat.android.identity.SecureIdentityStateManager
+import com.bitchat.android.util.AppConstants
+import com.bitchat.android.util.WriteBehindWriter
+import com.google.gson.Gson
+
+/**
+ * Persistent outbox of private messages that are not yet acknowledged.
+ *
+ * Each message moves QUEUED -> SENT_VIA_MESH / SENT_VIA_NOSTR -> DELIVERED / READ. An
+ * acknowledged message leaves the outbox. Queued messages are sent as soon as a transport
+ * is available. Messages that were sent but not acknowledged are resent with exponential
+ * backoff until MAX_SEND_ATTEMPTS. One record per message is kept in [Storage] (secure
+ * preferences in the app) through a [WriteBehindWriter], so queued messages survive a restart.
+ */
+class MessageOutbox(
+    private val storage: Storage,
+    private val clock: () -> Long = System::currentTimeMillis
+) {
+
+    constructor(context: Context, clock: () -> Long = System::currentTimeMillis) :
+        this(SecureStorage(SecureIdentityStateManager(context)), clock)
+
+    /**
+     * Key-value record store; `write` commits a batch (null removes) and throws on failure
+     */
+    interface Storage {
+        fun readWithPrefix(prefix: String): Map<String, String>
+        fun write(values: Map<String, String?>)
+    }
+
+    private class SecureStorage(private val stateManager: SecureIdentityStateManager) : Storage {
+        override fun readWithPrefix(prefix: String) = stateManager.getSecureValuesWithPrefix(prefix)
+        override fun write(values: Map<String, String?>) = stateManager.writeSecureValues(values)
+    }
+
+    enum class State { QUEUED, SENT_VIA_MESH, SENT_VIA_NOSTR, DELIVERED, READ }
+
+    data class Entry(
+        val messageID: String,
+        val peerID: String,
+        val content: String,
+        val recipientNickname: String,
+        val state: State = State.QUEUED,
+        val attempts: Int = 0,
+        val nextAttemptAt: Long = 0L,
+        val createdAt: Long = 0L
+    ) {
+        val isSent: Boolean get() = state == State.SENT_VIA_MESH || state == State.SENT_VIA_NOSTR
+    }
+
+    companion object {
+        private const val TAG = "MessageOutbox"
+        private const val RECORD_PREFIX = "outbox_v1_"
+    }
+
+    private val gson = Gson()
+    private val writer = WriteBehindWriter<String>("outbox") { batch -> storage.write(batch) }
+    // messageID -> entry, in enqueue order so per-recipient batches keep message order
+    private val entries = LinkedHashMap<String, Entry>()
+
+    init {
+        load()
+    }
+
+    @Synchronized
+    fun enqueue(messageID: String, peerID: String, content: String, recipientNickname: String) {
+        if (entries.containsKey(messageID)) return
+        put(Entry(messageID, peerID, content, recipientNickname, createdAt = clock()))
+    }
+
+    @Synchronized
+    fun get(messageID: String): Entry? = entries[messageID]
+
+    @Synchronized
+    fun recipients(): Set<String> = entries.values.mapTo(LinkedHashSet()) { it.peerID }
+
+    /**
+     * Messages for `peerID` that should go out now: everything still queued, plus sent
+     * messages whose backoff has elapsed
+     */
+    @Synchronized
+    fun dueFor(peerID: String): List<Entry> {
+        val now = clock()
+        return entries.values.filter { it.peerID == peerID && (!it.isSent || it.nextAttemptAt <= now) }
+    }
+
+    /**
+     * Drop the message once it has been sent MAX_SEND_ATTEMPTS times without an
+     * acknowledgement. Returns true if it was dropped and must not be sent again.
+     */
+    @Synchronized
+    fun giveUpIfExhausted(messageID: String): Boolean {
+        val entry = entries[messageID] ?: return false
+        if (entry.attempts < AppConstants.Outbox.MAX_SEND_ATTEMPTS) return false
+        Log.w(TAG, "Giving up on ${messageID.take(8)}… after ${entry.attempts} unacknowledged sends")
+        drop(messageID)
+        return true
+    }
+
+    /**
+     * Record a send attempt and schedule the next retry
+     */
+    @Synchronized
+    fun markSent(messageID: String, viaNostr: Boolean) {
+        val entry = entries[messageID] ?: return
+        val attempts = entry.attempts + 1
+        put(
+            entry.copy(
+                state = if (viaNostr) State.SENT_VIA_NOSTR else State.SENT_VIA_MESH,
+                attempts = attempts,
+                nextAttemptAt = clock() + backoff(attempts)
+            )
+        )
+    }
+
+    /**
+     * Delivery or read acknowledgement; returns the message's final state if it was outstanding
+     */
+    @Synchronized
+    fun acknowledge(messageID: String, read: Boolean): State? {
+        if (!entries.containsKey(messageID)) return null
+        drop(messageID)
+        return if (read) State.READ else State.DELIVERED
+    }
+
+    /**
+     * Earliest retry time over sent messages, if any
+     */
+    @Synchronized
+    fun nextRetryAt(): Long? = entries.values.filter { it.isSent }.minOfOrNull { it.nextAttemptAt }
+
+    @Synchronized
+    fun clear() {
+        entries.keys.toList().forEach { drop(it) }
+    }
+
+    private fun backoff(attempts: Int): Long {
+        val shift = (attempts - 1).coerceIn(0, 16)
+        return (AppConstants.Outbox.RETRY_BASE_MS shl shift).coerceAtMost(AppConstants.Outbox.RETRY_MAX_MS)
+    }
+
+    private fun put(entry: Entry) {
+        entries[entry.messageID] = entry
+        writer.put(RECORD_PREFIX + entry.messageID, gson.toJson(entry))
+    }
+
+    private fun drop(messageID: String) {
+        entries.remove(messageID)
+        writer.remove(RECORD_PREFIX + messageID)
+    }
+
+    private fun load() {
+        try {
+            val cutoff = clock() - AppConstants.Outbox.MAX_AGE_MS
+            storage.readWithPrefix(RECORD_PREFIX).values
+                .mapNotNull { json -> runCatching { gson.fromJson(json, Entry::class.java) }.getOrNull() }
+                .sortedBy { it.createdAt }
+                .forEach { entry ->
+                    if (entry.createdAt < cutoff) {
+                        writer.remove(RECORD_PREFIX + entry.messageID)
+                    } else {
+                        entries[entry.messageID] = entry
+                    }
+                }
+            if (entries.isNotEmpty()) Log.d(TAG, "Restored ${entries.size} outstanding private message(s)")
+        } catch (e: Exception) {
+            Log.e(TAG, "Failed to load outbox: ${e.message}")
+        }
+    }
+}
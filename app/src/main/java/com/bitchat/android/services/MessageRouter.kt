@@ -1,10 +1,21 @@
 package com.bitchat.android.services
 
 import android.content.Context
+import android.os.Handler
+import android.os.Looper
 import android.util.Log
 import com.bitchat.android.mesh.BluetoothMeshService
 import com.bitchat.android.model.ReadReceipt
+import com.bitchat.android.nostr.NostrRelayManager
 import com.bitchat.android.nostr.NostrTransport
+import com.bitchat.android.ui.debug.DebugSettingsManager
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+import java.util.concurrent.ConcurrentHashMap
 
 /**
  * Routes messages between BLE mesh and Nostr transports, matching iOS behavior.
@@ -12,7 +23,8 @@ import com.bitchat.android.nostr.NostrTransport
 class MessageRouter private constructor(
     private val context: Context,
     private val mesh: BluetoothMeshService,
-    private val nostr: NostrTransport
+    private val nostr: NostrTransport,
+    private val clock: () -> Long = System::currentTimeMillis
 ) {
     companion object {
         private const val TAG = "MessageRouter"
@@ -32,14 +44,21 @@ class MessageRouter private constructor(
                     try {
                         com.bitchat.android.favorites.FavoritesPersistenceService.shared.addListener(instance.favoriteListener)
                     } catch (_: Exception) {}
+                    instance.observeRelayConnectivity()
                     INSTANCE = instance
+                    // Messages restored from a previous run go out as soon as a transport allows
+                    instance.flushAllOutbox()
                 }
             }
         }
     }
 
-    // Outbox: peerID -> queued (content, nickname, messageID)
-    private val outbox = mutableMapOf<String, MutableList<Triple<String, String, String>>>()
+    // Persistent outbox of unacknowledged private messages (queued or awaiting a retry)
+    private val outbox = MessageOutbox(context, clock)
+    private val flushLock = Any()
+    private val scope = CoroutineScope(Dispatchers.Default + SupervisorJob())
+    private var retryJob: Job? = null
+    private var retryAt = Long.MAX_VALUE
 
     // Listener for favorites changes to flush outbox when npub mapping appears/changes
     private val favoriteListener = object: com.bitchat.android.favorites.FavoritesChangeListener {
@@ -70,18 +89,9 @@ class MessageRouter private constructor(
             }
         }
 
-        val hasMesh = mesh.getPeerInfo(toPeerID)?.isConnected == true
-        val hasEstablished = mesh.hasEstablishedSession(toPeerID)
-        if (hasMesh && hasEstablished) {
-            Log.d(TAG, "Routing PM via mesh to ${toPeerID} msg_id=${messageID.take(8)}…")
-            mesh.sendPrivateMessage(content, toPeerID, recipientNickname, messageID)
-        } else if (canSendViaNostr(toPeerID)) {
-            Log.d(TAG, "Routing PM via Nostr to ${toPeerID.take(32)}… msg_id=${messageID.take(8)}…")
-            nostr.sendPrivateMessage(content, toPeerID, recipientNickname, messageID)
-        } else {
+        outbox.enqueue(messageID, toPeerID, content, recipientNickname)
+        if (flush(toPeerID) == 0) {
             Log.d(TAG, "Queued PM for ${toPeerID} (no mesh, no Nostr mapping) msg_id=${messageID.take(8)}…")
-            val q = outbox.getOrPut(toPeerID) { mutableListOf() }
-            q.add(Triple(content, recipientNickname, messageID))
             Log.d(TAG, "Initiating noise handshake after queueing PM for ${toPeerID.take(8)}…")
             mesh.initiateNoiseHandshake(toPeerID)
         }
@@ -114,6 +124,8 @@ class MessageRouter private constructor(
 
     fun sendFavoriteNotification(toPeerID: String, isFavorite: Boolean) {
         if (mesh.getPeerInfo(toPeerID)?.isConnected == true) {
+            // Debounced, versioned state record; only peers without PEER_STATE get the PM
+            if (mesh.syncPeerState(toPeerID)) return
             val myNpub = try { com.bitchat.android.nostr.NostrIdentityBridge.getCurrentNostrIdentity(context)?.npub } catch (_: Exception) { null }
             val content = if (isFavorite) "[FAVORITED]:${myNpub ?: ""}" else "[UNFAVORITED]:${myNpub ?: ""}"
             val nickname = mesh.getPeerNicknames()[toPeerID] ?: toPeerID
@@ -125,39 +137,168 @@ class MessageRouter private constructor(
 
     // Flush any queued messages for a specific peerID
     fun flushOutboxFor(peerID: String) {
-        val queued = outbox[peerID] ?: return
-        if (queued.isEmpty()) return
-        Log.d(TAG, "Flushing outbox for ${peerID.take(8)}… count=${queued.size}")
-        val iterator = queued.iterator()
-        while (iterator.hasNext()) {
-            val (content, nickname, messageID) = iterator.next()
-            var hasMesh = mesh.getPeerInfo(peerID)?.isConnected == true && mesh.hasEstablishedSession(peerID)
+        flush(peerID)
+    }
+
+    // Flush everything (restart, relay reconnect, retry timer)
+    fun flushAllOutbox() {
+        outbox.recipients().forEach { flush(it) }
+    }
+
+    /**
+     * Delivery/read acknowledgement over any transport settles the outbox entry. `via` is the
+     * transport the ACK arrived on; it feeds that transport's path quality for the peer.
+     */
+    fun onAcknowledged(messageID: String, read: Boolean, via: PathQualityEstimator.Transport? = null) {
+        flights.remove(messageID)?.hedgeJob?.cancel()
+        if (via != null) quality.onAcked(messageID, via, read)
+        outbox.acknowledge(messageID, read)?.let { state ->
+            Log.d(TAG, "Outbox: ${messageID.take(8)}… $state${via?.let { " via $it" } ?: ""}")
+        }
+    }
+
+    fun clearOutbox() {
+        outbox.clear()
+        synchronized(flushLock) {
+            retryJob?.cancel()
+            retryJob = null
+            retryAt = Long.MAX_VALUE
+            flights.values.forEach { it.hedgeJob?.cancel() }
+            flights.clear()
+        }
+    }
+
+    private sealed interface Route {
+        val transport: PathQualityEstimator.Transport
+
+        data class Mesh(val peerID: String) : Route {
+            override val transport = PathQualityEstimator.Transport.MESH
+        }
+        object Nostr : Route {
+            override val transport = PathQualityEstimator.Transport.NOSTR
+        }
+    }
+
+    // Latest send of an unacknowledged message, for hedging
+    private class Flight(val peerID: String, val primary: Route) {
+        var hedgeJob: Job? = null
+    }
+
+    private val quality = PathQualityEstimator.shared
+    private val flights = ConcurrentHashMap<String, Flight>()
+
+    private fun hedgingEnabled(): Boolean =
+        try { DebugSettingsManager.getInstance().hedgedPrivateMessages.value } catch (_: Exception) { false }
+
+    /**
+     * Usable routes, preferred first: mesh when connected with an established session, else
+     * Nostr. With hedging on, Nostr goes first if its expected delivery time (RTT inflated
+     * by loss) has proven lower for this peer.
+     */
+    private fun resolveRoutes(peerID: String): List<Route> {
+        val routes = ArrayList<Route>(2)
+        if (mesh.getPeerInfo(peerID)?.isConnected == true && mesh.hasEstablishedSession(peerID)) {
+            routes.add(Route.Mesh(peerID))
+        } else if (peerID.length == 64 && peerID.matches(Regex("^[0-9a-fA-F]+$"))) {
             // If this is a noiseHex key, see if there is a connected mesh peer for this identity
-            if (!hasMesh && peerID.length == 64 && peerID.matches(Regex("^[0-9a-fA-F]+$"))) {
-                val meshPeer = resolveMeshPeerForNoiseHex(peerID)
-                if (meshPeer != null && mesh.getPeerInfo(meshPeer)?.isConnected == true && mesh.hasEstablishedSession(meshPeer)) {
-                    mesh.sendPrivateMessage(content, meshPeer, nickname, messageID)
-                    iterator.remove()
-                    continue
+            val meshPeer = resolveMeshPeerForNoiseHex(peerID)
+            if (meshPeer != null && mesh.getPeerInfo(meshPeer)?.isConnected == true && mesh.hasEstablishedSession(meshPeer)) {
+                routes.add(Route.Mesh(meshPeer))
+            }
+        }
+        if (canSendViaNostr(peerID)) routes.add(Route.Nostr)
+        if (routes.size == 2 && hedgingEnabled()) {
+            val meshMs = quality.expectedDeliveryMs(peerID, PathQualityEstimator.Transport.MESH)
+            val nostrMs = quality.expectedDeliveryMs(peerID, PathQualityEstimator.Transport.NOSTR)
+            if (meshMs != null && nostrMs != null && nostrMs < meshMs) routes.reverse()
+        }
+        return routes
+    }
+
+    private fun send(route: Route, peerID: String, entry: MessageOutbox.Entry) {
+        when (route) {
+            is Route.Mesh -> mesh.sendPrivateMessage(entry.content, route.peerID, entry.recipientNickname, entry.messageID)
+            Route.Nostr -> nostr.sendPrivateMessage(entry.content, peerID, entry.recipientNickname, entry.messageID)
+        }
+    }
+
+    /**
+     * Send everything due for one recipient over a single resolved route; returns the count sent
+     */
+    private fun flush(peerID: String): Int = synchronized(flushLock) {
+        // Exhausted messages fail here instead of going out one more time
+        val batch = outbox.dueFor(peerID).filterNot { entry ->
+            outbox.giveUpIfExhausted(entry.messageID).also { gaveUp ->
+                if (gaveUp) {
+                    flights.remove(entry.messageID)?.hedgeJob?.cancel()
+                    mesh.delegate?.didFailToDeliver(entry.messageID, peerID, "No acknowledgement")
                 }
             }
-            val canNostr = canSendViaNostr(peerID)
-            if (hasMesh) {
-                mesh.sendPrivateMessage(content, peerID, nickname, messageID)
-                iterator.remove()
-            } else if (canNostr) {
-                nostr.sendPrivateMessage(content, peerID, nickname, messageID)
-                iterator.remove()
+        }
+        if (batch.isEmpty()) return 0
+        val routes = resolveRoutes(peerID)
+        val route = routes.firstOrNull() ?: return 0
+        val hedge = routes.size > 1 && hedgingEnabled()
+        Log.d(TAG, "Flushing outbox for ${peerID.take(8)}… count=${batch.size} via ${route.transport}${if (hedge) " (hedged)" else ""}")
+        flights.keys.removeAll { outbox.get(it) == null }
+        batch.forEach { entry ->
+            send(route, peerID, entry)
+            outbox.markSent(entry.messageID, viaNostr = route == Route.Nostr)
+            quality.onSent(peerID, route.transport, entry.messageID)
+            val flight = Flight(peerID, route)
+            flights.put(entry.messageID, flight)?.hedgeJob?.cancel()
+            if (hedge) {
+                val budget = quality.budgetMs(peerID, route.transport)
+                flight.hedgeJob = scope.launch {
+                    delay(budget)
+                    hedge(entry.messageID, flight)
+                }
             }
         }
-        if (queued.isEmpty()) {
-            outbox.remove(peerID)
+        scheduleRetry()
+        batch.size
+    }
+
+    /**
+     * No delivery ACK within the primary transport's budget: also send over the alternate one
+     */
+    private fun hedge(messageID: String, flight: Flight) {
+        synchronized(flushLock) {
+            if (flights[messageID] !== flight) return
+            val entry = outbox.get(messageID) ?: return
+            val alternate = resolveRoutes(flight.peerID).firstOrNull { it.transport != flight.primary.transport } ?: return
+            Log.d(TAG, "Hedging ${messageID.take(8)}… via ${alternate.transport} after no ACK on ${flight.primary.transport}")
+            send(alternate, flight.peerID, entry)
+            quality.onSent(flight.peerID, alternate.transport, messageID)
         }
     }
 
-    // Flush everything (rarely used)
-    fun flushAllOutbox() {
-        outbox.keys.toList().forEach { flushOutboxFor(it) }
+    // Caller holds flushLock
+    private fun scheduleRetry() {
+        val next = outbox.nextRetryAt() ?: return
+        if (retryJob?.isActive == true && retryAt <= next) return
+        retryJob?.cancel()
+        retryAt = next
+        retryJob = scope.launch {
+            delay((next - clock()).coerceAtLeast(0))
+            synchronized(flushLock) {
+                retryJob = null
+                retryAt = Long.MAX_VALUE
+            }
+            flushAllOutbox()
+        }
+    }
+
+    private fun observeRelayConnectivity() {
+        Handler(Looper.getMainLooper()).post {
+            try {
+                NostrRelayManager.getInstance(context).isConnected.observeForever { connected ->
+                    if (connected == true) scope.launch { flushAllOutbox() }
+                }
+            } catch (e: Exception) {
+                Log.w(TAG, "Relay connectivity not observed: ${e.message}")
+            }
+        }
     }
 
     private fun canSendViaNostr(peerID: String): Boolean {
@@ -0,0 +1,229 @@
+package com.bitchat.android.services
+
+import com.bitchat.android.util.AppConstants
+
+/**
+ * Per-peer, per-transport path quality: smoothed RTT, loss rate and mesh hop count.
+ *
+ * Fed by the send -> delivery ACK timings of private messages ([onSent] / [onAcked]), ping
+ * round trips ([onRttSample]) and the TTL left on received announces ([onHopCount]).
+ *
+ * - RTT is smoothed as in TCP (RFC 6298): srtt += (sample - srtt) / 8, and
+ *   rttvar += (|sample - srtt| - rttvar) / 4.
+ * - Loss is an exponentially weighted rate over sends. A send counts as lost if its ACK
+ *   has not arrived within LOSS_TIMEOUT_MS.
+ * - Hop count is the latest announce observation, forgotten after HOPS_MAX_AGE_MS.
+ *
+ * Pure and clock-injected. MessageRouter uses it to pick and hedge transports, the packet
+ * relay to drop directed packets that cannot reach their recipient, and the debug sheet to
+ * show per-peer estimates. Thread-safe.
+ */
+class PathQualityEstimator(
+    private val clock: () -> Long = System::currentTimeMillis,
+    private val capacity: Int = AppConstants.PathQuality.TRACKED_PEERS
+) {
+
+    enum class Transport { MESH, NOSTR }
+
+    data class Estimate(
+        val srttMs: Long?,
+        val rttVarMs: Long?,
+        val lossRate: Double,
+        val hops: Int?,
+        val samples: Int,
+        val lastUpdatedMs: Long
+    )
+
+    companion object {
+        val shared: PathQualityEstimator by lazy { PathQualityEstimator() }
+
+        private const val RTT_GAIN = 1.0 / 8
+        private const val RTTVAR_GAIN = 1.0 / 4
+        private const val LOSS_GAIN = 1.0 / 8
+    }
+
+    private class PathState {
+        var srtt = -1.0
+        var rttvar = 0.0
+        var loss = 0.0
+        var samples = 0
+        var lastUpdated = 0L
+
+        fun addRtt(sample: Long) {
+            if (srtt < 0) {
+                srtt = sample.toDouble()
+                rttvar = sample / 2.0
+            } else {
+                rttvar += (Math.abs(sample - srtt) - rttvar) * RTTVAR_GAIN
+                srtt += (sample - srtt) * RTT_GAIN
+            }
+            samples++
+        }
+
+        fun addOutcome(lost: Boolean) {
+            loss += ((if (lost) 1.0 else 0.0) - loss) * LOSS_GAIN
+        }
+    }
+
+    private class PeerState {
+        val paths = HashMap<Transport, PathState>()
+        var hops: Int? = null
+        var hopsAt = 0L
+        fun path(transport: Transport) = paths.getOrPut(transport) { PathState() }
+    }
+
+    private class Outstanding(val peerID: String, val transport: Transport, val sentAt: Long)
+
+    private val peers = object : LinkedHashMap<String, PeerState>(16, 0.75f, true) {
+        override fun removeEldestEntry(eldest: MutableMap.MutableEntry<String, PeerState>?): Boolean {
+            return size > capacity
+        }
+    }
+    // Keyed by (message ID, transport); a hedged message is outstanding on both transports
+    private val outstanding = LinkedHashMap<String, Outstanding>()
+
+    /**
+     * A message left on `transport`; loss is judged by whether its ACK arrives in time
+     */
+    @Synchronized
+    fun onSent(peerID: String, transport: Transport, messageID: String) {
+        expireOutstanding()
+        val key = outstandingKey(messageID, transport)
+        outstanding.remove(key)?.let { resolveLost(it) }
+        outstanding[key] = Outstanding(peerID, transport, clock())
+        while (outstanding.size > AppConstants.PathQuality.MAX_OUTSTANDING) {
+            resolveLost(outstanding.remove(outstanding.keys.first())!!)
+        }
+    }
+
+    /**
+     * ACK for `messageID` arrived over `transport`. Returns the RTT sample, or null if that
+     * transport was not tracking the message. A read receipt settles the send without an RTT
+     * sample, since it includes however long the recipient took to open the chat.
+     */
+    @Synchronized
+    fun onAcked(messageID: String, transport: Transport, read: Boolean = false): Long? {
+        expireOutstanding()
+        val sent = outstanding.remove(outstandingKey(messageID, transport)) ?: return null
+        // The message got through; a copy still outstanding on the other transport is not a loss
+        Transport.values().filter { it != transport }.forEach { outstanding.remove(outstandingKey(messageID, it)) }
+        val rtt = (clock() - sent.sentAt).coerceAtLeast(0)
+        peer(sent.peerID).path(transport).apply {
+            if (!read) addRtt(rtt)
+            addOutcome(lost = false)
+            lastUpdated = clock()
+        }
+        return if (read) null else rtt
+    }
+
+    /**
+     * Round trip measured outside the message flow, e.g. a ping
+     */
+    @Synchronized
+    fun onRttSample(peerID: String, transport: Transport, rttMs: Long) {
+        if (rttMs < 0) return
+        peer(peerID).path(transport).apply {
+            addRtt(rttMs)
+            lastUpdated = clock()
+        }
+    }
+
+    /**
+     * Mesh hops to `peerID`, e.g. from the TTL an announce arrived with
+     */
+    @Synchronized
+    fun onHopCount(peerID: String, hops: Int) {
+        if (hops < 1) return
+        val state = peer(peerID)
+        state.hops = hops
+        state.hopsAt = clock()
+        state.path(Transport.MESH).lastUpdated = state.hopsAt
+    }
+
+    @Synchronized
+    fun estimate(peerID: String, transport: Transport): Estimate? {
+        expireOutstanding()
+        val state = peers[peerID] ?: return null
+        val path = state.paths[transport]
+        val hops = freshHops(state)
+        if (path == null && (transport != Transport.MESH || hops == null)) return null
+        return Estimate(
+            srttMs = path?.takeIf { it.samples > 0 }?.srtt?.toLong(),
+            rttVarMs = path?.takeIf { it.samples > 0 }?.rttvar?.toLong(),
+            lossRate = path?.loss ?: 0.0,
+            hops = if (transport == Transport.MESH) hops else null,
+            samples = path?.samples ?: 0,
+            lastUpdatedMs = path?.lastUpdated ?: 0L
+        )
+    }
+
+    /**
+     * Last announced hop count, or null if none was heard within HOPS_MAX_AGE_MS
+     */
+    @Synchronized
+    fun hops(peerID: String): Int? = peers[peerID]?.let { freshHops(it) }
+
+    /**
+     * How long to wait for a delivery ACK on `transport` before trying the other one:
+     * srtt + 4 * rttvar within bounds, or a per-transport default before any sample
+     */
+    @Synchronized
+    fun budgetMs(peerID: String, transport: Transport): Long {
+        val path = peers[peerID]?.paths?.get(transport)?.takeIf { it.samples > 0 }
+            ?: return when (transport) {
+                Transport.MESH -> AppConstants.PathQuality.DEFAULT_BUDGET_MESH_MS
+                Transport.NOSTR -> AppConstants.PathQuality.DEFAULT_BUDGET_NOSTR_MS
+            }
+        return (path.srtt + 4 * path.rttvar).toLong()
+            .coerceIn(AppConstants.PathQuality.MIN_BUDGET_MS, AppConstants.PathQuality.MAX_BUDGET_MS)
+    }
+
+    /**
+     * Expected time to a delivery ACK, inflated by loss (each loss costs roughly a budget);
+     * null when there are no samples. Lower is better.
+     */
+    @Synchronized
+    fun expectedDeliveryMs(peerID: String, transport: Transport): Long? {
+        expireOutstanding()
+        val path = peers[peerID]?.paths?.get(transport)?.takeIf { it.samples > 0 } ?: return null
+        val loss = path.loss.coerceAtMost(0.9)
+        return (path.srtt + loss / (1 - loss) * budgetMs(peerID, transport)).toLong()
+    }
+
+    @Synchronized
+    fun snapshot(): Map<String, Map<Transport, Estimate>> {
+        return peers.keys.toList().associateWith { peerID ->
+            Transport.values().mapNotNull { t -> estimate(peerID, t)?.let { t to it } }.toMap()
+        }.filterValues { it.isNotEmpty() }
+    }
+
+    @Synchronized
+    fun clear() {
+        peers.clear()
+        outstanding.clear()
+    }
+
+    // The peer may have moved or left since; a stale count would misroute relays
+    private fun freshHops(state: PeerState): Int? =
+        state.hops?.takeIf { clock() - state.hopsAt <= AppConstants.PathQuality.HOPS_MAX_AGE_MS }
+
+    private fun peer(peerID: String): PeerState = peers.getOrPut(peerID) { PeerState() }
+
+    private fun outstandingKey(messageID: String, transport: Transport) = "${transport.name}:$messageID"
+
+    private fun resolveLost(sent: Outstanding) {
+        peer(sent.peerID).path(sent.transport).addOutcome(lost = true)
+    }
+
+    private fun expireOutstanding() {
+        val cutoff = clock() - AppConstants.PathQuality.LOSS_TIMEOUT_MS
+        val it = outstanding.values.iterator()
+        while (it.hasNext()) {
+            val sent = it.next()
+            // Insertion order is send order, so stop at the first one still in time
+            if (sent.sentAt > cutoff) break
+            it.remove()
+            resolveLost(sent)
+        }
+    }
+}
@@ -0,0 +1,154 @@
+package com.bitchat.android.services
+
+import android.content.Context
+import android.os.Process
+import android.os.SystemClock
+import android.util.Log
+import com.bitchat.android.identity.SecureIdentityStateManager
+import com.bitchat.android.noise.NoiseEncryptionService
+import com.bitchat.android.nostr.NostrIdentityBridge
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Deferred
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.async
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.runBlocking
+import java.util.concurrent.ConcurrentHashMap
+
+/**
+ * Staged app startup.
+ *
+ * Critical-path stages (Tor, relay directory, favorites, preferences) run synchronously
+ * from BitchatApplication via [stage]. Key material lives behind EncryptedSharedPreferences,
+ * whose keystore round-trips are slow, so it is loaded concurrently in the background by
+ * [begin] and exposed as awaitable handles. MainActivity suspends on [identityKeys] and only
+ * then builds the mesh service, so the Noise service finds its keys ready instead of
+ * loading them on the main thread.
+ *
+ * Every stage and milestone (first frame, first announce) is timed from process start
+ * and reported in the mesh debug status.
+ */
+object StartupCoordinator {
+    private const val TAG = "StartupCoordinator"
+
+    private val scope = CoroutineScope(Dispatchers.Default + SupervisorJob())
+    private val startedAt = Process.getStartElapsedRealtime()
+
+    // name -> (start offset ms, duration ms, thread)
+    private data class StageTiming(val startMs: Long, val durationMs: Long, val thread: String)
+    private val stages = ConcurrentHashMap<String, StageTiming>()
+    private val milestones = ConcurrentHashMap<String, Long>()
+
+    private val lock = Any()
+    @Volatile private var identityKeys: Deferred<NoiseEncryptionService.IdentityKeys>? = null
+    private var nostrWarmupStarted = false
+
+    /**
+     * Kick off background stages. Safe to call more than once.
+     */
+    fun begin(context: Context) {
+        val appContext = context.applicationContext
+        identityKeysAsync(appContext)
+        synchronized(lock) {
+            if (nostrWarmupStarted) return
+            nostrWarmupStarted = true
+        }
+        scope.launch {
+            // Fills the bridge's identity and device seed caches so the first UI access is a hit
+            try {
+                stage("nostr.identity") { NostrIdentityBridge.getCurrentNostrIdentity(appContext) }
+            } catch (e: Exception) {
+                Log.w(TAG, "Nostr identity warm-up failed: ${e.message}")
+            }
+        }
+    }
+
+    /**
+     * Handle for the persistent Noise static and Ed25519 signing keys
+     */
+    fun identityKeysAsync(context: Context): Deferred<NoiseEncryptionService.IdentityKeys> {
+        identityKeys?.let { return it }
+        val appContext = context.applicationContext
+        return synchronized(lock) {
+            identityKeys ?: scope.async {
+                stage("identity.storage") { SecureIdentityStateManager.warmUp(appContext) }
+                stage("noise.keys") {
+                    NoiseEncryptionService.loadOrCreateIdentityKeys(SecureIdentityStateManager(appContext))
+                }
+            }.also { identityKeys = it }
+        }
+    }
+
+    /**
+     * Suspend until the identity keys are available; returns at once if warm-up already finished
+     */
+    suspend fun identityKeys(context: Context): NoiseEncryptionService.IdentityKeys {
+        val handle = identityKeysAsync(context)
+        val waitStart = SystemClock.elapsedRealtime()
+        val wasReady = handle.isCompleted
+        try {
+            return handle.await()
+        } catch (e: Exception) {
+            // Don't cache a failed load; the next caller retries
+            synchronized(lock) { if (identityKeys === handle) identityKeys = null }
+            throw e
+        } finally {
+            if (!wasReady) recordStage("noise.keys.wait", waitStart, SystemClock.elapsedRealtime() - waitStart)
+        }
+    }
+
+    /**
+     * Blocking variant for NoiseEncryptionService's constructor. MainActivity only builds the
+     * mesh service after [identityKeys] returned, so on the startup path this never waits.
+     */
+    fun awaitIdentityKeys(context: Context): NoiseEncryptionService.IdentityKeys {
+        return runBlocking { identityKeys(context) }
+    }
+
+    /**
+     * Drop cached handles after the persistent identity was wiped (panic mode)
+     */
+    fun invalidateIdentity() {
+        synchronized(lock) {
+            identityKeys = null
+            nostrWarmupStarted = false
+        }
+    }
+
+    /**
+     * Run a startup stage on the caller's thread and record its timing
+     */
+    fun <T> stage(name: String, block: () -> T): T {
+        val start = SystemClock.elapsedRealtime()
+        try {
+            return block()
+        } finally {
+            recordStage(name, start, SystemClock.elapsedRealtime() - start)
+        }
+    }
+
+    /**
+     * Record a milestone once (later calls are ignored)
+     */
+    fun mark(milestone: String) {
+        if (milestones.putIfAbsent(milestone, SystemClock.elapsedRealtime() - startedAt) == null) {
+            Log.i(TAG, "Startup milestone $milestone at +${milestones[milestone]}ms")
+        }
+    }
+
+    fun getDebugInfo(): String = buildString {
+        appendLine("=== Startup Timing ===")
+        stages.entries.sortedBy { it.value.startMs }.forEach { (name, t) ->
+            appendLine("  $name: +${t.startMs}ms, took ${t.durationMs}ms [${t.thread}]")
+        }
+        milestones.entries.sortedBy { it.value }.forEach { (name, at) ->
+            appendLine("  $name at +${at}ms")
+        }
+    }
+
+    private fun recordStage(name: String, start: Long, durationMs: Long) {
+        stages[name] = StageTiming(start - startedAt, durationMs, Thread.currentThread().name)
+        Log.d(TAG, "Startup stage $name took ${durationMs}ms")
+    }
+}
@@ -26,6 +26,7 @@ import androidx.compose.ui.text.font.FontWeight
 import androidx.compose.ui.text.style.BaselineShift
 import androidx.compose.ui.unit.dp
 import androidx.compose.ui.unit.sp
+import com.bitchat.android.nostr.BridgePreferenceManager
 import com.bitchat.android.nostr.NostrProofOfWork
 import com.bitchat.android.nostr.PoWPreferenceManager
 import com.bitchat.android.ui.debug.DebugSettingsSheet
@@ -380,6 +381,50 @@ fun AboutSheet(
                         }
                     }
 
+                    // Bridge node section
+                    item(key = "bridge_section") {
+                        Text(
+                            text = stringResource(R.string.about_bridge),
+                            style = MaterialTheme.typography.labelLarge,
+                            color = MaterialTheme.colorScheme.onBackground.copy(alpha = 0.7f),
+                            modifier = Modifier
+                                .padding(horizontal = 24.dp)
+                                .padding(top = 24.dp, bottom = 8.dp)
+                        )
+                        LaunchedEffect(Unit) {
+                            BridgePreferenceManager.init(context)
+                        }
+
+                        val bridgeEnabled by BridgePreferenceManager.bridgeEnabled.collectAsState()
+
+                        Column(
+                            modifier = Modifier.padding(horizontal = 24.dp),
+                            verticalArrangement = Arrangement.spacedBy(8.dp)
+                        ) {
+                            Row(
+                                horizontalArrangement = Arrangement.spacedBy(8.dp),
+                                verticalAlignment = Alignment.CenterVertically
+                            ) {
+                                FilterChip(
+                                    selected = !bridgeEnabled,
+                                    onClick = { BridgePreferenceManager.setBridgeEnabled(false) },
+                                    label = { Text(stringResource(R.string.about_bridge_off), fontFamily = FontFamily.Monospace) }
+                                )
+                                FilterChip(
+                                    selected = bridgeEnabled,
+                                    onClick = { BridgePreferenceManager.setBridgeEnabled(true) },
+                                    label = { Text(stringResource(R.string.about_bridge_on), fontFamily = FontFamily.Monospace) }
+                                )
+                            }
+                            Text(
+                                text = stringResource(R.string.about_bridge_tip),
+                                fontSize = 10.sp,
+                                fontFamily = FontFamily.Monospace,
+                                color = colorScheme.onSurface.copy(alpha = 0.6f)
+                            )
+                        }
+                    }
+
                     // Network (Tor) section
                     item(key = "network_section") {
                         val torMode = remember { mutableStateOf(com.bitchat.android.net.TorPreferenceManager.get(context)) }
@@ -459,6 +504,15 @@ fun AboutSheet(
                                                 color = colorScheme.onSurface.copy(alpha = 0.6f)
                                             )
                                         }
+                                        val circuits by com.bitchat.android.net.TorManager.circuitStats.circuits.collectAsState()
+                                        circuits.values.sortedBy { it.key }.forEach { circuit ->
+                                            Text(
+                                                text = stringResource(R.string.about_tor_circuit, circuit.key, circuit.smoothedConnectMs, circuit.connects, circuit.failures),
+                                                style = MaterialTheme.typography.labelSmall,
+                                                fontFamily = FontFamily.Monospace,
+                                                color = colorScheme.onSurface.copy(alpha = 0.6f)
+                                            )
+                                        }
                                     }
                                 }
                             }
@@ -87,8 +87,12 @@ class ChatViewModel(
         coroutineScope = viewModelScope,
         onHapticFeedback = { ChatViewModelUtils.triggerHapticFeedback(application.applicationContext) },
         getMyPeerID = { meshService.myPeerID },
-        getMeshService = { meshService }
+        getMeshService = { meshService },
+        onPublicMessage = { message -> meshBridgeManager.onMeshMessage(message) }
     )
+
+    // Opt-in bridge between the mesh timeline and the local geohash channel
+    private val meshBridgeManager = com.bitchat.android.nostr.MeshBridgeManager(application, viewModelScope) { meshService }
     
     // New Geohash architecture ViewModel (replaces God object service usage in UI path)
     val geohashViewModel = GeohashViewModel(
@@ -207,6 +211,7 @@ class ChatViewModel(
         
         // Initialize new geohash architecture
         geohashViewModel.initialize()
+        meshBridgeManager.initialize()
 
         // Initialize favorites persistence service
         com.bitchat.android.favorites.FavoritesPersistenceService.initialize(getApplication())
@@ -218,6 +223,13 @@ class ChatViewModel(
             nostrTransport.senderPeerID = meshService.myPeerID
         } catch (_: Exception) { }
 
+        // Create the router now so private messages persisted in its outbox are retried
+        try {
+            com.bitchat.android.services.MessageRouter.getInstance(getApplication(), meshService)
+        } catch (e: Exception) {
+            Log.w(TAG, "Failed to start message router: ${e.message}")
+        }
+
         // Note: Mesh service is now started by MainActivity
 
         // BLE receives are inserted by MessageHandler path; no VoiceNoteBus for Tor in this branch.
@@ -225,6 +237,7 @@ class ChatViewModel(
     
     override fun onCleared() {
         super.onCleared()
+        meshBridgeManager.shutdown()
         // Note: Mesh service lifecycle is now managed by MainActivity
     }
     
@@ -234,6 +247,7 @@ class ChatViewModel(
         state.setNickname(newNickname)
         dataManager.saveNickname(newNickname)
         meshService.sendBroadcastAnnounce()
+        meshService.syncPeerStateWithAll()
     }
     
     /**
@@ -544,13 +558,16 @@ class ChatViewModel(
                     val announcementContent = if (isNowFavorite) "[FAVORITED]:${myNostr?.npub ?: ""}" else "[UNFAVORITED]:${myNostr?.npub ?: ""}"
                     // Prefer mesh if session established, else try Nostr
                     if (meshService.hasEstablishedSession(peerID)) {
-                        // Reuse existing private message path for notifications
-                        meshService.sendPrivateMessage(
-                            announcementContent,
-                            peerID,
-                            nickname,
-                            java.util.UUID.randomUUID().toString()
-                        )
+                        // Peers supporting PEER_STATE get a debounced state record instead
+                        if (!meshService.syncPeerState(peerID)) {
+                            // Reuse existing private message path for notifications
+                            meshService.sendPrivateMessage(
+                                announcementContent,
+                                peerID,
+                                nickname,
+                                java.util.UUID.randomUUID().toString()
+                            )
+                        }
                     } else {
                         val nostrTransport = com.bitchat.android.nostr.NostrTransport.getInstance(getApplication())
                         nostrTransport.senderPeerID = meshService.myPeerID
@@ -709,6 +726,14 @@ class ChatViewModel(
         meshDelegateHandler.didReceiveReadReceipt(messageID, recipientPeerID)
     }
     
+    override fun didReceiveReadUpTo(messageID: String, recipientPeerID: String) {
+        meshDelegateHandler.didReceiveReadUpTo(messageID, recipientPeerID)
+    }
+    
+    override fun didFailToDeliver(messageID: String, recipientPeerID: String, reason: String) {
+        meshDelegateHandler.didFailToDeliver(messageID, recipientPeerID, reason)
+    }
+    
     override fun decryptChannelMessage(encryptedContent: ByteArray, channel: String): String? {
         return meshDelegateHandler.decryptChannelMessage(encryptedContent, channel)
     }
@@ -734,6 +759,10 @@ class ChatViewModel(
         privateChatManager.clearAllPrivateChats()
         dataManager.clearAllData()
         
+        // Drop private messages still waiting in the outbox
+        com.bitchat.android.services.MessageRouter.tryGetInstance()?.clearOutbox()
+        com.bitchat.android.services.PathQualityEstimator.shared.clear()
+
         // Clear all mesh service data
         clearAllMeshServiceData()
         
@@ -821,6 +850,20 @@ class ChatViewModel(
         return geohashViewModel.geohashParticipantCount(geohash)
     }
 
+    /**
+     * Local activity inside a geohash cell or any finer cell, since `sinceMs`
+     */
+    fun geohashActivityWithin(geohash: String, sinceMs: Long): com.bitchat.android.geohash.GeohashActivityIndex.Summary {
+        return geohashViewModel.activityWithin(geohash, sinceMs)
+    }
+
+    /**
+     * Local activity inside a geohash cell or its 8 neighbours, since `sinceMs`
+     */
+    fun geohashNeighborhoodActivity(geohash: String, sinceMs: Long): com.bitchat.android.geohash.GeohashActivityIndex.Summary {
+        return geohashViewModel.neighborhoodActivity(geohash, sinceMs)
+    }
+
     /**
      * Begin sampling multiple geohashes for participant activity
      */
@@ -832,7 +875,7 @@ class ChatViewModel(
      * End geohash sampling
      */
     fun endGeohashSampling() {
-        // No-op in refactored architecture; sampling subscriptions are short-lived
+        geohashViewModel.endGeohashSampling()
     }
 
     /**
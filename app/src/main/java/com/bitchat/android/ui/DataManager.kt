@@ -3,6 +3,7 @@ package com.bitchat.android.ui
 import android.content.Context
 import android.content.SharedPreferences
 import android.util.Log
+import com.bitchat.android.util.WriteBehindWriter
 import com.google.gson.Gson
 import kotlin.random.Random
 
@@ -18,6 +19,15 @@ class DataManager(private val context: Context) {
     private val prefs: SharedPreferences = context.getSharedPreferences("bitchat_prefs", Context.MODE_PRIVATE)
     private val gson = Gson()
     
+    // Favorite/block sets are snapshotted and committed together off the main thread
+    private val setWriter = WriteBehindWriter<Set<String>>("bitchat_prefs") { batch ->
+        val editor = prefs.edit()
+        batch.forEach { (key, value) ->
+            if (value != null) editor.putStringSet(key, value) else editor.remove(key)
+        }
+        if (!editor.commit()) throw IllegalStateException("bitchat_prefs commit failed")
+    }
+    
     // Channel-related maps that need to persist state
     private val _channelCreators = mutableMapOf<String, String>()
     private val _favoritePeers = mutableSetOf<String>()
@@ -162,7 +172,7 @@ class DataManager(private val context: Context) {
     }
     
     fun saveFavorites() {
-        prefs.edit().putStringSet("favorites", _favoritePeers).apply()
+        setWriter.put("favorites", _favoritePeers.toSet())
         Log.d(TAG, "Saved ${_favoritePeers.size} favorite users to storage: $_favoritePeers")
     }
     
@@ -203,7 +213,7 @@ class DataManager(private val context: Context) {
     }
     
     fun saveBlockedUsers() {
-        prefs.edit().putStringSet("blocked_users", _blockedUsers).apply()
+        setWriter.put("blocked_users", _blockedUsers.toSet())
     }
     
     fun addBlockedUser(fingerprint: String) {
@@ -231,7 +241,7 @@ class DataManager(private val context: Context) {
     }
     
     fun saveGeohashBlockedUsers() {
-        prefs.edit().putStringSet("geohash_blocked_users", _geohashBlockedUsers).apply()
+        setWriter.put("geohash_blocked_users", _geohashBlockedUsers.toSet())
     }
     
     fun addGeohashBlockedUser(pubkeyHex: String) {
@@ -256,6 +266,7 @@ class DataManager(private val context: Context) {
         _blockedUsers.clear()
         _geohashBlockedUsers.clear()
         _channelMembers.clear()
+        setWriter.discardPending()
         prefs.edit().clear().apply()
     }
 }
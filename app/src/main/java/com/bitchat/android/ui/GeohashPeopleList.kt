@@ -22,6 +22,8 @@ import java.util.*
 import androidx.compose.ui.text.style.TextOverflow
 import androidx.compose.ui.res.stringResource
 import com.bitchat.android.R
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.withContext
 
 /**
  * GeohashPeopleList - iOS-compatible component for displaying geohash participants
@@ -89,22 +91,27 @@ fun GeohashPeopleList(
                 modifier = Modifier.padding(horizontal = 24.dp, vertical = 12.dp)
             )
         } else {
-            // Get current geohash identity for "me" detection
-            val myHex = remember(selectedLocationChannel) {
-                when (val channel = selectedLocationChannel) {
-                    is com.bitchat.android.geohash.ChannelID.Location -> {
+            // Get current geohash identity for "me" detection; cached after the channel switch,
+            // otherwise derived off the main thread
+            val myHex by produceState<String?>(
+                initialValue = (selectedLocationChannel as? com.bitchat.android.geohash.ChannelID.Location)?.let {
+                    com.bitchat.android.nostr.NostrIdentityBridge.cachedIdentity(it.channel.geohash)?.publicKeyHex?.lowercase()
+                },
+                selectedLocationChannel
+            ) {
+                val channel = selectedLocationChannel as? com.bitchat.android.geohash.ChannelID.Location
+                value = channel?.let {
+                    withContext(Dispatchers.Default) {
                         try {
-                            val identity = com.bitchat.android.nostr.NostrIdentityBridge.deriveIdentity(
-                                forGeohash = channel.channel.geohash,
+                            com.bitchat.android.nostr.NostrIdentityBridge.deriveIdentity(
+                                forGeohash = it.channel.geohash,
                                 context = viewModel.getApplication()
-                            )
-                            identity.publicKeyHex.lowercase()
+                            ).publicKeyHex.lowercase()
                         } catch (e: Exception) {
                             Log.e("GeohashPeopleList", "Failed to derive identity: ${e.message}")
                             null
                         }
                     }
-                    else -> null
                 }
             }
             
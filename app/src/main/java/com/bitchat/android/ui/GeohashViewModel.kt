@@ -13,9 +13,12 @@ import com.bitchat.android.nostr.NostrProtocol
 import com.bitchat.android.nostr.NostrRelayManager
 import com.bitchat.android.nostr.NostrSubscriptionManager
 import com.bitchat.android.nostr.PoWPreferenceManager
+import com.bitchat.android.nostr.RelayConnectionScheduler
+import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.Job
 import kotlinx.coroutines.delay
 import kotlinx.coroutines.launch
+import kotlinx.coroutines.withContext
 import java.util.Date
 
 class GeohashViewModel(
@@ -50,9 +53,11 @@ class GeohashViewModel(
         dataManager = dataManager
     )
 
-    private var currentGeohashSubId: String? = null
+    private var currentGeohash: String? = null
+    private var sampledGeohashes: Set<String> = emptySet()
     private var currentDmSubId: String? = null
     private var geoTimer: Job? = null
+    private var countsTimer: Job? = null
     private var locationChannelManager: com.bitchat.android.geohash.LocationChannelManager? = null
 
     val geohashPeople: LiveData<List<GeoPerson>> = state.geohashPeople
@@ -89,12 +94,20 @@ class GeohashViewModel(
 
     fun panicReset() {
         repo.clearAll()
+        subscriptionManager.closeAllGeohash()
         subscriptionManager.disconnect()
-        currentGeohashSubId = null
+        currentGeohash = null
+        sampledGeohashes = emptySet()
         currentDmSubId = null
         geoTimer?.cancel()
         geoTimer = null
+        countsTimer?.cancel()
+        countsTimer = null
         try { NostrIdentityBridge.clearAllAssociations(getApplication()) } catch (_: Exception) {}
+        com.bitchat.android.geohash.GeohashActivityIndex.shared.clear()
+        viewModelScope.launch(Dispatchers.IO) {
+            try { com.bitchat.android.nostr.NostrEventStore.getInstance(getApplication()).clearAll() } catch (_: Exception) {}
+        }
         initialize()
     }
 
@@ -136,26 +149,52 @@ class GeohashViewModel(
         }
     }
 
+    /**
+     * Sample exactly `geohashes`: leases geohashes newly in the list and releases ones that
+     * dropped out, so repeated calls while the sheet's inputs change don't stack REQs.
+     */
     fun beginGeohashSampling(geohashes: List<String>) {
-        if (geohashes.isEmpty()) return
-        Log.d(TAG, "🌍 Beginning geohash sampling for ${geohashes.size} geohashes")
-        viewModelScope.launch {
-            geohashes.forEach { geohash ->
-                subscriptionManager.subscribeGeohash(
-                    geohash = geohash,
-                    sinceMs = System.currentTimeMillis() - 86400000L,
-                    limit = 200,
-                    id = "sampling-$geohash",
-                    handler = { event -> geohashMessageHandler.onEvent(event, geohash) }
-                )
-            }
+        val wanted = geohashes.toSet()
+        val added = wanted - sampledGeohashes
+        val removed = sampledGeohashes - wanted
+        sampledGeohashes = wanted
+        if (added.isEmpty() && removed.isEmpty()) return
+        Log.d(TAG, "🌍 Sampling ${wanted.size} geohashes (+${added.size} -${removed.size})")
+        removed.forEach { subscriptionManager.releaseGeohash(it, "sampling") }
+        startParticipantCountTimer()
+        added.forEach { geohash ->
+            subscriptionManager.acquireGeohash(
+                geohash = geohash,
+                feature = "sampling",
+                limit = 200,
+                handler = { event -> geohashMessageHandler.onEvent(event, geohash) },
+                // Sampled channels only feed counts: open their relays once the rest are up
+                priority = RelayConnectionScheduler.Priority.LAZY
+            ) { liveSinceMs -> geohashMessageHandler.catchUp(geohash, System.currentTimeMillis() - 86400000L, liveSinceMs, 200, RelayConnectionScheduler.Priority.LAZY) }
         }
     }
 
-    fun endGeohashSampling() { Log.d(TAG, "🌍 Ending geohash sampling") }
+    fun endGeohashSampling() {
+        if (sampledGeohashes.isEmpty()) return
+        Log.d(TAG, "🌍 Ending geohash sampling for ${sampledGeohashes.size} geohashes")
+        sampledGeohashes.forEach { subscriptionManager.releaseGeohash(it, "sampling") }
+        sampledGeohashes = emptySet()
+    }
     fun geohashParticipantCount(geohash: String): Int = repo.geohashParticipantCount(geohash)
     fun isPersonTeleported(pubkeyHex: String): Boolean = repo.isPersonTeleported(pubkeyHex)
 
+    /**
+     * Local activity inside a geohash cell at any finer level (messages, notes, bookmarks)
+     */
+    fun activityWithin(geohash: String, sinceMs: Long = 0L): com.bitchat.android.geohash.GeohashActivityIndex.Summary =
+        com.bitchat.android.geohash.GeohashActivityIndex.shared.summaryWithin(geohash, sinceMs)
+
+    /**
+     * Local activity inside a geohash cell and its 8 neighbours
+     */
+    fun neighborhoodActivity(geohash: String, sinceMs: Long = 0L): com.bitchat.android.geohash.GeohashActivityIndex.Summary =
+        com.bitchat.android.geohash.GeohashActivityIndex.shared.neighborhoodSummary(geohash, sinceMs)
+
     fun startGeohashDM(pubkeyHex: String, onStartPrivateChat: (String) -> Unit) {
         val convKey = "nostr_${pubkeyHex.take(16)}"
         repo.putNostrKeyMapping(convKey, pubkeyHex)
@@ -210,7 +249,7 @@ class GeohashViewModel(
 
     private fun switchLocationChannel(channel: com.bitchat.android.geohash.ChannelID?) {
         geoTimer?.cancel(); geoTimer = null
-        currentGeohashSubId?.let { subscriptionManager.unsubscribe(it); currentGeohashSubId = null }
+        currentGeohash?.let { subscriptionManager.releaseGeohash(it, "geohash"); currentGeohash = null }
         currentDmSubId?.let { subscriptionManager.unsubscribe(it); currentDmSubId = null }
 
         when (channel) {
@@ -228,26 +267,35 @@ class GeohashViewModel(
                 notificationManager.clearNotificationsForGeohash(channel.channel.geohash)
                 try { messageManager.clearChannelUnreadCount("geo:${channel.channel.geohash}") } catch (_: Exception) { }
 
-                try {
-                    val identity = NostrIdentityBridge.deriveIdentity(channel.channel.geohash, getApplication())
-                    repo.updateParticipant(channel.channel.geohash, identity.publicKeyHex, Date())
-                    val teleported = state.isTeleported.value ?: false
-                    if (teleported) repo.markTeleported(identity.publicKeyHex)
-                } catch (e: Exception) { Log.w(TAG, "Failed identity setup: ${e.message}") }
-
                 startGeoParticipantsTimer()
+                startParticipantCountTimer()
                 
+                val geohash = channel.channel.geohash
+                currentGeohash = geohash
+                // Live events flow at once; meanwhile what we have on disk is rendered and the gap
+                // before the live REQ is backfilled (negentropy, else a since-based fetch).
+                // Switching back within the idle period reuses the still-open subscription.
+                subscriptionManager.acquireGeohash(
+                    geohash = geohash,
+                    feature = "geohash",
+                    limit = 200,
+                    handler = { event -> geohashMessageHandler.onEvent(event, geohash) },
+                    priority = RelayConnectionScheduler.Priority.HIGH
+                ) { liveSinceMs -> geohashMessageHandler.catchUp(geohash, System.currentTimeMillis() - 3600000L, liveSinceMs, 200, RelayConnectionScheduler.Priority.HIGH) }
+
                 viewModelScope.launch {
-                    val geohash = channel.channel.geohash
-                    val subId = "geohash-$geohash"; currentGeohashSubId = subId
-                    subscriptionManager.subscribeGeohash(
-                        geohash = geohash,
-                        sinceMs = System.currentTimeMillis() - 3600000L,
-                        limit = 200,
-                        id = subId,
-                        handler = { event -> geohashMessageHandler.onEvent(event, geohash) }
-                    )
-                    val dmIdentity = NostrIdentityBridge.deriveIdentity(geohash, getApplication())
+                    // A cache miss loops HMAC candidates; derive off the main thread. This also
+                    // warms the cache that people list and name rendering read without deriving.
+                    val dmIdentity = try {
+                        withContext(Dispatchers.Default) { NostrIdentityBridge.deriveIdentity(geohash, getApplication()) }
+                    } catch (e: Exception) {
+                        Log.w(TAG, "Failed identity setup: ${e.message}")
+                        return@launch
+                    }
+                    repo.updateParticipant(geohash, dmIdentity.publicKeyHex, Date())
+                    val teleported = state.isTeleported.value ?: false
+                    if (teleported) repo.markTeleported(dmIdentity.publicKeyHex)
+
                     val dmSubId = "geo-dm-$geohash"; currentDmSubId = dmSubId
                     subscriptionManager.subscribeGiftWraps(
                         pubkey = dmIdentity.publicKeyHex,
@@ -267,6 +315,21 @@ class GeohashViewModel(
         }
     }
 
+    /**
+     * Counts rise per event but only fall as participants age out; expire them on a timer
+     * while anything is tracked, sampled or in view
+     */
+    private fun startParticipantCountTimer() {
+        if (countsTimer?.isActive == true) return
+        countsTimer = viewModelScope.launch {
+            while (true) {
+                delay(com.bitchat.android.util.AppConstants.Nostr.PARTICIPANT_COUNT_TICK_MS)
+                val tracking = withContext(Dispatchers.Default) { repo.updateReactiveParticipantCounts() }
+                if (!tracking && sampledGeohashes.isEmpty() && repo.getCurrentGeohash() == null) break
+            }
+        }
+    }
+
     private fun startGeoParticipantsTimer() {
         geoTimer = viewModelScope.launch {
             while (repo.getCurrentGeohash() != null) {
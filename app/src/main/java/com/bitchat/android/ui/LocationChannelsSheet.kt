@@ -69,6 +69,11 @@ fun LocationChannelsSheet(
 
     // Observe reactive participant counts
     val geohashParticipantCounts by viewModel.geohashParticipantCounts.observeAsState(emptyMap())
+    // Recent local activity (messages, notes) from the geohash activity index; re-read
+    // whenever the counts above change
+    val activitySinceMs = remember(geohashParticipantCounts) {
+        System.currentTimeMillis() - com.bitchat.android.util.AppConstants.Nostr.PARTICIPANT_ACTIVE_WINDOW_MS
+    }
 
     // UI state
     var customGeohash by remember { mutableStateOf("") }
@@ -257,7 +262,9 @@ fun LocationChannelsSheet(
                             val namePart = nameBase?.let { formattedNamePrefix(channel.level) + it }
                             val subtitlePrefix = "#${channel.geohash} • $coverage"
                             val participantCount = geohashParticipantCounts[channel.geohash] ?: 0
-                            val highlight = participantCount > 0
+                            // Zooming out covers every finer cell: one prefix range query
+                            val highlight = participantCount > 0 ||
+                                viewModel.geohashActivityWithin(channel.geohash, activitySinceMs).activeCells > 0
                             val isBookmarked = bookmarksStore.isBookmarked(channel.geohash)
 
                             ChannelRow(
@@ -322,13 +329,14 @@ fun LocationChannelsSheet(
                             val subtitle = subtitlePrefix + (name?.let { " • ${formattedNamePrefix(level)}$it" } ?: "")
                             val participantCount = geohashParticipantCounts[gh] ?: 0
                             val title = geohashHashTitleWithCount(gh, participantCount)
+                            val activeAround = viewModel.geohashNeighborhoodActivity(gh, activitySinceMs).activeCells > 0
 
                             ChannelRow(
                                 title = title,
                                 subtitle = subtitle,
                                 isSelected = isChannelSelected(channel, selectedChannel),
                                 titleColor = null,
-                                titleBold = participantCount > 0,
+                                titleBold = participantCount > 0 || activeAround,
                                 trailingContent = {
                                     IconButton(onClick = { bookmarksStore.toggle(gh) }) {
                                         Icon(
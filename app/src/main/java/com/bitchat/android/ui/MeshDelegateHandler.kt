@@ -21,7 +21,8 @@ class MeshDelegateHandler(
     private val coroutineScope: CoroutineScope,
     private val onHapticFeedback: () -> Unit,
     private val getMyPeerID: () -> String,
-    private val getMeshService: () -> BluetoothMeshService
+    private val getMeshService: () -> BluetoothMeshService,
+    private val onPublicMessage: (BitchatMessage) -> Unit = {}
 ) : BluetoothMeshDelegate {
 
     override fun didReceiveMessage(message: BitchatMessage) {
@@ -44,6 +45,9 @@ class MeshDelegateHandler(
             onHapticFeedback()
 
             if (message.isPrivate) {
+                // Hedged senders may deliver the same message over mesh and Nostr
+                if (privateChatManager.hasPrivateMessage(message.id)) return@launch
+
                 // Private message
                 privateChatManager.handleIncomingPrivateMessage(message)
                 
@@ -71,6 +75,7 @@ class MeshDelegateHandler(
             } else {
                 // Public mesh message - always store to preserve message history
                 messageManager.addMessage(message)
+                onPublicMessage(message)
 
                 // Check for mentions in mesh chat
                 checkAndTriggerMeshMentionNotification(message)
@@ -195,17 +200,37 @@ class MeshDelegateHandler(
     }
     
     override fun didReceiveDeliveryAck(messageID: String, recipientPeerID: String) {
+        // Nostr ACKs already settled the router entry (with their path) in NostrDirectMessageHandler
+        runCatching { com.bitchat.android.services.MessageRouter.tryGetInstance()?.onAcknowledged(messageID, read = false, via = com.bitchat.android.services.PathQualityEstimator.Transport.MESH) }
         coroutineScope.launch {
             messageManager.updateMessageDeliveryStatus(messageID, DeliveryStatus.Delivered(recipientPeerID, Date()))
         }
     }
     
     override fun didReceiveReadReceipt(messageID: String, recipientPeerID: String) {
+        // Nostr ACKs already settled the router entry (with their path) in NostrDirectMessageHandler
+        runCatching { com.bitchat.android.services.MessageRouter.tryGetInstance()?.onAcknowledged(messageID, read = true, via = com.bitchat.android.services.PathQualityEstimator.Transport.MESH) }
         coroutineScope.launch {
             messageManager.updateMessageDeliveryStatus(messageID, DeliveryStatus.Read(recipientPeerID, Date()))
         }
     }
     
+    override fun didReceiveReadUpTo(messageID: String, recipientPeerID: String) {
+        val router = runCatching { com.bitchat.android.services.MessageRouter.tryGetInstance() }.getOrNull()
+        router?.onAcknowledged(messageID, read = true, via = com.bitchat.android.services.PathQualityEstimator.Transport.MESH)
+        coroutineScope.launch {
+            val covered = messageManager.markPrivateMessagesReadUpTo(messageID, DeliveryStatus.Read(recipientPeerID, Date()))
+            // Earlier messages whose ACKs were lost stop retrying; no path sample for them
+            covered.forEach { router?.onAcknowledged(it, read = true) }
+        }
+    }
+    
+    override fun didFailToDeliver(messageID: String, recipientPeerID: String, reason: String) {
+        coroutineScope.launch {
+            messageManager.updateMessageDeliveryStatus(messageID, DeliveryStatus.Failed(reason))
+        }
+    }
+    
     override fun decryptChannelMessage(encryptedContent: ByteArray, channel: String): String? {
         return channelManager.decryptChannelMessage(encryptedContent, channel)
     }
@@ -2,20 +2,72 @@ package com.bitchat.android.ui
 
 import com.bitchat.android.model.BitchatMessage
 import com.bitchat.android.model.DeliveryStatus
+import com.bitchat.android.services.PathQualityEstimator
+import com.bitchat.android.util.SortedTimeline
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.withContext
 import java.util.*
 import java.util.Collections
+import java.util.concurrent.ConcurrentHashMap
 import kotlin.collections.toMutableList
 
 /**
  * Handles all message-related operations including deduplication and organization
  */
 class MessageManager(private val state: ChatState) {
+
+    companion object {
+        /**
+         * Messages besides `messageID` that a READ_UP_TO receipt for it covers: ours (same
+         * sender as the acknowledged message), not newer than it, and sent or delivered. A
+         * sent one may just have lost its delivery ACK; messages still sending or failed
+         * are left alone, the reader cannot have them.
+         */
+        fun coveredByReadReceipt(chat: List<BitchatMessage>, messageID: String): Set<String> {
+            val acknowledged = chat.firstOrNull { it.id == messageID } ?: return emptySet()
+            return chat.filter {
+                it.id != messageID &&
+                    it.senderPeerID == acknowledged.senderPeerID &&
+                    !it.timestamp.after(acknowledged.timestamp) &&
+                    (it.deliveryStatus is DeliveryStatus.Delivered || it.deliveryStatus == DeliveryStatus.Sent)
+            }.mapTo(HashSet()) { it.id }
+        }
+    }
     
     // Message deduplication - FIXED: Prevent duplicate messages from dual connection paths
     private val processedUIMessages = Collections.synchronizedSet(mutableSetOf<String>())
     private val recentSystemEvents = Collections.synchronizedMap(mutableMapOf<String, Long>())
     private val MESSAGE_DEDUP_TIMEOUT = com.bitchat.android.util.AppConstants.UI.MESSAGE_DEDUP_TIMEOUT_MS // 30 seconds
     private val SYSTEM_EVENT_DEDUP_TIMEOUT = com.bitchat.android.util.AppConstants.UI.SYSTEM_EVENT_DEDUP_TIMEOUT_MS // 5 seconds
+
+    // Geohash channels ("geo:<gh>") receive relay backlogs out of order and in bursts; they
+    // keep a sorted, bounded timeline that is published to state once per frame
+    private val timelineScope = CoroutineScope(Dispatchers.Default + SupervisorJob())
+    private val geoTimelines = ConcurrentHashMap<String, SortedTimeline<BitchatMessage>>()
+
+    private fun geoTimeline(channel: String): SortedTimeline<BitchatMessage> {
+        return geoTimelines.getOrPut(channel) {
+            lateinit var timeline: SortedTimeline<BitchatMessage>
+            timeline = SortedTimeline(
+                capacity = com.bitchat.android.util.AppConstants.UI.GEOHASH_TIMELINE_MAX_MESSAGES,
+                newestFirst = false,
+                scope = timelineScope,
+                idOf = { it.id },
+                timeOf = { it.timestamp.time },
+                publish = { snapshot ->
+                    withContext(Dispatchers.Main) {
+                        // Removed while this publish was on its way to the main thread
+                        if (!timeline.isClosed) {
+                            state.setChannelMessages(state.getChannelMessagesValue() + (channel to snapshot))
+                        }
+                    }
+                }
+            )
+            timeline
+        }
+    }
     
     // MARK: - Public Message Management
     
@@ -38,22 +90,27 @@ class MessageManager(private val state: ChatState) {
     
     fun clearMessages() {
         state.setMessages(emptyList())
+        geoTimelines.values.forEach { it.clear() }
         state.setChannelMessages(emptyMap())
     }
     
     // MARK: - Channel Message Management
     
     fun addChannelMessage(channel: String, message: BitchatMessage) {
-        val currentChannelMessages = state.getChannelMessagesValue().toMutableMap()
-        if (!currentChannelMessages.containsKey(channel)) {
-            currentChannelMessages[channel] = mutableListOf()
+        if (channel.startsWith("geo:")) {
+            if (!geoTimeline(channel).add(message)) return
+        } else {
+            val currentChannelMessages = state.getChannelMessagesValue().toMutableMap()
+            if (!currentChannelMessages.containsKey(channel)) {
+                currentChannelMessages[channel] = mutableListOf()
+            }
+            
+            val channelMessageList = currentChannelMessages[channel]?.toMutableList() ?: mutableListOf()
+            channelMessageList.add(message)
+            currentChannelMessages[channel] = channelMessageList
+            state.setChannelMessages(currentChannelMessages)
         }
         
-        val channelMessageList = currentChannelMessages[channel]?.toMutableList() ?: mutableListOf()
-        channelMessageList.add(message)
-        currentChannelMessages[channel] = channelMessageList
-        state.setChannelMessages(currentChannelMessages)
-        
         // Update unread count if not currently viewing this channel
         // Consider both classic channels (state.currentChannel) and geohash location channel selection
         val viewingClassicChannel = state.getCurrentChannelValue() == channel
@@ -72,13 +129,39 @@ class MessageManager(private val state: ChatState) {
         }
     }
     
+    /**
+     * Add a batch of geohash channel messages: timeline inserts coalesce into one published
+     * snapshot, and the unread count is updated once for the whole batch
+     */
+    fun addChannelMessages(channel: String, messages: List<BitchatMessage>) {
+        if (!channel.startsWith("geo:")) {
+            messages.forEach { addChannelMessage(channel, it) }
+            return
+        }
+        val timeline = geoTimeline(channel)
+        val added = messages.count { timeline.add(it) }
+        if (added == 0) return
+
+        val geo = channel.removePrefix("geo:")
+        val selected = state.selectedLocationChannel.value
+        val viewing = selected is com.bitchat.android.geohash.ChannelID.Location &&
+            selected.channel.geohash.equals(geo, ignoreCase = true)
+        if (!viewing && state.getCurrentChannelValue() != channel) {
+            val currentUnread = state.getUnreadChannelMessagesValue().toMutableMap()
+            currentUnread[channel] = (currentUnread[channel] ?: 0) + added
+            state.setUnreadChannelMessages(currentUnread)
+        }
+    }
+
     fun clearChannelMessages(channel: String) {
+        geoTimelines[channel]?.clear()
         val updatedChannelMessages = state.getChannelMessagesValue().toMutableMap()
         updatedChannelMessages[channel] = emptyList()
         state.setChannelMessages(updatedChannelMessages)
     }
     
     fun removeChannelMessages(channel: String) {
+        geoTimelines.remove(channel)?.close()
         val updatedChannelMessages = state.getChannelMessagesValue().toMutableMap()
         updatedChannelMessages.remove(channel)
         state.setChannelMessages(updatedChannelMessages)
@@ -103,6 +186,8 @@ class MessageManager(private val state: ChatState) {
         }
         
         val chatMessages = currentPrivateChats[peerID]?.toMutableList() ?: mutableListOf()
+        // Senders resend unacknowledged messages with the same ID; keep the first copy
+        if (chatMessages.any { it.id == message.id }) return
         chatMessages.add(message)
         currentPrivateChats[peerID] = chatMessages
         state.setPrivateChats(currentPrivateChats)
@@ -140,6 +225,7 @@ class MessageManager(private val state: ChatState) {
             currentPrivateChats[peerID] = mutableListOf()
         }
         val chatMessages = currentPrivateChats[peerID]?.toMutableList() ?: mutableListOf()
+        if (chatMessages.any { it.id == message.id }) return
         chatMessages.add(message)
         currentPrivateChats[peerID] = chatMessages
         state.setPrivateChats(currentPrivateChats)
@@ -244,6 +330,7 @@ class MessageManager(private val state: ChatState) {
                    )
                    addMessage(systemMessage)
                    state.addRttValues(rtt)
+                   PathQualityEstimator.shared.onRttSample(peerID, PathQualityEstimator.Transport.MESH, rtt)
                    return
                }
            }
@@ -274,6 +361,9 @@ class MessageManager(private val state: ChatState) {
         }
         
         // Update in channel messages
+        geoTimelines.values.forEach { timeline ->
+            timeline.update(messageID) { it.copy(deliveryStatus = status) }
+        }
         val updatedChannelMessages = state.getChannelMessagesValue().toMutableMap()
         updatedChannelMessages.forEach { (channel, messages) ->
             val channelMessagesList = messages.toMutableList()
@@ -286,6 +376,27 @@ class MessageManager(private val state: ChatState) {
         state.setChannelMessages(updatedChannelMessages)
     }
 
+    /**
+     * Apply a READ_UP_TO receipt for `messageID`: it and our earlier messages in that chat
+     * (see [coveredByReadReceipt]) become read. Returns the covered IDs besides `messageID`.
+     */
+    fun markPrivateMessagesReadUpTo(messageID: String, status: DeliveryStatus.Read): Set<String> {
+        updateMessageDeliveryStatus(messageID, status)
+
+        val updatedPrivateChats = state.getPrivateChatsValue().toMutableMap()
+        val coveredIDs = HashSet<String>()
+        updatedPrivateChats.forEach { (peerID, messages) ->
+            val covered = coveredByReadReceipt(messages, messageID)
+            if (covered.isEmpty()) return@forEach
+            updatedPrivateChats[peerID] = messages.map { if (it.id in covered) it.copy(deliveryStatus = status) else it }
+            coveredIDs += covered
+        }
+        if (coveredIDs.isNotEmpty()) {
+            state.setPrivateChats(updatedPrivateChats)
+        }
+        return coveredIDs
+    }
+
     // Remove a message from all locations (main timeline, private chats, channels)
     fun removeMessageById(messageID: String) {
         // Main timeline
@@ -313,6 +424,7 @@ class MessageManager(private val state: ChatState) {
             if (changed) state.setPrivateChats(chats)
         }
         // Channels
+        geoTimelines.values.forEach { it.remove(messageID) }
         run {
             val chans = state.getChannelMessagesValue().toMutableMap()
             var changed = false
@@ -355,6 +467,7 @@ class MessageManager(private val state: ChatState) {
     fun clearAllMessages() {
         state.setMessages(emptyList())
         state.setPrivateChats(emptyMap())
+        geoTimelines.values.forEach { it.clear() }
         state.setChannelMessages(emptyMap())
         state.setUnreadPrivateMessages(emptySet())
         state.setUnreadChannelMessages(emptyMap())
@@ -2,6 +2,7 @@ package com.bitchat.android.ui
 
 import com.bitchat.android.model.BitchatMessage
 import com.bitchat.android.model.DeliveryStatus
+import com.bitchat.android.model.PeerCapability
 import com.bitchat.android.mesh.PeerFingerprintManager
 import java.security.MessageDigest
 
@@ -324,6 +325,12 @@ class PrivateChatManager(
 
     // MARK: - Message Handling
 
+    /**
+     * Whether any private conversation already holds a message with this ID
+     */
+    fun hasPrivateMessage(messageID: String): Boolean =
+        state.getPrivateChatsValue().values.any { messages -> messages.any { it.id == messageID } }
+
     fun handleIncomingPrivateMessage(message: BitchatMessage) {
         handleIncomingPrivateMessage(message, suppressUnread = false)
     }
@@ -355,8 +362,9 @@ class PrivateChatManager(
     }
 
     /**
-     * Send read receipts for all unread messages from a specific peer
-     * Called when the user focuses on a private chat
+     * Send read receipts for the unread messages from a specific peer
+     * Called when the user focuses on a private chat. A READ_UP_TO peer gets one receipt for
+     * the newest unread message covering the rest; anyone else one receipt per message.
      */
     fun sendReadReceiptsForPeer(peerID: String, meshService: BluetoothMeshService) {
         val unreadList = unreadReceivedMessages[peerID]
@@ -365,16 +373,28 @@ class PrivateChatManager(
             return
         }
 
-        Log.d(TAG, "Sending read receipts for ${unreadList.size} unread messages from $peerID")
-
-        // Send read receipt for each unread message - now using direct method call
-        unreadList.forEach { message ->
+        val myNickname = state.getNicknameValue() ?: "unknown"
+        val capabilities = meshService.getPeerInfo(peerID)?.capabilities ?: 0L
+        if (PeerCapability.has(capabilities, PeerCapability.READ_UP_TO)) {
+            // Newest by arrival; timestamps of Nostr messages come from randomized gift wraps
+            val newest = unreadList.last()
+            Log.d(TAG, "Sending read receipt for ${unreadList.size} unread messages from $peerID (up to ${newest.id})")
             try {
-                val myNickname = state.getNicknameValue() ?: "unknown"
-                meshService.sendReadReceipt(message.id, peerID, myNickname)
-                Log.d(TAG, "Sent read receipt for message ${message.id} to $peerID")
+                meshService.sendReadReceipt(newest.id, peerID, myNickname, upTo = true)
             } catch (e: Exception) {
-                Log.w(TAG, "Failed to send read receipt for message ${message.id}: ${e.message}")
+                Log.w(TAG, "Failed to send read receipt for message ${newest.id}: ${e.message}")
+            }
+        } else {
+            Log.d(TAG, "Sending read receipts for ${unreadList.size} unread messages from $peerID")
+
+            // Send read receipt for each unread message - now using direct method call
+            unreadList.forEach { message ->
+                try {
+                    meshService.sendReadReceipt(message.id, peerID, myNickname)
+                    Log.d(TAG, "Sent read receipt for message ${message.id} to $peerID")
+                } catch (e: Exception) {
+                    Log.w(TAG, "Failed to send read receipt for message ${message.id}: ${e.message}")
+                }
             }
         }
 
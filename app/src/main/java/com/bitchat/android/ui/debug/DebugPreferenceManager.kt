@@ -13,6 +13,7 @@ object DebugPreferenceManager {
     private const val KEY_GATT_SERVER = "gatt_server_enabled"
     private const val KEY_GATT_CLIENT = "gatt_client_enabled"
     private const val KEY_PACKET_RELAY = "packet_relay_enabled"
+    private const val KEY_HEDGED_PM = "hedged_private_messages"
     private const val KEY_MAX_CONN_OVERALL = "max_connections_overall"
     private const val KEY_MAX_CONN_SERVER = "max_connections_server"
     private const val KEY_MAX_CONN_CLIENT = "max_connections_client"
@@ -57,6 +58,13 @@ object DebugPreferenceManager {
         if (ready()) prefs.edit().putBoolean(KEY_PACKET_RELAY, value).apply()
     }
 
+    fun getHedgedPrivateMessages(default: Boolean = false): Boolean =
+        if (ready()) prefs.getBoolean(KEY_HEDGED_PM, default) else default
+
+    fun setHedgedPrivateMessages(value: Boolean) {
+        if (ready()) prefs.edit().putBoolean(KEY_HEDGED_PM, value).apply()
+    }
+
     // Optional connection limits (0 or missing => use defaults)
     fun getMaxConnectionsOverall(default: Int = 8): Int =
         if (ready()) prefs.getInt(KEY_MAX_CONN_OVERALL, default) else default
@@ -1,5 +1,6 @@
 package com.bitchat.android.ui.debug
 
+import com.bitchat.android.services.PathQualityEstimator
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
@@ -36,6 +37,10 @@ class DebugSettingsManager private constructor() {
     private val _packetRelayEnabled = MutableStateFlow(true)
     val packetRelayEnabled: StateFlow<Boolean> = _packetRelayEnabled.asStateFlow()
 
+    // Private messages: also send over the other transport when no ACK arrives in time
+    private val _hedgedPrivateMessages = MutableStateFlow(false)
+    val hedgedPrivateMessages: StateFlow<Boolean> = _hedgedPrivateMessages.asStateFlow()
+
     // Connection limit overrides (debug)
     private val _maxConnectionsOverall = MutableStateFlow(8)
     val maxConnectionsOverall: StateFlow<Int> = _maxConnectionsOverall.asStateFlow()
@@ -51,6 +56,7 @@ class DebugSettingsManager private constructor() {
             _gattServerEnabled.value = DebugPreferenceManager.getGattServerEnabled(true)
             _gattClientEnabled.value = DebugPreferenceManager.getGattClientEnabled(true)
             _packetRelayEnabled.value = DebugPreferenceManager.getPacketRelayEnabled(true)
+            _hedgedPrivateMessages.value = DebugPreferenceManager.getHedgedPrivateMessages(false)
             _maxConnectionsOverall.value = DebugPreferenceManager.getMaxConnectionsOverall(8)
             _maxServerConnections.value = DebugPreferenceManager.getMaxConnectionsServer(8)
             _maxClientConnections.value = DebugPreferenceManager.getMaxConnectionsClient(8)
@@ -140,6 +146,14 @@ class DebugSettingsManager private constructor() {
         ))
     }
 
+    fun setHedgedPrivateMessages(enabled: Boolean) {
+        DebugPreferenceManager.setHedgedPrivateMessages(enabled)
+        _hedgedPrivateMessages.value = enabled
+        addDebugMessage(DebugMessage.SystemMessage(
+            if (enabled) "🔀 Hedged private messages enabled" else "➡️ Hedged private messages disabled"
+        ))
+    }
+
     fun setMaxConnectionsOverall(value: Int) {
         val clamped = value.coerceIn(1, 32)
         DebugPreferenceManager.setMaxConnectionsOverall(clamped)
@@ -426,7 +440,8 @@ data class ConnectedDevice(
     val nickname: String?,
     val rssi: Int?,
     val connectionType: ConnectionType,
-    val isDirectConnection: Boolean
+    val isDirectConnection: Boolean,
+    val pathQuality: PathQualityEstimator.Estimate? = null
 )
 
 enum class ConnectionType {
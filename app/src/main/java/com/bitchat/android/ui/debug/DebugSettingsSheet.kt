@@ -24,7 +24,9 @@ import androidx.compose.ui.unit.dp
 import androidx.compose.ui.unit.sp
 import androidx.compose.ui.draw.rotate
 import com.bitchat.android.mesh.BluetoothMeshService
+import com.bitchat.android.services.PathQualityEstimator
 import kotlinx.coroutines.launch
+import kotlin.math.roundToInt
 import androidx.compose.ui.res.stringResource
 import com.bitchat.android.R
 
@@ -43,6 +45,7 @@ fun DebugSettingsSheet(
     val gattServerEnabled by manager.gattServerEnabled.collectAsState()
     val gattClientEnabled by manager.gattClientEnabled.collectAsState()
     val packetRelayEnabled by manager.packetRelayEnabled.collectAsState()
+    val hedgedPrivateMessages by manager.hedgedPrivateMessages.collectAsState()
     val maxOverall by manager.maxConnectionsOverall.collectAsState()
     val maxServer by manager.maxServerConnections.collectAsState()
     val maxClient by manager.maxClientConnections.collectAsState()
@@ -72,7 +75,8 @@ fun DebugSettingsSheet(
                         nickname = pid?.let { nicknames[it] },
                         rssi = rssi,
                         connectionType = if (isClient) ConnectionType.GATT_CLIENT else ConnectionType.GATT_SERVER,
-                        isDirectConnection = pid?.let { directMap[it] } ?: false
+                        isDirectConnection = pid?.let { directMap[it] } ?: false,
+                        pathQuality = pid?.let { PathQualityEstimator.shared.estimate(it, PathQualityEstimator.Transport.MESH) }
                     )
                 }
                 manager.updateConnectedDevices(devices)
@@ -198,6 +202,26 @@ fun DebugSettingsSheet(
                 }
             }
 
+            // Private message delivery policy
+            item {
+                Surface(shape = RoundedCornerShape(12.dp), color = colorScheme.surfaceVariant.copy(alpha = 0.2f)) {
+                    Column(Modifier.padding(16.dp), verticalArrangement = Arrangement.spacedBy(8.dp)) {
+                        Row(verticalAlignment = Alignment.CenterVertically, horizontalArrangement = Arrangement.spacedBy(8.dp)) {
+                            Icon(Icons.Filled.SettingsEthernet, contentDescription = null, tint = Color(0xFF007AFF))
+                            Text(stringResource(R.string.debug_hedged_pm), fontFamily = FontFamily.Monospace, fontSize = 14.sp, fontWeight = FontWeight.Medium)
+                            Spacer(Modifier.weight(1f))
+                            Switch(checked = hedgedPrivateMessages, onCheckedChange = { manager.setHedgedPrivateMessages(it) })
+                        }
+                        Text(
+                            stringResource(R.string.debug_hedged_pm_hint),
+                            fontFamily = FontFamily.Monospace,
+                            fontSize = 11.sp,
+                            color = colorScheme.onSurface.copy(alpha = 0.7f)
+                        )
+                    }
+                }
+            }
+
             // Packet relay controls and stats
             item {
                 Surface(shape = RoundedCornerShape(12.dp), color = colorScheme.surfaceVariant.copy(alpha = 0.2f)) {
@@ -333,6 +357,10 @@ fun DebugSettingsSheet(
                                             Text((dev.peerID ?: stringResource(R.string.unknown)) + " • ${dev.deviceAddress}", fontFamily = FontFamily.Monospace, fontSize = 12.sp)
                                             val roleLabel = if (dev.connectionType == ConnectionType.GATT_SERVER) stringResource(R.string.debug_role_server) else stringResource(R.string.debug_role_client)
                                             Text("${dev.nickname ?: ""} • " + stringResource(R.string.debug_rssi_fmt, dev.rssi ?: stringResource(R.string.debug_question_mark)) + " • $roleLabel" + (if (dev.isDirectConnection) stringResource(R.string.debug_direct_suffix) else ""), fontFamily = FontFamily.Monospace, fontSize = 11.sp, color = colorScheme.onSurface.copy(alpha = 0.7f))
+                                            dev.pathQuality?.let { q ->
+                                                val rtt = q.srttMs?.let { "${it}±${q.rttVarMs ?: 0}ms" } ?: stringResource(R.string.debug_question_mark)
+                                                Text(stringResource(R.string.debug_path_quality_fmt, rtt, (q.lossRate * 100).roundToInt(), q.hops?.toString() ?: stringResource(R.string.debug_question_mark)), fontFamily = FontFamily.Monospace, fontSize = 11.sp, color = colorScheme.onSurface.copy(alpha = 0.7f))
+                                            }
                                         }
                                         Text(stringResource(R.string.debug_disconnect), color = Color(0xFFBF1A1A), fontFamily = FontFamily.Monospace, modifier = Modifier.clickable {
                                             meshService.connectionManager.disconnectAddress(dev.deviceAddress)
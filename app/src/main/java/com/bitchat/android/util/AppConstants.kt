@@ -25,6 +25,14 @@ object AppConstants {
         // GATT client RSSI updates
         const val RSSI_UPDATE_INTERVAL_MS: Long = 5_000L
 
+        // Delivery ACKs batched per sender for peers advertising PeerCapability.BATCH_ACK
+        const val ACK_BATCH_WINDOW_MS: Long = 200L
+        // Keeps one encrypted batch under the fragmentation threshold
+        const val ACK_BATCH_MAX_IDS: Int = 24
+
+        // Favorite / nickname / npub record sent to a PeerCapability.PEER_STATE peer this long after the last change
+        const val PEER_STATE_DEBOUNCE_MS: Long = 1_000L
+
         object Gatt {
             val SERVICE_UUID: UUID = UUID.fromString("F47B5E2D-4A9E-4C5A-9B3F-8E1D2C3A4B5C")
             val CHARACTERISTIC_UUID: UUID = UUID.fromString("A1B2C3D4-E5F6-4A5B-8C9D-0E1F2A3B4C5D")
@@ -41,6 +49,18 @@ object AppConstants {
         const val MAX_FRAGMENT_SIZE: Int = 469
         const val FRAGMENT_TIMEOUT_MS: Long = 30_000L
         const val CLEANUP_INTERVAL_MS: Long = 10_000L
+        const val INTER_FRAGMENT_DELAY_MS: Long = 20L
+    }
+
+    object FileStream {
+        const val RECORD_SIZE_BYTES: Int = 8 * 1024
+        const val MIN_STREAM_FILE_SIZE_BYTES: Int = 16 * 1024 // Smaller files stay a single Noise message
+        const val INCOMING_TIMEOUT_MS: Long = 120_000L
+        const val CLEANUP_INTERVAL_MS: Long = 30_000L
+        const val MAX_CONCURRENT_INCOMING: Int = 4
+        const val MAX_EARLY_RECORDS: Int = 16 // Records buffered while FILE_STREAM_START is still in flight
+        const val MAX_EARLY_BYTES_PER_PEER: Int = 256 * 1024 // Across all of one peer's not-yet-started transfers
+        const val MAX_EARLY_BYTES_TOTAL: Int = 1024 * 1024
     }
 
     object Security {
@@ -56,6 +76,9 @@ object AppConstants {
         const val REKEY_MESSAGE_LIMIT_SESSION: Long = 10_000L // session-level ceiling
         const val MAX_PAYLOAD_SIZE_BYTES: Int = 256
         const val HIGH_NONCE_WARNING_THRESHOLD: Long = 1_000_000_000L
+        // Replay window sizes in nonces (multiples of 64); sessions widen to BULK after a too-old rejection
+        const val REPLAY_WINDOW_SIZE: Int = 1_024
+        const val REPLAY_WINDOW_SIZE_BULK: Int = 8_192
     }
 
     object Protocol {
@@ -85,11 +108,12 @@ object AppConstants {
     }
 
     object Nostr {
-        // Relay backoff
+        // Relay reconnect backoff (decorrelated jitter between these bounds)
         const val INITIAL_BACKOFF_INTERVAL_MS: Long = 1_000L
         const val MAX_BACKOFF_INTERVAL_MS: Long = 300_000L
-        const val BACKOFF_MULTIPLIER: Double = 2.0
         const val MAX_RECONNECT_ATTEMPTS: Int = 10
+        // Relay connection attempts (TLS / Tor circuit setup) in flight at once
+        const val MAX_CONCURRENT_CONNECTS: Int = 4
 
         // Transport
         const val READ_ACK_INTERVAL_MS: Long = 350L
@@ -97,8 +121,96 @@ object AppConstants {
         // Deduplicator
         const val DEFAULT_DEDUP_CAPACITY: Int = 10_000
 
+        // Derived per-geohash identities kept in memory (LRU)
+        const val GEOHASH_IDENTITY_CACHE_SIZE: Int = 64
+
+        // Geohash participant counting
+        const val PARTICIPANT_ACTIVE_WINDOW_MS: Long = 300_000L
+        // Exact participants remembered per channel not in view (sampled channels use a sketch)
+        const val PARTICIPANT_EXACT_CAP: Int = 200
+        const val PARTICIPANT_COUNT_TICK_MS: Long = 30_000L
+
+        // Local geohash event store
+        const val EVENT_STORE_RETENTION_MS: Long = 86_400_000L
+        const val EVENT_STORE_PRUNE_EVERY: Int = 500
+        // Re-request this much before the stored high-water mark to cover relay clock skew
+        const val EVENT_STORE_SINCE_OVERLAP_SEC: Long = 60L
+        // Events dated further ahead than this are not stored (they would pin the high-water mark)
+        const val EVENT_STORE_MAX_FUTURE_SKEW_SEC: Long = 300L
+
+        // NIP-77 negentropy catch-up (falls back to since-based REQs on timeout or error)
+        const val NEGENTROPY_CONNECT_WAIT_MS: Long = 5_000L
+        const val NEGENTROPY_ROUND_TIMEOUT_MS: Long = 5_000L
+        const val NEGENTROPY_MAX_ROUNDS: Int = 8
+        const val NEGENTROPY_FETCH_CHUNK: Int = 100
+        const val NEGENTROPY_FETCH_TIMEOUT_MS: Long = 10_000L
+
+        // Geohash events handled per background batch
+        const val EVENT_BATCH_MAX: Int = 200
+
+        // Gift-wrap (NIP-17 DM) receive pipeline
+        const val GIFT_WRAP_BATCH_MAX: Int = 100
+        const val GIFT_WRAP_UNWRAP_PARALLELISM: Int = 4
+        const val GIFT_WRAP_KEY_CACHE_SIZE: Int = 256
+        // Seals are backdated up to 48h; 15 minutes of slack
+        const val GIFT_WRAP_MAX_AGE_SEC: Long = 173_700L
+
         // Relay subscription validation
         const val SUBSCRIPTION_VALIDATION_INTERVAL_MS: Long = 30_000L
+
+        // Unreferenced geohash subscriptions stay open this long before CLOSE
+        const val SUBSCRIPTION_IDLE_TEARDOWN_MS: Long = 30_000L
+        // Concurrent REQs sent to any one relay; the rest wait for a free slot
+        const val MAX_SUBSCRIPTIONS_PER_RELAY: Int = 16
+    }
+
+    object Location {
+        // Live refresh while the channel selector is visible
+        const val REFRESH_INTERVAL_MS: Long = 5_000L
+        const val REFRESH_MAX_INTERVAL_MS: Long = 60_000L
+        // Fixes without a cell change before polling backs off and prefers low-power providers
+        const val STATIONARY_FIXES: Int = 3
+
+        // Cell hysteresis: accept a new cell this far (fraction of a cell) past the border,
+        // or after this many consecutive fixes inside it
+        const val CELL_HYSTERESIS_MARGIN: Double = 0.25
+        const val CELL_CONFIRM_FIXES: Int = 3
+
+        // Reverse-geocoded names cached per block-level cell (LRU)
+        const val GEOCODE_CACHE_SIZE: Int = 32
+
+        // Local geohash activity index: idle cells are forgotten, and the total is capped
+        const val ACTIVITY_MAX_AGE_MS: Long = 24 * 60 * 60 * 1000L
+        const val ACTIVITY_MAX_CELLS: Int = 2_048
+    }
+
+    object Bridge {
+        // Geohash level a bridge node relays the mesh timeline into
+        const val GEOHASH_PRECISION: Int = 7
+        // Injected channel messages only need to cover the local mesh island
+        val MESH_TTL_HOPS: UByte = 3u
+        const val TO_RELAY_PER_MINUTE: Int = 30
+        const val TO_MESH_PER_MINUTE: Int = 20
+        const val PER_SENDER_PER_MINUTE: Int = 6
+        const val SENDER_LIMITS_SIZE: Int = 256
+        // Packet/event ids remembered for loop prevention (LRU)
+        const val LEDGER_SIZE: Int = 2_048
+        // Channel events older than this (e.g. stored history) are not injected
+        const val MAX_EVENT_AGE_MS: Long = 120_000L
+        const val MAX_CLOCK_SKEW_MS: Long = 600_000L
+        const val MAX_CONTENT_CHARS: Int = 500
+    }
+
+    object Network {
+        // Shared by every relay websocket and HTTP call made through OkHttpProvider
+        const val DISPATCHER_MAX_REQUESTS: Int = 128
+        const val POOL_MAX_IDLE_CONNECTIONS: Int = 8
+        const val POOL_KEEP_ALIVE_MS: Long = 300_000L
+        // WebSocket keepalive; a missed pong fails the socket and the relay reconnects with backoff
+        const val WEBSOCKET_PING_INTERVAL_MS: Long = 30_000L
+        const val WEBSOCKET_PING_INTERVAL_TOR_MS: Long = 60_000L
+        // After a proxy switch, the previous client is drained this long after reset
+        const val DRAIN_GRACE_MS: Long = 10_000L
     }
 
     object Tor {
@@ -107,6 +219,11 @@ object AppConstants {
         const val INACTIVITY_TIMEOUT_MS: Long = 5_000L
         const val MAX_RETRY_ATTEMPTS: Int = 5
         const val STOP_TIMEOUT_MS: Long = 7_000L
+        // SOCKS handshake wait, which includes building the circuit
+        const val SOCKS_CONNECT_TIMEOUT_MS: Long = 30_000L
+        // Circuit prewarming between "SOCKS functional" and the relay reconnect
+        const val PREWARM_TIMEOUT_MS: Long = 60_000L
+        const val PREWARM_RETRY_MS: Long = 2_000L
     }
 
     object UI {
@@ -115,6 +232,8 @@ object AppConstants {
         const val MESSAGE_DEDUP_TIMEOUT_MS: Long = 30_000L
         const val SYSTEM_EVENT_DEDUP_TIMEOUT_MS: Long = 5_000L
         const val ACTIVE_PEERS_NOTIFICATION_INTERVAL_MS: Long = 300_000L
+        // Messages kept per geohash channel timeline (oldest evicted first)
+        const val GEOHASH_TIMELINE_MAX_MESSAGES: Int = 1_000
     }
 
     object Media {
@@ -124,4 +243,36 @@ object AppConstants {
     object Services {
         const val SEEN_MESSAGE_MAX_IDS: Int = 10_000
     }
+
+    object Outbox {
+        // Resend unacknowledged private messages with exponential backoff
+        const val RETRY_BASE_MS: Long = 30_000L
+        const val RETRY_MAX_MS: Long = 600_000L
+        const val MAX_SEND_ATTEMPTS: Int = 6
+        // Queued messages older than this are dropped on load
+        const val MAX_AGE_MS: Long = 7 * 86_400_000L
+    }
+
+    object PathQuality {
+        const val TRACKED_PEERS: Int = 128
+        // Sends awaiting an ACK; past the timeout (or the cap) they count as lost
+        const val MAX_OUTSTANDING: Int = 512
+        const val LOSS_TIMEOUT_MS: Long = 60_000L
+        // ACK wait before hedging to the other transport: defaults until a peer/transport
+        // has RTT samples, then srtt + 4 * rttvar within bounds
+        const val DEFAULT_BUDGET_MESH_MS: Long = 4_000L
+        const val DEFAULT_BUDGET_NOSTR_MS: Long = 8_000L
+        const val MIN_BUDGET_MS: Long = 1_500L
+        const val MAX_BUDGET_MS: Long = 20_000L
+        // Directed packets are still relayed when the recipient's last known hop count
+        // exceeds the remaining TTL by at most this much (announces age quickly)
+        const val RELAY_HOP_SLACK: Int = 2
+        // Hop counts older than three 30 s announce intervals are ignored
+        const val HOPS_MAX_AGE_MS: Long = 90_000L
+    }
+
+    object Persistence {
+        // Write-behind stores batch mutations for this long before committing on IO
+        const val WRITE_BEHIND_DEBOUNCE_MS: Long = 500L
+    }
 }
@@ -0,0 +1,54 @@
+package com.bitchat.android.util
+
+import android.util.Log
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.launch
+
+/**
+ * Unbounded queue drained in batches by a single consumer on a background dispatcher.
+ *
+ * Producers (e.g. relay socket threads) only enqueue. The consumer takes whatever has
+ * accumulated, up to `maxBatch` items, and hands it to `process` in arrival order, so a
+ * burst of N items costs one `process` call instead of N coroutine launches. Items
+ * arriving while a batch is processed form the next batch.
+ */
+class BatchingQueue<T>(
+    scope: CoroutineScope,
+    private val maxBatch: Int,
+    private val process: suspend (List<T>) -> Unit
+) {
+    companion object { private const val TAG = "BatchingQueue" }
+
+    private val channel = Channel<T>(Channel.UNLIMITED)
+
+    init {
+        scope.launch(Dispatchers.Default) {
+            for (first in channel) {
+                val batch = ArrayList<T>(minOf(maxBatch, 64))
+                batch.add(first)
+                while (batch.size < maxBatch) {
+                    batch.add(channel.tryReceive().getOrNull() ?: break)
+                }
+                try {
+                    process(batch)
+                } catch (e: CancellationException) {
+                    throw e
+                } catch (e: Exception) {
+                    Log.e(TAG, "Batch of ${batch.size} failed: ${e.message}")
+                }
+            }
+        }
+    }
+
+    /**
+     * Enqueue an item; returns false once the queue has been closed
+     */
+    fun offer(item: T): Boolean = channel.trySend(item).isSuccess
+
+    fun close() {
+        channel.close()
+    }
+}
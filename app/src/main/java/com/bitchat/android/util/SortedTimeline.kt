@@ -0,0 +1,145 @@
+package com.bitchat.android.util
+
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.android.awaitFrame
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+
+/**
+ * Time-ordered, de-duplicated, size-bounded list of timeline items.
+ *
+ * Items are inserted at their binary-searched position (equal timestamps keep arrival
+ * order) instead of re-sorting the whole list per event. Changes are published at most
+ * once per frame: a relay backlog of hundreds of events yields one snapshot, and
+ * eviction of the oldest items plus the snapshot copy run on a background dispatcher.
+ *
+ * Thread-safe; `publish` is invoked from the background dispatcher.
+ */
+class SortedTimeline<T>(
+    private val capacity: Int,
+    private val newestFirst: Boolean,
+    private val scope: CoroutineScope,
+    private val idOf: (T) -> String,
+    private val timeOf: (T) -> Long,
+    private val awaitNextFrame: suspend () -> Unit = { withContext(Dispatchers.Main) { awaitFrame() } },
+    private val publish: suspend (List<T>) -> Unit
+) {
+    private val lock = Any()
+    private val items = ArrayList<T>() // oldest first
+    private val ids = HashSet<String>()
+    private var publishPending = false
+    // Snapshots are published in the order they were taken
+    private val publishMutex = Mutex()
+
+    // Set by close(); a closed timeline ignores changes and publishes nothing more
+    @Volatile var isClosed = false
+        private set
+
+    val size: Int get() = synchronized(lock) { items.size }
+
+    fun contains(id: String): Boolean = synchronized(lock) { ids.contains(id) }
+
+    /**
+     * Insert an item; returns false if its id is already present
+     */
+    fun add(item: T): Boolean {
+        synchronized(lock) {
+            if (isClosed || !ids.add(idOf(item))) return false
+            items.add(upperBound(timeOf(item)), item)
+        }
+        schedulePublish()
+        return true
+    }
+
+    /**
+     * Replace an item in place (its timestamp must not change)
+     */
+    fun update(id: String, transform: (T) -> T): Boolean {
+        synchronized(lock) {
+            if (isClosed || !ids.contains(id)) return false
+            val index = items.indexOfFirst { idOf(it) == id }
+            if (index < 0) return false
+            items[index] = transform(items[index])
+        }
+        schedulePublish()
+        return true
+    }
+
+    fun remove(id: String): Boolean {
+        synchronized(lock) {
+            if (isClosed || !ids.remove(id)) return false
+            items.removeAll { idOf(it) == id }
+        }
+        schedulePublish()
+        return true
+    }
+
+    fun clear() {
+        synchronized(lock) {
+            if (isClosed) return
+            items.clear()
+            ids.clear()
+        }
+        schedulePublish()
+    }
+
+    /**
+     * Discard the timeline: drop its items and cancel publishes that are already scheduled,
+     * so neither an empty nor a stale snapshot reaches `publish` afterwards
+     */
+    fun close() {
+        synchronized(lock) {
+            isClosed = true
+            items.clear()
+            ids.clear()
+        }
+    }
+
+    /**
+     * Current contents in display order, trimmed to capacity
+     */
+    fun snapshot(): List<T> = synchronized(lock) {
+        trimLocked()
+        if (newestFirst) items.asReversed().toList() else items.toList()
+    }
+
+    private fun schedulePublish() {
+        synchronized(lock) {
+            if (publishPending) return
+            publishPending = true
+        }
+        scope.launch(Dispatchers.Default) {
+            try {
+                awaitNextFrame()
+            } finally {
+                // Clear before snapshotting so changes made while publishing schedule another frame
+                synchronized(lock) { publishPending = false }
+            }
+            publishMutex.withLock { if (!isClosed) publish(snapshot()) }
+        }
+    }
+
+    private fun trimLocked() {
+        val excess = items.size - capacity
+        if (excess <= 0) return
+        val evicted = items.subList(0, excess)
+        evicted.forEach { ids.remove(idOf(it)) }
+        evicted.clear()
+    }
+
+    /**
+     * First index whose timestamp is greater than `time`
+     */
+    private fun upperBound(time: Long): Int {
+        var lo = 0
+        var hi = items.size
+        while (lo < hi) {
+            val mid = (lo + hi) ushr 1
+            if (timeOf(items[mid]) <= time) lo = mid + 1 else hi = mid
+        }
+        return lo
+    }
+}
@@ -0,0 +1,118 @@
+package com.bitchat.android.util
+
+import android.util.Log
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+import java.lang.ref.WeakReference
+import java.util.concurrent.CopyOnWriteArrayList
+
+/**
+ * Write-behind buffer for preference-backed stores.
+ *
+ * Mutations only record the latest value per key (null = remove). A debounced job on
+ * Dispatchers.IO hands every pending key to [commit] as one batch, so a burst of toggles
+ * costs a single write and callers never serialize or touch storage on their own thread.
+ *
+ * [commit] throws when the write did not persist; the batch is then re-queued and retried.
+ * [flushAllAsync] starts committing everything pending on IO at once; MainActivity calls it
+ * from onPause so records are written before the process can be killed in the background,
+ * without a synchronous EncryptedSharedPreferences commit on the main thread.
+ */
+class WriteBehindWriter<V : Any>(
+    private val name: String,
+    private val debounceMs: Long = AppConstants.Persistence.WRITE_BEHIND_DEBOUNCE_MS,
+    private val commit: (Map<String, V?>) -> Unit
+) {
+    companion object {
+        private const val TAG = "WriteBehindWriter"
+        private val scope = CoroutineScope(Dispatchers.IO + SupervisorJob())
+        private val writers = CopyOnWriteArrayList<WeakReference<WriteBehindWriter<*>>>()
+
+        /**
+         * Synchronously commit everything pending in every live writer
+         */
+        fun flushAll() {
+            writers.removeAll { it.get() == null }
+            writers.forEach { it.get()?.flush() }
+        }
+
+        /**
+         * Commit everything pending now (skipping the debounce), on IO
+         */
+        fun flushAllAsync() {
+            scope.launch { flushAll() }
+        }
+    }
+
+    private val lock = Any()
+    // Serializes commits so a background batch and a pause flush never interleave
+    private val commitLock = Any()
+    private val pending = LinkedHashMap<String, V?>()
+    private var flushJob: Job? = null
+
+    init {
+        writers.add(WeakReference(this))
+    }
+
+    fun put(key: String, value: V) = enqueue(key, value)
+
+    fun remove(key: String) = enqueue(key, null)
+
+    /**
+     * Forget pending writes, e.g. right before the backing store is wiped. Waits for a commit
+     * already in flight, so it cannot land after the wipe.
+     */
+    fun discardPending() {
+        synchronized(commitLock) {
+            synchronized(lock) {
+                pending.clear()
+                flushJob?.cancel()
+                flushJob = null
+            }
+        }
+    }
+
+    /**
+     * Commit pending writes on the calling thread
+     */
+    fun flush() {
+        synchronized(commitLock) {
+            val batch = synchronized(lock) {
+                flushJob?.cancel()
+                flushJob = null
+                if (pending.isEmpty()) null else LinkedHashMap(pending).also { pending.clear() }
+            } ?: return
+            try {
+                commit(batch)
+                Log.d(TAG, "[$name] committed ${batch.size} record(s)")
+            } catch (e: Exception) {
+                Log.e(TAG, "[$name] commit failed, will retry: ${e.message}")
+                // Re-queue unless a newer value for the key arrived meanwhile
+                synchronized(lock) {
+                    batch.forEach { (key, value) -> if (!pending.containsKey(key)) pending[key] = value }
+                    schedule()
+                }
+            }
+        }
+    }
+
+    private fun enqueue(key: String, value: V?) {
+        synchronized(lock) {
+            pending[key] = value
+            schedule()
+        }
+    }
+
+    // Caller holds lock
+    private fun schedule() {
+        if (flushJob?.isActive == true) return
+        flushJob = scope.launch {
+            delay(debounceMs)
+            flush()
+        }
+    }
+}
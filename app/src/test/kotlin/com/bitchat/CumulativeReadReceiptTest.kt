@@ -0,0 +1,69 @@
+package com.bitchat
+
+import com.bitchat.android.model.BitchatMessage
+import com.bitchat.android.model.DeliveryStatus
+import com.bitchat.android.model.PeerCapability
+import com.bitchat.android.ui.MessageManager
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import java.util.Date
+
+class CumulativeReadReceiptTest {
+
+    private val me = "aaaaaaaaaaaaaaaa"
+    private val peer = "bbbbbbbbbbbbbbbb"
+    private val delivered = DeliveryStatus.Delivered("bob", Date(0))
+
+    private fun message(id: String, from: String, at: Long, status: DeliveryStatus?) = BitchatMessage(
+        id = id,
+        sender = from,
+        content = id,
+        timestamp = Date(at),
+        isPrivate = true,
+        senderPeerID = from,
+        deliveryStatus = status
+    )
+
+    @Test
+    fun `receipt covers our earlier delivered and sent messages`() {
+        val chat = listOf(
+            message("m1", me, 1_000, delivered),
+            message("m2", me, 2_000, DeliveryStatus.Read("bob", Date(0))),
+            message("m3", me, 3_000, DeliveryStatus.Sent),
+            message("m4", me, 4_000, delivered)
+        )
+
+        // m3's delivery ACK was lost; the receipt settles it too
+        assertEquals(setOf("m1", "m3"), MessageManager.coveredByReadReceipt(chat, "m4"))
+    }
+
+    @Test
+    fun `newer, unsent and incoming messages are not covered`() {
+        val chat = listOf(
+            message("failed", me, 1_000, DeliveryStatus.Failed("timeout")),
+            message("sending", me, 1_500, DeliveryStatus.Sending),
+            message("theirs", peer, 2_000, delivered),
+            message("acked", me, 3_000, delivered),
+            message("later", me, 4_000, delivered)
+        )
+
+        assertEquals(emptySet<String>(), MessageManager.coveredByReadReceipt(chat, "acked"))
+    }
+
+    @Test
+    fun `read up to is a capability of its own`() {
+        val legacy = PeerCapability.toBitmask(setOf(PeerCapability.FILE_STREAM, PeerCapability.BATCH_ACK, PeerCapability.PEER_STATE))
+
+        assertFalse(PeerCapability.has(legacy, PeerCapability.READ_UP_TO))
+        assertTrue(PeerCapability.has(PeerCapability.toBitmask(PeerCapability.LOCAL), PeerCapability.READ_UP_TO))
+    }
+
+    @Test
+    fun `unknown message covers nothing`() {
+        val chat = listOf(message("m1", me, 1_000, delivered))
+
+        assertEquals(emptySet<String>(), MessageManager.coveredByReadReceipt(chat, "missing"))
+    }
+}
@@ -0,0 +1,67 @@
+package com.bitchat
+
+import com.bitchat.android.mesh.DeliveryAckBatcher
+import com.bitchat.android.model.DeliveredBatch
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.runBlocking
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNull
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import java.util.Collections
+import java.util.UUID
+
+class DeliveryAckBatchTest {
+
+    @Test
+    fun `batch round trips uuid and free-form ids`() {
+        val ids = listOf(UUID.randomUUID().toString().uppercase(), "legacy-id-1", UUID.randomUUID().toString())
+
+        val encoded = DeliveredBatch.encode(ids)!!
+
+        assertEquals(ids, DeliveredBatch.decode(encoded))
+    }
+
+    @Test
+    fun `uppercase uuids are packed into 17 bytes`() {
+        val ids = List(24) { UUID.randomUUID().toString().uppercase() }
+
+        assertEquals(1 + 24 * 17, DeliveredBatch.encode(ids)!!.size)
+    }
+
+    @Test
+    fun `truncated batch is rejected`() {
+        val encoded = DeliveredBatch.encode(listOf(UUID.randomUUID().toString().uppercase()))!!
+
+        assertNull(DeliveredBatch.decode(encoded.copyOf(encoded.size - 1)))
+        assertNull(DeliveredBatch.decode(ByteArray(0)))
+    }
+
+    @Test
+    fun `acks within the window go out together per peer`() = runBlocking {
+        val sent = Collections.synchronizedList(mutableListOf<Pair<String, List<String>>>())
+        val batcher = DeliveryAckBatcher(this, windowMs = 50, maxIds = 10) { peer, ids -> sent.add(peer to ids) }
+
+        batcher.add("peerA", "m1")
+        batcher.add("peerB", "m2")
+        batcher.add("peerA", "m3")
+        batcher.add("peerA", "m1")
+        assertTrue(sent.isEmpty())
+        delay(200)
+
+        assertEquals(setOf("peerA" to listOf("m1", "m3"), "peerB" to listOf("m2")), sent.toSet())
+    }
+
+    @Test
+    fun `a full batch goes out before the window closes`() = runBlocking {
+        val sent = Collections.synchronizedList(mutableListOf<List<String>>())
+        val batcher = DeliveryAckBatcher(this, windowMs = 150, maxIds = 3) { _, ids -> sent.add(ids) }
+
+        (1..4).forEach { batcher.add("peerA", "m$it") }
+        delay(50)
+        assertEquals(listOf(listOf("m1", "m2", "m3")), sent.toList())
+
+        delay(250)
+        assertEquals(listOf(listOf("m1", "m2", "m3"), listOf("m4")), sent.toList())
+    }
+}
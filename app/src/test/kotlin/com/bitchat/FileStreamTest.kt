@@ -0,0 +1,88 @@
+package com.bitchat
+
+import com.bitchat.android.model.FileStreamRecord
+import com.bitchat.android.model.FileStreamStart
+import com.bitchat.android.noise.FileStreamCipher
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNotNull
+import org.junit.Assert.assertNull
+import org.junit.Assert.fail
+import org.junit.Test
+
+class FileStreamTest {
+
+    private val handshakeHash = ByteArray(32) { (it * 7).toByte() }
+
+    @Test
+    fun `sealed record opens with the same secret and session binding`() {
+        val secret = FileStreamCipher.newSecret()
+        val transferId = FileStreamCipher.newTransferId()
+        val sender = FileStreamCipher.create(secret.copyOf(), handshakeHash, transferId)
+        val receiver = FileStreamCipher.create(secret.copyOf(), handshakeHash, transferId)
+
+        val plaintext = ByteArray(8192) { (it % 251).toByte() }
+        val sealed = sender.seal(3, false, plaintext)
+
+        assertEquals(plaintext.size + FileStreamCipher.TAG_SIZE, sealed.size)
+        assertArrayEquals(plaintext, receiver.open(3, false, sealed))
+    }
+
+    @Test
+    fun `record is rejected at another index, with a flipped final flag, or under another session`() {
+        val secret = FileStreamCipher.newSecret()
+        val transferId = FileStreamCipher.newTransferId()
+        val sender = FileStreamCipher.create(secret.copyOf(), handshakeHash, transferId)
+        val sealed = sender.seal(0, false, "hello".toByteArray())
+
+        val receiver = FileStreamCipher.create(secret.copyOf(), handshakeHash, transferId)
+        assertOpenFails { receiver.open(1, false, sealed) }
+        assertOpenFails { receiver.open(0, true, sealed) }
+
+        val otherSession = FileStreamCipher.create(secret.copyOf(), ByteArray(32), transferId)
+        assertOpenFails { otherSession.open(0, false, sealed) }
+
+        val tampered = sealed.copyOf().also { it[0] = (it[0].toInt() xor 1).toByte() }
+        assertOpenFails { receiver.open(0, false, tampered) }
+    }
+
+    @Test
+    fun `stream start and record survive encode and decode`() {
+        val start = FileStreamStart(
+            transferId = FileStreamCipher.newTransferId(),
+            secret = FileStreamCipher.newSecret(),
+            fileSize = 20_000,
+            recordSize = 8192,
+            recordCount = 3,
+            fileName = "photo.jpg",
+            mimeType = "image/jpeg"
+        )
+        assertEquals(start, FileStreamStart.decode(start.encode()!!))
+
+        val record = FileStreamRecord(start.transferId, 2, true, ByteArray(40) { it.toByte() })
+        assertEquals(record, FileStreamRecord.decode(record.encode()))
+    }
+
+    @Test
+    fun `stream start with inconsistent record layout is rejected`() {
+        val start = FileStreamStart(
+            transferId = FileStreamCipher.newTransferId(),
+            secret = FileStreamCipher.newSecret(),
+            fileSize = 20_000,
+            recordSize = 8192,
+            recordCount = 4, // 3 records already cover 20 000 bytes
+            fileName = "photo.jpg",
+            mimeType = "image/jpeg"
+        )
+        assertNull(FileStreamStart.decode(start.encode()!!))
+        assertNotNull(FileStreamStart.decode(start.copy(recordCount = 3).encode()!!))
+    }
+
+    private fun assertOpenFails(block: () -> Unit) {
+        try {
+            block()
+            fail("Expected record authentication to fail")
+        } catch (_: Exception) {
+        }
+    }
+}
@@ -0,0 +1,55 @@
+package com.bitchat
+
+import com.bitchat.android.geohash.Geohash
+import com.bitchat.android.geohash.GeohashCellTracker
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertNull
+import org.junit.Assert.assertTrue
+import org.junit.Test
+
+class GeohashCellTrackerTest {
+
+    private val tracker = GeohashCellTracker(precision = 8, marginFraction = 0.25, confirmFixes = 3)
+
+    // A cell and a point just across its eastern border, and one well past it
+    private val start = Geohash.encode(52.5200, 13.4050, 8)
+    private val bounds = Geohash.decodeToBounds(start)
+    private val lat = (bounds.latMin + bounds.latMax) / 2
+    private val width = bounds.lonMax - bounds.lonMin
+    private val justAcross = bounds.lonMax + width * 0.05
+    private val wellAcross = bounds.lonMax + width * 0.5
+
+    @Test
+    fun `jitter across a border keeps the committed cell`() {
+        assertEquals(start, tracker.update(lat, bounds.lonMax - width * 0.05))
+        repeat(10) {
+            assertNull(tracker.update(lat, justAcross))
+            assertNull(tracker.update(lat, bounds.lonMax - width * 0.05))
+        }
+        assertEquals(start, tracker.committed)
+        assertFalse(tracker.hasPendingChange)
+    }
+
+    @Test
+    fun `new cell is committed past the margin or after repeated fixes`() {
+        tracker.update(lat, bounds.lonMax - width * 0.05)
+        val east = Geohash.encode(lat, wellAcross, 8)
+        assertEquals(east, tracker.update(lat, wellAcross))
+
+        tracker.reset()
+        tracker.update(lat, bounds.lonMax - width * 0.05)
+        assertNull(tracker.update(lat, justAcross))
+        assertNull(tracker.update(lat, justAcross))
+        assertTrue(tracker.hasPendingChange)
+        assertEquals(east, tracker.update(lat, justAcross))
+    }
+
+    @Test
+    fun `every coarser level is a prefix of the tracked cell`() {
+        val cell = tracker.update(-33.8688, 151.2093)!!
+        for (precision in 1..8) {
+            assertEquals(Geohash.encode(-33.8688, 151.2093, precision), cell.take(precision))
+        }
+    }
+}
@@ -0,0 +1,86 @@
+package com.bitchat
+
+import com.bitchat.android.geohash.Geohash
+import com.bitchat.android.geohash.GeohashActivityIndex
+import com.bitchat.android.geohash.GeohashIndex
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+
+class GeohashIndexTest {
+
+    private var now = 1_000_000L
+
+    @Test
+    fun `prefix range holds the cell and every finer cell and nothing else`() {
+        val index = GeohashIndex<Int>()
+        listOf("u4pru", "u4prUy", "u4pruydq", "u4prv", "u4pr", "u4p", "u4pruz").forEachIndexed { i, gh -> index.put(gh, i) }
+
+        assertEquals(setOf("u4pru", "u4pruy", "u4pruydq", "u4pruz"), index.within("u4pru").keys)
+        assertEquals(setOf("u4pruy", "u4pruydq"), index.within("U4PRUY").keys)
+        assertEquals(setOf("u4pr", "u4pru", "u4pruy", "u4pruydq", "u4pruz", "u4prv"), index.within("u4pr").keys)
+        assertEquals(index.size, index.within("").size)
+        assertTrue(index.within("u4prx").isEmpty())
+        assertEquals(3, index.foldWithin("u4pruy", 0) { acc, _, v -> acc + v })
+    }
+
+    @Test
+    fun `neighbourhood covers the 8 neighbours and their finer cells only`() {
+        val cell = "u4pruyd"
+        val neighbor = Geohash.neighborsSamePrecision(cell).first()
+        val index = GeohashIndex<String>()
+        index.put(cell, "center")
+        index.put(neighbor + "q", "inside neighbour")
+        index.put(cell.take(6), "parent")
+        val outside = Geohash.neighborsSamePrecision(neighbor).first { it != cell && it !in Geohash.neighborsSamePrecision(cell) }
+        index.put(outside, "two cells away")
+
+        assertEquals(setOf(cell, neighbor + "q"), index.withinNeighborhood(cell).keys)
+    }
+
+    @Test
+    fun `activity summaries are range and neighbourhood queries`() {
+        val activity = GeohashActivityIndex(clock = { now })
+        val cell = "u4pruyd"
+        val neighbor = Geohash.neighborsSamePrecision(cell).first()
+        activity.recordMessage(cell + "q", now - 10_000)
+        activity.recordMessage(cell + "r", now)
+        activity.recordNote(cell, now - 1_000)
+        activity.recordMessage(neighbor, now - 500)
+        activity.setBookmarked(cell.take(5), true)
+
+        val within = activity.summaryWithin(cell)
+        assertEquals(2, within.messages)
+        assertEquals(1, within.notes)
+        assertEquals(3, within.activeCells)
+        assertEquals(now, within.lastActivityMs)
+
+        assertEquals(2, activity.summaryWithin(cell, sinceMs = now - 5_000).activeCells)
+        assertEquals(4, activity.neighborhoodSummary(cell).activeCells)
+        assertEquals(1, activity.summaryWithin(cell.take(5)).bookmarks)
+    }
+
+    @Test
+    fun `idle cells expire and the index stays under capacity`() {
+        val activity = GeohashActivityIndex(clock = { now }, maxCells = 4, maxAgeMs = 60_000)
+        activity.recordMessage("u4pru0", now - 120_000)
+        activity.setBookmarked("u4pru1", true)
+        activity.recordMessage("u4pru1", now - 120_000)
+        activity.prune()
+
+        // The stale cell is gone; the bookmark survives with its counters reset
+        assertEquals(1, activity.size)
+        assertEquals(0, activity.summaryWithin("u4pru").activeCells)
+        assertEquals(1, activity.summaryWithin("u4pru").bookmarks)
+
+        (2..7).forEach { activity.recordMessage("u4pru$it", now + it) }
+        assertTrue(activity.size <= 4)
+        assertEquals(1, activity.summaryWithin("u4pru1").bookmarks)
+        assertEquals(1, activity.summaryWithin("u4pru7").activeCells)
+        assertEquals(0, activity.summaryWithin("u4pru2").activeCells)
+
+        activity.setBookmarked("u4pru1", false)
+        assertEquals(0, activity.summaryWithin("u4pru1").bookmarks)
+        assertEquals(3, activity.size)
+    }
+}
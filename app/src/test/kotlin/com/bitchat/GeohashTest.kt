@@ -0,0 +1,142 @@
+package com.bitchat
+
+import com.bitchat.android.geohash.Geohash
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import kotlin.random.Random
+
+/**
+ * Property tests of the integer geohash codec against the original floating-point
+ * bisection implementation, kept here as the reference.
+ */
+class GeohashTest {
+
+    private val random = Random(20240611)
+
+    private fun randomLat(): Double = when (random.nextInt(20)) {
+        0 -> listOf(90.0, -90.0, 0.0, 45.0).random(random)
+        else -> random.nextDouble(-90.0, 90.0)
+    }
+
+    private fun randomLon(): Double = when (random.nextInt(20)) {
+        0 -> listOf(180.0, -180.0, 0.0, -0.0, 90.0).random(random)
+        else -> random.nextDouble(-180.0, 180.0)
+    }
+
+    @Test
+    fun `encode matches bisection encoder`() {
+        repeat(20_000) {
+            val lat = randomLat()
+            val lon = randomLon()
+            val precision = random.nextInt(1, Geohash.MAX_PRECISION + 1)
+            assertEquals("($lat, $lon) p=$precision", Reference.encode(lat, lon, precision), Geohash.encode(lat, lon, precision))
+        }
+    }
+
+    @Test
+    fun `bounds and neighbours match bisection reference`() {
+        repeat(5_000) {
+            val geohash = Reference.encode(randomLat(), randomLon(), random.nextInt(1, Geohash.MAX_PRECISION + 1))
+            assertEquals(geohash, Reference.decodeToBounds(geohash), Geohash.decodeToBounds(geohash))
+            assertEquals(geohash, Reference.neighborsSamePrecision(geohash), Geohash.neighborsSamePrecision(geohash))
+        }
+    }
+
+    @Test
+    fun `neighbours wrap at the antimeridian and clamp at the poles`() {
+        val east = Geohash.encode(0.1, 179.99, 4)
+        val west = Geohash.encode(0.1, -179.99, 4)
+        assertTrue(west in Geohash.neighborsSamePrecision(east))
+        assertEquals(5, Geohash.neighborsSamePrecision(Geohash.encode(90.0, 10.0, 4)).size)
+        assertEquals(emptySet<String>(), Geohash.neighborsSamePrecision("9q8!"))
+    }
+
+    /**
+     * The previous Geohash implementation, verbatim apart from naming
+     */
+    private object Reference {
+        private val base32Chars = "0123456789bcdefghjkmnpqrstuvwxyz".toCharArray()
+        private val charToValue: Map<Char, Int> = base32Chars.withIndex().associate { it.value to it.index }
+
+        fun encode(latitude: Double, longitude: Double, precision: Int): String {
+            if (precision <= 0) return ""
+            var latInterval = -90.0 to 90.0
+            var lonInterval = -180.0 to 180.0
+            var isEven = true
+            var bit = 0
+            var ch = 0
+            val geohash = StringBuilder()
+            val lat = latitude.coerceIn(-90.0, 90.0)
+            val lon = longitude.coerceIn(-180.0, 180.0)
+            while (geohash.length < precision) {
+                if (isEven) {
+                    val mid = (lonInterval.first + lonInterval.second) / 2
+                    if (lon >= mid) {
+                        ch = ch or (1 shl (4 - bit))
+                        lonInterval = mid to lonInterval.second
+                    } else {
+                        lonInterval = lonInterval.first to mid
+                    }
+                } else {
+                    val mid = (latInterval.first + latInterval.second) / 2
+                    if (lat >= mid) {
+                        ch = ch or (1 shl (4 - bit))
+                        latInterval = mid to latInterval.second
+                    } else {
+                        latInterval = latInterval.first to mid
+                    }
+                }
+                isEven = !isEven
+                if (bit < 4) {
+                    bit += 1
+                } else {
+                    geohash.append(base32Chars[ch])
+                    bit = 0
+                    ch = 0
+                }
+            }
+            return geohash.toString()
+        }
+
+        fun decodeToBounds(geohash: String): Geohash.Bounds {
+            var latInterval = -90.0 to 90.0
+            var lonInterval = -180.0 to 180.0
+            var isEven = true
+            geohash.lowercase().forEach { ch ->
+                val cd = charToValue[ch] ?: return Geohash.Bounds(0.0, 0.0, 0.0, 0.0)
+                for (mask in intArrayOf(16, 8, 4, 2, 1)) {
+                    if (isEven) {
+                        val mid = (lonInterval.first + lonInterval.second) / 2
+                        lonInterval = if ((cd and mask) != 0) mid to lonInterval.second else lonInterval.first to mid
+                    } else {
+                        val mid = (latInterval.first + latInterval.second) / 2
+                        latInterval = if ((cd and mask) != 0) mid to latInterval.second else latInterval.first to mid
+                    }
+                    isEven = !isEven
+                }
+            }
+            return Geohash.Bounds(latInterval.first, latInterval.second, lonInterval.first, lonInterval.second)
+        }
+
+        fun neighborsSamePrecision(geohash: String): Set<String> {
+            val p = geohash.length
+            val b = decodeToBounds(geohash)
+            val dLat = b.latMax - b.latMin
+            val dLon = b.lonMax - b.lonMin
+            val neighbors = mutableSetOf<String>()
+            for (dy in -1..1) {
+                for (dx in -1..1) {
+                    if (dx == 0 && dy == 0) continue
+                    val centerLat = (b.latMin + b.latMax) / 2 + dy * dLat
+                    var centerLon = (b.lonMin + b.lonMax) / 2 + dx * dLon
+                    while (centerLon > 180.0) centerLon -= 360.0
+                    while (centerLon < -180.0) centerLon += 360.0
+                    val enc = encode(centerLat.coerceIn(-90.0, 90.0), centerLon, p)
+                    if (enc.isNotEmpty() && enc != geohash) neighbors.add(enc)
+                }
+            }
+            return neighbors
+        }
+    }
+}
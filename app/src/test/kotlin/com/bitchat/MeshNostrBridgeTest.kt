@@ -0,0 +1,155 @@
+package com.bitchat
+
+import com.bitchat.android.nostr.MeshNostrBridge
+import com.bitchat.android.nostr.MeshNostrBridge.Result
+import com.bitchat.android.nostr.NostrEvent
+import com.bitchat.android.nostr.NostrKind
+import com.bitchat.android.util.AppConstants
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNotEquals
+import org.junit.Assert.assertNotNull
+import org.junit.Test
+import java.security.MessageDigest
+
+/**
+ * Bridge nodes on two separate mesh islands sharing one fake relay.
+ */
+class MeshNostrBridgeTest {
+
+    private val geohash = "u4pruyd"
+    private var now = 1_700_000_000_000L
+
+    private class Island {
+        val broadcasts = mutableListOf<Pair<String, UByte>>()
+    }
+
+    /**
+     * Stores published events and hands them to every subscribed bridge when pumped
+     */
+    private inner class FakeRelay {
+        val published = mutableListOf<NostrEvent>()
+        val subscribers = mutableListOf<MeshNostrBridge>()
+        private val pending = ArrayDeque<NostrEvent>()
+
+        fun publish(outbound: MeshNostrBridge.Outbound, signer: String) {
+            // Each bridge signs with its own pseudonym for the peer, so ids differ per bridge
+            val tags = listOf(listOf("g", outbound.geohash), listOf("n", outbound.nickname), listOf("bridge", outbound.meshKey))
+            val pubkey = "pk-$signer-${outbound.senderPeerID}"
+            val id = sha256Hex("$pubkey|${outbound.createdAtSec}|$tags|${outbound.content}")
+            val event = NostrEvent(id, pubkey, outbound.createdAtSec.toInt(), NostrKind.EPHEMERAL_EVENT, tags, outbound.content)
+            published.add(event)
+            pending.add(event)
+        }
+
+        fun pump() {
+            while (pending.isNotEmpty()) {
+                val event = pending.removeFirst()
+                subscribers.forEach { it.onRelayEvent(event) }
+            }
+        }
+    }
+
+    private val relay = FakeRelay()
+
+    private fun bridge(island: Island): MeshNostrBridge {
+        val signer = "bridge${relay.subscribers.size}"
+        return MeshNostrBridge(
+            geohash = geohash,
+            mesh = { content, ttl -> island.broadcasts.add(content to ttl) },
+            relay = { relay.publish(it, signer) },
+            clock = { now }
+        ).also { relay.subscribers.add(it) }
+    }
+
+    private fun channelEvent(id: String, content: String, nickname: String = "alice") = NostrEvent(
+        id = id,
+        pubkey = "ab".repeat(32),
+        createdAt = (now / 1000).toInt(),
+        kind = NostrKind.EPHEMERAL_EVENT,
+        tags = listOf(listOf("g", geohash), listOf("n", nickname)),
+        content = content
+    )
+
+    @Test
+    fun `mesh message crosses to the other island once and never loops`() {
+        val north = Island()
+        val south = Island()
+        val northBridge = bridge(north)
+        val southBridge = bridge(south)
+
+        assertEquals(Result.BRIDGED, northBridge.onMeshMessage("peer1", "bob", "hello", now))
+        assertEquals(Result.DUPLICATE, northBridge.onMeshMessage("peer1", "bob", "hello", now))
+        relay.pump()
+
+        assertEquals(1, relay.published.size)
+        assertEquals(0, north.broadcasts.size)
+        assertEquals(1, south.broadcasts.size)
+        val (content, ttl) = south.broadcasts.single()
+        assertEquals(AppConstants.Bridge.MESH_TTL_HOPS, ttl)
+        val envelope = MeshNostrBridge.parseEnvelope(content)
+        assertNotNull(envelope)
+        assertEquals(geohash, envelope!!.geohash)
+        assertEquals("bob", envelope.nickname)
+        assertEquals("hello", envelope.content)
+
+        // The injected envelope is heard back on the south mesh: not republished
+        assertEquals(Result.LOOP, southBridge.onMeshMessage("southBridgePeer", "carol", content, now))
+        relay.pump()
+        assertEquals(1, relay.published.size)
+        assertEquals(1, south.broadcasts.size)
+    }
+
+    @Test
+    fun `two bridges on one mesh share a bridge key and inject nothing back`() {
+        val island = Island()
+        val first = bridge(island)
+        val second = bridge(island)
+
+        first.onMeshMessage("peer1", "bob", "same packet", now)
+        second.onMeshMessage("peer1", "bob", "same packet", now)
+        relay.pump()
+
+        // Separately signed copies; receivers collapse them on the bridge tag
+        assertEquals(2, relay.published.size)
+        assertNotEquals(relay.published[0].id, relay.published[1].id)
+        assertEquals(1, relay.published.map { MeshNostrBridge.bridgeKey(it) }.toSet().size)
+        assertEquals(0, island.broadcasts.size)
+    }
+
+    @Test
+    fun `channel event is injected once and later copies are suppressed`() {
+        val island = Island()
+        val first = bridge(island)
+        val second = bridge(island)
+        val event = channelEvent("1234abcd" + "0".repeat(56), "from nostr")
+
+        assertEquals(Result.BRIDGED, first.onRelayEvent(event))
+        assertEquals(Result.DUPLICATE, first.onRelayEvent(event))
+        // The second bridge hears the envelope on the mesh before the relay delivers the event
+        second.onMeshMessage("firstBridgePeer", "dave", island.broadcasts.single().first, now)
+        assertEquals(Result.LOOP, second.onRelayEvent(event))
+        assertEquals(1, island.broadcasts.size)
+        assertEquals(0, relay.published.size)
+    }
+
+    @Test
+    fun `rate limits, stale events and other cells`() {
+        val island = Island()
+        val bridge = bridge(island)
+        val perSender = AppConstants.Bridge.PER_SENDER_PER_MINUTE
+
+        repeat(perSender) { assertEquals(Result.BRIDGED, bridge.onMeshMessage("chatty", "eve", "msg $it", now)) }
+        assertEquals(Result.RATE_LIMITED, bridge.onMeshMessage("chatty", "eve", "one more", now))
+        assertEquals(Result.BRIDGED, bridge.onMeshMessage("quiet", "frank", "hi", now))
+        now += 60_000L / perSender
+        assertEquals(Result.BRIDGED, bridge.onMeshMessage("chatty", "eve", "later", now))
+
+        val old = channelEvent("ff".repeat(32), "history").copy(createdAt = ((now - AppConstants.Bridge.MAX_EVENT_AGE_MS - 1_000) / 1000).toInt())
+        assertEquals(Result.STALE, bridge.onRelayEvent(old))
+        val elsewhere = channelEvent("ee".repeat(32), "hi").copy(tags = listOf(listOf("g", "u4pruye")))
+        assertEquals(Result.IGNORED, bridge.onRelayEvent(elsewhere))
+    }
+
+    private fun sha256Hex(s: String): String =
+        MessageDigest.getInstance("SHA-256").digest(s.toByteArray()).joinToString("") { "%02x".format(it) }
+}
@@ -0,0 +1,134 @@
+package com.bitchat
+
+import com.bitchat.android.services.MessageOutbox
+import com.bitchat.android.util.AppConstants
+import com.bitchat.android.util.WriteBehindWriter
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertNotNull
+import org.junit.Assert.assertNull
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import org.junit.runner.RunWith
+import org.robolectric.RobolectricTestRunner
+
+@RunWith(RobolectricTestRunner::class)
+class MessageOutboxTest {
+
+    private var now = 1_700_000_000_000L
+
+    private class MemoryStorage : MessageOutbox.Storage {
+        val records = LinkedHashMap<String, String>()
+
+        @Synchronized
+        override fun readWithPrefix(prefix: String): Map<String, String> =
+            records.filterKeys { it.startsWith(prefix) }
+
+        @Synchronized
+        override fun write(values: Map<String, String?>) {
+            values.forEach { (key, value) -> if (value != null) records[key] = value else records.remove(key) }
+        }
+    }
+
+    private val storage = MemoryStorage()
+
+    private fun outbox() = MessageOutbox(storage, clock = { now })
+
+    private fun MessageOutbox.enqueueAt(messageID: String, peerID: String) {
+        now += 1
+        enqueue(messageID, peerID, "content $messageID", "nick")
+    }
+
+    @Test
+    fun `unacknowledged sends back off exponentially up to the cap`() {
+        val outbox = outbox()
+        outbox.enqueueAt("m1", "peer")
+        assertEquals(listOf("m1"), outbox.dueFor("peer").map { it.messageID })
+
+        outbox.markSent("m1", viaNostr = false)
+        assertTrue(outbox.dueFor("peer").isEmpty())
+        assertEquals(now + AppConstants.Outbox.RETRY_BASE_MS, outbox.nextRetryAt())
+
+        now += AppConstants.Outbox.RETRY_BASE_MS
+        assertEquals(listOf("m1"), outbox.dueFor("peer").map { it.messageID })
+        outbox.markSent("m1", viaNostr = true)
+        assertEquals(now + 2 * AppConstants.Outbox.RETRY_BASE_MS, outbox.nextRetryAt())
+        assertEquals(MessageOutbox.State.SENT_VIA_NOSTR, outbox.get("m1")!!.state)
+
+        repeat(AppConstants.Outbox.MAX_SEND_ATTEMPTS - 2) {
+            now = outbox.nextRetryAt()!!
+            outbox.markSent("m1", viaNostr = false)
+        }
+        assertEquals(now + AppConstants.Outbox.RETRY_MAX_MS, outbox.nextRetryAt())
+    }
+
+    @Test
+    fun `outbox gives up after the last attempt without another send`() {
+        val outbox = outbox()
+        outbox.enqueueAt("m1", "peer")
+        repeat(AppConstants.Outbox.MAX_SEND_ATTEMPTS) {
+            assertFalse(outbox.giveUpIfExhausted("m1"))
+            outbox.markSent("m1", viaNostr = false)
+        }
+
+        assertTrue(outbox.giveUpIfExhausted("m1"))
+        assertNull(outbox.get("m1"))
+        assertNull(outbox.nextRetryAt())
+        assertFalse(outbox.giveUpIfExhausted("m1"))
+    }
+
+    @Test
+    fun `acknowledged messages leave the outbox`() {
+        val outbox = outbox()
+        outbox.enqueueAt("m1", "peer")
+        outbox.markSent("m1", viaNostr = false)
+
+        assertEquals(MessageOutbox.State.READ, outbox.acknowledge("m1", read = true))
+        assertNull(outbox.acknowledge("m1", read = false))
+        assertTrue(outbox.dueFor("peer").isEmpty())
+    }
+
+    @Test
+    fun `restore keeps recent messages and drops those past the max age`() {
+        val first = outbox()
+        first.enqueueAt("old", "peer")
+        now += AppConstants.Outbox.MAX_AGE_MS / 2
+        first.enqueueAt("recent", "peer")
+        first.markSent("recent", viaNostr = false)
+        WriteBehindWriter.flushAll()
+        assertEquals(2, storage.records.size)
+
+        now += AppConstants.Outbox.MAX_AGE_MS / 2 + 1
+        val restored = outbox()
+        assertNull(restored.get("old"))
+        val recent = restored.get("recent")
+        assertNotNull(recent)
+        assertEquals(1, recent!!.attempts)
+        assertEquals(MessageOutbox.State.SENT_VIA_MESH, recent.state)
+
+        WriteBehindWriter.flushAll()
+        assertEquals(1, storage.records.size)
+    }
+
+    @Test
+    fun `messages keep their order per recipient across a restart`() {
+        val first = outbox()
+        first.enqueueAt("a1", "alice")
+        first.enqueueAt("b1", "bob")
+        first.enqueueAt("a2", "alice")
+        first.enqueueAt("a3", "alice")
+        first.enqueueAt("a2", "alice")
+        WriteBehindWriter.flushAll()
+
+        assertEquals(listOf("a1", "a2", "a3"), first.dueFor("alice").map { it.messageID })
+        assertEquals(listOf("alice", "bob"), first.recipients().toList())
+
+        // Storage hands records back in arbitrary order; creation time restores it
+        val shuffled = storage.records.entries.reversed().associate { it.key to it.value }
+        storage.records.clear()
+        storage.records.putAll(shuffled)
+        val restored = outbox()
+        assertEquals(listOf("a1", "a2", "a3"), restored.dueFor("alice").map { it.messageID })
+        assertEquals(listOf("b1"), restored.dueFor("bob").map { it.messageID })
+    }
+}
@@ -0,0 +1,50 @@
+package com.bitchat
+
+import com.bitchat.android.nostr.NIP44KeyCache
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNull
+import org.junit.Test
+
+class NIP44KeyCacheTest {
+
+    private val alice = "a".repeat(64)
+    private val bob = "b".repeat(64)
+
+    @Test
+    fun `keys are per recipient and sender`() {
+        val cache = NIP44KeyCache(capacity = 4)
+        cache.put(alice, "01".repeat(32), byteArrayOf(1))
+        cache.put(bob, "01".repeat(32), byteArrayOf(2))
+
+        assertArrayEquals(byteArrayOf(1), cache.get(alice, "01".repeat(32)))
+        assertArrayEquals(byteArrayOf(2), cache.get(bob, "01".repeat(32)))
+        assertNull(cache.get(alice, "02".repeat(32)))
+        // Pubkeys arrive in either case
+        assertArrayEquals(byteArrayOf(1), cache.get(alice, "01".repeat(32).uppercase()))
+    }
+
+    @Test
+    fun `least recently used sender is evicted`() {
+        val cache = NIP44KeyCache(capacity = 2)
+        cache.put(alice, "s1", byteArrayOf(1))
+        cache.put(alice, "s2", byteArrayOf(2))
+        cache.get(alice, "s1")
+        cache.put(alice, "s3", byteArrayOf(3))
+
+        assertEquals(2, cache.size)
+        assertNull(cache.get(alice, "s2"))
+        assertArrayEquals(byteArrayOf(1), cache.get(alice, "s1"))
+        assertArrayEquals(byteArrayOf(3), cache.get(alice, "s3"))
+    }
+
+    @Test
+    fun `remove drops a stale key`() {
+        val cache = NIP44KeyCache(capacity = 2)
+        cache.put(alice, "s1", byteArrayOf(1))
+        cache.remove(alice, "s1")
+
+        assertNull(cache.get(alice, "s1"))
+        assertEquals(0, cache.size)
+    }
+}
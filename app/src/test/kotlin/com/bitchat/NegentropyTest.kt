@@ -0,0 +1,68 @@
+package com.bitchat
+
+import com.bitchat.android.nostr.Negentropy
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import kotlin.random.Random
+
+class NegentropyTest {
+
+    private val random = Random(77)
+
+    private fun randomItem(timestamp: Long) = Negentropy.Item(timestamp, random.nextBytes(32))
+
+    private data class Result(val have: Set<String>, val need: Set<String>, val rounds: Int, val bytes: Int)
+
+    private fun reconcile(client: List<Negentropy.Item>, relay: List<Negentropy.Item>): Result {
+        val initiator = Negentropy(client)
+        val responder = Negentropy(relay)
+        val have = mutableListOf<String>()
+        val need = mutableListOf<String>()
+        var message: ByteArray? = initiator.initiate()
+        var rounds = 0
+        var bytes = 0
+        while (message != null) {
+            bytes += message.size
+            val reply = responder.reconcile(message, mutableListOf(), mutableListOf())!!
+            bytes += reply.size
+            message = initiator.reconcile(reply, have, need)
+            rounds++
+            assertTrue("did not converge", rounds < 20)
+        }
+        return Result(have.toSet(), need.toSet(), rounds, bytes)
+    }
+
+    private fun ids(items: List<Negentropy.Item>) = items.map { Negentropy.toHex(it.id) }.toSet()
+
+    @Test
+    fun `finds the symmetric difference`() {
+        // Few distinct timestamps so bounds need id prefixes
+        val shared = List(3_000) { randomItem(1_700_000_000L + random.nextLong(50)) }
+        val onlyClient = List(7) { randomItem(1_700_000_000L + random.nextLong(50)) }
+        val onlyRelay = List(40) { randomItem(1_700_000_000L + random.nextLong(50)) }
+
+        val result = reconcile(shared + onlyClient, (shared + onlyRelay).shuffled(random))
+        assertEquals(ids(onlyClient), result.have)
+        assertEquals(ids(onlyRelay), result.need)
+    }
+
+    @Test
+    fun `identical and empty sets`() {
+        val items = List(500) { randomItem(1_700_000_000L + it) }
+        val same = reconcile(items, items)
+        assertTrue(same.have.isEmpty() && same.need.isEmpty())
+        // Traffic for an in-sync window is a handful of fingerprints, not the ids
+        assertTrue("${same.bytes} bytes", same.bytes < 500 * 32 / 4)
+
+        val fromEmpty = reconcile(emptyList(), items)
+        assertEquals(ids(items), fromEmpty.need)
+    }
+
+    @Test
+    fun `hex round trip`() {
+        val hex = "00ff10ab" + "7".repeat(56)
+        assertEquals(hex, Negentropy.toHex(Negentropy.fromHex(hex)))
+        assertEquals(null, Negentropy.item(1, "xyz"))
+    }
+}
@@ -0,0 +1,129 @@
+package com.bitchat
+
+import com.bitchat.android.services.PathQualityEstimator
+import com.bitchat.android.services.PathQualityEstimator.Transport
+import com.bitchat.android.util.AppConstants
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNotNull
+import org.junit.Assert.assertNull
+import org.junit.Assert.assertTrue
+import org.junit.Test
+
+class PathQualityEstimatorTest {
+
+    private var now = 1_000_000L
+    private val estimator = PathQualityEstimator(clock = { now })
+
+    private fun sendAndAck(peerID: String, transport: Transport, messageID: String, rttMs: Long): Long? {
+        estimator.onSent(peerID, transport, messageID)
+        now += rttMs
+        return estimator.onAcked(messageID, transport)
+    }
+
+    @Test
+    fun `ack timings smooth into srtt and widen the budget with jitter`() {
+        assertEquals(AppConstants.PathQuality.DEFAULT_BUDGET_MESH_MS, estimator.budgetMs("peer", Transport.MESH))
+
+        assertEquals(400L, sendAndAck("peer", Transport.MESH, "m1", 400))
+        var estimate = estimator.estimate("peer", Transport.MESH)!!
+        assertEquals(400L, estimate.srttMs)
+        assertEquals(200L, estimate.rttVarMs)
+
+        repeat(20) { sendAndAck("peer", Transport.MESH, "s$it", 400) }
+        val stableBudget = estimator.budgetMs("peer", Transport.MESH)
+        assertEquals(AppConstants.PathQuality.MIN_BUDGET_MS, stableBudget)
+
+        repeat(20) { sendAndAck("peer", Transport.MESH, "j$it", if (it % 2 == 0) 200 else 3_000) }
+        estimate = estimator.estimate("peer", Transport.MESH)!!
+        assertTrue(estimate.srttMs!! in 400L..3_000L)
+        assertTrue(estimator.budgetMs("peer", Transport.MESH) > stableBudget)
+        assertNull(estimator.estimate("peer", Transport.NOSTR))
+    }
+
+    @Test
+    fun `unacked sends count as loss after the timeout`() {
+        repeat(4) { sendAndAck("peer", Transport.NOSTR, "ok$it", 1_000) }
+        assertEquals(0.0, estimator.estimate("peer", Transport.NOSTR)!!.lossRate, 0.0)
+
+        repeat(4) { estimator.onSent("peer", Transport.NOSTR, "lost$it") }
+        // Still within the timeout: not yet judged
+        assertEquals(0.0, estimator.estimate("peer", Transport.NOSTR)!!.lossRate, 0.0)
+
+        now += AppConstants.PathQuality.LOSS_TIMEOUT_MS + 1
+        val lossy = estimator.estimate("peer", Transport.NOSTR)!!.lossRate
+        assertTrue(lossy > 0.3)
+        // A late ACK no longer produces a sample
+        assertNull(estimator.onAcked("lost0", Transport.NOSTR))
+
+        repeat(4) { sendAndAck("peer", Transport.NOSTR, "again$it", 1_000) }
+        assertTrue(estimator.estimate("peer", Transport.NOSTR)!!.lossRate < lossy)
+        // Loss inflates expected delivery beyond the smoothed RTT
+        assertTrue(estimator.expectedDeliveryMs("peer", Transport.NOSTR)!! > estimator.estimate("peer", Transport.NOSTR)!!.srttMs!!)
+    }
+
+    @Test
+    fun `hedged copy acked on one transport is not a loss on the other`() {
+        estimator.onSent("peer", Transport.MESH, "m")
+        now += 4_000
+        estimator.onSent("peer", Transport.NOSTR, "m")
+        now += 500
+        assertEquals(500L, estimator.onAcked("m", Transport.NOSTR))
+
+        now += AppConstants.PathQuality.LOSS_TIMEOUT_MS + 1
+        assertNull(estimator.estimate("peer", Transport.MESH))
+        assertEquals(0.0, estimator.estimate("peer", Transport.NOSTR)!!.lossRate, 0.0)
+    }
+
+    @Test
+    fun `read receipts settle sends without an rtt sample`() {
+        estimator.onSent("peer", Transport.MESH, "m")
+        now += 30_000
+        assertNull(estimator.onAcked("m", Transport.MESH, read = true))
+        val estimate = estimator.estimate("peer", Transport.MESH)!!
+        assertNull(estimate.srttMs)
+        assertEquals(0.0, estimate.lossRate, 0.0)
+    }
+
+    @Test
+    fun `pings and announce hops feed the mesh estimate`() {
+        estimator.onHopCount("peer", 3)
+        val hopsOnly = estimator.estimate("peer", Transport.MESH)
+        assertNotNull(hopsOnly)
+        assertEquals(3, hopsOnly!!.hops)
+        assertNull(hopsOnly.srttMs)
+
+        estimator.onRttSample("peer", Transport.MESH, 250)
+        val estimate = estimator.estimate("peer", Transport.MESH)!!
+        assertEquals(250L, estimate.srttMs)
+        assertEquals(1, estimate.samples)
+        assertEquals(now, estimate.lastUpdatedMs)
+        assertEquals(3, estimator.hops("peer"))
+        assertEquals(setOf("peer"), estimator.snapshot().keys)
+    }
+
+    @Test
+    fun `hop counts expire without fresh announces`() {
+        estimator.onHopCount("peer", 2)
+        now += AppConstants.PathQuality.HOPS_MAX_AGE_MS
+        assertEquals(2, estimator.hops("peer"))
+
+        now += 1
+        assertNull(estimator.hops("peer"))
+        assertNull(estimator.estimate("peer", Transport.MESH))
+
+        estimator.onHopCount("peer", 4)
+        assertEquals(4, estimator.hops("peer"))
+    }
+
+    @Test
+    fun `least recently used peers are evicted`() {
+        val small = PathQualityEstimator(clock = { now }, capacity = 2)
+        small.onHopCount("a", 1)
+        small.onHopCount("b", 2)
+        small.hops("a")
+        small.onHopCount("c", 3)
+        assertEquals(1, small.hops("a"))
+        assertNull(small.hops("b"))
+        assertEquals(3, small.hops("c"))
+    }
+}
@@ -0,0 +1,115 @@
+package com.bitchat
+
+import com.bitchat.android.mesh.PeerStateSync
+import com.bitchat.android.model.PeerStateRecord
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.runBlocking
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertNull
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import java.util.Collections
+
+class PeerStateSyncTest {
+
+    @Test
+    fun `record round trips with and without npub`() {
+        val withNpub = PeerStateRecord(1_700_000_000_123L, true, "alice", "npub1abc")
+        val withoutNpub = PeerStateRecord(7L, false, "bob", null)
+
+        assertEquals(withNpub, PeerStateRecord.decode(withNpub.encode()!!))
+        assertEquals(withoutNpub, PeerStateRecord.decode(withoutNpub.encode()!!))
+    }
+
+    @Test
+    fun `record without version is rejected`() {
+        val encoded = PeerStateRecord(1L, true, "alice", null).encode()!!
+
+        assertNull(PeerStateRecord.decode(encoded.copyOfRange(10, encoded.size)))
+        assertNull(PeerStateRecord.decode(encoded.copyOf(encoded.size - 1)))
+    }
+
+    @Test
+    fun `rapid changes collapse into one send of the latest state`() = runBlocking {
+        var favorite = false
+        val sent = Collections.synchronizedList(mutableListOf<PeerStateRecord>())
+        val sync = PeerStateSync(
+            scope = this,
+            debounceMs = 50,
+            localState = { PeerStateRecord(0L, favorite, "me", null) },
+            send = { _, record -> sent.add(record) }
+        )
+
+        repeat(5) {
+            favorite = !favorite
+            sync.schedule("key", "peer")
+        }
+        delay(200)
+
+        assertEquals(1, sent.size)
+        assertTrue(sent.single().isFavorite)
+    }
+
+    @Test
+    fun `unchanged state is not resent and a change bumps the version`() = runBlocking {
+        var nickname = "me"
+        val sent = Collections.synchronizedList(mutableListOf<PeerStateRecord>())
+        val sync = PeerStateSync(
+            scope = this,
+            debounceMs = 10,
+            clock = { 100L },
+            localState = { PeerStateRecord(0L, true, nickname, null) },
+            send = { _, record -> sent.add(record) }
+        )
+
+        sync.schedule("key", "peer")
+        delay(50)
+        sync.schedule("key", "rotated-peer")
+        delay(50)
+        assertEquals(1, sent.size)
+
+        nickname = "renamed"
+        sync.schedule("key", "rotated-peer")
+        delay(50)
+
+        assertEquals(listOf(100L, 101L), sent.map { it.version })
+        assertEquals("renamed", sent.last().nickname)
+    }
+
+    @Test
+    fun `failed send is retried on the next schedule`() = runBlocking {
+        var online = false
+        val sent = Collections.synchronizedList(mutableListOf<PeerStateRecord>())
+        val sync = PeerStateSync(
+            scope = this,
+            debounceMs = 10,
+            localState = { PeerStateRecord(0L, true, "me", null) },
+            send = { _, record -> online.also { if (it) sent.add(record) } }
+        )
+
+        sync.schedule("key", "peer")
+        delay(50)
+        online = true
+        sync.schedule("key", "peer")
+        delay(50)
+
+        assertEquals(1, sent.size)
+    }
+
+    @Test
+    fun `only newer versions are accepted`() = runBlocking {
+        val sync = PeerStateSync(
+            scope = this,
+            localState = { null },
+            send = { _, _ -> true }
+        )
+        val record = PeerStateRecord(5L, true, "alice", null)
+
+        assertTrue(sync.accept("key", record))
+        assertFalse(sync.accept("key", record))
+        assertFalse(sync.accept("key", record.copy(version = 4L)))
+        assertTrue(sync.accept("key", record.copy(version = 6L)))
+        assertTrue(sync.accept("other", record))
+    }
+}
@@ -0,0 +1,102 @@
+package com.bitchat
+
+import com.bitchat.android.nostr.RelayConnectionScheduler
+import com.bitchat.android.nostr.RelayConnectionScheduler.Priority
+import com.bitchat.android.util.AppConstants
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNull
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import kotlin.random.Random
+
+class RelayConnectionSchedulerTest {
+
+    private var now = 0L
+    private val scheduler = RelayConnectionScheduler(maxConcurrent = 2, clock = { now }, random = Random(42))
+
+    @Test
+    fun `attempts stay within the budget and go out by priority`() {
+        scheduler.request("wss://normal1", Priority.NORMAL)
+        scheduler.request("wss://high1", Priority.HIGH)
+        scheduler.request("wss://normal2", Priority.NORMAL)
+        scheduler.request("wss://high2", Priority.HIGH)
+
+        assertEquals(listOf("wss://high1", "wss://high2"), scheduler.due())
+        assertEquals(emptyList<String>(), scheduler.due())
+
+        scheduler.onConnected("wss://high1")
+        assertEquals(listOf("wss://normal1"), scheduler.due())
+        // Raising a waiting relay's priority moves it up, it is not queued twice
+        assertEquals(false, scheduler.request("wss://normal2", Priority.HIGH))
+        scheduler.onConnected("wss://high2")
+        assertEquals(listOf("wss://normal2"), scheduler.due())
+    }
+
+    @Test
+    fun `lazy relays wait until eager ones are settled`() {
+        scheduler.request("wss://sampled", Priority.LAZY)
+        scheduler.request("wss://active", Priority.HIGH)
+
+        assertEquals(listOf("wss://active"), scheduler.due())
+        // A free slot is not enough while an eager relay is still connecting
+        assertEquals(emptyList<String>(), scheduler.due())
+
+        scheduler.onConnected("wss://active")
+        assertEquals(listOf("wss://sampled"), scheduler.due())
+    }
+
+    @Test
+    fun `an eager relay backing off does not hold lazy relays back`() {
+        scheduler.request("wss://unreachable", Priority.HIGH)
+        scheduler.request("wss://sampled", Priority.LAZY)
+
+        assertEquals(listOf("wss://unreachable"), scheduler.due())
+        val delay = scheduler.onFailed("wss://unreachable")!!
+        assertEquals(listOf("wss://sampled"), scheduler.due())
+
+        // Once its backoff has passed the eager relay goes first again
+        scheduler.request("wss://sampled2", Priority.LAZY)
+        now += delay
+        assertEquals(listOf("wss://unreachable"), scheduler.due())
+        assertEquals(emptyList<String>(), scheduler.due())
+    }
+
+    @Test
+    fun `failures back off with decorrelated jitter until attempts run out`() {
+        scheduler.request("wss://flaky", Priority.NORMAL)
+        var previous = AppConstants.Nostr.INITIAL_BACKOFF_INTERVAL_MS
+        repeat(AppConstants.Nostr.MAX_RECONNECT_ATTEMPTS - 1) { attempt ->
+            assertEquals(listOf("wss://flaky"), scheduler.due())
+            val delay = scheduler.onFailed("wss://flaky")!!
+            assertTrue(delay >= AppConstants.Nostr.INITIAL_BACKOFF_INTERVAL_MS)
+            if (attempt == 0) assertEquals(AppConstants.Nostr.INITIAL_BACKOFF_INTERVAL_MS, delay)
+            assertTrue(delay <= minOf(previous * 3, AppConstants.Nostr.MAX_BACKOFF_INTERVAL_MS))
+            previous = delay
+
+            // Not due before the delay has passed
+            assertEquals(emptyList<String>(), scheduler.due())
+            assertEquals(now + delay, scheduler.nextWakeAt())
+            now += delay
+        }
+        assertEquals(listOf("wss://flaky"), scheduler.due())
+        assertNull(scheduler.onFailed("wss://flaky"))
+        assertNull(scheduler.nextWakeAt())
+    }
+
+    @Test
+    fun `a connection resets backoff and untracked relays are not retried`() {
+        scheduler.request("wss://relay", Priority.HIGH)
+        scheduler.due()
+        scheduler.onFailed("wss://relay")
+        now += AppConstants.Nostr.MAX_BACKOFF_INTERVAL_MS
+        scheduler.due()
+        scheduler.onConnected("wss://relay")
+        assertEquals(0, scheduler.attempts("wss://relay"))
+        // The open socket drops later: first retry uses the base delay again
+        assertEquals(AppConstants.Nostr.INITIAL_BACKOFF_INTERVAL_MS, scheduler.onFailed("wss://relay"))
+
+        scheduler.clear()
+        assertNull(scheduler.onFailed("wss://relay"))
+        assertNull(scheduler.onFailed("wss://other", retry = true))
+    }
+}
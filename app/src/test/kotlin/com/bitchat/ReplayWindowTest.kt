@@ -0,0 +1,54 @@
+package com.bitchat
+
+import com.bitchat.android.noise.ReplayWindow
+import org.junit.Assert.assertEquals
+import org.junit.Test
+
+class ReplayWindowTest {
+
+    private fun ReplayWindow.receive(nonce: Long): ReplayWindow.Verdict {
+        return check(nonce).also { if (it == ReplayWindow.Verdict.ACCEPT) markSeen(nonce) }
+    }
+
+    @Test
+    fun `out of order nonces inside the window are accepted once`() {
+        val window = ReplayWindow(128)
+        listOf(5L, 1L, 100L, 3L, 70L, 2L).forEach {
+            assertEquals(ReplayWindow.Verdict.ACCEPT, window.receive(it))
+        }
+        assertEquals(ReplayWindow.Verdict.DUPLICATE, window.receive(70))
+        assertEquals(ReplayWindow.Verdict.DUPLICATE, window.receive(3))
+        assertEquals(ReplayWindow.Verdict.ACCEPT, window.receive(4))
+        assertEquals(2L, window.duplicateCount)
+        assertEquals(98L, window.maxReorderDepth)
+    }
+
+    @Test
+    fun `shift across word boundaries keeps seen bits`() {
+        val window = ReplayWindow(256)
+        window.receive(10)
+        window.receive(11)
+        window.receive(150) // shift of 139 bits: two words plus a partial word
+        assertEquals(ReplayWindow.Verdict.DUPLICATE, window.receive(10))
+        assertEquals(ReplayWindow.Verdict.DUPLICATE, window.receive(11))
+        assertEquals(ReplayWindow.Verdict.ACCEPT, window.receive(12))
+    }
+
+    @Test
+    fun `nonce behind the window is too old and stays rejected after growing`() {
+        val window = ReplayWindow(64)
+        window.receive(1)
+        window.receive(200)
+        assertEquals(ReplayWindow.Verdict.TOO_OLD, window.receive(100))
+        assertEquals(1L, window.tooOldCount)
+
+        // History the small window had already dropped stays rejected after growing
+        window.resize(256)
+        assertEquals(ReplayWindow.Verdict.DUPLICATE, window.receive(1))
+        assertEquals(ReplayWindow.Verdict.DUPLICATE, window.receive(100))
+
+        window.receive(300)
+        assertEquals(ReplayWindow.Verdict.ACCEPT, window.receive(150))
+        assertEquals(ReplayWindow.Verdict.DUPLICATE, window.receive(200))
+    }
+}
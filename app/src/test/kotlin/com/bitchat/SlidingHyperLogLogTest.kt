@@ -0,0 +1,45 @@
+package com.bitchat
+
+import com.bitchat.android.nostr.SlidingHyperLogLog
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import kotlin.math.abs
+
+class SlidingHyperLogLogTest {
+
+    private val window = 300_000L
+    private val now = 1_700_000_000_000L
+
+    @Test
+    fun `small crowds are counted exactly and repeats do not inflate`() {
+        val sketch = SlidingHyperLogLog(window)
+        repeat(3) { round ->
+            (1..12).forEach { sketch.add("pubkey-$it", now - round * 1000, now) }
+        }
+        assertEquals(12, sketch.estimate(now))
+        assertFalse(sketch.add("pubkey-1", now, now))
+    }
+
+    @Test
+    fun `large crowds stay within sketch error`() {
+        val sketch = SlidingHyperLogLog(window)
+        (1..5000).forEach { sketch.add("%064x".format(it * 7919L), now, now) }
+        val estimate = sketch.estimate(now)
+        assertTrue("estimate $estimate", abs(estimate - 5000) < 5000 * 0.2)
+    }
+
+    @Test
+    fun `participants age out of the window`() {
+        val sketch = SlidingHyperLogLog(window)
+        (1..10).forEach { sketch.add("old-$it", now, now) }
+        (1..4).forEach { sketch.add("new-$it", now + 240_000, now + 240_000) }
+        assertEquals(14, sketch.estimate(now + 240_000))
+
+        // One slice later the first slice has left the window
+        assertEquals(4, sketch.estimate(now + 300_000))
+        assertFalse(sketch.add("stale", now, now + 300_000))
+        assertTrue(sketch.isExpired(now + 600_000))
+    }
+}
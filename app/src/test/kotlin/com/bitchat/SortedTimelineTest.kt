@@ -0,0 +1,80 @@
+package com.bitchat
+
+import com.bitchat.android.util.SortedTimeline
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.joinAll
+import kotlinx.coroutines.runBlocking
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Test
+import java.util.Collections
+
+class SortedTimelineTest {
+
+    private data class Item(val id: String, val time: Long)
+
+    private val job = Job()
+    private val frame = CompletableDeferred<Unit>()
+    private val published = Collections.synchronizedList(mutableListOf<List<Item>>())
+
+    private fun timeline(capacity: Int, newestFirst: Boolean) = SortedTimeline<Item>(
+        capacity = capacity,
+        newestFirst = newestFirst,
+        scope = CoroutineScope(job),
+        idOf = { it.id },
+        timeOf = { it.time },
+        awaitNextFrame = { frame.await() },
+        publish = { published.add(it) }
+    )
+
+    private fun awaitPublished() = runBlocking {
+        frame.complete(Unit)
+        job.children.toList().joinAll()
+    }
+
+    @Test
+    fun `burst of out of order items publishes one sorted snapshot`() {
+        val timeline = timeline(capacity = 1000, newestFirst = false)
+        val times = (1..300).map { (it * 7919L) % 1000 }
+        times.forEachIndexed { i, t -> timeline.add(Item("e$i", t)) }
+        assertFalse(timeline.add(Item("e0", 5)))
+
+        awaitPublished()
+        assertEquals(1, published.size)
+        assertEquals(times.sorted(), published[0].map { it.time })
+    }
+
+    @Test
+    fun `equal timestamps keep arrival order`() {
+        val timeline = timeline(capacity = 10, newestFirst = false)
+        timeline.add(Item("a", 10))
+        timeline.add(Item("b", 5))
+        timeline.add(Item("c", 10))
+        assertEquals(listOf("b", "a", "c"), timeline.snapshot().map { it.id })
+    }
+
+    @Test
+    fun `oldest items are evicted beyond capacity`() {
+        val timeline = timeline(capacity = 3, newestFirst = true)
+        listOf(40L, 10L, 30L, 20L, 50L).forEachIndexed { i, t -> timeline.add(Item("n$i", t)) }
+
+        awaitPublished()
+        assertEquals(listOf(50L, 40L, 30L), published.last().map { it.time })
+        assertEquals(3, timeline.size)
+        assertFalse(timeline.contains("n1"))
+    }
+
+    @Test
+    fun `closed timeline drops its pending publish and later changes`() {
+        val timeline = timeline(capacity = 10, newestFirst = false)
+        timeline.add(Item("a", 1))
+        timeline.close()
+        assertFalse(timeline.add(Item("b", 2)))
+
+        awaitPublished()
+        assertEquals(0, published.size)
+        assertEquals(0, timeline.size)
+    }
+}
@@ -0,0 +1,117 @@
+package com.bitchat
+
+import com.bitchat.android.net.Socks5SocketFactory
+import com.bitchat.android.net.TorCircuitPrewarmer
+import com.bitchat.android.net.TorCircuitPrewarmer.Target
+import com.bitchat.android.net.TorCircuitStats
+import com.bitchat.android.net.TorIsolation
+import kotlinx.coroutines.runBlocking
+import org.junit.After
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import java.io.DataInputStream
+import java.net.InetAddress
+import java.net.InetSocketAddress
+import java.net.ServerSocket
+import java.util.Collections
+import kotlin.concurrent.thread
+
+/**
+ * Prewarming against a local SOCKS5 stand-in for Arti's proxy port.
+ */
+class TorCircuitPrewarmerTest {
+
+    /**
+     * Accepts username/password auth and CONNECT by domain name; records each stream and
+     * refuses the first `failures` CONNECTs (as Arti does while it has no usable circuit)
+     */
+    private class SocksStandIn(@Volatile var failures: Int = 0) {
+        data class Stream(val username: String, val password: String, val host: String, val port: Int)
+
+        val streams: MutableList<Stream> = Collections.synchronizedList(mutableListOf())
+        private val server = ServerSocket(0, 50, InetAddress.getLoopbackAddress())
+        val address = InetSocketAddress(InetAddress.getLoopbackAddress(), server.localPort)
+
+        init {
+            thread(isDaemon = true) {
+                while (!server.isClosed) {
+                    val client = try { server.accept() } catch (_: Exception) { break }
+                    thread(isDaemon = true) { client.use { serve(it) } }
+                }
+            }
+        }
+
+        private fun serve(client: java.net.Socket) {
+            val input = DataInputStream(client.getInputStream())
+            val output = client.getOutputStream()
+            input.readUnsignedByte()
+            input.readFully(ByteArray(input.readUnsignedByte()))
+            output.write(byteArrayOf(5, 2))
+            input.readUnsignedByte()
+            val username = String(ByteArray(input.readUnsignedByte()).also { input.readFully(it) })
+            val password = String(ByteArray(input.readUnsignedByte()).also { input.readFully(it) })
+            output.write(byteArrayOf(1, 0))
+            input.readFully(ByteArray(4))
+            val host = String(ByteArray(input.readUnsignedByte()).also { input.readFully(it) })
+            val port = input.readUnsignedShort()
+            val refuse = synchronized(this) { (failures > 0).also { if (it) failures-- } }
+            streams.add(Stream(username, password, host, port))
+            output.write(byteArrayOf(5, if (refuse) 1 else 0, 0, 1, 0, 0, 0, 0, 0, 0))
+            output.flush()
+        }
+
+        fun close() = server.close()
+    }
+
+    private val socks = SocksStandIn()
+    private val stats = TorCircuitStats()
+    private val prewarmer = TorCircuitPrewarmer { isolation -> Socks5SocketFactory(socks.address, isolation, "secret", stats) }
+
+    @After
+    fun tearDown() = socks.close()
+
+    @Test
+    fun `dm relays get a circuit each and geohash relays share one`() = runBlocking {
+        val results = prewarmer.prewarm(
+            listOf(
+                Target(TorIsolation.DIRECT_MESSAGES, "wss://relay-a.example"),
+                Target(TorIsolation.DIRECT_MESSAGES, "wss://relay-b.example:7447"),
+                Target(TorIsolation.GEOHASH, "wss://geo-1.example"),
+                Target(TorIsolation.GEOHASH, "wss://geo-2.example")
+            )
+        )
+
+        assertEquals(mapOf("dm:relay-a.example" to true, "dm:relay-b.example" to true, "geohash" to true), results)
+        val streams = socks.streams.sortedBy { it.username }
+        assertEquals(listOf("dm:relay-a.example", "dm:relay-b.example", "geohash"), streams.map { it.username })
+        assertEquals(listOf(443, 7447, 443), streams.map { it.port })
+        assertTrue(streams.all { it.password == "secret" })
+        // Hostnames go to the proxy unresolved
+        assertEquals("relay-a.example", streams.first().host)
+        assertEquals(setOf("dm:relay-a.example", "dm:relay-b.example", "geohash"), stats.circuits.value.keys)
+        assertTrue(stats.circuits.value.values.all { it.connects == 1 && it.failures == 0 })
+    }
+
+    @Test
+    fun `refused streams are retried until the circuit is up`() = runBlocking {
+        socks.failures = 2
+        val results = prewarmer.prewarm(listOf(Target(TorIsolation.GEOHASH, "wss://geo.example")), timeoutMs = 5_000, retryMs = 10)
+
+        assertEquals(mapOf("geohash" to true), results)
+        assertEquals(3, socks.streams.size)
+        val circuit = stats.circuits.value.getValue("geohash")
+        assertEquals(1, circuit.connects)
+        assertEquals(2, circuit.failures)
+    }
+
+    @Test
+    fun `prewarm gives up at the deadline`() = runBlocking {
+        socks.failures = Int.MAX_VALUE
+        val results = prewarmer.prewarm(listOf(Target(TorIsolation.DIRECT_MESSAGES, "wss://down.example")), timeoutMs = 200, retryMs = 20)
+
+        assertFalse(results.getValue("dm:down.example"))
+        assertEquals(0, stats.circuits.value.getValue("dm:down.example").connects)
+    }
+}